@@ -0,0 +1,422 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "bench.h"
+#include "cn_log.h"
+#include "sn_file.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * Micro benchmarks for the cn_ / sn_ core routines
+ *
+ * Usage:
+ *   bench_program [-s size] [-i max iterations] [-m min millis]
+ *                 [-f name filter] [-o output file]
+ *                 [-c baseline file] [-t threshold percent]
+ *
+ * Results are written as JSON, one benchmark per line. When a baseline
+ * (a previous JSON output) is given with -c, each benchmark also gets its
+ * baseline ns/op and the change in percent. The exit status is then 1, if
+ * any benchmark is slower than the baseline by more than the threshold.
+ */
+
+#define DEFAULT_SIZE 1000
+#define DEFAULT_MAX_ITERATIONS 1000000
+#define DEFAULT_MIN_MILLIS 500
+#define DEFAULT_THRESHOLD_PCT 10.0
+
+#define MAX_BASELINE 256
+#define BENCH_NAME_LENGTH 64
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Allocation counting                                            |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+/*
+ * The bench program is linked with:
+ *   -Wl,--wrap=malloc -Wl,--wrap=calloc -Wl,--wrap=realloc -Wl,--wrap=strdup
+ *
+ * ... so allocations made by the sn1ff object files are counted. Allocations
+ * made inside libc itself (e.g. by fopen) are not
+ */
+
+static size_t ALLOCS = 0;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t nmemb, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+char *__real_strdup(const char *s);
+
+void *__wrap_malloc(size_t size) {
+  ALLOCS++;
+  return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t nmemb, size_t size) {
+  ALLOCS++;
+  return __real_calloc(nmemb, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+  ALLOCS++;
+  return __real_realloc(ptr, size);
+}
+
+char *__wrap_strdup(const char *s) {
+  ALLOCS++;
+  return __real_strdup(s);
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Helpers for the benchmarks                                     |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+static char TMP_DIR[64] = {'\0'};
+
+const char *bench_tmp_dir(void) { return TMP_DIR; }
+
+/**
+ * Write a sn1ff file, with a header and a number of body lines
+ *
+ * @return  0 success
+ *         -1 could not open the file
+ */
+int bench_write_file(const char *path, size_t body_lines) {
+  return bench_write_file_fmt(path, body_lines, SN_FILE_FORMAT_V1);
+}
+
+/**
+ * Write a sn1ff file, as bench_write_file, in the given file format
+ */
+int bench_write_file_fmt(const char *path, size_t body_lines, int format) {
+  FILE *file = fopen(path, "w");
+  if (file == NULL)
+    return -1;
+
+  HEADER hdr = {.host = "benchhost",
+                .ipv4 = "192.0.2.1",
+                .timestamp = "Mon January 01, 2025 00:00:00",
+                .checkid = "BENCH/CHECK.SH"};
+  sn_file_write_header_fmt(file, &hdr, format);
+
+  for (size_t i = 0; i < body_lines; i++)
+    fprintf(file, "Line %6zu - the quick brown fox jumps over the lazy dog\n",
+            i);
+
+  fclose(file);
+  return 0;
+}
+
+static double now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Baseline                                                       |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+typedef struct {
+  char name[BENCH_NAME_LENGTH];
+  double ns_per_op;
+} BASELINE;
+
+static BASELINE BASELINES[MAX_BASELINE];
+static size_t NUM_BASELINES = 0;
+
+/**
+ * Load a previous JSON output, as the baseline to compare against
+ *
+ * @return  0 success
+ *         -1 could not open the baseline file
+ */
+static int load_baseline(const char *path) {
+  FILE *file = fopen(path, "r");
+  if (file == NULL) {
+    fprintf(stderr, "Could not open baseline file -> %s <-\n", path);
+    return -1;
+  }
+
+  char line[512];
+  while (fgets(line, sizeof(line), file) && NUM_BASELINES < MAX_BASELINE) {
+    char *name = strstr(line, "\"name\": \"");
+    char *ns = strstr(line, "\"ns_per_op\": ");
+    if (name == NULL || ns == NULL)
+      continue;
+
+    BASELINE *b = &BASELINES[NUM_BASELINES];
+    if (sscanf(name, "\"name\": \"%63[^\"]\"", b->name) == 1 &&
+        sscanf(ns, "\"ns_per_op\": %lf", &b->ns_per_op) == 1)
+      NUM_BASELINES++;
+  }
+
+  fclose(file);
+  return 0;
+}
+
+static const BASELINE *find_baseline(const char *name) {
+  for (size_t i = 0; i < NUM_BASELINES; i++) {
+    if (strcmp(BASELINES[i].name, name) == 0)
+      return &BASELINES[i];
+  }
+  return NULL;
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Run                                                            |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+typedef struct {
+  size_t size;
+  size_t max_iterations;
+  long min_millis;
+  const char *filter;
+  double threshold_pct;
+  bool compare;
+} OPTIONS;
+
+/**
+ * Run one benchmark, and write its JSON line
+ *
+ * @return  0 success, and within threshold of any baseline
+ *          1 slower than the baseline by more than the threshold
+ *         -1 setup failed
+ *         -2 skipped, it cannot run on this host
+ */
+static int run_bench(const BENCH *bench, const OPTIONS *opts, FILE *out,
+                     bool first) {
+  int setup = bench->setup(opts->size);
+  if (setup == BENCH_SKIP) {
+    fprintf(stderr, "Skipped benchmark -> %s <-\n", bench->name);
+    bench->teardown();
+    return -2;
+  }
+  if (setup != 0) {
+    fprintf(stderr, "Setup failed for benchmark -> %s <-\n", bench->name);
+    bench->teardown();
+    return -1;
+  }
+
+  // Warm up
+
+  bench->op(0);
+
+  // Time operations, until both the minimum time has passed, or the
+  // maximum number of iterations is reached
+
+  double min_ns = (double)opts->min_millis * 1e6;
+  size_t iterations = 0;
+  size_t allocs_start = ALLOCS;
+  double start = now_ns();
+  double elapsed = 0;
+
+  while (iterations < opts->max_iterations) {
+    bench->op(iterations);
+    iterations++;
+
+    if ((iterations & 0x3f) == 0 || iterations < 64) {
+      elapsed = now_ns() - start;
+      if (elapsed >= min_ns)
+        break;
+    }
+  }
+  elapsed = now_ns() - start;
+  size_t allocs = ALLOCS - allocs_start;
+
+  bench->teardown();
+
+  double ns_per_op = elapsed / (double)iterations;
+  double ops_per_sec = ns_per_op > 0 ? 1e9 / ns_per_op : 0;
+  double allocs_per_op = (double)allocs / (double)iterations;
+
+  fprintf(out,
+          "%s    {\"name\": \"%s\", \"size\": %zu, \"iterations\": %zu, "
+          "\"ns_per_op\": %.1f, \"ops_per_sec\": %.1f, \"allocs_per_op\": %.2f",
+          first ? "" : ",\n", bench->name, opts->size, iterations, ns_per_op,
+          ops_per_sec, allocs_per_op);
+
+  int result = 0;
+  const BASELINE *baseline = opts->compare ? find_baseline(bench->name) : NULL;
+  if (baseline != NULL && baseline->ns_per_op > 0) {
+    double change_pct =
+        (ns_per_op - baseline->ns_per_op) * 100.0 / baseline->ns_per_op;
+    fprintf(out, ", \"baseline_ns_per_op\": %.1f, \"change_pct\": %.1f",
+            baseline->ns_per_op, change_pct);
+
+    if (change_pct > opts->threshold_pct) {
+      fprintf(stderr, "REGRESSION -> %s <- %.1f%% slower than baseline\n",
+              bench->name, change_pct);
+      result = 1;
+    }
+  }
+
+  fprintf(out, "}");
+  fflush(out);
+  return result;
+}
+
+static int run_table(const BENCH *table, const OPTIONS *opts, FILE *out,
+                     bool *first) {
+  int result = 0;
+
+  for (const BENCH *bench = table; bench->name != NULL; bench++) {
+    if (opts->filter != NULL && strstr(bench->name, opts->filter) == NULL)
+      continue;
+
+    int status = run_bench(bench, opts, out, *first);
+    if (status >= 0)
+      *first = false; // Its JSON line is written
+    if (status != 0 && status != -2)
+      result = 1;
+  }
+
+  return result;
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Main                                                           |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+static void print_usage(const char *program_name) {
+  fprintf(stderr,
+          "Usage: %s [-s size] [-i max iterations] [-m min millis] "
+          "[-f name filter] [-o output file] [-c baseline file] "
+          "[-t threshold percent]\n",
+          program_name);
+}
+
+int main(int argc, char *argv[]) {
+  OPTIONS opts = {.size = DEFAULT_SIZE,
+                  .max_iterations = DEFAULT_MAX_ITERATIONS,
+                  .min_millis = DEFAULT_MIN_MILLIS,
+                  .filter = NULL,
+                  .threshold_pct = DEFAULT_THRESHOLD_PCT,
+                  .compare = false};
+  const char *output_path = NULL;
+  const char *baseline_path = NULL;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "hs:i:m:f:o:c:t:")) != -1) {
+    switch (opt) {
+    case 's':
+      opts.size = strtoul(optarg, NULL, 10);
+      break;
+    case 'i':
+      opts.max_iterations = strtoul(optarg, NULL, 10);
+      break;
+    case 'm':
+      opts.min_millis = strtol(optarg, NULL, 10);
+      break;
+    case 'f':
+      opts.filter = optarg;
+      break;
+    case 'o':
+      output_path = optarg;
+      break;
+    case 'c':
+      baseline_path = optarg;
+      break;
+    case 't':
+      opts.threshold_pct = strtod(optarg, NULL);
+      break;
+    case 'h':
+      print_usage(argv[0]);
+      return EXIT_SUCCESS;
+    default:
+      print_usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (opts.size == 0 || opts.max_iterations == 0) {
+    fprintf(stderr, "Size and iterations must be > 0\n");
+    return EXIT_FAILURE;
+  }
+
+  // Only log errors, so syslog does not dominate the timings
+
+  cn_log_open("sn1ff_bench", LOG_ERR);
+
+  if (baseline_path != NULL) {
+    if (load_baseline(baseline_path) != 0)
+      return EXIT_FAILURE;
+    opts.compare = true;
+  }
+
+  FILE *out = stdout;
+  if (output_path != NULL) {
+    out = fopen(output_path, "w");
+    if (out == NULL) {
+      fprintf(stderr, "Could not open output file -> %s <-\n", output_path);
+      return EXIT_FAILURE;
+    }
+  }
+
+  snprintf(TMP_DIR, sizeof(TMP_DIR), "/tmp/sn1ff_bench.XXXXXX");
+  if (mkdtemp(TMP_DIR) == NULL) {
+    fprintf(stderr, "Could not create temporary dir -> %s <-\n", TMP_DIR);
+    return EXIT_FAILURE;
+  }
+
+  fprintf(out, "{\n  \"size\": %zu,\n  \"benchmarks\": [\n", opts.size);
+
+  bool first = true;
+  int result = 0;
+  result |= run_table(BENCH_CN, &opts, out, &first);
+  result |= run_table(BENCH_SN, &opts, out, &first);
+  result |= run_table(BENCH_INGEST, &opts, out, &first);
+  result |= run_table(BENCH_BATCH, &opts, out, &first);
+  result |= run_table(BENCH_SHARD, &opts, out, &first);
+  result |= run_table(BENCH_INDEX, &opts, out, &first);
+  result |= run_table(BENCH_API, &opts, out, &first);
+  result |= run_table(BENCH_SEARCH, &opts, out, &first);
+
+  fprintf(out, "\n  ]\n}\n");
+
+  if (out != stdout)
+    fclose(out);
+
+  rmdir(TMP_DIR);
+  cn_log_close();
+
+  return result == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,64 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stddef.h>
+
+/*
+ * A benchmark is a "setup", an "op" that is timed, and a "teardown".
+ *
+ *   - setup     generates the inputs for "size" (e.g. number of names,
+ *               files or body lines), return 0 on success, or BENCH_SKIP
+ *               if the benchmark cannot run on this host
+ *   - op        one operation, called with the iteration number
+ *   - teardown  release what setup created
+ */
+
+#define BENCH_SKIP 1
+
+typedef struct {
+  const char *name;
+  int (*setup)(size_t size);
+  void (*op)(size_t i);
+  void (*teardown)(void);
+} BENCH;
+
+extern const BENCH BENCH_CN[];
+extern const BENCH BENCH_SN[];
+extern const BENCH BENCH_INGEST[];
+extern const BENCH BENCH_BATCH[];
+extern const BENCH BENCH_SHARD[];
+extern const BENCH BENCH_INDEX[];
+extern const BENCH BENCH_API[];
+extern const BENCH BENCH_SEARCH[];
+
+const char *bench_tmp_dir(void);
+
+int bench_write_file(const char *path, size_t body_lines);
+
+int bench_write_file_fmt(const char *path, size_t body_lines, int format);
+
+#endif
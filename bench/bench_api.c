@@ -0,0 +1,165 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "bench.h"
+#include "sn1ff.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/*
+ * Results made with libsn1ff, against with sn1ff_client
+ *
+ * One op is one result of "size" lines: begun, appended to, given a
+ * status, and written out. Through libsn1ff that is in-process, through
+ * the CLI it is "sn1ff_client -b", then "sn1ff_client -w" fed the lines,
+ * as a check using sn1ff_lib.sh's sn_stream does. Delivery is left out
+ * of both, as it is the same copy to the local sn1ff server.
+ *
+ * Both need /etc/sn1ff/sn1ff.conf, and the CLI bin/sn1ff_client, else
+ * they are skipped
+ */
+
+#define CLIENT_PATH "./bin/sn1ff_client"
+#define CONF_PATH "/etc/sn1ff/sn1ff.conf"
+
+static size_t LINES = 0;
+
+static int setup_lib(size_t size) {
+  LINES = size;
+  if (access(CONF_PATH, R_OK) != 0) {
+    fprintf(stderr, "Needs -> %s <-\n", CONF_PATH);
+    return BENCH_SKIP;
+  }
+  return sn1ff_init("bench_program");
+}
+
+static int setup_cli(size_t size) {
+  if (access(CLIENT_PATH, X_OK) != 0) {
+    fprintf(stderr, "Needs -> %s <-, run make sn1ff_client\n", CLIENT_PATH);
+    return BENCH_SKIP;
+  }
+  return setup_lib(size);
+}
+
+static void teardown_api(void) {}
+
+static void op_result_lib(size_t i) {
+  (void)i;
+  char line[64];
+
+  sn1ff_result *result = sn1ff_result_begin("bench/api");
+  if (result == NULL)
+    return;
+
+  for (size_t n = 0; n < LINES; n++) {
+    snprintf(line, sizeof(line), "line %zu of the check's output", n);
+    sn1ff_result_append(result, line);
+  }
+  sn1ff_result_set_status(result, SN1FF_OKAY);
+  sn1ff_result_finish(result);
+  sn1ff_result_free(result); // Deletes the undelivered file
+}
+
+/**
+ * Run the client, with its stdin and stdout on pipes if given. The
+ * parent's end of the pipe is closed in the child, else the client
+ * never sees EOF on stdin
+ *
+ * @return  pid, -1 on error
+ */
+static pid_t run_client(char *const argv[], int stdin_fd, int stdout_fd,
+                        int parent_fd) {
+  pid_t pid = fork();
+  if (pid == 0) {
+    if (stdin_fd != -1)
+      dup2(stdin_fd, STDIN_FILENO);
+    if (stdout_fd != -1)
+      dup2(stdout_fd, STDOUT_FILENO);
+    close(parent_fd);
+    execv(argv[0], argv);
+    _exit(127);
+  }
+  return pid;
+}
+
+static void op_result_cli(size_t i) {
+  (void)i;
+  int out_pipe[2];
+  int in_pipe[2];
+  char path[512] = {'\0'};
+
+  // sn1ff_client -b, prints the file path
+
+  if (pipe(out_pipe) != 0)
+    return;
+
+  char *begin_argv[] = {CLIENT_PATH, "-b", "-i", "bench/api", NULL};
+  pid_t pid = run_client(begin_argv, -1, out_pipe[1], out_pipe[0]);
+  close(out_pipe[1]);
+
+  FILE *out = fdopen(out_pipe[0], "r");
+  if (out != NULL) {
+    if (fgets(path, sizeof(path), out) != NULL)
+      path[strcspn(path, "\n")] = '\0';
+    fclose(out);
+  }
+  waitpid(pid, NULL, 0);
+  if (path[0] == '\0')
+    return;
+
+  // sn1ff_client -w, fed the lines
+
+  if (pipe(in_pipe) != 0)
+    return;
+
+  char *stream_argv[] = {CLIENT_PATH, "-w", "-f", path, NULL};
+  pid = run_client(stream_argv, in_pipe[0], -1, in_pipe[1]);
+  close(in_pipe[0]);
+
+  FILE *in = fdopen(in_pipe[1], "w");
+  if (in != NULL) {
+    for (size_t n = 0; n < LINES; n++)
+      fprintf(in, "message line %zu of the check's output\n", n);
+    fclose(in);
+  }
+  waitpid(pid, NULL, 0);
+
+  unlink(path);
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Table                                                          |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+const BENCH BENCH_API[] = {
+    {"sn1ff_result_lib", setup_lib, op_result_lib, teardown_api},
+    {"sn1ff_result_cli", setup_cli, op_result_cli, teardown_api},
+    {NULL, NULL, NULL, NULL}};
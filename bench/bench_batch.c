@@ -0,0 +1,133 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "bench.h"
+#include "sn_batch.h"
+#include "sn_file.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * Cleaner deletes, one sn_file_delete per file against sn_batch unlinks
+ *
+ * One op is a cleaner pass over "size" expired files. Each pass first links
+ * the files back into place from a template dir, the same for both
+ */
+
+#define BENCH_NAME_LENGTH 80
+
+static size_t SIZE = 0;
+static char (*NAMES)[BENCH_NAME_LENGTH] = NULL;
+static char TEMPLATE_DIR[300];
+static char WATCH_DIR[300];
+static Batch BATCH;
+
+static int setup_batch(size_t size) {
+  SIZE = size;
+  NAMES = malloc(size * sizeof(*NAMES));
+  if (NAMES == NULL)
+    return -1;
+
+  snprintf(TEMPLATE_DIR, sizeof(TEMPLATE_DIR), "%s/template", bench_tmp_dir());
+  snprintf(WATCH_DIR, sizeof(WATCH_DIR), "%s/watch", bench_tmp_dir());
+  mkdir(TEMPLATE_DIR, 0700);
+  mkdir(WATCH_DIR, 0700);
+
+  for (size_t i = 0; i < size; i++) {
+    char path[400];
+    snprintf(NAMES[i], BENCH_NAME_LENGTH,
+             "%08zx-0000-0000-0000-000000000000_OKAY_1742198614.snff", i);
+    snprintf(path, sizeof(path), "%s/%s", TEMPLATE_DIR, NAMES[i]);
+    if (bench_write_file(path, 20) != 0)
+      return -1;
+  }
+
+  return sn_batch_init(&BATCH, SN_BATCH_CAPACITY);
+}
+
+static void teardown_batch(void) {
+  char path[400];
+  for (size_t i = 0; i < SIZE; i++) {
+    snprintf(path, sizeof(path), "%s/%s", TEMPLATE_DIR, NAMES[i]);
+    unlink(path);
+    snprintf(path, sizeof(path), "%s/%s", WATCH_DIR, NAMES[i]);
+    unlink(path);
+  }
+  rmdir(TEMPLATE_DIR);
+  rmdir(WATCH_DIR);
+
+  sn_batch_free(&BATCH);
+  free(NAMES);
+  NAMES = NULL;
+}
+
+static void relink_files(void) {
+  char from[400];
+  char to[400];
+  for (size_t i = 0; i < SIZE; i++) {
+    snprintf(from, sizeof(from), "%s/%s", TEMPLATE_DIR, NAMES[i]);
+    snprintf(to, sizeof(to), "%s/%s", WATCH_DIR, NAMES[i]);
+    link(from, to);
+  }
+}
+
+static void op_delete_pass(size_t i) {
+  (void)i;
+  relink_files();
+  for (size_t n = 0; n < SIZE; n++)
+    sn_file_delete(WATCH_DIR, NAMES[n]);
+}
+
+static void op_batch_pass(size_t i) {
+  (void)i;
+  char path[SN_BATCH_PATH_LENGTH];
+
+  relink_files();
+  for (size_t n = 0; n < SIZE; n++) {
+    snprintf(path, sizeof(path), "%s/%s", WATCH_DIR, NAMES[n]);
+    if (sn_batch_add_unlink(&BATCH, path, false) == -1) {
+      sn_batch_submit(&BATCH);
+      sn_batch_reset(&BATCH);
+      sn_batch_add_unlink(&BATCH, path, false);
+    }
+  }
+  sn_batch_submit(&BATCH);
+  sn_batch_reset(&BATCH);
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Table                                                          |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+const BENCH BENCH_BATCH[] = {
+    {"cleaner_pass_sn_file_delete", setup_batch, op_delete_pass,
+     teardown_batch},
+    {"cleaner_pass_sn_batch", setup_batch, op_batch_pass, teardown_batch},
+    {NULL, NULL, NULL, NULL}};
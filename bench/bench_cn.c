@@ -0,0 +1,223 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "bench.h"
+#include "cn_file.h"
+#include "cn_hash.h"
+#include "cn_multistr.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/*
+ * Benchmarks for the cn_ routines
+ */
+
+#define BENCH_STR_LENGTH 80
+
+static size_t SIZE = 0;
+static char (*STRS)[BENCH_STR_LENGTH] = NULL;
+static MultiString MS;
+static char *BUFFER = NULL;
+static char *CONTENT = NULL;
+static size_t CONTENT_LENGTH = 0;
+static char FILE_PATH[256];
+
+/**
+ * Generate "size" strings, in the form of sn1ff file names
+ */
+static int gen_strs(size_t size) {
+  SIZE = size;
+  STRS = malloc(size * sizeof(*STRS));
+  if (STRS == NULL)
+    return -1;
+
+  for (size_t i = 0; i < size; i++)
+    snprintf(STRS[i], BENCH_STR_LENGTH,
+             "%08x-0380-4af3-a6cc-144c82aa31a7_OKAY_1742198614.snff",
+             (unsigned int)i);
+
+  return 0;
+}
+
+static void free_strs(void) {
+  free(STRS);
+  STRS = NULL;
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | cn_multistr                                                    |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+static int setup_append(size_t size) {
+  cn_multistr_init(&MS);
+  return gen_strs(size);
+}
+
+static void op_append(size_t i) {
+  // Start again, once "size" strings have been appended
+
+  if (MS.num_strings == SIZE) {
+    cn_multistr_free(&MS);
+    cn_multistr_init(&MS);
+  }
+  cn_multistr_append(&MS, STRS[i % SIZE]);
+}
+
+static void teardown_ms(void) {
+  cn_multistr_free(&MS);
+  free_strs();
+  free(BUFFER);
+  BUFFER = NULL;
+}
+
+static int setup_filled(size_t size) {
+  if (gen_strs(size) != 0)
+    return -1;
+
+  cn_multistr_init(&MS);
+  for (size_t i = 0; i < size; i++)
+    cn_multistr_append(&MS, STRS[i]);
+
+  BUFFER = malloc(cn_multistr_reqd_buffsize(&MS));
+  if (BUFFER == NULL)
+    return -1;
+
+  cn_multistr_serialize(&MS, BUFFER);
+  return 0;
+}
+
+static volatile size_t SINK = 0;
+
+static void op_getstr(size_t i) {
+  SINK += (size_t)cn_multistr_getstr(&MS, i % SIZE)[0];
+}
+
+static void op_serialize(size_t i) {
+  (void)i;
+  SINK += cn_multistr_serialize(&MS, BUFFER);
+}
+
+static void op_deserialize(size_t i) {
+  (void)i;
+  MultiString ms;
+  cn_multistr_deserialize(&ms, BUFFER);
+  SINK += ms.num_strings;
+  cn_multistr_free(&ms);
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | cn_file                                                        |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+/**
+ * File of "size" lines, each with some non printable characters to be
+ * cleaned
+ */
+static int setup_clean(size_t size) {
+  snprintf(FILE_PATH, sizeof(FILE_PATH), "%s/clean.txt", bench_tmp_dir());
+
+  CONTENT = malloc(size * BENCH_STR_LENGTH + 1);
+  if (CONTENT == NULL)
+    return -1;
+
+  CONTENT_LENGTH = 0;
+  for (size_t i = 0; i < size; i++)
+    CONTENT_LENGTH += sprintf(CONTENT + CONTENT_LENGTH,
+                              "Line %6zu \x01\x02 caf\xc3\xa9 \x1b[0m text\n", i);
+
+  return 0;
+}
+
+static void op_clean(size_t i) {
+  (void)i;
+
+  // Restore the uncleaned content, as cn_file_clean rewrites the file
+
+  FILE *file = fopen(FILE_PATH, "w");
+  if (file == NULL)
+    return;
+  fwrite(CONTENT, 1, CONTENT_LENGTH, file);
+  fclose(file);
+
+  cn_file_clean(FILE_PATH);
+}
+
+static void teardown_clean(void) {
+  unlink(FILE_PATH);
+  free(CONTENT);
+  CONTENT = NULL;
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | cn_hash                                                        |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+/**
+ * Hash the body of a sn1ff file of "size" lines, as the greeter does to
+ * spot repeated results
+ */
+static int setup_hash(size_t size) {
+  CONTENT_LENGTH = size * BENCH_STR_LENGTH;
+  CONTENT = malloc(CONTENT_LENGTH + 1);
+  if (CONTENT == NULL)
+    return -1;
+
+  for (size_t i = 0; i < CONTENT_LENGTH; i++)
+    CONTENT[i] = (char)(' ' + i % 95);
+  return 0;
+}
+
+static void op_hash(size_t i) {
+  SINK += (size_t)cn_hash_xxh64(CONTENT, CONTENT_LENGTH, (uint64_t)i);
+}
+
+static void teardown_hash(void) {
+  free(CONTENT);
+  CONTENT = NULL;
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Table                                                          |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+const BENCH BENCH_CN[] = {
+    {"cn_multistr_append", setup_append, op_append, teardown_ms},
+    {"cn_multistr_getstr", setup_filled, op_getstr, teardown_ms},
+    {"cn_multistr_serialize", setup_filled, op_serialize, teardown_ms},
+    {"cn_multistr_deserialize", setup_filled, op_deserialize, teardown_ms},
+    {"cn_file_clean", setup_clean, op_clean, teardown_clean},
+    {"cn_hash_xxh64", setup_hash, op_hash, teardown_hash},
+    {NULL, NULL, NULL, NULL}};
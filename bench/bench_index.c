@@ -0,0 +1,148 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "bench.h"
+#include "sn_index.h"
+#include "sn_shard.h"
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * Cold against warm start of the "watch" dir index (see sn_index.h), over
+ * a dir of "size" files (e.g. -s 500000):
+ *   - cold  every dir is scanned, and every name parsed
+ *   - warm  the checkpoint is loaded, and only changed dirs rescanned
+ */
+
+#define BENCH_NAME_LENGTH 80
+
+static size_t SIZE = 0;
+static int SHARDS = SN_SHARD_NONE;
+static char DIR_PATH[300];
+static char INDEX_PATH[300];
+static volatile size_t SINK = 0;
+
+static void file_path(size_t i, char *path, size_t path_sz) {
+  char name[BENCH_NAME_LENGTH];
+  uint32_t hash = (uint32_t)(i * 2654435761u);
+  snprintf(name, sizeof(name),
+           "%08x-%04zx-0000-0000-000000000000_OKAY_%010zu.snff",
+           (unsigned int)hash, i & 0xffff, 1742198614 + i);
+  sn_shard_path(DIR_PATH, name, SHARDS, path, path_sz);
+}
+
+/**
+ * Fill the dir, age its mtimes so the index trusts them, and checkpoint it
+ */
+static int setup_index(size_t size, int shards) {
+  SIZE = size;
+  SHARDS = shards;
+
+  snprintf(DIR_PATH, sizeof(DIR_PATH), "%s/index", bench_tmp_dir());
+  snprintf(INDEX_PATH, sizeof(INDEX_PATH), "%s/watch.idx", bench_tmp_dir());
+  mkdir(DIR_PATH, 0700);
+  if (sn_shard_create_dirs(DIR_PATH, shards) != 0)
+    return -1;
+
+  char path[512];
+  for (size_t i = 0; i < size; i++) {
+    file_path(i, path, sizeof(path));
+    int fd = open(path, O_WRONLY | O_CREAT, S_IRUSR | S_IWUSR);
+    if (fd == -1)
+      return -1;
+    close(fd);
+  }
+
+  struct timespec times[2] = {{1000000000, 0}, {1000000000, 0}};
+  utimensat(AT_FDCWD, DIR_PATH, times, 0);
+  for (int i = 0; i < shards; i++) {
+    sn_shard_index_dir(DIR_PATH, shards, i, path, sizeof(path));
+    utimensat(AT_FDCWD, path, times, 0);
+  }
+
+  Index index;
+  if (sn_index_init(&index, DIR_PATH, shards) != 0)
+    return -1;
+  int result = sn_index_refresh(&index) < 0 ||
+               sn_index_save(&index, INDEX_PATH) != 0;
+  sn_index_free(&index);
+  return result ? -1 : 0;
+}
+
+static int setup_flat(size_t size) {
+  return setup_index(size, SN_SHARD_NONE);
+}
+static int setup_256(size_t size) { return setup_index(size, SN_SHARD_256); }
+
+static void teardown_index(void) {
+  char path[512];
+  for (size_t i = 0; i < SIZE; i++) {
+    file_path(i, path, sizeof(path));
+    unlink(path);
+  }
+  for (int i = 0; i < SHARDS; i++) {
+    sn_shard_index_dir(DIR_PATH, SHARDS, i, path, sizeof(path));
+    rmdir(path);
+  }
+  rmdir(DIR_PATH);
+  unlink(INDEX_PATH);
+}
+
+static void op_cold(size_t i) {
+  (void)i;
+  Index index;
+  sn_index_init(&index, DIR_PATH, SHARDS);
+  sn_index_refresh(&index);
+  SINK += index.count;
+  sn_index_free(&index);
+}
+
+static void op_warm(size_t i) {
+  (void)i;
+  Index index;
+  sn_index_init(&index, DIR_PATH, SHARDS);
+  sn_index_load(&index, INDEX_PATH);
+  sn_index_refresh(&index);
+  SINK += index.count;
+  sn_index_free(&index);
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Table                                                          |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+const BENCH BENCH_INDEX[] = {
+    {"index_cold_start_flat", setup_flat, op_cold, teardown_index},
+    {"index_warm_start_flat", setup_flat, op_warm, teardown_index},
+    {"index_cold_start_256", setup_256, op_cold, teardown_index},
+    {"index_warm_start_256", setup_256, op_warm, teardown_index},
+    {NULL, NULL, NULL, NULL}};
@@ -0,0 +1,212 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "bench.h"
+#include "sn_ingest.h"
+#include "sn_shard.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * Greeter ingest throughput, against the number of workers
+ *
+ * One op is a full greeter pass: "size" files are linked into the "upload"
+ * dir, submitted to the pool, published to "watch" and "export", deleted,
+ * and then unpublished again.
+ * The ns/op of each worker count gives the scaling, and the journaled
+ * pass the cost of the journal's group commits and per batch syncs
+ */
+
+#define BENCH_NAME_LENGTH 80
+#define BENCH_BODY_LINES 20
+
+static size_t SIZE = 0;
+static char (*NAMES)[BENCH_NAME_LENGTH] = NULL;
+static char BASE_DIR[256];
+static char TEMPLATE_DIR[300];
+static char UPLOAD_DIR[300];
+static char WATCH_DIR[300];
+static char EXPORT_DIR[300];
+static Ingest INGEST;
+static Journal JOURNAL;
+static bool JOURNALED = false;
+static char JOURNAL_PATH[300];
+
+static void remove_files(const char *dir) {
+  char path[400];
+  for (size_t i = 0; i < SIZE; i++) {
+    snprintf(path, sizeof(path), "%s/%s", dir, NAMES[i]);
+    unlink(path);
+  }
+  rmdir(dir);
+}
+
+static int setup_ingest(size_t size, size_t num_workers, bool journaled) {
+  SIZE = size;
+  INGEST.workers = NULL;
+  NAMES = malloc(size * sizeof(*NAMES));
+  if (NAMES == NULL)
+    return -1;
+
+  snprintf(BASE_DIR, sizeof(BASE_DIR), "%s/ingest", bench_tmp_dir());
+  snprintf(TEMPLATE_DIR, sizeof(TEMPLATE_DIR), "%s/template", BASE_DIR);
+  snprintf(UPLOAD_DIR, sizeof(UPLOAD_DIR), "%s/upload", BASE_DIR);
+  snprintf(WATCH_DIR, sizeof(WATCH_DIR), "%s/watch", BASE_DIR);
+  snprintf(EXPORT_DIR, sizeof(EXPORT_DIR), "%s/export", BASE_DIR);
+  mkdir(BASE_DIR, 0700);
+  mkdir(TEMPLATE_DIR, 0700);
+  mkdir(UPLOAD_DIR, 0700);
+  mkdir(WATCH_DIR, 0700);
+  mkdir(EXPORT_DIR, 0700);
+
+  for (size_t i = 0; i < size; i++) {
+    char path[400];
+    snprintf(NAMES[i], BENCH_NAME_LENGTH,
+             "%08zx-0000-0000-0000-000000000000_OKAY_1742198614.snff", i);
+    snprintf(path, sizeof(path), "%s/%s", TEMPLATE_DIR, NAMES[i]);
+    if (bench_write_file(path, BENCH_BODY_LINES) != 0)
+      return -1;
+  }
+
+  JOURNALED = journaled;
+  snprintf(JOURNAL_PATH, sizeof(JOURNAL_PATH), "%s/ingest.journal", BASE_DIR);
+  if (journaled && sn_journal_open(&JOURNAL, JOURNAL_PATH) != 0)
+    return -1;
+
+  return sn_ingest_start(&INGEST, UPLOAD_DIR, WATCH_DIR, EXPORT_DIR,
+                         SN_SHARD_NONE, journaled ? &JOURNAL : NULL,
+                         num_workers);
+}
+
+static int setup_workers_1(size_t size) {
+  return setup_ingest(size, 1, false);
+}
+static int setup_workers_2(size_t size) {
+  return setup_ingest(size, 2, false);
+}
+static int setup_workers_4(size_t size) {
+  return setup_ingest(size, 4, false);
+}
+static int setup_workers_8(size_t size) {
+  return setup_ingest(size, 8, false);
+}
+static int setup_journaled_4(size_t size) {
+  return setup_ingest(size, 4, true);
+}
+
+static void teardown_ingest(void) {
+  if (INGEST.workers != NULL)
+    sn_ingest_stop(&INGEST);
+  if (JOURNALED) {
+    sn_journal_close(&JOURNAL);
+    unlink(JOURNAL_PATH);
+    JOURNALED = false;
+  }
+
+  remove_files(TEMPLATE_DIR);
+  remove_files(UPLOAD_DIR);
+  remove_files(WATCH_DIR);
+  remove_files(EXPORT_DIR);
+  rmdir(BASE_DIR);
+
+  free(NAMES);
+  NAMES = NULL;
+}
+
+/**
+ * Remove the published files, so every pass publishes new files, as the
+ * greeter does
+ */
+static void unpublish_files(void) {
+  char path[400];
+  for (size_t n = 0; n < SIZE; n++) {
+    snprintf(path, sizeof(path), "%s/%s", WATCH_DIR, NAMES[n]);
+    unlink(path);
+    snprintf(path, sizeof(path), "%s/%s", EXPORT_DIR, NAMES[n]);
+    unlink(path);
+  }
+}
+
+static void op_ingest_pass(size_t i) {
+  (void)i;
+  char from[400];
+  char to[400];
+
+  for (size_t n = 0; n < SIZE; n++) {
+    snprintf(from, sizeof(from), "%s/%s", TEMPLATE_DIR, NAMES[n]);
+    snprintf(to, sizeof(to), "%s/%s", UPLOAD_DIR, NAMES[n]);
+    link(from, to);
+    sn_ingest_submit(&INGEST, NAMES[n]);
+  }
+
+  sn_ingest_drain(&INGEST);
+  if (JOURNALED)
+    sn_journal_reset(&JOURNAL);
+  unpublish_files();
+}
+
+/**
+ * The same pass, one sn_ingest_file per file on this thread, as before the
+ * worker pool and batching
+ */
+static void op_per_file_pass(size_t i) {
+  (void)i;
+  char from[400];
+  char to[400];
+
+  for (size_t n = 0; n < SIZE; n++) {
+    snprintf(from, sizeof(from), "%s/%s", TEMPLATE_DIR, NAMES[n]);
+    snprintf(to, sizeof(to), "%s/%s", UPLOAD_DIR, NAMES[n]);
+    link(from, to);
+    sn_ingest_file(UPLOAD_DIR, WATCH_DIR, EXPORT_DIR, SN_SHARD_NONE,
+                   NAMES[n]);
+  }
+  unpublish_files();
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Table                                                          |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+const BENCH BENCH_INGEST[] = {
+    {"sn_ingest_pass_per_file", setup_workers_1, op_per_file_pass,
+     teardown_ingest},
+    {"sn_ingest_pass_workers_1", setup_workers_1, op_ingest_pass,
+     teardown_ingest},
+    {"sn_ingest_pass_workers_2", setup_workers_2, op_ingest_pass,
+     teardown_ingest},
+    {"sn_ingest_pass_workers_4", setup_workers_4, op_ingest_pass,
+     teardown_ingest},
+    {"sn_ingest_pass_workers_8", setup_workers_8, op_ingest_pass,
+     teardown_ingest},
+    {"sn_ingest_pass_journaled_4", setup_journaled_4, op_ingest_pass,
+     teardown_ingest},
+    {NULL, NULL, NULL, NULL}};
@@ -0,0 +1,165 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "bench.h"
+#include "sn_file.h"
+#include "sn_trigram.h"
+#include <dirent.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * Finding the results with a line, over "size" result files (e.g.
+ * -s 20000), 1 in 1000 with the line:
+ *   - scan   every file is read, as "grep -r" does
+ *   - index  the trigram index is searched (see sn_trigram.h), reading
+ *            only the documents with all the trigrams of the line
+ */
+
+#define BENCH_NAME_LENGTH 80
+#define BENCH_BODY_LINES 20
+#define BENCH_NEEDLE "mallory"
+
+static size_t SIZE = 0;
+static char DIR_PATH[300];
+static char INDEX_PATH[300];
+static volatile size_t SINK = 0;
+
+static void file_path(size_t i, char *path, size_t path_sz) {
+  uint32_t hash = (uint32_t)(i * 2654435761u);
+  snprintf(path, path_sz,
+           "%s/%08x-%04zx-0000-0000-000000000000_OKAY_%010zu.snff", DIR_PATH,
+           (unsigned int)hash, i & 0xffff, 1742198614 + i);
+}
+
+static int setup_search(size_t size) {
+  SIZE = size;
+  snprintf(DIR_PATH, sizeof(DIR_PATH), "%s/search_files", bench_tmp_dir());
+  snprintf(INDEX_PATH, sizeof(INDEX_PATH), "%s/search", bench_tmp_dir());
+  mkdir(DIR_PATH, 0700);
+
+  TrigramIndex index;
+  if (sn_trigram_open(&index, INDEX_PATH) != 0)
+    return -1;
+
+  HEADER hdr;
+
+  char path[512];
+  int result = 0;
+  for (size_t i = 0; i < size && result == 0; i++) {
+    file_path(i, path, sizeof(path));
+    result = bench_write_file(path, BENCH_BODY_LINES);
+    if (result == 0 && i % 1000 == 0) {
+      FILE *file = fopen(path, "a");
+      if (file == NULL)
+        return -1;
+      fprintf(file,
+              "Accepted password for " BENCH_NEEDLE " from 10.0.%zu.%zu\n",
+              i / 256 % 256, i % 256);
+      fclose(file);
+    }
+    char *body = NULL;
+    size_t body_len = 0;
+    if (result == 0 && sn_file_read_header(path, &hdr) == 0 &&
+        sn_file_read_body(path, SN_FILE_MAX_RAW_BODY, &body, &body_len) >=
+            0) {
+      result = sn_trigram_add(&index, &hdr, path + 1,
+                              (time_t)(1742198614 + i), body, body_len);
+      free(body);
+    }
+  }
+
+  if (result == 0 && sn_trigram_flush(&index) < 0)
+    result = -1;
+  sn_trigram_close(&index);
+  return result;
+}
+
+static void teardown_search(void) {
+  char path[600];
+  for (size_t i = 0; i < SIZE; i++) {
+    file_path(i, path, sizeof(path));
+    unlink(path);
+  }
+  rmdir(DIR_PATH);
+
+  DIR *d = opendir(INDEX_PATH);
+  if (d != NULL) {
+    struct dirent *entry;
+    while ((entry = readdir(d)) != NULL) {
+      snprintf(path, sizeof(path), "%s/%s", INDEX_PATH, entry->d_name);
+      unlink(path);
+    }
+    closedir(d);
+  }
+  rmdir(INDEX_PATH);
+}
+
+static void op_scan(size_t i) {
+  (void)i;
+  char path[512];
+  char line[256];
+  for (size_t f = 0; f < SIZE; f++) {
+    file_path(f, path, sizeof(path));
+    FILE *file = fopen(path, "r");
+    if (file == NULL)
+      continue;
+    while (fgets(line, sizeof(line), file) != NULL) {
+      if (strstr(line, BENCH_NEEDLE) != NULL)
+        SINK++;
+    }
+    fclose(file);
+  }
+}
+
+static int count_match(const TrigramMatch *match, void *arg) {
+  (void)match;
+  (void)arg;
+  SINK++;
+  return 0;
+}
+
+static void op_index(size_t i) {
+  (void)i;
+  TrigramQuery query = {BENCH_NEEDLE, SN_TRIGRAM_FIXED, NULL, NULL, 0,
+                        (time_t)1 << 40};
+  sn_trigram_search(INDEX_PATH, &query, count_match, NULL);
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Table                                                          |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+const BENCH BENCH_SEARCH[] = {
+    {"search_scan_files", setup_search, op_scan, teardown_search},
+    {"search_trigram_index", setup_search, op_index, teardown_search},
+    {NULL, NULL, NULL, NULL}};
@@ -0,0 +1,149 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "bench.h"
+#include "cn_multistr.h"
+#include "sn_dir.h"
+#include "sn_shard.h"
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * Flat against sharded "watch" dir layout (see sn_shard.h)
+ *
+ * The dir is first filled with "size" files (e.g. -s 1000000), then:
+ *   - create_unlink  one more file is created and unlinked
+ *   - list           every file is listed
+ */
+
+#define BENCH_NAME_LENGTH 80
+
+static size_t SIZE = 0;
+static int SHARDS = SN_SHARD_NONE;
+static char DIR_PATH[300];
+static volatile size_t SINK = 0;
+
+/**
+ * A GUID like name, spread over the shards as real GUIDs are
+ */
+static void gen_name(size_t i, char *name) {
+  uint32_t hash = (uint32_t)(i * 2654435761u);
+  snprintf(name, BENCH_NAME_LENGTH,
+           "%08x-%04zx-0000-0000-000000000000_OKAY_1742198614.snff",
+           (unsigned int)hash, i & 0xffff);
+}
+
+static int create_file(size_t i) {
+  char name[BENCH_NAME_LENGTH];
+  char path[512];
+  gen_name(i, name);
+  sn_shard_path(DIR_PATH, name, SHARDS, path, sizeof(path));
+
+  int fd = open(path, O_WRONLY | O_CREAT, S_IRUSR | S_IWUSR);
+  if (fd == -1)
+    return -1;
+  close(fd);
+  return 0;
+}
+
+static void unlink_file(size_t i) {
+  char name[BENCH_NAME_LENGTH];
+  char path[512];
+  gen_name(i, name);
+  sn_shard_path(DIR_PATH, name, SHARDS, path, sizeof(path));
+  unlink(path);
+}
+
+static int setup_shards(size_t size, int shards) {
+  SIZE = size;
+  SHARDS = shards;
+
+  snprintf(DIR_PATH, sizeof(DIR_PATH), "%s/shard", bench_tmp_dir());
+  mkdir(DIR_PATH, 0700);
+  if (sn_shard_create_dirs(DIR_PATH, shards) != 0)
+    return -1;
+
+  for (size_t i = 0; i < size; i++) {
+    if (create_file(i) != 0)
+      return -1;
+  }
+  return 0;
+}
+
+static int setup_flat(size_t size) {
+  return setup_shards(size, SN_SHARD_NONE);
+}
+static int setup_256(size_t size) { return setup_shards(size, SN_SHARD_256); }
+static int setup_4096(size_t size) {
+  return setup_shards(size, SN_SHARD_4096);
+}
+
+static void teardown_shards(void) {
+  for (size_t i = 0; i < SIZE; i++)
+    unlink_file(i);
+
+  char shard_dir[512];
+  for (int i = 0; i < SHARDS; i++) {
+    sn_shard_index_dir(DIR_PATH, SHARDS, i, shard_dir, sizeof(shard_dir));
+    rmdir(shard_dir);
+  }
+  rmdir(DIR_PATH);
+}
+
+static void op_create_unlink(size_t i) {
+  create_file(SIZE + i);
+  unlink_file(SIZE + i);
+}
+
+static void op_list(size_t i) {
+  (void)i;
+  MultiString ms;
+  cn_multistr_init(&ms);
+  sn_dir_list_files_sharded(DIR_PATH, SHARDS, &ms);
+  SINK += ms.num_strings;
+  cn_multistr_free(&ms);
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Table                                                          |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+const BENCH BENCH_SHARD[] = {
+    {"shard_create_unlink_flat", setup_flat, op_create_unlink,
+     teardown_shards},
+    {"shard_create_unlink_256", setup_256, op_create_unlink, teardown_shards},
+    {"shard_create_unlink_4096", setup_4096, op_create_unlink,
+     teardown_shards},
+    {"shard_list_flat", setup_flat, op_list, teardown_shards},
+    {"shard_list_256", setup_256, op_list, teardown_shards},
+    {"shard_list_4096", setup_4096, op_list, teardown_shards},
+    {NULL, NULL, NULL, NULL}};
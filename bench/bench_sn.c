@@ -0,0 +1,300 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "bench.h"
+#include "cn_multistr.h"
+#include "sn_cname.h"
+#include "sn_dir.h"
+#include "sn_file.h"
+#include "sn_fname.h"
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * Benchmarks for the sn_ routines
+ */
+
+#define BENCH_NAME_LENGTH 128
+
+static const char *STATUSES[] = {"ALRT", "WARN", "OKAY", "NONE"};
+
+static size_t SIZE = 0;
+static char (*NAMES)[BENCH_NAME_LENGTH] = NULL;
+static FName *FNAMES = NULL;
+static FILE_DATA FILE_DATA_BUF;
+static char DIR_PATH[256];
+static char DIR_PATH_TO[256];
+static char FILE_PATH[FNAME_PATH_LENGTH_D + BENCH_NAME_LENGTH];
+
+static volatile size_t SINK = 0;
+
+/**
+ * Generate "size" valid sn1ff file names:
+ *   <guid>_<status>_<epoch>.snff
+ */
+static int gen_names(size_t size) {
+  SIZE = size;
+  NAMES = malloc(size * sizeof(*NAMES));
+  if (NAMES == NULL)
+    return -1;
+
+  for (size_t i = 0; i < size; i++) {
+    uuid_t guid_bin;
+    char guid_str[CNAME_GUID_LENGTH_D];
+    uuid_generate(guid_bin);
+    uuid_unparse(guid_bin, guid_str);
+    snprintf(NAMES[i], BENCH_NAME_LENGTH, "%s_%s_%ld.snff", guid_str,
+             STATUSES[i % 4], 1742198614L + (long)i);
+  }
+
+  return 0;
+}
+
+static void teardown_names(void) {
+  free(NAMES);
+  NAMES = NULL;
+  free(FNAMES);
+  FNAMES = NULL;
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | sn_cname / sn_fname                                            |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+static void op_parse_name(size_t i) {
+  CName cname;
+  sn_cname_parse_name(NAMES[i % SIZE], &cname);
+  SINK += (size_t)cname.epoch.bin;
+}
+
+/*
+ * The sscanf / uuid_parse / strtol parse sn_cname_parse_name replaced, as a
+ * reference
+ */
+static void op_parse_name_sscanf(size_t i) {
+  char guid_str[CNAME_GUID_LENGTH_D];
+  char status[CNAME_STATUS_LENGTH_D];
+  char epoch_str[CNAME_EPOCH_LENGTH_D];
+  uuid_t guid_bin;
+
+  if (sscanf(NAMES[i % SIZE], "%36s_%4s_%10s.snff", guid_str, status,
+             epoch_str) != 3 ||
+      uuid_parse(guid_str, guid_bin) != 0)
+    return;
+  SINK += (size_t)strtol(epoch_str, NULL, 10) + guid_bin[0];
+}
+
+static int setup_fnames(size_t size) {
+  SIZE = size;
+  FNAMES = malloc(size * sizeof(FName));
+  if (FNAMES == NULL)
+    return -1;
+
+  for (size_t i = 0; i < size; i++) {
+    sn_fname_init(&FNAMES[i]);
+    sn_fname_set_dir(&FNAMES[i], "/home/chroot/sn1ff/upload/watch");
+    sn_cname_set_status(&FNAMES[i].cname, STATUSES[i % 4]);
+  }
+
+  return 0;
+}
+
+static void op_get_path(size_t i) {
+  char path[FNAME_PATH_LENGTH_D + BENCH_NAME_LENGTH];
+  sn_fname_get_path(&FNAMES[i % SIZE], path);
+  SINK += (size_t)path[0];
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | sn_file                                                        |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+/**
+ * One sn1ff file, with "size" body lines, in the given format
+ */
+static int setup_file_fmt(size_t size, int format) {
+  if (gen_names(1) != 0)
+    return -1;
+
+  snprintf(DIR_PATH, sizeof(DIR_PATH), "%s/from", bench_tmp_dir());
+  snprintf(DIR_PATH_TO, sizeof(DIR_PATH_TO), "%s/to", bench_tmp_dir());
+  mkdir(DIR_PATH, 0700);
+  mkdir(DIR_PATH_TO, 0700);
+
+  snprintf(FILE_PATH, sizeof(FILE_PATH), "%s/%s", DIR_PATH, NAMES[0]);
+  return bench_write_file_fmt(FILE_PATH, size, format);
+}
+
+static int setup_file(size_t size) {
+  return setup_file_fmt(size, SN_FILE_FORMAT_V1);
+}
+
+static int setup_file_v2(size_t size) {
+  return setup_file_fmt(size, SN_FILE_FORMAT_V2);
+}
+
+static void teardown_file(void) {
+  char path[FNAME_PATH_LENGTH_D + BENCH_NAME_LENGTH];
+  snprintf(path, sizeof(path), "%s/%s", DIR_PATH_TO, NAMES[0]);
+  unlink(path);
+  unlink(FILE_PATH);
+  rmdir(DIR_PATH);
+  rmdir(DIR_PATH_TO);
+  teardown_names();
+}
+
+static void op_read(size_t i) {
+  (void)i;
+  sn_file_read(FILE_PATH, &FILE_DATA_BUF);
+  SINK += FILE_DATA_BUF.body_lines;
+}
+
+static void op_read_header(size_t i) {
+  (void)i;
+  HEADER hdr;
+  sn_file_read_header(FILE_PATH, &hdr);
+  SINK += (size_t)hdr.checkid[0];
+}
+
+static void op_copy(size_t i) {
+  (void)i;
+  SINK += (size_t)sn_file_copy(DIR_PATH, DIR_PATH_TO, NAMES[0]);
+}
+
+static void op_publish(size_t i) {
+  (void)i;
+  SINK += (size_t)sn_file_publish(DIR_PATH, DIR_PATH_TO, NAMES[0]);
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | sn_dir                                                         |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+/**
+ * Directory of "size" sn1ff files, plus some that are not
+ */
+static int setup_dir(size_t size) {
+  if (gen_names(size) != 0)
+    return -1;
+
+  snprintf(DIR_PATH, sizeof(DIR_PATH), "%s/dir", bench_tmp_dir());
+  mkdir(DIR_PATH, 0700);
+
+  for (size_t i = 0; i < size; i++) {
+    char path[FNAME_PATH_LENGTH_D + BENCH_NAME_LENGTH];
+    snprintf(path, sizeof(path), "%s/%s%s", DIR_PATH, NAMES[i],
+             (i % 10 == 9) ? ".tmp" : "");
+    FILE *file = fopen(path, "w");
+    if (file == NULL)
+      return -1;
+    fclose(file);
+  }
+
+  return 0;
+}
+
+static void teardown_dir(void) {
+  for (size_t i = 0; i < SIZE; i++) {
+    char path[FNAME_PATH_LENGTH_D + BENCH_NAME_LENGTH];
+    snprintf(path, sizeof(path), "%s/%s%s", DIR_PATH, NAMES[i],
+             (i % 10 == 9) ? ".tmp" : "");
+    unlink(path);
+  }
+  rmdir(DIR_PATH);
+  teardown_names();
+}
+
+static void op_list_files(size_t i) {
+  (void)i;
+  MultiString ms;
+  cn_multistr_init(&ms);
+  sn_dir_list_files(DIR_PATH, &ms);
+  SINK += ms.num_strings;
+  cn_multistr_free(&ms);
+}
+
+static int count_name(const char *name, void *arg) {
+  (void)name;
+  (*(size_t *)arg)++;
+  return 0;
+}
+
+static void op_each_file(size_t i) {
+  (void)i;
+  size_t count = 0;
+  sn_dir_each_file(DIR_PATH, count_name, &count);
+  SINK += count;
+}
+
+/*
+ * The readdir scan sn_dir_each_file replaced, as a reference
+ */
+static void op_readdir(size_t i) {
+  (void)i;
+  size_t count = 0;
+  DIR *dir = opendir(DIR_PATH);
+  if (dir == NULL)
+    return;
+
+  struct dirent *entry;
+  while ((entry = readdir(dir)) != NULL) {
+    if (sn_dir_file_has_ext(entry->d_name))
+      count++;
+  }
+  closedir(dir);
+  SINK += count;
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Table                                                          |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+const BENCH BENCH_SN[] = {
+    {"sn_cname_parse_name", gen_names, op_parse_name, teardown_names},
+    {"sscanf_parse_name", gen_names, op_parse_name_sscanf, teardown_names},
+    {"sn_fname_get_path", setup_fnames, op_get_path, teardown_names},
+    {"sn_file_read", setup_file, op_read, teardown_file},
+    {"sn_file_read_v2", setup_file_v2, op_read, teardown_file},
+    {"sn_file_read_header", setup_file, op_read_header, teardown_file},
+    {"sn_file_read_header_v2", setup_file_v2, op_read_header, teardown_file},
+    {"sn_file_copy", setup_file, op_copy, teardown_file},
+    {"sn_file_publish", setup_file, op_publish, teardown_file},
+    {"sn_dir_list_files", setup_dir, op_list_files, teardown_dir},
+    {"sn_dir_each_file", setup_dir, op_each_file, teardown_dir},
+    {"readdir_snff", setup_dir, op_readdir, teardown_dir},
+    {NULL, NULL, NULL, NULL}};
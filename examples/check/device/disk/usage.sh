@@ -121,12 +121,17 @@ WHITELIST=("/mnt/external" "/dev/lxd" "/opt/google/cros-containers" "/dev/.lxd-m
 
 THRESHOLD=95
 CHECK_FAILED=false
+ROOT_USE_PERC=""
 
 # Note: size, used and avail are is not used, from the output from "df"
 
 while read -r filesystem _size _used _avail use_perc mount_point; do
   use_num=${use_perc%\%}
 
+  if [[ "$mount_point" == "/" ]]; then
+    ROOT_USE_PERC="$use_perc"
+  fi
+
   skip=false
   for white in "${WHITELIST[@]}"; do
     if [[ "$mount_point" == *"$white"* ]]; then
@@ -141,6 +146,12 @@ while read -r filesystem _size _used _avail use_perc mount_point; do
   fi
 done < <(df -P | tail -n +2)
 
+# Always given, for the root_used_pct metric (see /etc/sn1ff/metrics.conf)
+
+if [[ -n "$ROOT_USE_PERC" ]]; then
+  echo "Root used: $ROOT_USE_PERC" >>"$SN_FILENAME"
+fi
+
 echo "" >>"$SN_FILENAME"
 
 if [ "$CHECK_FAILED" = true ]; then
@@ -113,7 +113,9 @@ fi
 # |                                                                |
 # '----------------------------------------------------------------'
 
-sn_append_titlebox "$CHECKID" "$SN_FILENAME"
+sn_stream_open "$SN_FILENAME"
+
+sn_stream title "$CHECKID"
 
 # .----------------------------------------------------------------.
 # |                                                                |
@@ -121,11 +123,11 @@ sn_append_titlebox "$CHECKID" "$SN_FILENAME"
 # |                                                                |
 # '----------------------------------------------------------------'
 
-sn_append_first_header "$CHECKID: CHECK FOR 'WORLD WRITEABLE FILES'" "$SN_FILENAME"
+sn_stream first "$CHECKID: CHECK FOR 'WORLD WRITEABLE FILES'"
 
 # Description: Check for world-writable files on the system (excluding mounted filesystems)
 
-echo "Checking for world-writable files..." >>"$SN_FILENAME" 2>&1
+sn_stream message "Checking for world-writable files..."
 
 # Run the find command and store the results
 
@@ -134,11 +136,11 @@ world_writable_files=$(find / -xdev -type f -perm -0002 -exec ls -l {} \; 2>/dev
 # Check if the result is non-empty
 
 if [[ -n "$world_writable_files" ]]; then
-  echo "ERROR: World-writable files found!" >>"$SN_FILENAME" 2>&1
-  echo "$world_writable_files" >>"$SN_FILENAME" 2>&1
+  sn_stream message "ERROR: World-writable files found!"
+  sn_stream_lines <<<"$world_writable_files"
   sn_exit_with_message "FAILED: CHECK FOR FOR 'WORLD WRITEABLE FILES'" "$SN_FILENAME" "ALRT" "$SN_ADDR"
 else
-  echo "No world-writable files found." >>"$SN_FILENAME" 2>&1
+  sn_stream message "No world-writable files found."
 fi
 
 # .----------------------------------------------------------------.
@@ -194,6 +194,43 @@ sn_append_message_center() {
   printf "%*s\n\n\n" $((pad + ${#message})) "$message" >>"$sn_filename" 2>&1
 }
 
+# Streamed appends, through one "sn1ff_client -w" process for the check,
+# rather than subshells and a reopen of the file for each line:
+#
+#   sn_stream_open "$SN_FILENAME"
+#   sn_stream title "$CHECKID"
+#   sn_stream message "Checking ..."
+#   find ... | sn_stream_lines
+#   sn_stream_close
+
+sn_stream_open() {
+  local sn_filename="$1"
+  exec {SN_STREAM_FD}> >(sn1ff_client -w -f "$sn_filename")
+  SN_STREAM_PID=$!
+}
+
+# sn_stream <title|first|header|message|center|trailer> [text]
+sn_stream() {
+  printf "%s %s\n" "$1" "${2:-}" >&"$SN_STREAM_FD"
+}
+
+# Each line read as a message
+sn_stream_lines() {
+  local line
+  while IFS= read -r line; do
+    printf "message %s\n" "$line"
+  done >&"$SN_STREAM_FD"
+}
+
+# Wait for everything streamed to be written to the file
+sn_stream_close() {
+  if [[ -n "${SN_STREAM_FD:-}" ]]; then
+    exec {SN_STREAM_FD}>&-
+    wait "$SN_STREAM_PID" 2>/dev/null || true
+    unset SN_STREAM_FD SN_STREAM_PID
+  fi
+}
+
 # @exit 0 for OKAY
 #       1 for NONE
 #       2 for WARN
@@ -206,6 +243,8 @@ sn_exit_with_message() {
   local exit_code
   declare -i exit_code
 
+  sn_stream_close
+
   sn_append_trailer_line "$sn_filename"
 
   sn_append_message_center "$message" "$sn_filename"
@@ -241,7 +280,11 @@ sn_exit_with_message() {
       ;;
   esac
 
-  if [ -z "$sn_addr" ]; then
+  if [ "${SN1FF_RUNNER:-}" = "1" ]; then
+    # Run by "sn1ff_client run", which sends the file, with the status of
+    # the exit code
+    :
+  elif [ -z "$sn_addr" ]; then
     # Local client, as there is no addr for SCP
     sn1ff_client \
       -e \
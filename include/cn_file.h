@@ -45,10 +45,16 @@ int cn_file_delete(const char *filepath);
 
 int cn_file_chgrp(const char *path, const char *groupname);
 
+int cn_file_fchgrp(int fd, const char *groupname);
+
 int cn_file_mode660(const char *path);
 
+int cn_file_fmode660(int fd);
+
 int cn_file_mode600(const char *path);
 
 int cn_file_clean(const char *filename);
 
+int cn_file_clean_from(const char *filename, long offset);
+
 #endif
@@ -49,4 +49,6 @@ int cn_host_hostname(char *hostname);
 
 int cn_host_utcdt(char *utc_datetime);
 
+int cn_host_utcdt_parse(const char *utc_datetime, time_t *when);
+
 #endif
@@ -0,0 +1,64 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef CN_QUEUE_H
+#define CN_QUEUE_H
+
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stddef.h>
+
+/*
+ * Bounded lock-free multi producer / multi consumer queue, of pointers
+ *
+ * Each cell has a sequence number, which tells producers and consumers if
+ * the cell is free to be written, or ready to be read (D. Vyukov's bounded
+ * MPMC queue). The capacity must be a power of 2
+ */
+
+#define CN_QUEUE_CACHE_LINE 64
+
+typedef struct {
+  atomic_size_t sequence; // Position this cell is ready for
+  void *data;             // Item pointer
+} QueueCell;
+
+typedef struct {
+  QueueCell *cells;
+  size_t mask; // Capacity - 1
+  alignas(CN_QUEUE_CACHE_LINE) atomic_size_t enqueue_pos;
+  alignas(CN_QUEUE_CACHE_LINE) atomic_size_t dequeue_pos;
+} Queue;
+
+int cn_queue_init(Queue *queue, size_t capacity);
+
+void cn_queue_free(Queue *queue);
+
+int cn_queue_push(Queue *queue, void *item);
+
+int cn_queue_pop(Queue *queue, void **item);
+
+size_t cn_queue_capacity(const Queue *queue);
+
+#endif
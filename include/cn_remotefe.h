@@ -64,4 +64,38 @@ SOFTWARE.
 int cn_remotefe_scp(const char *local_file, const char *remote_dest,
                     int timeout_seconds);
 
+/**
+ * Share one SSH connection between the SCPs of cn_remotefe_scp_files,
+ * kept open for a time after the last one, so a process sending files
+ * regularly does not connect each time
+ *
+ * @param control_path     Path of the connection's socket (ssh_config
+ *                         ControlPath), NULL to stop sharing
+ * @param persist_seconds  Time to keep the connection open when unused
+ */
+void cn_remotefe_set_control(const char *control_path, int persist_seconds);
+
+/**
+ * Perform one SCP transfer of several local files to a remote dir, so a
+ * batch of files needs one SSH connection. The local files are deleted if
+ * the SCP is successful, and kept for a retry otherwise.
+ *
+ * @param local_files      The full paths, of the local files
+ * @param count            Number of local files
+ * @param remote_dest      The remote host and dir, in format:
+ *
+ *                         Example - username@remote_host:/path/to/dir/
+ *
+ * @param timeout_seconds  If the SCP attempt hangs, then the process will
+ *                         timeout in this amount of seconds
+ *
+ * @return                 Status code:
+ *                           0 - success
+ *                           1 - fork failed
+ *                           2 - scp failed, or timed out
+ *                           3 - could not allocate
+ */
+int cn_remotefe_scp_files(const char *const *local_files, size_t count,
+                          const char *remote_dest, int timeout_seconds);
+
 #endif
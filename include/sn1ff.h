@@ -0,0 +1,128 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef SN1FF_H
+#define SN1FF_H
+
+/*
+ * libsn1ff - make sn1ff check results in-process
+ *
+ * For checks written in C, or any language that can call C, rather than
+ * running "sn1ff_client -b", appending to the file, then running
+ * "sn1ff_client -e", for each result:
+ *
+ *   sn1ff_init("my_check");
+ *
+ *   sn1ff_result *result = sn1ff_result_begin("disk/root");
+ *   sn1ff_result_append(result, "Disk usage 91%");
+ *   sn1ff_result_set_status(result, SN1FF_WARN);
+ *   sn1ff_result_deliver(result, NULL);
+ *   sn1ff_result_free(result);
+ *
+ * Results delivered to a remote sn1ff server wait in ~/sn1ff/outbox,
+ * until sent together by sn1ff_flush. None of the functions fork, bar
+ * sn1ff_flush to a remote sn1ff server, which runs scp, once per 256
+ * results.
+ *
+ * A result is used by one thread at a time. sn1ff_init, delivery to a
+ * remote sn1ff server and sn1ff_flush are not thread safe.
+ *
+ * Link with -lsn1ff. Functions returning int return 0 on success, and -1
+ * on error, with details in syslog.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SN1FF_API_VERSION 1
+
+typedef enum {
+  SN1FF_NONE = 0,
+  SN1FF_OKAY = 1,
+  SN1FF_WARN = 2,
+  SN1FF_ALRT = 3
+} sn1ff_status;
+
+typedef struct sn1ff_result sn1ff_result;
+
+/*
+ * Load /etc/sn1ff/sn1ff.conf, and log to syslog as "ident". Call once,
+ * before any other function
+ */
+int sn1ff_init(const char *ident);
+
+/*
+ * Begin a result, for a check ID (NULL for none), status NONE
+ *
+ * @return  the result, NULL on error
+ */
+sn1ff_result *sn1ff_result_begin(const char *checkid);
+
+/*
+ * Append a line, a newline is added. Control characters are dropped
+ */
+int sn1ff_result_append(sn1ff_result *result, const char *line);
+
+int sn1ff_result_set_status(sn1ff_result *result, sn1ff_status status);
+
+/*
+ * TTL in minutes, the default is that of the status in client_ttls
+ */
+int sn1ff_result_set_ttl(sn1ff_result *result, int ttl_mins);
+
+/*
+ * Write out the result, no more lines can be appended. Called by
+ * sn1ff_result_deliver if need be
+ */
+int sn1ff_result_finish(sn1ff_result *result);
+
+/*
+ * Deliver the result, to the sn1ff server on this host if "server" is
+ * NULL. Otherwise it goes to the outbox, to be sent by sn1ff_flush to
+ * the sn1ff server at address "server". Subject to client_suppress
+ */
+int sn1ff_result_deliver(sn1ff_result *result, const char *server);
+
+/*
+ * Path of the result's file, until delivered
+ */
+const char *sn1ff_result_path(const sn1ff_result *result);
+
+/*
+ * Free a result, deleting its file if it was not delivered
+ */
+void sn1ff_result_free(sn1ff_result *result);
+
+/*
+ * Send the results in the outbox to the sn1ff server at address "server",
+ * in an scp per 256 results
+ */
+int sn1ff_flush(const char *server);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
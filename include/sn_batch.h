@@ -0,0 +1,77 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef SN_BATCH_H
+#define SN_BATCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Batch of filesystem operations (link, rename, unlink)
+ *
+ * Each operation is a plain syscall, run in the order added.
+ *
+ * An operation added with "link_next" set, only lets the next operation
+ * run if it succeeds. Later operations in the same chain get -ECANCELED
+ */
+
+#define SN_BATCH_CAPACITY 256
+#define SN_BATCH_PATH_LENGTH 1024
+
+#define SN_BATCH_OP_LINK 1
+#define SN_BATCH_OP_RENAME 2
+#define SN_BATCH_OP_UNLINK 3
+
+typedef struct {
+  int op;
+  bool link_next;
+  char from[SN_BATCH_PATH_LENGTH];
+  char to[SN_BATCH_PATH_LENGTH]; // Unused for unlink
+  int result;                    // 0 success, -errno error
+} BatchOp;
+
+typedef struct {
+  BatchOp *ops;
+  size_t count;
+  size_t capacity;
+} Batch;
+
+int sn_batch_init(Batch *batch, size_t capacity);
+
+void sn_batch_free(Batch *batch);
+
+int sn_batch_add_link(Batch *batch, const char *from, const char *to,
+                      bool link_next);
+
+int sn_batch_add_rename(Batch *batch, const char *from, const char *to,
+                        bool link_next);
+
+int sn_batch_add_unlink(Batch *batch, const char *path, bool link_next);
+
+size_t sn_batch_submit(Batch *batch);
+
+void sn_batch_reset(Batch *batch);
+
+#endif
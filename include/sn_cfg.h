@@ -32,6 +32,8 @@ SOFTWARE.
 #include <strings.h>
 #include <syslog.h>
 
+#define SN_CFG_AGENT_SCHEDULES_MAX 8
+
 int sn_cfg_str2loglevel(const char *level_str);
 
 int sn_cfg_load(void);
@@ -43,12 +45,40 @@ char *sn_cfg_get_client_ttls(void);
 char *sn_cfg_get_server_address(void);
 bool sn_cfg_watch_enabled(void);
 bool sn_cfg_export_enabled(void);
+int sn_cfg_get_greeter_workers(void);
+int sn_cfg_get_server_shards(void);
+bool sn_cfg_index_checkpoint_enabled(void);
+bool sn_cfg_greeter_journal_enabled(void);
+bool sn_cfg_greeter_dedup_enabled(void);
+bool sn_cfg_greeter_transitions_only(void);
+int sn_cfg_get_greeter_heartbeat_mins(void);
+bool sn_cfg_greeter_history_enabled(void);
+bool sn_cfg_greeter_metrics_enabled(void);
+bool sn_cfg_greeter_search_enabled(void);
+const char *sn_cfg_get_greeter_sink_path(void);
+int sn_cfg_get_greeter_sink_type(void);
+bool sn_cfg_greeter_sink_body(void);
+int sn_cfg_get_greeter_sink_buffer_kb(void);
+bool sn_cfg_client_suppress(void);
+int sn_cfg_get_client_file_format(void);
+int sn_cfg_get_agent_schedule_count(void);
+const char *sn_cfg_get_agent_schedule(int index);
+int sn_cfg_get_agent_jobs(void);
+int sn_cfg_get_agent_timeout_secs(void);
 
 const char *sn_cfg_get_server_upload_dir(void);
 const char *sn_cfg_get_server_upload_base_dir(void);
 const char *sn_cfg_get_server_watch_dir(void);
 const char *sn_cfg_get_server_export_dir(void);
 
+const char *sn_cfg_get_server_watch_index_file(void);
+const char *sn_cfg_get_server_ingest_journal_file(void);
+const char *sn_cfg_get_server_check_state_file(void);
+const char *sn_cfg_get_server_history_dir(void);
+const char *sn_cfg_get_server_metrics_dir(void);
+const char *sn_cfg_get_server_search_dir(void);
+const char *sn_cfg_get_server_metrics_rules_file(void);
+
 char *sn_cfg_get_server_user(void);
 char *sn_cfg_get_server_group(void);
 
@@ -27,6 +27,7 @@ SOFTWARE.
 
 #include <stdio.h>
 #include <stdlib.h>
+#include "sn_status.h"
 #include <string.h>
 #include <time.h>
 #include <uuid/uuid.h> // Requires package
@@ -84,9 +85,28 @@ typedef struct {
   char prefix[CNAME_PREFIX_LENGTH_D];
   Guid guid;
   char status[CNAME_STATUS_LENGTH_D];
+  Status status_id;
   Epoch epoch;
 } CName;
 
+// Length of a parsed file name:  <guid>_<status>_<epoch>.snff
+
+#define CNAME_EXTENSION ".snff"
+#define CNAME_EXTENSION_LENGTH 5
+#define CNAME_FILE_NAME_LENGTH                                                 \
+  (CNAME_GUID_LENGTH + 1 + CNAME_STATUS_LENGTH + 1 + CNAME_EPOCH_LENGTH +      \
+   CNAME_EXTENSION_LENGTH)
+
+// sn_cname_parse_name return codes
+
+#define CNAME_PARSE_OK 0
+#define CNAME_PARSE_ERR_LENGTH -1
+#define CNAME_PARSE_ERR_GUID -2
+#define CNAME_PARSE_ERR_SEPARATOR -3
+#define CNAME_PARSE_ERR_STATUS -4
+#define CNAME_PARSE_ERR_EPOCH -5
+#define CNAME_PARSE_ERR_EXTENSION -6
+
 // prefix
 
 void sn_cname_set_prefix(CName *cname, const char *prefix);
@@ -101,6 +121,7 @@ void sn_cname_get_guid_bin(CName *cname, uuid_t *guid_bin);
 
 void sn_cname_set_status(CName *cname, const char *status);
 void sn_cname_get_status(CName *cname, char *status);
+Status sn_cname_get_status_id(CName *cname);
 
 // epoch
 
@@ -111,6 +132,7 @@ void sn_cname_incr_epoch_bin(CName *cname, int incr_minutes);
 // parse
 
 int sn_cname_parse_name(const char *name_str, CName *name);
+const char *sn_cname_parse_error(int code);
 int sn_cname_parse_guid_name(const char *guid_name_str, const char *status_str,
                              CName *name);
 
@@ -0,0 +1,111 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef SN_DEDUP_H
+#define SN_DEDUP_H
+
+#include "sn_cname.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+/*
+ * Table of the last result received for each (Host, CheckID), to spot
+ * results that repeat the one before them byte for byte, and results that
+ * only repeat its status
+ *
+ * A result is keyed by a hash of its Host and CheckID header values. Its
+ * body hash covers its status, and the whole file less its "At: " header
+ * line, so only the time it was run is ignored. Hashes are xxHash64 (see
+ * cn_hash.h), for a 64 bit key a collision is not a practical concern.
+ *
+ * With "transitions only", a result is only for "watch" when its status
+ * differs from the last result's, it is WARN or ALRT, or no result of its
+ * check has been for "watch" for "heartbeat" seconds.
+ *
+ * The table can be saved to a state file, to carry it across restarts:
+ *
+ *   DedupHeader
+ *   DedupEntry  x count
+ *
+ * It is in host byte order, being only read on the host that wrote it
+ */
+
+#define SN_DEDUP_MAGIC "SN1FFDD1"
+#define SN_DEDUP_MAGIC_LENGTH 8
+#define SN_DEDUP_VERSION 1
+
+// sn_dedup_check flags
+
+#define SN_DEDUP_WATCH 0x1  // Publish to "watch"
+#define SN_DEDUP_REPEAT 0x2 // Repeats the last result, which is in "watch"
+
+// Larger files are not read, and taken as new
+#define SN_DEDUP_MAX_FILE_SIZE (256 * 1024)
+
+// DedupEntry flags
+#define SN_DEDUP_ENTRY_WATCHED 0x1 // Last result is in "watch", as "name"
+
+typedef struct {
+  uint64_t key;    // 0 for an empty slot
+  uint64_t body;   // Of the last result
+  int64_t expiry;  // Epoch of the last result's name
+  int64_t watched; // When a result was last for "watch", 0 never
+  int32_t status;  // Of the last result
+  int32_t flags;
+  char name[CNAME_NAME_LENGTH_D]; // Last result for "watch"
+} DedupEntry;
+
+typedef struct {
+  char magic[SN_DEDUP_MAGIC_LENGTH];
+  uint32_t version;
+  uint32_t reserved;
+  uint64_t count;
+} DedupHeader;
+
+typedef struct {
+  DedupEntry *entries;
+  size_t capacity; // A power of 2
+  size_t count;
+  bool transitions_only;
+  long heartbeat; // Seconds, 0 for no heartbeat
+  bool dirty;     // Changed since loaded or saved
+} Dedup;
+
+int sn_dedup_init(Dedup *dedup, bool transitions_only, long heartbeat);
+
+void sn_dedup_free(Dedup *dedup);
+
+int sn_dedup_hash_file(const char *path, uint64_t seed, uint64_t *key,
+                       uint64_t *body);
+
+int sn_dedup_check(Dedup *dedup, const char *dir, const char *name,
+                   time_t now, char *previous);
+
+int sn_dedup_save(Dedup *dedup, const char *path);
+
+int sn_dedup_load(Dedup *dedup, const char *path);
+
+#endif
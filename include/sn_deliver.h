@@ -0,0 +1,61 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef SN_DELIVER_H
+#define SN_DELIVER_H
+
+#include "sn_run.h"
+#include "sn_suppress.h"
+
+/*
+ * Delivery of ended sn1ff files to a sn1ff server, shared by
+ * sn1ff_client and sn1ff_agent
+ */
+
+// Timeout for each SCP of a run's results
+#define SN_DELIVER_SCP_TIMEOUT 120
+
+// Files in each SCP of the outbox, keeping the scp command line well
+// within ARG_MAX
+#define SN_DELIVER_SCP_BATCH 256
+
+int sn_deliver_suppress_begin(const char *file_path, const char *status,
+                              const char *ttl, const char *server,
+                              SuppressRecord *record);
+
+void sn_deliver_suppress_end(const SuppressRecord *record);
+
+int sn_deliver_local(const char *file_path, const char *status, int ttl_mins);
+
+int sn_deliver_outbox_dir(char *outbox_dir, size_t outbox_dir_sz);
+
+int sn_deliver_send_outbox(const char *outbox_dir, const char *server);
+
+int sn_deliver_file(const char *file_path, Status status, int ttl_mins,
+                    const char *outbox_dir, const char *server,
+                    SuppressRecord *record, bool *sent);
+
+int sn_deliver_run(const Run *run, const char *server);
+
+#endif
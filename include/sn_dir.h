@@ -34,10 +34,24 @@ SOFTWARE.
 
 #define EXTENSION ".snff"
 
+// Size of the buffer directory entries are read into, by sn_dir_each_file
+#define SN_DIR_BUFFER_SIZE (64 * 1024)
+
+// Called with each file name, returns 0 to continue, non zero to stop
+typedef int (*DirFileFn)(const char *name, void *arg);
+
 int sn_dir_file_has_ext(const char *filename);
 
+int sn_dir_each_file(const char *dir_path, DirFileFn fn, void *arg);
+
+int sn_dir_each_file_sharded(const char *dir_path, int shards, DirFileFn fn,
+                             void *arg);
+
 int sn_dir_list_files(const char *dir_path, MultiString *ms);
 
+int sn_dir_list_files_sharded(const char *dir_path, int shards,
+                              MultiString *ms);
+
 int sn_dir_client(char *sn1ff_dir_path, int sn1ff_dir_path_sz);
 
 #endif
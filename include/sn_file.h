@@ -29,7 +29,10 @@ SOFTWARE.
 #include "cn_file.h"
 #include "cn_host.h"
 #include "sn_fname.h"
+#include "sn_status.h"
 #include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -43,6 +46,9 @@ SOFTWARE.
 #define SN_FILE_MAX_BODY_LENGTH 85
 #define SN_FILE_MAX_BODY_LINES 256
 
+// Bytes of a body read whole, by sn_file_read_body, at most
+#define SN_FILE_MAX_RAW_BODY (1024 * 1024)
+
 /**
  * ATTRIBUTES
  */
@@ -66,6 +72,47 @@ typedef struct {
   char checkid[SN_FILE_HEADER_CHECKID_LENGTH_D];
 } HEADER;
 
+/**
+ * Result file formats
+ *
+ * v1 is text, "Name: value" header lines, an empty line, then the body
+ *
+ * v2 starts with a fixed size preamble, so a reader can go straight to a
+ * header value, or the body, without parsing lines. Numbers are little
+ * endian:
+ *
+ *   offset  size
+ *        0     4  magic "\x7fSNF"
+ *        4     2  format version (2)
+ *        6     2  header block length
+ *        8     4  body offset
+ *       12     4  body line count  (set by sn_file_finish)
+ *       16     1  status           (set by sn_file_finish)
+ *       17     7  reserved, 0
+ *       24     8  begun, epoch seconds
+ *       32     8  finished, epoch seconds (set by sn_file_finish)
+ *
+ * The header block follows, the Ver, Host, IPv4, At and CheckID values in
+ * that order, each a 2 byte length then the value. The text body follows
+ * that, at the body offset
+ */
+
+#define SN_FILE_FORMAT_V1 1
+#define SN_FILE_FORMAT_V2 2
+
+#define SN_FILE_V2_MAGIC "\x7fSNF"
+#define SN_FILE_V2_PREAMBLE_SZ 40
+#define SN_FILE_V2_HEADER_MAX 1024
+
+typedef struct {
+  uint16_t header_len;
+  uint32_t body_offset;
+  uint32_t line_count;
+  uint8_t status;
+  int64_t begun;
+  int64_t finished;
+} PREAMBLE;
+
 /**
  * FILE_DATA
  */
@@ -76,17 +123,53 @@ typedef struct {
   char body[SN_FILE_MAX_BODY_LINES]
            [SN_FILE_MAX_BODY_LENGTH + 1]; // 80-char lines + null terminator
   size_t body_lines;
+  bool body_truncated; // A line was cut, or lines were left unread
 } FILE_DATA;
 
+int sn_file_host_refresh(void);
+
+const char *sn_file_host_name(void);
+
 int sn_file_begin(char *file_path, const char *checkid);
 
 int sn_file_write_header(FILE *file, const HEADER *hdr);
 
+int sn_file_write_header_fmt(FILE *file, const HEADER *hdr, int format);
+
+int sn_file_parse_preamble(const unsigned char *buffer, size_t length,
+                           PREAMBLE *preamble, HEADER *hdr);
+
+int sn_file_read_header(const char *file_path, HEADER *hdr);
+
+int sn_file_finish(const char *file_path, Status status);
+
 int sn_file_read(const char *file_path, FILE_DATA *file_data);
 
+int sn_file_read_body(const char *file_path, size_t max, char **body,
+                      size_t *body_len);
+
 void sn_file_delete(const char *file_dir, const char *file_name);
 
+void sn_file_delete_sharded(const char *file_dir, int shards,
+                            const char *file_name);
+
 int sn_file_copy(const char *from_dir, const char *to_dir,
                  const char *file_name);
 
+/**
+ * How sn_file_publish / sn_file_move published the file
+ */
+
+#define SN_FILE_PUBLISH_LINK 0
+#define SN_FILE_PUBLISH_REFLINK 1
+#define SN_FILE_PUBLISH_COPY_RANGE 2
+#define SN_FILE_PUBLISH_SENDFILE 3
+#define SN_FILE_PUBLISH_RENAME 4
+
+int sn_file_publish(const char *from_dir, const char *to_dir,
+                    const char *file_name);
+
+int sn_file_move(const char *file_path, const char *dest_path,
+                 const char *group);
+
 #endif
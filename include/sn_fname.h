@@ -26,6 +26,7 @@ SOFTWARE.
 #define SN_FNAME_H
 
 #include "sn_cname.h"
+#include "sn_shard.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -38,22 +39,27 @@ SOFTWARE.
  *   - cname
  *       - components:
  *           <id>_<status>_<epoch>
+ *   - shards (0, 256 or 4096, see sn_shard.h)
  *   - path (not in struct):
  *       dir / cname
+ *       dir / shard / cname  (sharded)
  */
 
 #define FNAME_DIR_LENGTH 512
 #define FNAME_DIR_LENGTH_D (FNAME_DIR_LENGTH + 1)
 
 #define FNAME_PATH_LENGTH                                                      \
-  (FNAME_DIR_LENGTH + CNAME_NAME_LENGTH + 6 + 3) // 6 for ".sn1ff"
-                                                 // 3 for / and _'s
-                                                 //   "%s/%s%s_%s_%s.snff"
+  (FNAME_DIR_LENGTH + SN_SHARD_NAME_LENGTH + 1 + CNAME_NAME_LENGTH + 6 +      \
+   3) // 6 for ".sn1ff"
+      // 3 for / and _'s
+      //   "%s/%s%s_%s_%s.snff"
+      // shard name and its / when sharded
 #define FNAME_PATH_LENGTH_D (FNAME_PATH_LENGTH + 1)
 
 typedef struct {
   char dir[FNAME_DIR_LENGTH_D];
   CName cname;
+  int shards;
 } FName;
 
 // object
@@ -66,6 +72,11 @@ void sn_fname_dump(FName *fname);
 void sn_fname_set_dir(FName *fname, const char *dir);
 void sn_fname_get_dir(const FName *fname, char *dir);
 
+// shards
+
+void sn_fname_set_shards(FName *fname, int shards);
+int sn_fname_get_shards(const FName *fname);
+
 // path
 
 void sn_fname_get_tmp_path(const FName *fname, char *tmp_path);
@@ -0,0 +1,52 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef SN_FRAME_H
+#define SN_FRAME_H
+
+#include <stdio.h>
+
+/*
+ * Framed appends to a sn1ff file, for "sn1ff_client -w"
+ *
+ * Each line read is a command, then a space, then its text:
+ *
+ *   title <text>    box around the spaced out text (sn_append_titlebox)
+ *   first <text>    first header (sn_append_first_header)
+ *   header <text>   header, with blank lines above (sn_append_header)
+ *   message <text>  line of text (sn_append_message)
+ *   center <text>   centered text (sn_append_message_center)
+ *   trailer         line of dashes (sn_append_trailer_line)
+ *
+ * The output is as the sn1ff_lib.sh function of the same name, with
+ * control characters dropped from the text
+ */
+
+#define SN_FRAME_WIDTH 80
+
+size_t sn_frame_clean(char *text);
+
+int sn_frame_line(FILE *out, char *line);
+
+#endif
@@ -0,0 +1,127 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef SN_HISTORY_H
+#define SN_HISTORY_H
+
+#include "cn_multistr.h"
+#include "sn_series.h"
+#include "sn_status.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+/*
+ * Store of the status history of each (Host, CheckID), kept by the greeter
+ * and queried with sn1ff_history
+ *
+ * A (Host, CheckID) is interned as a series id, its line number (from 0)
+ * in the "series" file of "<Host>\t<CheckID>" lines (see sn_series.h).
+ * Only the first result of a series, and a change of its status, is
+ * recorded.
+ *
+ * Records are appended to a file per UTC day, "YYYYMMDD.log", each two
+ * varints (LEB128): (series << 2 | status), then the seconds into the day.
+ * Once a day is over, its records are also written grouped by series to
+ * "YYYYMMDD.idx", so a query reads only the records of its series:
+ *
+ *   HistoryIndexHeader
+ *   HistoryIndexSeries  x num_series, by series
+ *   uint32_t            x num_records, (seconds into the day << 2 |
+ *                       status), grouped by series, in time order
+ *
+ * A record is ~5 bytes in the log, and 4 in the index. The last status of
+ * each series is kept in "series.state", a HistoryState per series at
+ * (series * its size), so a change of status is seen across restarts.
+ *
+ * The index and state are in host byte order, being only read on the host
+ * that wrote them
+ */
+
+#define SN_HISTORY_MAGIC "SN1FFHI1"
+#define SN_HISTORY_MAGIC_LENGTH 8
+#define SN_HISTORY_VERSION 1
+
+#define SN_HISTORY_DAY_SECS 86400
+
+#define SN_HISTORY_NAME_LENGTH 256
+
+typedef struct {
+  int64_t last;   // Epoch of the last record, 0 no record
+  int32_t status; // Of the last record
+  int32_t reserved;
+} HistoryState;
+
+typedef struct {
+  char magic[SN_HISTORY_MAGIC_LENGTH];
+  uint32_t version;
+  uint32_t reserved;
+  int64_t day; // Epoch / SN_HISTORY_DAY_SECS
+  uint64_t num_series;
+  uint64_t num_records;
+} HistoryIndexHeader;
+
+typedef struct {
+  uint32_t series;
+  uint32_t count;
+  uint64_t first; // Index of its first record
+} HistoryIndexSeries;
+
+typedef struct {
+  char dir[SN_HISTORY_NAME_LENGTH];
+  SeriesTable series;
+  int state_fd;
+  int log_fd;   // Log of "log_day", -1 none open
+  int64_t log_day;
+  HistoryState *states; // Of each series
+  size_t states_capacity;
+} History;
+
+typedef int (*HistoryRecordFn)(int64_t when, Status status, void *arg);
+
+int sn_history_open(History *history, const char *dir);
+
+void sn_history_close(History *history);
+
+int sn_history_record(History *history, const char *host,
+                      const char *checkid, Status status, time_t when);
+
+int sn_history_index_day(const char *dir, int64_t day);
+
+int sn_history_index_all(const char *dir, int64_t today);
+
+int64_t sn_history_find(const char *dir, const char *host,
+                        const char *checkid);
+
+int sn_history_names(const char *dir, MultiString *names);
+
+int sn_history_each(const char *dir, uint32_t series, time_t from, time_t to,
+                    HistoryRecordFn fn, void *arg);
+
+int sn_history_counts(const char *dir, time_t from, time_t to,
+                      uint32_t *counts, size_t num_series);
+
+#endif
@@ -0,0 +1,120 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef SN_INDEX_H
+#define SN_INDEX_H
+
+#include "sn_status.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+/*
+ * In memory index of the sn1ff files in the "watch" dir, with a binary
+ * checkpoint file for warm restarts
+ *
+ * The index holds one IndexDir per dir scanned, the dir itself, or each of
+ * its shard dirs (see sn_shard.h). A refresh only rescans the dirs whose
+ * identity or mtime changed, since they were last scanned.
+ *
+ * The checkpoint is written to a temp file and renamed over the old one,
+ * so a reader never sees it part written. It is loaded with mmap, and is
+ * ignored if it is for another dir or layout:
+ *
+ *   IndexHeader
+ *   IndexDirRecord  x num_dirs
+ *   IndexEntry      x count
+ *
+ * It is in host byte order, being only read on the host that wrote it
+ */
+
+#define SN_INDEX_MAGIC "SN1FFIX1"
+#define SN_INDEX_MAGIC_LENGTH 8
+#define SN_INDEX_VERSION 1
+
+#define SN_INDEX_DIR_LENGTH 256
+
+// No sn1ff file name is longer, a longer name is not indexed
+#define SN_INDEX_NAME_LENGTH 63
+#define SN_INDEX_NAME_LENGTH_D (SN_INDEX_NAME_LENGTH + 1)
+
+// A dir changed this recently is rescanned on the next refresh, as changes
+// within the same mtime tick can not be seen
+#define SN_INDEX_RACY_SECS 2
+
+typedef struct {
+  char name[SN_INDEX_NAME_LENGTH_D];
+  int64_t expiry; // Epoch of the name, 0 if the name does not parse
+  int32_t status; // Status, SN_STATUS_INVALID if the name does not parse
+  int32_t reserved;
+} IndexEntry;
+
+typedef struct {
+  uint64_t dev;
+  uint64_t ino;
+  int64_t mtime_sec; // 0, rescan on the next refresh
+  int64_t mtime_nsec;
+  uint64_t count;
+} IndexDirRecord;
+
+typedef struct {
+  char magic[SN_INDEX_MAGIC_LENGTH];
+  uint32_t version;
+  uint32_t shards;
+  uint64_t num_dirs;
+  uint64_t count;
+  char dir[SN_INDEX_DIR_LENGTH];
+} IndexHeader;
+
+typedef struct {
+  IndexDirRecord record;
+  IndexEntry *entries;
+  size_t capacity;
+} IndexDir;
+
+typedef struct {
+  char dir[SN_INDEX_DIR_LENGTH];
+  int shards;
+  size_t num_dirs;
+  IndexDir *dirs;
+  size_t count;
+  bool dirty; // Changed since loaded or saved
+} Index;
+
+typedef int (*IndexEntryFn)(const IndexEntry *entry, void *arg);
+
+int sn_index_init(Index *index, const char *dir, int shards);
+
+void sn_index_free(Index *index);
+
+int sn_index_refresh(Index *index);
+
+int sn_index_each(const Index *index, IndexEntryFn fn, void *arg);
+
+int sn_index_save(Index *index, const char *path);
+
+int sn_index_load(Index *index, const char *path);
+
+#endif
@@ -0,0 +1,112 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef SN_INGEST_H
+#define SN_INGEST_H
+
+#include "cn_multistr.h"
+#include "cn_queue.h"
+#include "sn_batch.h"
+#include "sn_journal.h"
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Greeter ingest worker pool
+ *
+ * File names found in the "upload" dir are submitted to a bounded queue,
+ * and a pool of workers publishes each file to the "watch" and "export" dirs.
+ * A file is only deleted from "upload", after it is published everywhere,
+ * otherwise it is left for the next pass
+ *
+ * Each worker takes up to SN_INGEST_BATCH_FILES queued files at a time, and
+ * publishes them with one sn_batch submit
+ *
+ * A file can be submitted for "export" only, when it is not to be shown in
+ * "watch" (see sn_dedup.h)
+ *
+ * With a journal (see sn_journal.h), each batch is synced to disk once,
+ * and journaled, before its files are deleted from "upload". After a crash,
+ * sn_ingest_recover resumes each file from its journaled state
+ *
+ * The names of the files published to "watch" or "export" can be kept (see
+ * sn_ingest_keep_published), for the greeter to record them only once they
+ * are published. A file for "export" only, with "export" disabled, is not
+ * published, so is not kept
+ */
+
+#define SN_INGEST_MAX_WORKERS 64
+#define SN_INGEST_QUEUE_CAPACITY 1024
+#define SN_INGEST_BATCH_FILES 64
+
+typedef struct {
+  const char *upload_dir;
+  const char *watch_dir; // NULL when watch is disabled
+  const char *export_dir; // NULL when export is disabled
+  int shards;             // Layout of "watch" and "export"
+  Journal *journal;       // NULL when not journaling
+
+  Queue queue;
+  sem_t items; // Number of items in the queue, idle workers wait on this
+
+  pthread_mutex_t idle_lock;
+  pthread_cond_t idle; // Signalled when "pending" reaches 0
+
+  atomic_size_t pending;   // Submitted, but not yet processed
+  atomic_size_t published; // Copied and deleted from "upload"
+  atomic_size_t failed;    // Left in "upload" for the next pass
+  atomic_bool stop;
+
+  pthread_mutex_t kept_lock;
+  MultiString *kept; // Names of the files published, NULL when not kept
+
+  pthread_t *workers;
+  size_t num_workers;
+} Ingest;
+
+int sn_ingest_file(const char *upload_dir, const char *watch_dir,
+                   const char *export_dir, int shards, const char *file_name);
+
+int sn_ingest_recover(const char *journal_path, const char *upload_dir,
+                      const char *watch_dir, const char *export_dir,
+                      int shards, MultiString *resumed_names);
+
+int sn_ingest_start(Ingest *ingest, const char *upload_dir,
+                    const char *watch_dir, const char *export_dir,
+                    int shards, Journal *journal, size_t num_workers);
+
+void sn_ingest_keep_published(Ingest *ingest, MultiString *names);
+
+int sn_ingest_submit(Ingest *ingest, const char *file_name);
+
+int sn_ingest_submit_export(Ingest *ingest, const char *file_name);
+
+void sn_ingest_drain(Ingest *ingest);
+
+void sn_ingest_stop(Ingest *ingest);
+
+#endif
@@ -0,0 +1,94 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef SN_JOURNAL_H
+#define SN_JOURNAL_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Greeter ingest intent journal
+ *
+ * Each file ingested moves through the states:
+ *
+ *   STAGED   about to be published
+ *   WATCH    published to "watch", and synced
+ *   EXPORT   published to "export", and synced
+ *   REMOVED  deleted from "upload"
+ *
+ * Records are appended to a buffer, and made durable by sn_journal_commit
+ * with one write and one fdatasync for every record appended so far, so
+ * workers committing together share the sync (group commit).
+ *
+ * On a restart, sn_journal_replay gives the last state of each file that
+ * was not REMOVED, so ingest can resume it, rather than redo it
+ */
+
+#define SN_JOURNAL_STAGED 1
+#define SN_JOURNAL_WATCH 2
+#define SN_JOURNAL_EXPORT 3
+#define SN_JOURNAL_REMOVED 4
+
+#define SN_JOURNAL_MAGIC 0x314a4e53 // "SNJ1"
+#define SN_JOURNAL_NAME_LENGTH 67
+#define SN_JOURNAL_NAME_LENGTH_D (SN_JOURNAL_NAME_LENGTH + 1)
+
+typedef struct {
+  uint32_t magic;
+  uint32_t state;
+  char name[SN_JOURNAL_NAME_LENGTH_D];
+  uint32_t check; // Of state and name, a torn record at the end fails it
+} JournalRecord;
+
+typedef struct {
+  int fd;
+
+  pthread_mutex_t append_lock; // Guards the buffer, and "appended"
+  JournalRecord *buffer;
+  size_t count;
+  size_t capacity;
+  uint64_t appended; // Sequence number of the last record appended
+
+  pthread_mutex_t commit_lock; // Held over the write and fdatasync
+  uint64_t durable;            // Sequence number of the last durable record
+} Journal;
+
+typedef void (*JournalReplayFn)(const char *name, int state, void *arg);
+
+int sn_journal_open(Journal *journal, const char *path);
+
+void sn_journal_close(Journal *journal);
+
+uint64_t sn_journal_append(Journal *journal, int state, const char *name);
+
+int sn_journal_commit(Journal *journal, uint64_t seq);
+
+int sn_journal_reset(Journal *journal);
+
+int sn_journal_replay(const char *path, JournalReplayFn fn, void *arg);
+
+#endif
@@ -0,0 +1,88 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef SN_METRICS_H
+#define SN_METRICS_H
+
+#include "sn_file.h"
+#include <regex.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Rules to extract numeric metrics from the body of results, applied by
+ * the greeter, the points going to the metrics store (see sn_tsdb.h)
+ *
+ * A rules file has a rule per line, blank lines and "#" comments aside:
+ *
+ *   <CheckID> <Metric> regex <POSIX extended regex>
+ *   <CheckID> <Metric> key <Key>
+ *
+ * A "regex" rule takes the first parenthesised group of the first body
+ * line it matches. A "key" rule takes the value of the first body line
+ * "<Key>: <value>" or "<Key>=<value>". The regex, or key, is the rest of
+ * the line, so it may hold spaces. A CheckID of "*" applies to every
+ * check.
+ *
+ * A value is a number, as for strtod, with an optional K, M, G, T or P
+ * suffix scaling it by a power of 1024 ("107.2M"). Anything after it,
+ * such as a "%", is ignored. A result gives at most one point per rule
+ */
+
+#define SN_METRICS_NAME_LENGTH 64
+#define SN_METRICS_NAME_LENGTH_D (SN_METRICS_NAME_LENGTH + 1)
+
+#define SN_METRICS_RULE_REGEX 0
+#define SN_METRICS_RULE_KEY 1
+
+typedef struct {
+  char checkid[SN_FILE_HEADER_CHECKID_LENGTH_D];
+  char name[SN_METRICS_NAME_LENGTH_D];
+  int kind;
+  char key[SN_FILE_MAX_BODY_LENGTH + 1]; // SN_METRICS_RULE_KEY
+  regex_t regex;                         // SN_METRICS_RULE_REGEX
+} MetricRule;
+
+typedef struct {
+  MetricRule *rules;
+  size_t count;
+  size_t capacity;
+} MetricRules;
+
+typedef int (*MetricPointFn)(const char *name, double value, void *arg);
+
+int sn_metrics_parse_rule(const char *line, MetricRule *rule);
+
+int sn_metrics_load(MetricRules *rules, const char *path);
+
+void sn_metrics_free(MetricRules *rules);
+
+bool sn_metrics_applies(const MetricRules *rules, const char *checkid);
+
+int sn_metrics_parse_value(const char *text, double *value);
+
+int sn_metrics_extract(const MetricRules *rules, const FILE_DATA *file_data,
+                       MetricPointFn fn, void *arg);
+
+#endif
@@ -0,0 +1,93 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef SN_PREFETCH_H
+#define SN_PREFETCH_H
+
+#include "cn_multistr.h"
+#include "sn_file.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
+
+/*
+ * Prefetch of the results sn1ff_monitor shows next
+ *
+ * The monitor shows the files of a LIST in turn. While one is on screen, a
+ * worker thread reads and parses the next "depth" files into a ring of
+ * FILE_DATA, so moving on to the next is not held up by the storage of
+ * the "watch" dir (e.g. NFS).
+ *
+ * The ring has a slot more than "depth", for the file on screen, which is
+ * kept until the next is taken. A file that can not be read is dropped by
+ * the worker. A file read, but deleted before it is taken (expired by the
+ * cleaner, or deleted by a user), is dropped when taken: by the expiry of
+ * its name, or, once read SN_PREFETCH_RECHECK_SECS ago, as it is no
+ * longer there
+ */
+
+#define SN_PREFETCH_DEPTH 4
+#define SN_PREFETCH_MAX_DEPTH 64
+#define SN_PREFETCH_RECHECK_SECS 5
+
+#define SN_PREFETCH_PATH_LENGTH 256
+
+typedef struct {
+  FILE_DATA data;
+  char name[SN_PREFETCH_PATH_LENGTH];
+  char path[SN_PREFETCH_PATH_LENGTH];
+  bool ok;         // Read, else dropped when taken
+  time_t expires;  // From its name
+  time_t read_at;
+} PrefetchSlot;
+
+typedef struct {
+  char dir[SN_PREFETCH_PATH_LENGTH];
+  int shards;
+  MultiString *names; // Files of the LIST, in the order shown
+  size_t count;
+  size_t depth;
+  long recheck_secs;
+
+  PrefetchSlot *slots; // depth + 1, file i in slot (i % (depth + 1))
+  size_t read_next;    // Next file the worker reads
+  size_t take_next;    // Next file taken to be shown
+  bool stop;
+
+  pthread_mutex_t lock;
+  pthread_cond_t ready; // Signalled when a file is read
+  pthread_cond_t space; // Signalled when a file is taken, or on stop
+  pthread_t worker;
+} Prefetch;
+
+int sn_prefetch_start(Prefetch *prefetch, const char *dir, int shards,
+                      MultiString *names, size_t depth);
+
+int sn_prefetch_next(Prefetch *prefetch, const char **name,
+                     FILE_DATA **data);
+
+void sn_prefetch_stop(Prefetch *prefetch);
+
+#endif
@@ -0,0 +1,93 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef SN_RUN_H
+#define SN_RUN_H
+
+#include "sn_file.h"
+#include "sn_fname.h"
+#include "sn_status.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+/*
+ * Parallel check runner, for "sn1ff_client run <dir>"
+ *
+ * Every executable file under <dir> (bar hidden ones) is a check. Each is
+ * run with its output written straight into a sn1ff file begun for it,
+ * with its path under <dir>, less any extension, as its CheckID. Its exit
+ * code gives the status of the result:
+ *
+ *   0 OKAY,  1 NONE,  2 WARN,  3 ALRT
+ *
+ * as sn_exit_with_message (examples/lib/sn1ff_lib.sh) exits. Any other
+ * exit code, a signal, or running past the timeout, is ALRT. Checks run in
+ * parallel, up to a number of jobs. A check that times out is killed, with
+ * any processes it started (its process group)
+ *
+ * A check is run with SN_RUN_ENV set to "1", and SN_RUN_FILE_ENV to its
+ * result file. "sn1ff_client -b" then gives it that file, rather than
+ * beginning another, and sn_exit_with_message leaves sending it to the
+ * runner, so each result is sent once
+ */
+
+#define SN_RUN_ENV "SN1FF_RUNNER"
+#define SN_RUN_FILE_ENV "SN1FF_RUN_FILE"
+
+#define SN_RUN_MAX_CHECKS 1024
+#define SN_RUN_MAX_JOBS 64
+#define SN_RUN_DEFAULT_JOBS 8
+#define SN_RUN_DEFAULT_TIMEOUT 300 // Seconds
+
+#define SN_RUN_PATH_LENGTH 1024
+#define SN_RUN_PATH_LENGTH_D (SN_RUN_PATH_LENGTH + 1)
+
+typedef struct {
+  char script[SN_RUN_PATH_LENGTH_D];
+  char checkid[SN_FILE_HEADER_CHECKID_LENGTH_D];
+  char file_path[FNAME_PATH_LENGTH_D]; // Result file, "" if not begun
+  pid_t pid;                           // While running
+  long deadline;                       // Monotonic ms
+  bool timed_out;
+  int wait_status; // From waitpid
+  Status status;
+} RunCheck;
+
+typedef struct {
+  RunCheck *checks;
+  size_t count;
+} Run;
+
+int sn_run_discover(Run *run, const char *dir);
+
+void sn_run_free(Run *run);
+
+int sn_run_checks(Run *run, size_t jobs, int timeout_secs);
+
+Status sn_run_status(int exit_code);
+
+int sn_run_ttl(const char *ttls, Status status);
+
+#endif
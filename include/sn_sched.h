@@ -0,0 +1,58 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef SN_SCHED_H
+#define SN_SCHED_H
+
+#include "sn_run.h"
+#include <stddef.h>
+#include <time.h>
+
+/*
+ * Check schedules, for sn1ff_agent
+ *
+ * A schedule runs the checks in a dir every period. Rather than at the
+ * start of each period, as cron would, each host runs them at an offset
+ * into the period (its splay). The splay is a hash of the host name and
+ * dir, so it is spread evenly over the hosts, yet the same for a host
+ * across restarts
+ */
+
+#define SN_SCHED_PERIOD_MINS_MAX (7 * 24 * 60)
+
+typedef struct {
+  long period; // Seconds
+  long splay;  // Seconds into the period
+  time_t next; // When the checks next run
+  char dir[SN_RUN_PATH_LENGTH_D];
+} Schedule;
+
+long sn_sched_splay(const char *host, const char *dir, long period);
+
+time_t sn_sched_next(time_t now, long period, long splay);
+
+int sn_sched_parse(const char *value, const char *host, time_t now,
+                   Schedule *schedule);
+
+#endif
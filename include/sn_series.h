@@ -0,0 +1,72 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef SN_SERIES_H
+#define SN_SERIES_H
+
+#include "cn_multistr.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+ * Series of a store, interned as ids, shared by the status history (see
+ * sn_history.h) and the metrics store (see sn_tsdb.h)
+ *
+ * A series name is its parts, e.g. "<Host>\t<CheckID>", joined by tabs,
+ * with any tab or newline in a part made a space. Its series id is its line
+ * number (from 0) in the "series" file of the store's dir, appended to as
+ * series are interned. In memory, a table of the xxh64 of each name (linear
+ * probing, at most half full) gives its id
+ */
+
+#define SN_SERIES_FILE_NAME "series"
+
+typedef struct {
+  uint64_t key; // Hash of the series name, 0 for an empty slot
+  uint32_t series;
+  uint32_t reserved;
+} SeriesSlot;
+
+typedef struct {
+  FILE *file; // Appended to, as series are interned
+  SeriesSlot *slots;
+  size_t capacity; // A power of 2
+  uint32_t count;
+} SeriesTable;
+
+void sn_series_name(const char *const *parts, size_t num_parts, char *name,
+                    size_t name_sz);
+
+int sn_series_open(SeriesTable *table, const char *dir);
+
+void sn_series_close(SeriesTable *table);
+
+int64_t sn_series_intern(SeriesTable *table, const char *name);
+
+int64_t sn_series_find(const char *dir, const char *name);
+
+int sn_series_names(const char *dir, MultiString *names);
+
+#endif
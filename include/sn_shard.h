@@ -0,0 +1,66 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef SN_SHARD_H
+#define SN_SHARD_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Sharded "watch" / "export" dir layout
+ *
+ * With 256 or 4096 shards, a sn1ff file is kept in a sub dir named after
+ * the first 2 or 3 hex characters of its GUID:
+ *
+ *   <dir>/<guid>_<status>_<epoch>.snff        (0 shards, flat)
+ *   <dir>/3f/3fa85f64-..._OKAY_1742198614.snff   (256 shards)
+ *   <dir>/3fa/3fa85f64-..._OKAY_1742198614.snff  (4096 shards)
+ *
+ * The "upload" dir is always flat, as clients scp into it directly
+ */
+
+#define SN_SHARD_NONE 0
+#define SN_SHARD_256 256
+#define SN_SHARD_4096 4096
+
+#define SN_SHARD_NAME_LENGTH 3
+#define SN_SHARD_NAME_LENGTH_D (SN_SHARD_NAME_LENGTH + 1)
+
+bool sn_shard_valid(int shards);
+
+int sn_shard_name(const char *file_name, int shards, char *shard);
+
+int sn_shard_dir(const char *dir, const char *file_name, int shards,
+                 char *shard_dir, size_t shard_dir_sz);
+
+int sn_shard_path(const char *dir, const char *file_name, int shards,
+                  char *path, size_t path_sz);
+
+int sn_shard_index_dir(const char *dir, int shards, int index, char *shard_dir,
+                       size_t shard_dir_sz);
+
+int sn_shard_create_dirs(const char *dir, int shards);
+
+#endif
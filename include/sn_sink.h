@@ -0,0 +1,105 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef SN_SINK_H
+#define SN_SINK_H
+
+#include "sn_cname.h"
+#include "sn_file.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
+
+/*
+ * Stream of the results ingested by the greeter, as NDJSON records, to a
+ * FIFO or UNIX socket read by a downstream consumer (e.g. Vector, Fluent
+ * Bit), so it need not scan the "export" directory. One record a result:
+ *
+ *   {"name":"<file name>","guid":"<guid>","status":"OKAY",
+ *    "expires":<epoch>,"received":<epoch>,"host":"<host>","ipv4":"<ipv4>",
+ *    "at":"<At: value>","checkid":"<checkid>","body":["<line>",...],
+ *    "truncated":true}
+ *
+ * on one line, "body" only when enabled. The body is the lines sn_file_read
+ * keeps, with "truncated" only when a line was cut, or lines left out.
+ * sn1ff_monitor --snapshot prints the same records, without "received". A
+ * FIFO or stream socket gets the records newline delimited, a datagram
+ * socket one record a datagram.
+ *
+ * Records are batched in a bounded buffer, and written without blocking,
+ * when the buffer is a quarter full, and at the end of each pass. While
+ * the consumer is slow or away, records wait in the buffer, and once it
+ * is full, new records are dropped and counted, so ingest never waits.
+ * The FIFO or socket is opened (again) at most once a second, the FIFO
+ * only while it has a reader. The caller ignores SIGPIPE, for a FIFO
+ * whose reader has gone
+ */
+
+#define SN_SINK_FIFO 0
+#define SN_SINK_STREAM 1
+#define SN_SINK_DGRAM 2
+
+#define SN_SINK_PATH_LENGTH 108 // sun_path of a sockaddr_un
+
+#define SN_SINK_RETRY_SECS 1
+
+// Longest record, every body line escaped, each byte as "\u00XX"
+#define SN_SINK_RECORD_MAX                                                     \
+  (4096 + SN_FILE_MAX_BODY_LINES * (SN_FILE_MAX_BODY_LENGTH * 6 + 3) + 32)
+
+typedef struct {
+  char path[SN_SINK_PATH_LENGTH];
+  int type;
+  bool body; // Send the body lines of results
+  int fd;    // -1 not open
+  time_t retry_at;
+  char *buffer; // Records not yet written, from "start", "length" bytes
+  size_t capacity;
+  size_t start;
+  size_t length;
+  bool partial;   // Part of the record at "start" written, to a stream
+  size_t sent;    // Records written
+  size_t dropped; // Records dropped, the buffer being full
+} Sink;
+
+int sn_sink_type(const char *name);
+
+int sn_sink_open(Sink *sink, const char *path, int type, size_t capacity,
+                 bool body);
+
+void sn_sink_close(Sink *sink);
+
+size_t sn_sink_line_length(const char *line);
+
+int sn_sink_format(char *out, size_t out_sz, const char *name,
+                   const CName *cname, const HEADER *hdr,
+                   const FILE_DATA *file_data, time_t received);
+
+int sn_sink_add(Sink *sink, const char *name, const CName *cname,
+                const HEADER *hdr, const FILE_DATA *file_data,
+                time_t received);
+
+int sn_sink_flush(Sink *sink);
+
+#endif
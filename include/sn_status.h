@@ -27,6 +27,20 @@ SOFTWARE.
 
 #include <string.h>
 
+// Status values, in order of severity
+
+typedef enum {
+  SN_STATUS_INVALID = -1,
+  SN_STATUS_NONE = 0,
+  SN_STATUS_OKAY,
+  SN_STATUS_WARN,
+  SN_STATUS_ALRT
+} Status;
+
+#define SN_STATUS_LENGTH 4
+
 int sn_status_isvalid(const char *value);
 
+Status sn_status_from_chars(const char *chars);
+
 #endif
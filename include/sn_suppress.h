@@ -0,0 +1,70 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef SN_SUPPRESS_H
+#define SN_SUPPRESS_H
+
+#include "sn_status.h"
+#include <stdint.h>
+#include <time.h>
+
+/*
+ * Client side suppression of unchanged results
+ *
+ * The client keeps a small state file, of the last result sent for each
+ * CheckID and server. A result that is unchanged from the last one (same
+ * status, and same file bar its "At: " time), is not sent while the last
+ * one still has at least half of the TTL left on the server. So the server
+ * always has a live result of the check, only a less recent one.
+ *
+ * Results without a CheckID (or the default "N/A") are always sent, as
+ * they can not be told apart.
+ *
+ * The state file is fixed size records, locked with flock, as several
+ * checks can end at once. It is in host byte order
+ */
+
+#define SN_SUPPRESS_FILE_NAME "suppress.state"
+
+// Oldest record is reused, when full
+#define SN_SUPPRESS_MAX_RECORDS 4096
+
+#define SN_SUPPRESS_SEND 0
+#define SN_SUPPRESS_SKIP 1
+
+typedef struct {
+  uint64_t key;    // Hash of the CheckID and server
+  uint64_t body;   // Hash of the status, and file bar "At: "
+  int64_t sent;    // Epoch sent
+  int64_t expiry;  // Epoch it expires on the server
+  uint64_t check;  // Hash of the above, 0 for an unused record
+} SuppressRecord;
+
+int sn_suppress_check(const char *state_path, const char *file_path,
+                      const char *server, Status status, int ttl_mins,
+                      time_t now, SuppressRecord *record);
+
+int sn_suppress_record(const char *state_path, const SuppressRecord *record);
+
+#endif
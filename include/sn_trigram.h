@@ -0,0 +1,150 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef SN_TRIGRAM_H
+#define SN_TRIGRAM_H
+
+#include "sn_file.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+/*
+ * Trigram index over the body lines of results, kept by the greeter and
+ * searched with sn1ff_grep
+ *
+ * Each result is appended to "docs.dat" as a document, its id being its
+ * number (from 0): a TrigramDoc, then the Host, CheckID, file name and the
+ * body as written, every line at its full length (up to
+ * SN_FILE_MAX_RAW_BODY bytes). "docs.off" holds the offset of each
+ * document, a uint64_t at (id * 8).
+ *
+ * After each greeter pass, the documents added are indexed into a new
+ * segment, "<first id>-<end id>.tri" (end exclusive):
+ *
+ *   TrigramSegment
+ *   TrigramEntry    x num_trigrams, by trigram
+ *   postings        for each trigram, the ids of the documents with it,
+ *                   as varints (LEB128) of the difference from the id
+ *                   before (the first from the first id)
+ *
+ * A trigram is 3 bytes of a line, ASCII letters lower cased, as
+ * (b0 << 16 | b1 << 8 | b2). Once the newest segment holds as many
+ * documents as the one before it, the two are merged, so there are at
+ * most ~log2(documents) segments.
+ *
+ * Documents are kept until the result they are of expires, by the epoch
+ * of its file name. Once a quarter of them have, sn_trigram_compact
+ * rewrites the index without them, renumbering those kept from 0, so
+ * neither the files nor the ids grow without end.
+ *
+ * A search takes the trigrams of the literal text a match must contain,
+ * intersects their postings in each segment, and checks only the
+ * documents found against the pattern. The files are in host byte order,
+ * being only read on the host that wrote them
+ */
+
+#define SN_TRIGRAM_MAGIC "SN1FFTG1"
+#define SN_TRIGRAM_MAGIC_LENGTH 8
+#define SN_TRIGRAM_VERSION 1
+
+#define SN_TRIGRAM_NAME_LENGTH 256
+
+// Search flags
+#define SN_TRIGRAM_FIXED 0x1 // Pattern is a fixed string, not a regex
+#define SN_TRIGRAM_ICASE 0x2 // Ignore case
+#define SN_TRIGRAM_FIRST 0x4 // Only the first matching line of a document
+
+typedef struct {
+  char magic[SN_TRIGRAM_MAGIC_LENGTH];
+  uint32_t version;
+  uint32_t num_trigrams;
+  uint32_t first; // Id of the first document
+  uint32_t end;   // Id after the last document
+} TrigramSegment;
+
+typedef struct {
+  uint32_t trigram;
+  uint32_t count;  // Documents with it
+  uint64_t offset; // Of its postings, from the start of the file
+} TrigramEntry;
+
+typedef struct {
+  int64_t when; // Epoch received
+  uint32_t body_len;
+  uint16_t host_len;
+  uint16_t checkid_len;
+  uint16_t name_len;
+  uint16_t reserved[3];
+} TrigramDoc;
+
+typedef struct {
+  char dir[SN_TRIGRAM_NAME_LENGTH];
+  int docs_fd;
+  int offsets_fd;
+  uint64_t docs_size; // Where the next document is appended
+  uint32_t num_docs;
+  uint32_t indexed; // Documents in segments
+} TrigramIndex;
+
+typedef struct {
+  const char *pattern;
+  int flags;
+  const char *host;    // NULL for any
+  const char *checkid; // NULL for any
+  time_t from;
+  time_t to;
+} TrigramQuery;
+
+typedef struct {
+  uint32_t doc;
+  time_t when;
+  const char *host;
+  const char *checkid;
+  const char *name;
+  const char *line;
+  size_t line_no; // From 1
+} TrigramMatch;
+
+typedef int (*TrigramMatchFn)(const TrigramMatch *match, void *arg);
+
+int sn_trigram_open(TrigramIndex *index, const char *dir);
+
+void sn_trigram_close(TrigramIndex *index);
+
+int sn_trigram_add(TrigramIndex *index, const HEADER *hdr, const char *name,
+                   time_t when, const char *body, size_t body_len);
+
+int sn_trigram_flush(TrigramIndex *index);
+
+int sn_trigram_compact(TrigramIndex *index, time_t now);
+
+int sn_trigram_required(const char *pattern, int flags, uint32_t *trigrams,
+                        size_t max_trigrams);
+
+int sn_trigram_search(const char *dir, const TrigramQuery *query,
+                      TrigramMatchFn fn, void *arg);
+
+#endif
@@ -0,0 +1,126 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef SN_TSDB_H
+#define SN_TSDB_H
+
+#include "cn_multistr.h"
+#include "sn_series.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+/*
+ * Store of numeric metrics of each (Host, CheckID, Metric), extracted from
+ * results by the greeter (see sn_metrics.h), and queried with
+ * sn1ff_metrics
+ *
+ * A (Host, CheckID, Metric) is interned as a series id, its line number
+ * (from 0) in the "series" file of "<Host>\t<CheckID>\t<Metric>" lines
+ * (see sn_series.h).
+ *
+ * Points are not kept as such, each is rolled up as it is added into a
+ * 1 minute, a 1 hour and a 1 day bucket: their count, min, max and sum.
+ * Each resolution is a round robin file, "1m.tsdb", "1h.tsdb" and
+ * "1d.tsdb", of a TsdbHeader then a region per series at (header size +
+ * series * region size), holding its last "slots" buckets as columns:
+ *
+ *   uint32_t  bucket[slots]  (epoch / step) of the bucket in the slot
+ *   uint32_t  count[slots]   0 for an empty slot
+ *   double    min[slots]
+ *   double    max[slots]
+ *   double    sum[slots]
+ *
+ * A bucket goes in slot (bucket % slots), over the older bucket there.
+ * A slot is 32 bytes, and a series ~170KB over the 3 files: 1 day of 1
+ * minute buckets, 90 days of 1 hour and 5 years of 1 day.
+ *
+ * The files are in host byte order, being only read on the host that wrote
+ * them
+ */
+
+#define SN_TSDB_MAGIC "SN1FFTS1"
+#define SN_TSDB_MAGIC_LENGTH 8
+#define SN_TSDB_VERSION 1
+
+#define SN_TSDB_RES_1M 0
+#define SN_TSDB_RES_1H 1
+#define SN_TSDB_RES_1D 2
+#define SN_TSDB_RESOLUTIONS 3
+
+#define SN_TSDB_NAME_LENGTH 256
+
+typedef struct {
+  char magic[SN_TSDB_MAGIC_LENGTH];
+  uint32_t version;
+  uint32_t step;  // Seconds per bucket
+  uint32_t slots; // Buckets kept per series
+  uint32_t reserved;
+} TsdbHeader;
+
+typedef struct {
+  time_t when; // Start of the bucket
+  uint32_t count;
+  double min;
+  double max;
+  double sum;
+} TsdbBucket;
+
+typedef struct {
+  int fd;
+  unsigned char *map;
+  uint32_t mapped_series; // Series the map covers
+  uint32_t step;
+  uint32_t slots;
+} TsdbRollup;
+
+typedef struct {
+  char dir[SN_TSDB_NAME_LENGTH];
+  SeriesTable series;
+  TsdbRollup rollups[SN_TSDB_RESOLUTIONS];
+} Tsdb;
+
+typedef int (*TsdbBucketFn)(const TsdbBucket *bucket, void *arg);
+
+int sn_tsdb_open(Tsdb *tsdb, const char *dir);
+
+void sn_tsdb_close(Tsdb *tsdb);
+
+int sn_tsdb_add(Tsdb *tsdb, const char *host, const char *checkid,
+                const char *metric, double value, time_t when);
+
+int sn_tsdb_resolution(const char *name);
+
+uint32_t sn_tsdb_step(int resolution);
+
+int64_t sn_tsdb_find(const char *dir, const char *host, const char *checkid,
+                     const char *metric);
+
+int sn_tsdb_names(const char *dir, MultiString *names);
+
+int sn_tsdb_query(const char *dir, int resolution, uint32_t series,
+                  time_t from, time_t to, TsdbBucketFn fn, void *arg);
+
+#endif
@@ -0,0 +1,49 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef SN_VARINT_H
+#define SN_VARINT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Varints (LEB128), as written to the status history (see sn_history.h)
+ * and the trigram index (see sn_trigram.h): 7 bits a byte, lowest first,
+ * the top bit set on all but the last
+ */
+
+// Bytes of a varint, at most
+#define SN_VARINT_MAX 10
+#define SN_VARINT_MAX_32 5 // Of a value that fits a uint32_t
+
+size_t sn_varint_put(unsigned char *dest, uint64_t value);
+
+int sn_varint_get(const unsigned char **src, const unsigned char *end,
+                  uint64_t *value);
+
+int sn_varint_get_32(const unsigned char **src, const unsigned char *end,
+                     uint32_t *value);
+
+#endif
@@ -69,14 +69,14 @@ int cn_file_copy(const char *source_filepath,
 int cn_file_delete(const char *filepath) { return remove(filepath); }
 
 /**
- * Change group ownership of a file to a group the current user is in.
+ * Get the id of a group the current user is in
  *
- * @param  path       Path to the file
- * @param  groupname  Target group name (must be in user's groups)
+ * @param  groupname  Group name (must be in user's groups)
+ * @param  gid        Set to the group id
  * @return  0 success,
  *         -1 on error
  */
-int cn_file_chgrp(const char *path, const char *groupname) {
+static int member_gid(const char *groupname, gid_t *gid) {
   // Get group for group name
 
   struct group *grp = getgrnam(groupname);
@@ -88,8 +88,6 @@ int cn_file_chgrp(const char *path, const char *groupname) {
     return -1;
   }
 
-  gid_t target_gid = grp->gr_gid;
-
   // Check if process is a member of the target group
 
   // TODO: Add check that process owns the file
@@ -102,7 +100,9 @@ int cn_file_chgrp(const char *path, const char *groupname) {
   // has
   //     the CAP_CHOWN capability (root usually does).
 
-  int result = cn_proc_ingrp(target_gid);
+  // getgroups may leave out the effective group id
+
+  int result = grp->gr_gid == getegid() ? 0 : cn_proc_ingrp(grp->gr_gid);
   if (result != 0) {
     cn_log_msg(LOG_ERR, __func__,
                "Process failed to show membership of group -> %s <-",
@@ -110,12 +110,54 @@ int cn_file_chgrp(const char *path, const char *groupname) {
     return -1;
   }
 
+  *gid = grp->gr_gid;
+  return 0;
+}
+
+/**
+ * Change group ownership of a file to a group the current user is in.
+ *
+ * @param  path       Path to the file
+ * @param  groupname  Target group name (must be in user's groups)
+ * @return  0 success,
+ *         -1 on error
+ */
+int cn_file_chgrp(const char *path, const char *groupname) {
+  gid_t target_gid;
+  if (member_gid(groupname, &target_gid) != 0)
+    return -1;
+
   // Change group ownership (keep UID the same with -1)
 
   if (chown(path, -1, target_gid) != 0) {
     cn_log_msg(LOG_ERR, __func__,
                "'chown' gave error trying to change file -> %s <-, "
-               "strerror(errno) -> %m <-");
+               "strerror(errno) -> %m <-",
+               path);
+    return -1;
+  }
+
+  return 0;
+}
+
+/**
+ * Change group ownership of an open file to a group the current user is in
+ *
+ * @param  fd         Open file
+ * @param  groupname  Target group name (must be in user's groups)
+ * @return  0 success,
+ *         -1 on error
+ */
+int cn_file_fchgrp(int fd, const char *groupname) {
+  gid_t target_gid;
+  if (member_gid(groupname, &target_gid) != 0)
+    return -1;
+
+  if (fchown(fd, -1, target_gid) != 0) {
+    cn_log_msg(LOG_ERR, __func__,
+               "'fchown' gave error trying to change fd -> %d <-, "
+               "strerror(errno) -> %m <-",
+               fd);
     return -1;
   }
 
@@ -142,6 +184,26 @@ int cn_file_mode660(const char *path) {
   return 0;
 }
 
+/**
+ * Change permissions of an open file to 0660 (rw-rw----)
+ *
+ * @param fd Open file
+ * @return 0 on success, -1 on failure
+ */
+int cn_file_fmode660(int fd) {
+  mode_t mode = S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP; // 0660
+
+  if (fchmod(fd, mode) != 0) {
+    cn_log_msg(LOG_ERR, __func__,
+               "'fchmod' gave error trying to change fd -> %d <-, "
+               "strerror(errno) -> %m <-",
+               fd);
+    return -1;
+  }
+
+  return 0;
+}
+
 /**
  * Change file permissions to 0600 (rw-------)
  *
@@ -208,13 +270,31 @@ static int is_printable_utf8(const unsigned char *buf, size_t *char_len) {
  *         1 error opening file
  */
 int cn_file_clean(const char *filename) {
+  return cn_file_clean_from(filename, 0);
+}
+
+/**
+ * Clean non-printable characters from a file, as cn_file_clean, leaving the
+ * first "offset" bytes (e.g. a binary preamble) as they are
+ *
+ * @param  filename  is the file to clean
+ * @param  offset    bytes at the start of the file not to clean
+ * @return 0 success
+ *         1 error opening file
+ */
+int cn_file_clean_from(const char *filename, long offset) {
   setlocale(LC_CTYPE, "");
 
   FILE *file = fopen(filename, "rb+"); // Open for reading and writing
   if (!file) {
     cn_log_msg(LOG_ERR, __func__,
                "'fopen' failed to open file ->%s<- strerror(errno) -> %m <-",
-               file);
+               filename);
+    return 1;
+  }
+
+  if (fseek(file, offset, SEEK_SET) != 0) {
+    fclose(file);
     return 1;
   }
 
@@ -241,13 +321,13 @@ int cn_file_clean(const char *filename) {
 
   // Rewind and write cleaned data
 
-  rewind(file);
+  fseek(file, offset, SEEK_SET);
   fwrite(out_buf, 1, write_pos, file);
   fflush(file);
 
   // Truncate the rest of the file
 
-  ftruncate(fileno(file), write_pos);
+  ftruncate(fileno(file), offset + (off_t)write_pos);
 
   fclose(file);
   return 0;
@@ -0,0 +1,153 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "cn_hash.h"
+#include <string.h>
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | xxHash64                                                       |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+/*
+ * XXH64, from the xxHash specification (BSD 2-Clause), by Yann Collet:
+ *
+ *   https://github.com/Cyan4973/xxHash/blob/dev/doc/xxhash_spec.md
+ *
+ * It is not a cryptographic hash, only a fast one with a good spread
+ */
+
+#define PRIME64_1 0x9E3779B185EBCA87ULL
+#define PRIME64_2 0xC2B2AE3D27D4EB4FULL
+#define PRIME64_3 0x165667B19E3779F9ULL
+#define PRIME64_4 0x85EBCA77C2B2AE63ULL
+#define PRIME64_5 0x27D4EB2F165667C5ULL
+
+static uint64_t rotl64(uint64_t value, int bits) {
+  return (value << bits) | (value >> (64 - bits));
+}
+
+// Little endian reads, memcpy avoids unaligned access
+
+static uint64_t read64(const unsigned char *p) {
+  uint64_t value;
+  memcpy(&value, p, sizeof(value));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  value = __builtin_bswap64(value);
+#endif
+  return value;
+}
+
+static uint32_t read32(const unsigned char *p) {
+  uint32_t value;
+  memcpy(&value, p, sizeof(value));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  value = __builtin_bswap32(value);
+#endif
+  return value;
+}
+
+static uint64_t round64(uint64_t acc, uint64_t input) {
+  acc += input * PRIME64_2;
+  acc = rotl64(acc, 31);
+  return acc * PRIME64_1;
+}
+
+static uint64_t merge64(uint64_t acc, uint64_t value) {
+  acc ^= round64(0, value);
+  return acc * PRIME64_1 + PRIME64_4;
+}
+
+/**
+ * Hash "length" bytes of "data"
+ *
+ * @param  seed  start value, hashing the same data with a different seed
+ *               gives an unrelated hash, so can be used to chain hashes
+ * @return  64 bit hash
+ */
+uint64_t cn_hash_xxh64(const void *data, size_t length, uint64_t seed) {
+  const unsigned char *p = data;
+  const unsigned char *end = p + length;
+  uint64_t hash;
+
+  // 32 byte stripes, into 4 accumulators
+
+  if (length >= 32) {
+    uint64_t acc1 = seed + PRIME64_1 + PRIME64_2;
+    uint64_t acc2 = seed + PRIME64_2;
+    uint64_t acc3 = seed;
+    uint64_t acc4 = seed - PRIME64_1;
+
+    const unsigned char *limit = end - 32;
+    do {
+      acc1 = round64(acc1, read64(p));
+      acc2 = round64(acc2, read64(p + 8));
+      acc3 = round64(acc3, read64(p + 16));
+      acc4 = round64(acc4, read64(p + 24));
+      p += 32;
+    } while (p <= limit);
+
+    hash = rotl64(acc1, 1) + rotl64(acc2, 7) + rotl64(acc3, 12) +
+           rotl64(acc4, 18);
+    hash = merge64(hash, acc1);
+    hash = merge64(hash, acc2);
+    hash = merge64(hash, acc3);
+    hash = merge64(hash, acc4);
+  } else {
+    hash = seed + PRIME64_5;
+  }
+
+  hash += (uint64_t)length;
+
+  // Remaining 0 - 31 bytes
+
+  for (; p + 8 <= end; p += 8) {
+    hash ^= round64(0, read64(p));
+    hash = rotl64(hash, 27) * PRIME64_1 + PRIME64_4;
+  }
+
+  if (p + 4 <= end) {
+    hash ^= (uint64_t)read32(p) * PRIME64_1;
+    hash = rotl64(hash, 23) * PRIME64_2 + PRIME64_3;
+    p += 4;
+  }
+
+  for (; p < end; p++) {
+    hash ^= (uint64_t)(*p) * PRIME64_5;
+    hash = rotl64(hash, 11) * PRIME64_1;
+  }
+
+  // Avalanche
+
+  hash ^= hash >> 33;
+  hash *= PRIME64_2;
+  hash ^= hash >> 29;
+  hash *= PRIME64_3;
+  hash ^= hash >> 32;
+
+  return hash;
+}
@@ -23,6 +23,7 @@ SOFTWARE.
 */
 
 #define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE // For timegm
 
 #include "cn_host.h"
 #include "cn_log.h"
@@ -105,13 +106,14 @@ int cn_host_utcdt(char *utc_datetime) {
     return -1;
   }
 
-  // Convert to UTC time
+  // Convert to UTC time, reentrant as files are begun from threads
 
-  struct tm *tm_info = gmtime(&t);
+  struct tm tm_buf;
+  struct tm *tm_info = gmtime_r(&t, &tm_buf);
   if (tm_info == NULL) {
-    cn_log_msg(
-        LOG_ERR, __func__,
-        "'gmtime' gave error converting time to UTC, strerror(errno) -> %m <-");
+    cn_log_msg(LOG_ERR, __func__,
+               "'gmtime_r' gave error converting time to UTC, strerror(errno) "
+               "-> %m <-");
     return -2;
   }
 
@@ -122,3 +124,35 @@ int cn_host_utcdt(char *utc_datetime) {
 
   return 0;
 }
+
+/**
+ * Parse a UTC date/time, as cn_host_utcdt formats it
+ *
+ * @param  when  returns the time, in seconds since the epoch
+ * @return  0 success
+ *         -1 not a date/time cn_host_utcdt formats
+ */
+int cn_host_utcdt_parse(const char *utc_datetime, time_t *when) {
+  static const char *const MONTHS[] = {
+      "January", "February", "March",     "April",   "May",      "June",
+      "July",    "August",   "September", "October", "November", "December"};
+
+  char month[16];
+  struct tm tm = {0};
+  if (sscanf(utc_datetime, "%*s %15s %d, %d %d:%d:%d", month, &tm.tm_mday,
+             &tm.tm_year, &tm.tm_hour, &tm.tm_min, &tm.tm_sec) != 6)
+    return -1;
+
+  tm.tm_mon = -1;
+  for (int i = 0; i < 12; i++)
+    if (strcmp(month, MONTHS[i]) == 0)
+      tm.tm_mon = i;
+
+  if (tm.tm_mon == -1 || tm.tm_mday < 1 || tm.tm_mday > 31 ||
+      tm.tm_year < 1970)
+    return -1;
+
+  tm.tm_year -= 1900;
+  *when = timegm(&tm);
+  return 0;
+}
@@ -0,0 +1,152 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "cn_queue.h"
+#include "cn_log.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+ * Initialize the queue, with room for "capacity" items
+ *
+ * @param  capacity  must be a power of 2, and at least 2
+ * @return  0 success
+ *         -1 capacity is not a power of 2
+ *         -2 could not allocate the cells
+ */
+int cn_queue_init(Queue *queue, size_t capacity) {
+  queue->cells = NULL;
+  queue->mask = 0;
+
+  if (capacity < 2 || (capacity & (capacity - 1)) != 0) {
+    cn_log_msg(LOG_ERR, __func__,
+               "Queue capacity -> %zu <- is not a power of 2", capacity);
+    return -1;
+  }
+
+  queue->cells = malloc(capacity * sizeof(QueueCell));
+  if (queue->cells == NULL) {
+    cn_log_msg(LOG_ERR, __func__,
+               "Could not allocate queue cells, capacity -> %zu <-",
+               capacity);
+    return -2;
+  }
+
+  for (size_t i = 0; i < capacity; i++) {
+    atomic_init(&queue->cells[i].sequence, i);
+    queue->cells[i].data = NULL;
+  }
+
+  queue->mask = capacity - 1;
+  atomic_init(&queue->enqueue_pos, 0);
+  atomic_init(&queue->dequeue_pos, 0);
+  return 0;
+}
+
+/**
+ * Free the cells. Items still in the queue are not freed
+ */
+void cn_queue_free(Queue *queue) {
+  free(queue->cells);
+  queue->cells = NULL;
+  queue->mask = 0;
+}
+
+/**
+ * Add an item, without blocking
+ *
+ * @return  0 success
+ *         -1 queue is full
+ */
+int cn_queue_push(Queue *queue, void *item) {
+  QueueCell *cell;
+  size_t pos = atomic_load_explicit(&queue->enqueue_pos, memory_order_relaxed);
+
+  while (true) {
+    cell = &queue->cells[pos & queue->mask];
+    size_t seq = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+    intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+
+    if (diff == 0) {
+      // Cell is free, claim it (on failure "pos" is reloaded)
+
+      if (atomic_compare_exchange_weak_explicit(&queue->enqueue_pos, &pos,
+                                                pos + 1, memory_order_relaxed,
+                                                memory_order_relaxed))
+        break;
+    } else if (diff < 0) {
+      return -1; // Full
+    } else {
+      pos = atomic_load_explicit(&queue->enqueue_pos, memory_order_relaxed);
+    }
+  }
+
+  cell->data = item;
+  atomic_store_explicit(&cell->sequence, pos + 1, memory_order_release);
+  return 0;
+}
+
+/**
+ * Remove the oldest item, without blocking
+ *
+ * @param  item  returns the item
+ * @return  0 success
+ *         -1 queue is empty
+ */
+int cn_queue_pop(Queue *queue, void **item) {
+  QueueCell *cell;
+  size_t pos = atomic_load_explicit(&queue->dequeue_pos, memory_order_relaxed);
+
+  while (true) {
+    cell = &queue->cells[pos & queue->mask];
+    size_t seq = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+    intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+
+    if (diff == 0) {
+      // Cell has an item, claim it (on failure "pos" is reloaded)
+
+      if (atomic_compare_exchange_weak_explicit(&queue->dequeue_pos, &pos,
+                                                pos + 1, memory_order_relaxed,
+                                                memory_order_relaxed))
+        break;
+    } else if (diff < 0) {
+      return -1; // Empty
+    } else {
+      pos = atomic_load_explicit(&queue->dequeue_pos, memory_order_relaxed);
+    }
+  }
+
+  *item = cell->data;
+
+  // Free the cell for the producer one lap ahead
+
+  atomic_store_explicit(&cell->sequence, pos + queue->mask + 1,
+                        memory_order_release);
+  return 0;
+}
+
+size_t cn_queue_capacity(const Queue *queue) { return queue->mask + 1; }
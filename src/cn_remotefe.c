@@ -26,6 +26,8 @@ SOFTWARE.
 
 #include "cn_remotefe.h"
 #include "cn_log.h"
+#include <stdbool.h>
+#include <stdio.h>
 
 // Global variable to store the PID of the child process
 
@@ -123,3 +125,94 @@ int cn_remotefe_scp(const char *local_file, const char *remote_dest,
 
   return 0;
 }
+
+// SSH connection sharing options, for cn_remotefe_scp_files
+
+#define CONTROL_OPTS 3
+#define CONTROL_OPT_LENGTH 512
+
+static char control_opts[CONTROL_OPTS][CONTROL_OPT_LENGTH];
+static bool control_set = false;
+
+void cn_remotefe_set_control(const char *control_path, int persist_seconds) {
+  if (control_path == NULL) {
+    control_set = false;
+    return;
+  }
+
+  snprintf(control_opts[0], CONTROL_OPT_LENGTH, "ControlMaster=auto");
+  snprintf(control_opts[1], CONTROL_OPT_LENGTH, "ControlPath=%s",
+           control_path);
+  snprintf(control_opts[2], CONTROL_OPT_LENGTH, "ControlPersist=%d",
+           persist_seconds);
+  control_set = true;
+}
+
+int cn_remotefe_scp_files(const char *const *local_files, size_t count,
+                          const char *remote_dest, int timeout_seconds) {
+  if (count == 0)
+    return 0;
+
+  // scp -q [-o <control opt> ...] <file> ... <dest>
+
+  char **args = calloc(count + 4 + 2 * CONTROL_OPTS, sizeof(char *));
+  if (args == NULL)
+    return 3;
+
+  size_t arg = 0;
+  args[arg++] = "scp";
+  args[arg++] = "-q";
+  for (size_t i = 0; control_set && i < CONTROL_OPTS; i++) {
+    args[arg++] = "-o";
+    args[arg++] = control_opts[i];
+  }
+  for (size_t i = 0; i < count; i++)
+    args[arg++] = (char *)local_files[i];
+  args[arg++] = (char *)remote_dest;
+  args[arg] = NULL;
+
+  pid_t pid = fork();
+
+  if (pid == -1) {
+    cn_log_msg(LOG_ERR, __func__,
+               "'fork' gave error, strerror(errno) -> %m <-");
+    free(args);
+    return 1;
+  }
+
+  if (pid == 0) {
+    execvp(args[0], args);
+    cn_log_msg(LOG_ERR, __func__,
+               "'execvp' gave error, strerror(errno) -> %m <-");
+    _exit(EXIT_FAILURE);
+  }
+
+  free(args);
+
+  signal(SIGALRM, timeout_handler);
+  alarm(timeout_seconds);
+  child_pid = pid;
+
+  int status;
+  waitpid(pid, &status, 0);
+
+  alarm(0);
+  child_pid = -1;
+
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    cn_log_msg(LOG_ERR, __func__,
+               "SCP of -> %zu <- files failed or timed out, local files kept",
+               count);
+    return 2;
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    if (remove(local_files[i]) != 0)
+      cn_log_msg(LOG_ERR, __func__,
+                 "'remove' gave error removing file -> %s <-, "
+                 "strerror(errno) -> %m <-",
+                 local_files[i]);
+  }
+
+  return 0;
+}
@@ -0,0 +1,234 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "sn1ff.h"
+#include "cn_log.h"
+#include "sn_cfg.h"
+#include "sn_deliver.h"
+#include "sn_file.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/*
+ * libsn1ff public API, see sn1ff.h
+ */
+
+_Static_assert(SN1FF_NONE == (int)SN_STATUS_NONE &&
+                   SN1FF_OKAY == (int)SN_STATUS_OKAY &&
+                   SN1FF_WARN == (int)SN_STATUS_WARN &&
+                   SN1FF_ALRT == (int)SN_STATUS_ALRT,
+               "sn1ff_status must match Status");
+
+struct sn1ff_result {
+  FILE *file; // NULL once finished
+  char path[FNAME_PATH_LENGTH_D];
+  Status status;
+  int ttl_mins; // -1 for that of the status, in client_ttls
+  bool delivered;
+};
+
+// Suppression records of results in the outbox, kept until they are sent
+
+static SuppressRecord *pending = NULL;
+static size_t pending_count = 0;
+static size_t pending_capacity = 0;
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Setup                                                          |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+int sn1ff_init(const char *ident) {
+  if (sn_cfg_load() != 0)
+    return -1;
+
+  cn_log_open(ident != NULL ? ident : "libsn1ff", sn_cfg_get_minloglevel());
+  return 0;
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Results                                                        |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+sn1ff_result *sn1ff_result_begin(const char *checkid) {
+  sn1ff_result *result = calloc(1, sizeof(*result));
+  if (result == NULL)
+    return NULL;
+
+  if (sn_file_begin(result->path, checkid) != 0) {
+    free(result);
+    return NULL;
+  }
+
+  result->file = fopen(result->path, "a");
+  if (result->file == NULL) {
+    cn_log_msg(LOG_ERR, __func__,
+               "'fopen' gave an error opening file -> %s <-, strerror(errno) "
+               "-> %m <-",
+               result->path);
+    unlink(result->path);
+    free(result);
+    return NULL;
+  }
+
+  result->status = SN_STATUS_NONE;
+  result->ttl_mins = -1;
+  return result;
+}
+
+int sn1ff_result_append(sn1ff_result *result, const char *line) {
+  if (result == NULL || line == NULL || result->file == NULL)
+    return -1;
+
+  // Drop control characters, bar tab, as sn_frame_clean
+
+  for (const char *p = line; *p != '\0'; p++) {
+    unsigned char c = (unsigned char)*p;
+    if ((c >= 0x20 && c != 0x7f) || c == '\t')
+      putc(c, result->file);
+  }
+  putc('\n', result->file);
+
+  return ferror(result->file) ? -1 : 0;
+}
+
+int sn1ff_result_set_status(sn1ff_result *result, sn1ff_status status) {
+  if (result == NULL || status < SN1FF_NONE || status > SN1FF_ALRT)
+    return -1;
+
+  result->status = (Status)status;
+  return 0;
+}
+
+int sn1ff_result_set_ttl(sn1ff_result *result, int ttl_mins) {
+  if (result == NULL || ttl_mins < 0)
+    return -1;
+
+  result->ttl_mins = ttl_mins;
+  return 0;
+}
+
+int sn1ff_result_finish(sn1ff_result *result) {
+  if (result == NULL)
+    return -1;
+  if (result->file == NULL)
+    return 0;
+
+  int closed = fclose(result->file);
+  result->file = NULL;
+  if (closed != 0) {
+    cn_log_msg(LOG_ERR, __func__,
+               "Could not write file -> %s <-, strerror(errno) -> %m <-",
+               result->path);
+    return -1;
+  }
+  return 0;
+}
+
+static int add_pending(const SuppressRecord *record) {
+  if (pending_count == pending_capacity) {
+    size_t capacity = pending_capacity ? pending_capacity * 2 : 64;
+    SuppressRecord *grown = realloc(pending, capacity * sizeof(*pending));
+    if (grown == NULL)
+      return -1;
+    pending = grown;
+    pending_capacity = capacity;
+  }
+
+  pending[pending_count++] = *record;
+  return 0;
+}
+
+int sn1ff_result_deliver(sn1ff_result *result, const char *server) {
+  if (result == NULL || result->delivered ||
+      sn1ff_result_finish(result) != 0)
+    return -1;
+
+  char outbox_dir[512] = {'\0'};
+  if (server != NULL &&
+      sn_deliver_outbox_dir(outbox_dir, sizeof(outbox_dir)) != 0)
+    return -1;
+
+  SuppressRecord record;
+  bool sent = false;
+  if (sn_deliver_file(result->path, result->status, result->ttl_mins,
+                      server != NULL ? outbox_dir : NULL, server, &record,
+                      &sent) != 0)
+    return -1;
+
+  result->delivered = true;
+
+  if (sent) {
+    if (server == NULL)
+      sn_deliver_suppress_end(&record);
+    else
+      add_pending(&record); // Not recorded, it is sent again next time
+  }
+  return 0;
+}
+
+const char *sn1ff_result_path(const sn1ff_result *result) {
+  return result != NULL ? result->path : NULL;
+}
+
+void sn1ff_result_free(sn1ff_result *result) {
+  if (result == NULL)
+    return;
+
+  if (result->file != NULL)
+    fclose(result->file);
+  if (!result->delivered)
+    unlink(result->path);
+  free(result);
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Send                                                           |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+int sn1ff_flush(const char *server) {
+  if (server == NULL)
+    return -1;
+
+  char outbox_dir[512];
+  if (sn_deliver_outbox_dir(outbox_dir, sizeof(outbox_dir)) != 0 ||
+      sn_deliver_send_outbox(outbox_dir, server) != 0)
+    return -1;
+
+  for (size_t i = 0; i < pending_count; i++)
+    sn_deliver_suppress_end(&pending[i]);
+  pending_count = 0;
+
+  return 0;
+}
@@ -0,0 +1,344 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "cn_log.h"
+#include "cn_remotefe.h"
+#include "sn_cfg.h"
+#include "sn_deliver.h"
+#include "sn_dir.h"
+#include "sn_file.h"
+#include "sn_run.h"
+#include "sn_sched.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+// Longest wait between looking at the clock, so a change to it is noticed
+#define MAX_WAIT_MS (60 * 1000)
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Program usage                                                  |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+void print_usage(int level, char *program_name) {
+  cn_log_msg(
+      level, __func__,
+      "Usage:\n"
+      "  Display this info ...\n"
+      "    %s -h\n"
+      "\n"
+      "\n"
+      "  Run the agent_schedule checks, send results to local sn1ff server\n"
+      "    %s\n"
+      "\n"
+      "\n"
+      "  Run the agent_schedule checks, SCP results to remote sn1ff server\n"
+      "    %s -a <remote sn1ff server host>\n"
+      "\n"
+      "\n"
+      "See man pages:\n"
+      "    man (8) sn1ff_agent\n"
+      "    man (1) sn1ff_client\n"
+      "    man (7) sn1ff\n"
+      "  \n\n",
+      program_name, program_name, program_name);
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Signals                                                        |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+static volatile sig_atomic_t stop_requested = 0;
+static volatile sig_atomic_t refresh_requested = 0;
+
+static void on_stop(int signum) {
+  (void)signum;
+  stop_requested = 1;
+}
+
+static void on_refresh(int signum) {
+  (void)signum;
+  refresh_requested = 1;
+}
+
+static void set_handlers(void) {
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  sigemptyset(&action.sa_mask);
+
+  action.sa_handler = on_stop;
+  sigaction(SIGTERM, &action, NULL);
+  sigaction(SIGINT, &action, NULL);
+
+  action.sa_handler = on_refresh;
+  sigaction(SIGHUP, &action, NULL);
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Address changes                                                |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+/**
+ * Open a netlink socket, told of IPv4 addresses added to or removed from
+ * this host, so the host metadata is refreshed when they change
+ *
+ * @return  socket, -1 if it could not be opened
+ */
+static int open_addr_watch(void) {
+  int sock = socket(AF_NETLINK, SOCK_RAW, NETLINK_ROUTE);
+  if (sock == -1) {
+    cn_log_msg(LOG_WARNING, __func__,
+               "'socket' gave error opening netlink socket, strerror(errno) "
+               "-> %m <-");
+    return -1;
+  }
+
+  struct sockaddr_nl addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.nl_family = AF_NETLINK;
+  addr.nl_groups = RTMGRP_IPV4_IFADDR;
+
+  if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) == -1 ||
+      fcntl(sock, F_SETFL, O_NONBLOCK) == -1) {
+    cn_log_msg(LOG_WARNING, __func__,
+               "Could not set up netlink socket, strerror(errno) -> %m <-");
+    close(sock);
+    return -1;
+  }
+
+  return sock;
+}
+
+/**
+ * Read all waiting address change messages, as only the fact of a change
+ * is used
+ */
+static void drain_addr_watch(int sock) {
+  char buffer[8192];
+  while (recv(sock, buffer, sizeof(buffer), 0) > 0)
+    ;
+}
+
+static void refresh_host(void) {
+  if (sn_file_host_refresh() != 0)
+    cn_log_msg(LOG_WARNING, __func__,
+               "Could not get host name or ip addr, defaults used");
+  else
+    cn_log_msg(LOG_INFO, __func__, "Host metadata refreshed, host -> %s <-",
+               sn_file_host_name());
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Schedules                                                      |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+static int load_schedules(Schedule *schedules, size_t *count, time_t now) {
+  *count = 0;
+
+  for (int i = 0; i < sn_cfg_get_agent_schedule_count(); i++) {
+    const char *value = sn_cfg_get_agent_schedule(i);
+    if (sn_sched_parse(value, sn_file_host_name(), now,
+                       &schedules[*count]) != 0) {
+      cn_log_msg(LOG_ERR, __func__,
+                 "Invalid agent_schedule, expected <period mins>:<checks "
+                 "dir>, got -> %s <-",
+                 value);
+      return -1;
+    }
+
+    cn_log_msg(LOG_INFO, __func__,
+               "Checks in -> %s <- run every -> %ld <- mins, at -> %ld <- "
+               "secs into the period",
+               schedules[*count].dir, schedules[*count].period / 60,
+               schedules[*count].splay);
+    (*count)++;
+  }
+
+  return 0;
+}
+
+static void run_schedule(const Schedule *schedule, const char *server) {
+  Run run;
+  if (sn_run_discover(&run, schedule->dir) != 0) {
+    cn_log_msg(LOG_ERR, __func__, "Could not find checks in dir -> %s <-",
+               schedule->dir);
+    return;
+  }
+
+  sn_run_checks(&run, (size_t)sn_cfg_get_agent_jobs(),
+                sn_cfg_get_agent_timeout_secs());
+
+  if (sn_deliver_run(&run, server) != 0)
+    cn_log_msg(LOG_ERR, __func__,
+               "Not all results of checks in -> %s <- were delivered",
+               schedule->dir);
+
+  sn_run_free(&run);
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Cleanup                                                        |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+void cleanup(void) {
+  cn_log_msg(LOG_DEBUG, __func__, "Exiting ...");
+  cn_log_close();
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Main                                                           |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+int main(int argc, char *argv[]) {
+  atexit(cleanup);
+
+  if (sn_cfg_load() != 0) {
+    fprintf(stderr, "Could not open/access conf file -> %s <-\n",
+            sn_cfg_get_conf_file());
+    return EXIT_FAILURE;
+  }
+
+  cn_log_open(argv[0], sn_cfg_get_minloglevel());
+  cn_log_msg(LOG_DEBUG, __func__, "Starting ...");
+
+  // Options
+
+  const char *server = NULL; // -a Remote sn1ff server, NULL for this host
+
+  int opt;
+  while ((opt = getopt(argc, argv, "ha:")) != -1) {
+    switch (opt) {
+    case 'a':
+      server = optarg;
+      break;
+    case 'h':
+      print_usage(LOG_INFO, argv[0]);
+      return EXIT_SUCCESS;
+    default:
+      print_usage(LOG_ERR, argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  set_handlers();
+
+  // Host metadata, kept for every file begun
+
+  refresh_host();
+
+  // Schedules
+
+  Schedule schedules[SN_CFG_AGENT_SCHEDULES_MAX];
+  size_t count = 0;
+  if (load_schedules(schedules, &count, time(NULL)) != 0)
+    return EXIT_FAILURE;
+
+  if (count == 0) {
+    cn_log_msg(LOG_ERR, __func__, "No agent_schedule in conf file -> %s <-",
+               sn_cfg_get_conf_file());
+    return EXIT_FAILURE;
+  }
+
+  // Keep the SSH connection to a remote sn1ff server open between runs
+
+  if (server != NULL) {
+    long shortest = schedules[0].period;
+    for (size_t i = 1; i < count; i++)
+      if (schedules[i].period < shortest)
+        shortest = schedules[i].period;
+
+    char client_dir[256];
+    char control_path[512];
+    if (sn_dir_client(client_dir, sizeof(client_dir)) == 0) {
+      snprintf(control_path, sizeof(control_path), "%s/ssh-%%C", client_dir);
+      cn_remotefe_set_control(control_path, (int)shortest + 60);
+    }
+  }
+
+  int addr_watch = open_addr_watch();
+
+  // Run each schedule when due, until stopped
+
+  while (!stop_requested) {
+    time_t now = time(NULL);
+
+    size_t due = 0;
+    for (size_t i = 1; i < count; i++)
+      if (schedules[i].next < schedules[due].next)
+        due = i;
+
+    if (schedules[due].next <= now) {
+      run_schedule(&schedules[due], server);
+      schedules[due].next = sn_sched_next(time(NULL), schedules[due].period,
+                                          schedules[due].splay);
+      continue;
+    }
+
+    long wait_ms = (long)(schedules[due].next - now) * 1000;
+    if (wait_ms > MAX_WAIT_MS)
+      wait_ms = MAX_WAIT_MS;
+
+    struct pollfd pfd = {.fd = addr_watch, .events = POLLIN};
+    int ready = poll(&pfd, addr_watch != -1 ? 1 : 0, (int)wait_ms);
+
+    if (ready > 0 && (pfd.revents & POLLIN)) {
+      drain_addr_watch(addr_watch);
+      refresh_requested = 1;
+    }
+
+    if (refresh_requested) {
+      refresh_requested = 0;
+      refresh_host();
+    }
+  }
+
+  if (addr_watch != -1)
+    close(addr_watch);
+
+  return EXIT_SUCCESS;
+}
@@ -25,13 +25,15 @@ SOFTWARE.
 #define _POSIX_C_SOURCE 200809L
 
 #include "cn_log.h"
-#include "cn_multistr.h"
 #include "cn_string.h"
 #include "cn_time.h"
+#include "sn_batch.h"
 #include "sn_cfg.h"
 #include "sn_dir.h"
 #include "sn_file.h"
 #include "sn_fname.h"
+#include "sn_index.h"
+#include "sn_shard.h"
 #include <arpa/inet.h>
 #include <dirent.h>
 #include <stdint.h>
@@ -76,21 +78,129 @@ void print_usage(int level, char *program_name) {
  '----------------------------------------------------------------*/
 
 /**
- * Process LIST message from client, by supplying the names of
- * available sn1ff files
+ * Unlink the batched expired files, and log any that failed
+ */
+static void submit_deletes(Batch *batch) {
+  if (sn_batch_submit(batch) > 0) {
+    for (size_t i = 0; i < batch->count; i++) {
+      if (batch->ops[i].result != 0)
+        cn_log_msg(LOG_ERR, __func__,
+                   "Could not delete file -> %s <-, error -> %s <-",
+                   batch->ops[i].from, strerror(-batch->ops[i].result));
+    }
+  }
+  sn_batch_reset(batch);
+}
+
+typedef struct {
+  const char *watch_dir;
+  int shards;
+  Batch *batch; // NULL, to delete one by one
+  size_t inspected;
+} CLEANER_PASS;
+
+/**
+ * Delete a file in the "watch" directory, if it has "expired"
+ */
+static void expire_file(CLEANER_PASS *pass, const char *file_name,
+                        time_t epoch_bin) {
+  char file_path[SN_BATCH_PATH_LENGTH];
+
+  if (!cn_time_epoch_expired(epoch_bin))
+    return;
+
+  cn_log_msg(LOG_DEBUG, __func__, "Deleting file %s", file_name);
+
+  if (pass->batch == NULL) {
+    sn_file_delete_sharded(pass->watch_dir, pass->shards, file_name);
+    return;
+  }
+
+  if (sn_shard_path(pass->watch_dir, file_name, pass->shards, file_path,
+                    sizeof(file_path)) != 0)
+    return;
+
+  if (sn_batch_add_unlink(pass->batch, file_path, false) == -1) {
+    submit_deletes(pass->batch);
+    sn_batch_add_unlink(pass->batch, file_path, false);
+  }
+}
+
+/**
+ * Inspect a file read from the "watch" directory
+ */
+static int inspect_file(const char *file_name, void *arg) {
+  CLEANER_PASS *pass = arg;
+
+  pass->inspected++;
+  cn_log_msg(LOG_DEBUG, __func__, "Inspecting file %s", file_name);
+
+  // Not a sn1ff file name, its expiry is not known
+
+  CName name;
+  if (sn_cname_parse_name(file_name, &name) != CNAME_PARSE_OK)
+    return 0;
+
+  time_t epoch_bin;
+  sn_cname_get_epoch_bin(&name, &epoch_bin);
+
+  expire_file(pass, file_name, epoch_bin);
+  return 0;
+}
+
+/**
+ * Inspect a file in the "watch" directory index, already parsed
+ */
+static int inspect_entry(const IndexEntry *entry, void *arg) {
+  CLEANER_PASS *pass = arg;
+
+  pass->inspected++;
+  if (entry->status != SN_STATUS_INVALID)
+    expire_file(pass, entry->name, (time_t)entry->expiry);
+  return 0;
+}
+
+/**
+ * Delete the expired sn1ff files in the "watch" directory, every 60 seconds
+ *
+ * The files are kept in an index, so each pass only rescans the (shard)
+ * dirs that changed. The index is checkpointed after each pass that
+ * changed it, and loaded on start, so a restart does not rescan every dir.
+ * Without an index, the files are inspected as the directory is read
  *
- * @param [i] client_sock    socket to communicate to the client with
- * @return                   none
+ * @param [i] sn1ff_watch_files_dir    the "watch" directory
+ * @return                             none
  */
 void clean_files(const char *sn1ff_watch_files_dir) {
-  MultiString ms;
+  Batch batch;
+  Index index;
+  int shards = sn_cfg_get_server_shards();
+  bool checkpoint = sn_cfg_index_checkpoint_enabled();
+
+  // Expired files are unlinked in batches, or one by one without a batch
+
+  bool batched = sn_batch_init(&batch, SN_BATCH_CAPACITY) == 0;
+
+  bool indexed = sn_index_init(&index, sn1ff_watch_files_dir, shards) == 0;
+  if (indexed && checkpoint &&
+      sn_index_load(&index, sn_cfg_get_server_watch_index_file()) == 0)
+    cn_log_msg(LOG_INFO, __func__, "Loaded -> %zu <- files from checkpoint",
+               index.count);
 
   while (true) {
-    cn_multistr_init(&ms);
+    CLEANER_PASS pass = {sn1ff_watch_files_dir, shards,
+                         batched ? &batch : NULL, 0};
+    int status;
 
-    // Get list of sn1ff files
+    if (indexed) {
+      int rescanned = sn_index_refresh(&index);
+      cn_log_msg(LOG_DEBUG, __func__, "Rescanned -> %d <- dirs", rescanned);
 
-    int status = sn_dir_list_files(sn1ff_watch_files_dir, &ms);
+      status = rescanned < 0 ? 1 : sn_index_each(&index, inspect_entry, &pass);
+    } else {
+      status = sn_dir_each_file_sharded(sn1ff_watch_files_dir, shards,
+                                        inspect_file, &pass);
+    }
 
     if (status != 0) {
       cn_log_msg(LOG_ERR, __func__,
@@ -99,30 +209,19 @@ void clean_files(const char *sn1ff_watch_files_dir) {
       EXIT_FAILURE;
     }
 
-    if (ms.num_strings > 0) {
-      for (size_t i = 0; i < ms.num_strings; ++i) {
-        cn_log_msg(LOG_DEBUG, __func__, "Inspecting file %s",
-                   cn_multistr_getstr(&ms, i));
-        CName name;
-        sn_cname_parse_name(cn_multistr_getstr(&ms, i), &name);
-
-        time_t epoch_bin;
-        sn_cname_get_epoch_bin(&name, &epoch_bin);
-
-        // Delete sn1ff file if it has "expired"
-
-        if (cn_time_epoch_expired(epoch_bin)) {
-          cn_log_msg(LOG_DEBUG, __func__, "Deleting file %s",
-                     cn_multistr_getstr(&ms, i));
-          sn_file_delete(sn1ff_watch_files_dir, cn_multistr_getstr(&ms, i));
-          sleep(1);
-        }
-      }
+    if (pass.inspected > 0) {
+      if (batched)
+        submit_deletes(&batch);
     } else {
       cn_log_msg(LOG_DEBUG, __func__, "No sn1ff files to inspect\n");
     }
 
-    cn_multistr_free(&ms);
+    // Dirs with deleted files have a new mtime, so are rescanned on the
+    // next pass, or on a restart from this checkpoint
+
+    if (indexed && checkpoint && index.dirty)
+      sn_index_save(&index, sn_cfg_get_server_watch_index_file());
+
     cn_log_msg(LOG_DEBUG, __func__, "Sleeping for 60 seconds");
     sleep(60);
   }
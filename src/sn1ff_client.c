@@ -28,8 +28,11 @@ SOFTWARE.
 #include "cn_log.h"
 #include "cn_remotefe.h"
 #include "sn_cfg.h"
+#include "sn_deliver.h"
 #include "sn_file.h"
 #include "sn_fpath.h"
+#include "sn_frame.h"
+#include "sn_run.h"
 #include "sn_status.h"
 #include <stdbool.h>
 
@@ -47,6 +50,16 @@ void print_usage(int level, char *program_name) {
       "    %s -b\n"
       "\n"
       "\n"
+      "  Append to sn1ff file, from commands read on stdin "
+      "[title|first|header|message|center|trailer] <text>\n"
+      "    %s -w -f <sn1ff file path/name>\n"
+      "\n"
+      "\n"
+      "  Run the checks in a dir in parallel, and send the results\n"
+      "    %s run [-j <jobs>] [-T <timeout in seconds>] "
+      "[-a <remote sn1ff server host>] <dir>\n"
+      "\n"
+      "\n"
       "  End sn1ff file, copy it to local sn1ff server directory\n"
       "    %s -e -f <sn1ff file path/name> -s <status [ALRT}WARN|OKAY|NONE]> "
       "-t <TTL in minutes>\n\n",
@@ -62,7 +75,143 @@ void print_usage(int level, char *program_name) {
       "    man (7) sn1ff_service\n"
       "    man (1) sn1ff_monitor\n"
       "  \n\n",
-      program_name, program_name, program_name, program_name);
+      program_name, program_name, program_name, program_name, program_name,
+      program_name);
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Append to file                                                 |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+// Output buffer, the file is written when full, so in few large writes
+#define STREAM_BUFFER_SIZE (64 * 1024)
+
+/**
+ * "-w" - append to a sn1ff file, from the commands read on stdin (see
+ * sn_frame.h), through one buffered stream
+ *
+ * @return  EXIT_SUCCESS, EXIT_FAILURE if a command was not recognized, or
+ *          the file could not be written
+ */
+static int stream_file(const char *file_path) {
+  FILE *out = fopen(file_path, "a");
+  if (out == NULL) {
+    cn_log_msg(LOG_ERR, __func__,
+               "'fopen' gave an error opening file -> %s <-, strerror(errno) "
+               "-> %m <-",
+               file_path);
+    return EXIT_FAILURE;
+  }
+  setvbuf(out, NULL, _IOFBF, STREAM_BUFFER_SIZE);
+
+  char *line = NULL;
+  size_t line_sz = 0;
+  ssize_t len;
+  size_t line_no = 0;
+  int exit_code = EXIT_SUCCESS;
+
+  while ((len = getline(&line, &line_sz, stdin)) != -1) {
+    line_no++;
+    if (len > 0 && line[len - 1] == '\n')
+      line[len - 1] = '\0';
+
+    if (sn_frame_line(out, line) != 0) {
+      cn_log_msg(LOG_ERR, __func__,
+                 "Command not recognized -> %s <-, on line -> %zu <-", line,
+                 line_no);
+      exit_code = EXIT_FAILURE;
+    }
+  }
+  free(line);
+
+  if (fclose(out) != 0) {
+    cn_log_msg(LOG_ERR, __func__,
+               "Could not write file -> %s <-, strerror(errno) -> %m <-",
+               file_path);
+    exit_code = EXIT_FAILURE;
+  }
+
+  return exit_code;
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Run checks                                                     |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+/**
+ * "run" - run every check under a dir in parallel, and deliver the
+ * results, through the outbox if to a remote sn1ff server
+ *
+ * @return  EXIT_SUCCESS, EXIT_FAILURE
+ */
+static int run_checks(int argc, char *argv[]) {
+  size_t jobs = SN_RUN_DEFAULT_JOBS;
+  int timeout_secs = SN_RUN_DEFAULT_TIMEOUT;
+  const char *server = NULL;
+  char *endptr = NULL;
+  long value;
+
+  // Options follow "run", as if it were the program name
+
+  optind = 1;
+  int opt;
+  while ((opt = getopt(argc - 1, argv + 1, "j:T:a:")) != -1) {
+    switch (opt) {
+    case 'j': // Jobs, run in parallel
+      value = strtol(optarg, &endptr, 10);
+      if (*endptr != '\0' || value < 1 || value > SN_RUN_MAX_JOBS) {
+        cn_log_msg(LOG_ERR, __func__, "Jobs must be 1 to %d -> %s <-",
+                   SN_RUN_MAX_JOBS, optarg);
+        return EXIT_FAILURE;
+      }
+      jobs = (size_t)value;
+      break;
+    case 'T': // Timeout of each check, in seconds
+      value = strtol(optarg, &endptr, 10);
+      if (*endptr != '\0' || value < 1 || value > 86400) {
+        cn_log_msg(LOG_ERR, __func__,
+                   "Timeout must be 1 to 86400 seconds -> %s <-", optarg);
+        return EXIT_FAILURE;
+      }
+      timeout_secs = (int)value;
+      break;
+    case 'a': // Remote sn1ff server
+      server = optarg;
+      break;
+    default:
+      cn_log_msg(LOG_ERR, __func__, "Option not recognized-> %c <-", opt);
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (optind != argc - 2) {
+    cn_log_msg(LOG_ERR, __func__, "Expected one dir of checks to run");
+    print_usage(LOG_ERR, argv[0]);
+    return EXIT_FAILURE;
+  }
+  const char *dir = argv[optind + 1];
+
+  // Run the checks
+
+  Run run;
+  if (sn_run_discover(&run, dir) != 0) {
+    cn_log_msg(LOG_ERR, __func__, "Could not find checks in dir -> %s <-", dir);
+    return EXIT_FAILURE;
+  }
+
+  if (sn_run_checks(&run, jobs, timeout_secs) != 0)
+    cn_log_msg(LOG_ERR, __func__, "Not all checks in -> %s <- could be run",
+               dir);
+
+  // Deliver the results
+
+  int result = sn_deliver_run(&run, server);
+  sn_run_free(&run);
+  return result == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
 }
 
 /*----------------------------------------------------------------.
@@ -108,6 +257,13 @@ int main(int argc, char *argv[]) {
   cn_log_open(argv[0], min_log_level);
   cn_log_msg(LOG_DEBUG, __func__, "Starting ...");
 
+  /*
+   * Run checks, "run" is a subcommand with its own options
+   */
+
+  if (argc > 1 && strcmp(argv[1], "run") == 0)
+    return run_checks(argc, argv);
+
   /*
    * Process options
    */
@@ -115,6 +271,7 @@ int main(int argc, char *argv[]) {
   bool is_help = false;       // -h Help requested
   bool is_begin_file = false; // -b Begin file
   bool is_end_file = false;   // -e End file, SCP to remote sn1ff server
+  bool is_stream = false;     // -w Append to file, from stdin
 
   char *arg_i = NULL; // ID of the sn1ff check
   char *arg_f = NULL; // File path of sn1ff file
@@ -129,10 +286,12 @@ int main(int argc, char *argv[]) {
   // Leave empty if client is on same host
   // as the sn1ff server (local check)
 
+  SuppressRecord record; // Of the result being sent, when suppressing
+
   // Loop through command-line arguments using getopt
 
   int opt;
-  while ((opt = getopt(argc, argv, "hbef:s:t:a:i:")) != -1) {
+  while ((opt = getopt(argc, argv, "hbewf:s:t:a:i:")) != -1) {
     switch (opt) {
       // Begin file
     case 'b':
@@ -142,6 +301,11 @@ int main(int argc, char *argv[]) {
       arg_i = optarg;
       break;
 
+      // Append to file
+    case 'w':
+      is_stream = true;
+      break;
+
       // End file
     case 'e':
       is_end_file = true;
@@ -180,6 +344,15 @@ int main(int argc, char *argv[]) {
   // Begin file
 
   else if (is_begin_file) {
+
+    // Run by "sn1ff_client run", which has begun the file already
+
+    const char *run_file = getenv(SN_RUN_FILE_ENV);
+    if (run_file != NULL && run_file[0] != '\0') {
+      fprintf(stdout, "%s\n", run_file);
+      return EXIT_SUCCESS;
+    }
+
     char file_path[FNAME_PATH_LENGTH_D] = {'\0'};
     int result = sn_file_begin(file_path, arg_i);
     if (result != 0) {
@@ -194,6 +367,12 @@ int main(int argc, char *argv[]) {
     return EXIT_SUCCESS;
   }
 
+  // Append to file
+
+  else if (is_stream && arg_f != NULL) {
+    return stream_file(arg_f);
+  }
+
   // End file - local copy - address or "host" is not set in arg_a
 
   else if (is_end_file && arg_f != NULL && arg_s != NULL && arg_t != NULL &&
@@ -206,15 +385,20 @@ int main(int argc, char *argv[]) {
       return EXIT_FAILURE;
     }
 
-    // Clean non printable chars from file
+    // Finish the file, cleaning non printable chars from it
 
-    if (cn_file_clean(arg_f) != 0) {
-      cn_log_msg(LOG_ERR, __func__,
-                 "Error cleaning non-printable chars from file ->%s<-", arg_f);
+    if (sn_file_finish(arg_f, sn_status_from_chars(arg_s)) != 0)
       return EXIT_FAILURE;
-    }
 
-    // Build destination file path
+    // Skip a result unchanged from the last one sent. Hashed once finished,
+    // as sn_deliver_file does, so results sent either way match
+
+    int suppress =
+        sn_deliver_suppress_begin(arg_f, arg_s, arg_t, arg_a, &record);
+    if (suppress == SN_SUPPRESS_SKIP)
+      return EXIT_SUCCESS;
+
+    // Convert TTL
 
     char *endptr = NULL;
     int arg_t_i =
@@ -226,45 +410,13 @@ int main(int argc, char *argv[]) {
       return EXIT_FAILURE;
     }
 
-    char new_dir_path[FNAME_PATH_LENGTH_D] = {'\0'};
-    memset(new_dir_path, '\0', (FNAME_PATH_LENGTH_D) * sizeof(char));
-
-    sn_fpath_genfull(arg_f, arg_s, sn_cfg_get_server_upload_dir(), arg_t_i,
-                     new_dir_path);
-
-    // Copy the file
-
-    if (cn_file_copy(arg_f, new_dir_path) != 0) {
-      cn_log_msg(LOG_ERR, __func__, "Copy of file failed, from -> %s  to -> %s",
-                 arg_f, new_dir_path);
-      return EXIT_FAILURE;
-    }
-
-    // Change the file group
-
-    if (cn_file_chgrp(new_dir_path, sn_cfg_get_server_group()) != 0) {
-      cn_log_msg(
-          LOG_ERR, __func__,
-          "main: Setting group failed for file -> %s <- to group -> %s <-",
-          new_dir_path, sn_cfg_get_server_group);
-      return EXIT_FAILURE;
-    }
-
-    // Change the file mode to 660
+    // Copy it to the local sn1ff server
 
-    if (cn_file_mode660(new_dir_path) != 0) {
-      cn_log_msg(LOG_ERR, __func__, "Setting mode 660 failed for file -> %s <-",
-                 new_dir_path);
+    if (sn_deliver_local(arg_f, arg_s, arg_t_i) != 0)
       return EXIT_FAILURE;
-    }
 
-    // Delete the original file
-
-    if (cn_file_delete(arg_f) != 0) {
-      cn_log_msg(LOG_ERR, __func__, "Delete of file failed, from -> %s <-",
-                 arg_f);
-      return EXIT_FAILURE;
-    }
+    if (suppress == SN_SUPPRESS_SEND)
+      sn_deliver_suppress_end(&record);
   }
 
   // End file - Remote SCP - address or "host" has value in arg_a
@@ -279,13 +431,18 @@ int main(int argc, char *argv[]) {
       return EXIT_FAILURE;
     }
 
-    // Clean non printable chars from file
+    // Finish the file, cleaning non printable chars from it
 
-    if (cn_file_clean(arg_f) != 0) {
-      cn_log_msg(LOG_ERR, __func__,
-                 "Error cleaning non-printable chars from file ->%s<-", arg_f);
+    if (sn_file_finish(arg_f, sn_status_from_chars(arg_s)) != 0)
       return EXIT_FAILURE;
-    }
+
+    // Skip a result unchanged from the last one sent. Hashed once finished,
+    // as sn_deliver_file does, so results sent either way match
+
+    int suppress =
+        sn_deliver_suppress_begin(arg_f, arg_s, arg_t, arg_a, &record);
+    if (suppress == SN_SUPPRESS_SKIP)
+      return EXIT_SUCCESS;
 
     // Build destination file path
 
@@ -325,6 +482,9 @@ int main(int argc, char *argv[]) {
       cn_log_msg(LOG_ERR, __func__, "Remote copy with scp failed");
       return EXIT_FAILURE;
     }
+
+    if (suppress == SN_SUPPRESS_SEND)
+      sn_deliver_suppress_end(&record);
   }
 
   else {
@@ -24,16 +24,25 @@ SOFTWARE.
 
 #define _POSIX_C_SOURCE 200809L
 
+#include "cn_host.h"
 #include "cn_log.h"
-#include "cn_multistr.h"
 #include "cn_string.h"
 #include "cn_time.h"
 #include "sn_cfg.h"
+#include "sn_dedup.h"
 #include "sn_dir.h"
 #include "sn_file.h"
 #include "sn_fname.h"
+#include "sn_history.h"
+#include "sn_ingest.h"
+#include "sn_metrics.h"
+#include "sn_shard.h"
+#include "sn_sink.h"
+#include "sn_trigram.h"
+#include "sn_tsdb.h"
 #include <arpa/inet.h>
 #include <dirent.h>
+#include <signal.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -43,6 +52,10 @@ SOFTWARE.
 #include <sys/un.h>
 #include <unistd.h>
 
+// Seconds between compactions of the search index, dropping the documents
+// of expired results
+#define GREETER_COMPACT_SECS 3600
+
 /*----------------------------------------------------------------.
  |                                                                |
  | Program usage                                                  |
@@ -75,20 +88,407 @@ void print_usage(int level, char *program_name) {
  |                                                                |
  '----------------------------------------------------------------*/
 
+typedef struct {
+  char previous[CNAME_NAME_LENGTH_D];
+  char name[CNAME_NAME_LENGTH_D];
+} SUPERSEDED;
+
+typedef struct {
+  Ingest *ingest;
+  size_t submitted;
+  size_t unwatched; // Submitted for "export" only
+  Dedup *dedup;     // NULL, when not checking results against the last
+  bool replace;     // Replace repeated results in "watch"
+  History *history; // NULL, when not keeping status history
+  Tsdb *metrics;    // NULL, when not extracting metrics
+  MetricRules *rules;
+  TrigramIndex *search; // NULL, when not indexing bodies for search
+  Sink *sink;           // NULL, when not streaming results
+  FILE_DATA *file_data; // Read into, for metrics and the sink
+  MultiString published; // Published this pass, to record
+  time_t now;
+  SUPERSEDED *superseded;
+  size_t num_superseded;
+  size_t superseded_capacity;
+} GREETER_PASS;
+
+/**
+ * Note a "watch" file, superseded by an identical later result
+ */
+static void add_superseded(GREETER_PASS *pass, const char *previous,
+                           const char *name) {
+  if (pass->num_superseded == pass->superseded_capacity) {
+    size_t capacity =
+        pass->superseded_capacity == 0 ? 64 : pass->superseded_capacity * 2;
+    SUPERSEDED *superseded =
+        realloc(pass->superseded, capacity * sizeof(SUPERSEDED));
+    if (superseded == NULL)
+      return; // Kept, it expires as before
+    pass->superseded = superseded;
+    pass->superseded_capacity = capacity;
+  }
+
+  SUPERSEDED *entry = &pass->superseded[pass->num_superseded++];
+  strcpy(entry->previous, previous);
+  strcpy(entry->name, name);
+}
+
+typedef struct {
+  Tsdb *metrics;
+  const HEADER *hdr;
+  time_t at;
+} METRIC_POINT;
+
+static int add_point(const char *name, double value, void *arg) {
+  METRIC_POINT *point = arg;
+  return sn_tsdb_add(point->metrics, point->hdr->host, point->hdr->checkid,
+                     name, value, point->at);
+}
+
+/**
+ * Path of the published copy of a result, in "export" when it went there,
+ * as that is kept longest, else in "watch"
+ *
+ * @return  0 success
+ *         -1 no published copy, e.g. it was already removed from "watch"
+ */
+static int published_path(const Ingest *ingest, const char *name, char *path,
+                          size_t path_sz) {
+  const char *dirs[] = {ingest->export_dir, ingest->watch_dir};
+
+  for (size_t i = 0; i < 2; i++)
+    if (dirs[i] != NULL &&
+        sn_shard_path(dirs[i], name, ingest->shards, path, path_sz) == 0 &&
+        access(path, F_OK) == 0)
+      return 0;
+  return -1;
+}
+
+/**
+ * Record the status of a published result in the history store, when it
+ * changes the status of its (Host, CheckID), add the metrics the rules
+ * extract from its body to the metrics store, its body to the search
+ * index, and its record to the sink
+ */
+static void record_result(GREETER_PASS *pass, const char *name) {
+  CName cname;
+  HEADER hdr;
+  char path[1024];
+
+  if (published_path(pass->ingest, name, path, sizeof(path)) != 0 ||
+      sn_cname_parse_name(name, &cname) != CNAME_PARSE_OK ||
+      sn_file_read_header(path, &hdr) != 0)
+    return;
+
+  if (pass->history != NULL)
+    sn_history_record(pass->history, hdr.host, hdr.checkid,
+                      sn_cname_get_status_id(&cname), pass->now);
+
+  // The search index takes the body as written, not cut to the lines
+  // sn_file_read keeps
+
+  if (pass->search != NULL) {
+    char *body = NULL;
+    size_t body_len = 0;
+    if (sn_file_read_body(path, SN_FILE_MAX_RAW_BODY, &body, &body_len) >=
+        0) {
+      sn_trigram_add(pass->search, &hdr, name, pass->now, body, body_len);
+      free(body);
+    }
+  }
+
+  // Without bodies in the sink, only the results of checks with rules are
+  // read whole
+
+  bool measure =
+      pass->metrics != NULL && sn_metrics_applies(pass->rules, hdr.checkid);
+  bool whole = measure || (pass->sink != NULL && pass->sink->body);
+  bool read = whole && sn_file_read(path, pass->file_data) == 0;
+
+  if (pass->sink != NULL)
+    sn_sink_add(pass->sink, name, &cname, &hdr,
+                read ? pass->file_data : NULL, pass->now);
+
+  if (!read)
+    return;
+
+  // Points are at the time the check ran, the "At: " of its header, not
+  // when the greeter got to it
+
+  if (measure) {
+    time_t at;
+    if (cn_host_utcdt_parse(hdr.timestamp, &at) != 0)
+      at = pass->now;
+
+    METRIC_POINT point = {pass->metrics, &hdr, at};
+    sn_metrics_extract(pass->rules, pass->file_data, add_point, &point);
+  }
+}
+
+/**
+ * Record the results published, or resumed from the journal, since last
+ * recorded. Results dropped by dedup, or not published, are not recorded
+ */
+static void record_published(GREETER_PASS *pass) {
+  for (size_t i = 0; i < pass->published.num_strings; i++)
+    record_result(pass, cn_multistr_getstr(&pass->published, i));
+
+  cn_multistr_free(&pass->published);
+}
+
+/**
+ * Hand a file read from the "upload" directory to the ingest worker pool
+ */
+static int submit_file(const char *name, void *arg) {
+  GREETER_PASS *pass = arg;
+  int flags = SN_DEDUP_WATCH;
+
+  // A file that can not be checked, is shown in "watch"
+
+  if (pass->dedup != NULL) {
+    char previous[CNAME_NAME_LENGTH_D];
+    int result = sn_dedup_check(pass->dedup, pass->ingest->upload_dir, name,
+                                pass->now, previous);
+    if (result >= 0)
+      flags = result;
+    if (pass->replace && (flags & SN_DEDUP_REPEAT))
+      add_superseded(pass, previous, name);
+  }
+
+  if (!(flags & SN_DEDUP_WATCH)) {
+    if (sn_ingest_submit_export(pass->ingest, name) == 0) {
+      pass->submitted++;
+      pass->unwatched++;
+    }
+  } else if (sn_ingest_submit(pass->ingest, name) == 0) {
+    pass->submitted++;
+  }
+  return 0;
+}
+
+/**
+ * Remove the "watch" files superseded by an identical later result, once
+ * that result is in "watch" in their place
+ *
+ * @return  number of files removed
+ */
+static size_t remove_superseded(GREETER_PASS *pass, const char *watch_dir,
+                                int shards) {
+  size_t removed = 0;
+
+  for (size_t i = 0; i < pass->num_superseded; i++) {
+    char path[1024];
+    char previous_path[1024];
+    SUPERSEDED *entry = &pass->superseded[i];
+
+    if (sn_shard_path(watch_dir, entry->name, shards, path, sizeof(path)) !=
+            0 ||
+        sn_shard_path(watch_dir, entry->previous, shards, previous_path,
+                      sizeof(previous_path)) != 0)
+      continue;
+
+    // Not published, or already removed (expired, or removed by a user)
+
+    if (access(path, F_OK) != 0 || access(previous_path, F_OK) != 0)
+      continue;
+
+    sn_file_delete_sharded(watch_dir, shards, entry->previous);
+    removed++;
+  }
+
+  pass->num_superseded = 0;
+  return removed;
+}
+
 /**
- * Move files to the "watch" and "data" directories
+ * Move files to the "watch" and "export" directories
+ *
+ * Each pass reads the "upload" directory, and hands the files to the ingest
+ * worker pool as they are read, so workers start before the read ends. The
+ * pass waits for the pool to finish, so a file is never being processed by
+ * two workers
+ *
+ * With dedup enabled, a result that repeats the last result of its (Host,
+ * CheckID) byte for byte (bar its "At: " time) replaces it in "watch",
+ * rather than being shown beside it. With transitions only, a result only
+ * goes to "watch" on a change of status, while WARN / ALRT, or for a
+ * heartbeat. "export" still gets every result. The last result of each
+ * check is kept in a state file across restarts
  */
 void copy_files(const char *sn1ff_upload_files_dir,
                 const char *sn1ff_watch_files_dir,
                 const char *sn1ff_export_files_dir) {
-  MultiString ms;
+  Ingest ingest;
+  GREETER_PASS pass = {0};
+  int shards = sn_cfg_get_server_shards();
+
+  // Sharded "watch" / "export" dirs, need their shard dirs to publish into
+
+  if (shards != SN_SHARD_NONE &&
+      ((sn_cfg_watch_enabled() &&
+        sn_shard_create_dirs(sn1ff_watch_files_dir, shards) != 0) ||
+       (sn_cfg_export_enabled() &&
+        sn_shard_create_dirs(sn1ff_export_files_dir, shards) != 0))) {
+    cn_log_msg(LOG_ERR, __func__, "Error creating -> %d <- shard dirs",
+               shards);
+    return;
+  }
+
+  const char *watch_dir =
+      sn_cfg_watch_enabled() ? sn1ff_watch_files_dir : NULL;
+  const char *export_dir =
+      sn_cfg_export_enabled() ? sn1ff_export_files_dir : NULL;
+
+  // Resume any files part way through ingest when last stopped, then start
+  // a new journal. Those resumed are recorded with the first pass
+
+  Journal journal;
+  bool journaled = false;
+
+  if (sn_cfg_greeter_journal_enabled()) {
+    const char *journal_path = sn_cfg_get_server_ingest_journal_file();
+    int resumed =
+        sn_ingest_recover(journal_path, sn1ff_upload_files_dir, watch_dir,
+                          export_dir, shards, &pass.published);
+    if (resumed > 0)
+      cn_log_msg(LOG_INFO, __func__, "Resumed -> %d <- files from journal",
+                 resumed);
+
+    journaled = resumed >= 0 && sn_journal_open(&journal, journal_path) == 0 &&
+                sn_journal_reset(&journal) == 0;
+    if (!journaled)
+      cn_log_msg(LOG_WARNING, __func__, "Running without ingest journal");
+  }
+
+  int status = sn_ingest_start(&ingest, sn1ff_upload_files_dir, watch_dir,
+                               export_dir, shards,
+                               journaled ? &journal : NULL,
+                               (size_t)sn_cfg_get_greeter_workers());
+
+  if (status != 0) {
+    cn_log_msg(LOG_ERR, __func__, "Error starting ingest workers -> %d <-",
+               status);
+    return;
+  }
+
+  // Last result of each check, to spot repeats and unchanged statuses
+
+  Dedup dedup;
+  const char *state_path = sn_cfg_get_server_check_state_file();
+  bool transitions = sn_cfg_greeter_transitions_only();
+  bool deduped =
+      watch_dir != NULL && (sn_cfg_greeter_dedup_enabled() || transitions) &&
+      sn_dedup_init(&dedup, transitions,
+                    (long)sn_cfg_get_greeter_heartbeat_mins() * 60) == 0;
+
+  if (deduped && sn_dedup_load(&dedup, state_path) == 0)
+    cn_log_msg(LOG_INFO, __func__, "Loaded last results of -> %zu <- checks",
+               dedup.count);
+
+  // Status history of each check, indexing any days over since last run
+
+  History history;
+  bool historied =
+      sn_cfg_greeter_history_enabled() &&
+      sn_history_open(&history, sn_cfg_get_server_history_dir()) == 0;
+
+  if (historied) {
+    int indexed = sn_history_index_all(
+        history.dir, (int64_t)cn_time_epoch() / SN_HISTORY_DAY_SECS);
+    if (indexed > 0)
+      cn_log_msg(LOG_INFO, __func__, "Indexed -> %d <- days of history",
+                 indexed);
+  } else if (sn_cfg_greeter_history_enabled()) {
+    cn_log_msg(LOG_WARNING, __func__, "Running without status history");
+  }
+
+  // Metrics extracted from results by the rules, into the metrics store
+
+  Tsdb metrics;
+  MetricRules rules = {0};
+  FILE_DATA *file_data = NULL;
+  bool measured = false;
+
+  bool sinking = sn_cfg_get_greeter_sink_path()[0] != '\0';
+
+  if (sn_cfg_greeter_metrics_enabled() ||
+      (sinking && sn_cfg_greeter_sink_body()))
+    file_data = malloc(sizeof(FILE_DATA));
+
+  if (sn_cfg_greeter_metrics_enabled()) {
+    int loaded =
+        sn_metrics_load(&rules, sn_cfg_get_server_metrics_rules_file());
+    measured = loaded > 0 && file_data != NULL &&
+               sn_tsdb_open(&metrics, sn_cfg_get_server_metrics_dir()) == 0;
+    if (measured)
+      cn_log_msg(LOG_INFO, __func__, "Loaded -> %d <- metrics rules", loaded);
+    else
+      cn_log_msg(LOG_WARNING, __func__,
+                 "Running without metrics, no rules in -> %s <-, or no "
+                 "metrics store",
+                 sn_cfg_get_server_metrics_rules_file());
+  }
+
+  // Search index of result bodies, indexing any left from the last run
+
+  TrigramIndex search;
+  time_t compacted = 0;
+  bool searched =
+      sn_cfg_greeter_search_enabled() &&
+      sn_trigram_open(&search, sn_cfg_get_server_search_dir()) == 0;
+
+  if (searched) {
+    int indexed = sn_trigram_flush(&search);
+    if (indexed > 0)
+      cn_log_msg(LOG_INFO, __func__, "Indexed -> %d <- results for search",
+                 indexed);
+  } else if (sn_cfg_greeter_search_enabled()) {
+    cn_log_msg(LOG_WARNING, __func__, "Running without search index");
+  }
+
+  // Stream of results to a downstream consumer, never waiting on it
+
+  Sink sink;
+
+  if (sinking) {
+    signal(SIGPIPE, SIG_IGN); // A FIFO reader going, is seen as EPIPE
+    sinking =
+        (file_data != NULL || !sn_cfg_greeter_sink_body()) &&
+        sn_sink_open(&sink, sn_cfg_get_greeter_sink_path(),
+                     sn_cfg_get_greeter_sink_type(),
+                     (size_t)sn_cfg_get_greeter_sink_buffer_kb() * 1024,
+                     sn_cfg_greeter_sink_body()) == 0;
+    if (!sinking)
+      cn_log_msg(LOG_WARNING, __func__, "Running without sink -> %s <-",
+                 sn_cfg_get_greeter_sink_path());
+  }
+
+  pass.ingest = &ingest;
+  pass.dedup = deduped ? &dedup : NULL;
+  pass.replace = sn_cfg_greeter_dedup_enabled();
+  pass.history = historied ? &history : NULL;
+  pass.metrics = measured ? &metrics : NULL;
+  pass.rules = &rules;
+  pass.search = searched ? &search : NULL;
+  pass.sink = sinking ? &sink : NULL;
+  pass.file_data = file_data;
+
+  // Results are recorded once published, so never for a file left in
+  // "upload" to be tried again
+
+  if (historied || measured || searched || sinking)
+    sn_ingest_keep_published(&ingest, &pass.published);
+  else
+    cn_multistr_free(&pass.published);
 
   while (true) {
-    cn_multistr_init(&ms);
+    pass.submitted = 0;
+    pass.unwatched = 0;
+    pass.now = cn_time_epoch();
 
-    // Get list of sn1ff files, in the upload directory
+    // Submit the sn1ff files in the upload directory, as they are read
 
-    int status = sn_dir_list_files(sn1ff_upload_files_dir, &ms);
+    status = sn_dir_each_file(sn1ff_upload_files_dir, submit_file, &pass);
 
     if (status != 0) {
       cn_log_msg(LOG_ERR, __func__,
@@ -97,34 +497,90 @@ void copy_files(const char *sn1ff_upload_files_dir,
       EXIT_FAILURE;
     }
 
-    if (ms.num_strings > 0) {
-      for (size_t i = 0; i < ms.num_strings; ++i) {
-        cn_log_msg(LOG_DEBUG, __func__, "Inspecting file %s",
-                   cn_multistr_getstr(&ms, i));
-
-        if (sn_cfg_watch_enabled()) {
-          sn_file_copy(sn1ff_upload_files_dir, sn1ff_watch_files_dir,
-                       cn_multistr_getstr(&ms, i));
-        }
-
-        if (sn_cfg_export_enabled()) {
-          sn_file_copy(sn1ff_upload_files_dir, sn1ff_export_files_dir,
-                       cn_multistr_getstr(&ms, i));
-        }
-
-        cn_log_msg(LOG_DEBUG, __func__, "Deleting file %s",
-                   cn_multistr_getstr(&ms, i));
-        sn_file_delete(sn1ff_upload_files_dir, cn_multistr_getstr(&ms, i));
-        sleep(1);
-      }
+    if (pass.submitted > 0) {
+      sn_ingest_drain(&ingest);
+
+      // Every file is published or left in "upload", none part way
+
+      if (journaled)
+        sn_journal_reset(&journal);
+
+      if (pass.num_superseded > 0)
+        cn_log_msg(LOG_DEBUG, __func__,
+                   "Replaced -> %zu <- repeated results in watch",
+                   remove_superseded(&pass, watch_dir, shards));
+
+      if (pass.unwatched > 0)
+        cn_log_msg(LOG_DEBUG, __func__,
+                   "Kept -> %zu <- unchanged results out of watch",
+                   pass.unwatched);
+
+      if (deduped && dedup.dirty)
+        sn_dedup_save(&dedup, state_path);
+
+      cn_log_msg(LOG_DEBUG, __func__,
+                 "Ingest totals, published -> %zu <-, failed -> %zu <-",
+                 atomic_load(&ingest.published), atomic_load(&ingest.failed));
     } else {
       cn_log_msg(LOG_DEBUG, __func__, "No sn1ff files to copy\n");
     }
 
-    cn_multistr_free(&ms);
+    // Record the results now in "watch" or "export"
+
+    if (pass.published.num_strings > 0) {
+      record_published(&pass);
+
+      if (searched && sn_trigram_flush(&search) < 0)
+        cn_log_msg(LOG_ERR, __func__, "Could not index results for search");
+    }
+
+    // Documents of expired results are dropped from the search index
+
+    if (searched && pass.now - compacted >= GREETER_COMPACT_SECS) {
+      compacted = pass.now;
+      int dropped = sn_trigram_compact(&search, pass.now);
+      if (dropped > 0)
+        cn_log_msg(LOG_INFO, __func__,
+                   "Dropped -> %d <- expired results from search", dropped);
+      if (dropped == -3) {
+        cn_log_msg(LOG_ERR, __func__, "Running without search index");
+        searched = false;
+        pass.search = NULL;
+      }
+    }
+
+    // Records the consumer could not take yet, are tried again each pass
+
+    if (sinking) {
+      sn_sink_flush(&sink);
+      if (sink.dropped > 0)
+        cn_log_msg(LOG_WARNING, __func__,
+                   "Sink dropped -> %zu <- records",
+                   sink.dropped);
+      sink.dropped = 0;
+    }
+
     cn_log_msg(LOG_DEBUG, __func__, "Sleeping for 60 seconds");
     sleep(60);
   }
+
+  sn_ingest_stop(&ingest);
+  cn_multistr_free(&pass.published);
+  if (journaled)
+    sn_journal_close(&journal);
+  if (deduped)
+    sn_dedup_free(&dedup);
+  if (historied)
+    sn_history_close(&history);
+  if (measured)
+    sn_tsdb_close(&metrics);
+  if (searched)
+    sn_trigram_close(&search);
+  if (sinking)
+    sn_sink_close(&sink);
+  sn_metrics_free(&rules);
+  free(file_data);
+  free(pass.superseded);
 }
 
 /*----------------------------------------------------------------.
@@ -0,0 +1,224 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _DEFAULT_SOURCE // For timegm
+
+#include "cn_log.h"
+#include "sn_cfg.h"
+#include "sn_trigram.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * Search the body lines of results, indexed by sn1ff_greeter when
+ * "greeter_search_enabled=true" (see sn_trigram.h)
+ *
+ * Exits as grep does, 0 lines found, 1 none found, 2 error
+ */
+
+#define DAY_SECS 86400
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Usage                                                          |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+void print_usage(const char *program_name) {
+  printf("Usage: %s [OPTION]... PATTERN\n", program_name);
+  printf("Search the body lines of results for PATTERN, a POSIX extended "
+         "regex\n");
+  printf("Options:\n");
+  printf("  -F            PATTERN is a fixed string\n");
+  printf("  -i            Ignore case\n");
+  printf("  -l            Only the results with a match, not their lines\n");
+  printf("  -H <host>     Only results of this host\n");
+  printf("  -c <checkid>  Only results of this CheckID\n");
+  printf("  -f <from>     From YYYY-MM-DD, or epoch seconds (default all)\n");
+  printf("  -t <to>       To YYYY-MM-DD (inclusive), or epoch seconds "
+         "(default now)\n");
+  printf("  -m <count>    Stop after this many matching results\n");
+  printf("  -d <dir>      Search dir (default %s)\n",
+         sn_cfg_get_server_search_dir());
+  printf("  -h            Show this help message\n\n");
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Arguments                                                      |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+/**
+ * Parse a time of YYYY-MM-DD (UTC), or epoch seconds. A date "to" is the
+ * end of the day
+ *
+ * @return  0 success
+ *         -1 not a time
+ */
+static int parse_time(const char *arg, bool end_of_day, time_t *when) {
+  int year, month, mday;
+  char extra;
+
+  if (sscanf(arg, "%4d-%2d-%2d%c", &year, &month, &mday, &extra) == 3) {
+    struct tm tm = {0};
+    tm.tm_year = year - 1900;
+    tm.tm_mon = month - 1;
+    tm.tm_mday = mday;
+    *when = timegm(&tm) + (end_of_day ? DAY_SECS - 1 : 0);
+    return 0;
+  }
+
+  char *endptr = NULL;
+  long long epoch = strtoll(arg, &endptr, 10);
+  if (*arg == '\0' || *endptr != '\0' || epoch < 0)
+    return -1;
+  *when = (time_t)epoch;
+  return 0;
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Search                                                         |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+typedef struct {
+  bool list;
+  long max_results;
+  long results;
+  uint32_t last_doc;
+} PRINT;
+
+static int print_match(const TrigramMatch *match, void *arg) {
+  PRINT *print = arg;
+
+  struct tm tm;
+  char at[32];
+  gmtime_r(&match->when, &tm);
+  strftime(at, sizeof(at), "%Y-%m-%d %H:%M:%S", &tm);
+
+  // Stop at the first line of the result after the last one wanted
+
+  if (print->results == 0 || match->doc != print->last_doc) {
+    if (print->max_results > 0 && print->results >= print->max_results)
+      return 1;
+    print->results++;
+    print->last_doc = match->doc;
+  }
+
+  if (print->list)
+    printf("%s\t%s\t%s\t%s\n", at, match->host, match->checkid, match->name);
+  else
+    printf("%s\t%s\t%s\t%s\n", at, match->host, match->checkid, match->line);
+  return 0;
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Main                                                           |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+int main(int argc, char *argv[]) {
+  const char *dir = NULL;
+  TrigramQuery query = {0};
+  PRINT print = {0};
+  query.to = time(NULL);
+
+  if (sn_cfg_load() != 0) {
+    fprintf(stderr, "Could not open/access conf file -> %s <-\n",
+            sn_cfg_get_conf_file());
+  }
+  cn_log_open(argv[0], sn_cfg_get_minloglevel());
+
+  int opt;
+  while ((opt = getopt(argc, argv, "hFilH:c:f:t:m:d:")) != -1) {
+    switch (opt) {
+    case 'F':
+      query.flags |= SN_TRIGRAM_FIXED;
+      break;
+    case 'i':
+      query.flags |= SN_TRIGRAM_ICASE;
+      break;
+    case 'l':
+      query.flags |= SN_TRIGRAM_FIRST;
+      print.list = true;
+      break;
+    case 'H':
+      query.host = optarg;
+      break;
+    case 'c':
+      query.checkid = optarg;
+      break;
+    case 'f':
+    case 't':
+      if (parse_time(optarg, opt == 't',
+                     opt == 'f' ? &query.from : &query.to) != 0) {
+        fprintf(stderr, "Invalid time -> %s <-\n", optarg);
+        return 2;
+      }
+      break;
+    case 'm':
+      print.max_results = strtol(optarg, NULL, 10);
+      break;
+    case 'd':
+      dir = optarg;
+      break;
+    case 'h':
+      print_usage(argv[0]);
+      return EXIT_SUCCESS;
+    default:
+      print_usage(argv[0]);
+      return 2;
+    }
+  }
+
+  if (optind + 1 != argc || query.from > query.to ||
+      print.max_results < 0) {
+    print_usage(argv[0]);
+    return 2;
+  }
+
+  query.pattern = argv[optind];
+  if (dir == NULL)
+    dir = sn_cfg_get_server_search_dir();
+
+  int result = sn_trigram_search(dir, &query, print_match, &print);
+
+  cn_log_close();
+
+  if (result == -1)
+    fprintf(stderr, "No search index in -> %s <-\n", dir);
+  else if (result == -2)
+    fprintf(stderr, "Invalid pattern -> %s <-\n", query.pattern);
+  else if (result < 0)
+    fprintf(stderr, "Search failed\n");
+
+  return result < 0 ? 2 : (result > 0 ? 0 : 1);
+}
@@ -0,0 +1,280 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _DEFAULT_SOURCE // For timegm
+
+#include "cn_log.h"
+#include "cn_multistr.h"
+#include "sn_cfg.h"
+#include "sn_history.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * Query the status history of checks, kept by sn1ff_greeter when
+ * "greeter_history_enabled=true" (see sn_history.h)
+ */
+
+static const char *const STATUS_CHARS[] = {"NONE", "OKAY", "WARN", "ALRT"};
+
+#define DEFAULT_DAYS 7
+#define DEFAULT_CHANGES 4
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Usage                                                          |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+void print_usage(const char *program_name) {
+  printf("Usage: %s <command> [OPTION]...\n", program_name);
+  printf("Commands:\n");
+  printf("  show          Status changes of one check, needs -H and -c\n");
+  printf("  flapping      Checks with the most status changes\n");
+  printf("  index         Index the days of history that are over\n");
+  printf("Options:\n");
+  printf("  -H <host>     Host of the check\n");
+  printf("  -c <checkid>  CheckID of the check\n");
+  printf("  -f <from>     From YYYY-MM-DD, or epoch seconds (default %d days "
+         "ago)\n",
+         DEFAULT_DAYS);
+  printf("  -t <to>       To YYYY-MM-DD (inclusive), or epoch seconds "
+         "(default now)\n");
+  printf("  -n <changes>  flapping, at least this many changes (default "
+         "%d)\n",
+         DEFAULT_CHANGES);
+  printf("  -d <dir>      History dir (default %s)\n",
+         sn_cfg_get_server_history_dir());
+  printf("  -h            Show this help message\n\n");
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Arguments                                                      |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+/**
+ * Parse a time of YYYY-MM-DD (UTC), or epoch seconds. A date "to" is the
+ * end of the day
+ *
+ * @return  0 success
+ *         -1 not a time
+ */
+static int parse_time(const char *arg, bool end_of_day, time_t *when) {
+  int year, month, mday;
+  char extra;
+
+  if (sscanf(arg, "%4d-%2d-%2d%c", &year, &month, &mday, &extra) == 3) {
+    struct tm tm = {0};
+    tm.tm_year = year - 1900;
+    tm.tm_mon = month - 1;
+    tm.tm_mday = mday;
+    *when = timegm(&tm) + (end_of_day ? SN_HISTORY_DAY_SECS - 1 : 0);
+    return 0;
+  }
+
+  char *endptr = NULL;
+  long long epoch = strtoll(arg, &endptr, 10);
+  if (*arg == '\0' || *endptr != '\0' || epoch < 0)
+    return -1;
+  *when = (time_t)epoch;
+  return 0;
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Commands                                                       |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+static int print_record(int64_t when, Status status, void *arg) {
+  (void)arg;
+  time_t epoch = (time_t)when;
+  struct tm tm;
+  char at[32];
+  gmtime_r(&epoch, &tm);
+  strftime(at, sizeof(at), "%Y-%m-%d %H:%M:%S", &tm);
+  printf("%s  %s\n", at, STATUS_CHARS[status]);
+  return 0;
+}
+
+static int show(const char *dir, const char *host, const char *checkid,
+                time_t from, time_t to) {
+  int64_t series = sn_history_find(dir, host, checkid);
+  if (series < 0) {
+    fprintf(stderr, "No history of -> %s <- on host -> %s <-\n", checkid,
+            host);
+    return -1;
+  }
+
+  return sn_history_each(dir, (uint32_t)series, from, to, print_record, NULL);
+}
+
+typedef struct {
+  uint32_t series;
+  uint32_t count;
+} FLAPPING;
+
+static int compare_flapping(const void *a, const void *b) {
+  const FLAPPING *fa = a;
+  const FLAPPING *fb = b;
+  if (fa->count != fb->count)
+    return fa->count > fb->count ? -1 : 1;
+  return fa->series < fb->series ? -1 : fa->series > fb->series;
+}
+
+static int flapping(const char *dir, time_t from, time_t to,
+                    uint32_t min_changes) {
+  MultiString names;
+  cn_multistr_init(&names);
+  if (sn_history_names(dir, &names) != 0) {
+    fprintf(stderr, "No history in -> %s <-\n", dir);
+    cn_multistr_free(&names);
+    return -1;
+  }
+
+  size_t num_series = names.num_strings;
+  uint32_t *counts = calloc(num_series + 1, sizeof(uint32_t));
+  FLAPPING *found = calloc(num_series + 1, sizeof(FLAPPING));
+  if (counts == NULL || found == NULL) {
+    free(counts);
+    free(found);
+    cn_multistr_free(&names);
+    return -1;
+  }
+
+  sn_history_counts(dir, from, to, counts, num_series);
+
+  size_t num_found = 0;
+  for (size_t i = 0; i < num_series; i++) {
+    if (counts[i] >= min_changes) {
+      found[num_found].series = (uint32_t)i;
+      found[num_found].count = counts[i];
+      num_found++;
+    }
+  }
+  qsort(found, num_found, sizeof(FLAPPING), compare_flapping);
+
+  // "<changes>  <Host>  <CheckID>"
+
+  for (size_t i = 0; i < num_found; i++) {
+    char name[2 * SN_HISTORY_NAME_LENGTH];
+    snprintf(name, sizeof(name), "%s",
+             cn_multistr_getstr(&names, found[i].series));
+    char *tab = strchr(name, '\t');
+    if (tab != NULL)
+      *tab = '\0';
+    printf("%6u  %s  %s\n", found[i].count, name, tab ? tab + 1 : "");
+  }
+
+  free(counts);
+  free(found);
+  cn_multistr_free(&names);
+  return 0;
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Main                                                           |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+int main(int argc, char *argv[]) {
+  const char *dir = NULL;
+  const char *host = NULL;
+  const char *checkid = NULL;
+  time_t to = time(NULL);
+  time_t from = to - DEFAULT_DAYS * SN_HISTORY_DAY_SECS;
+  long min_changes = DEFAULT_CHANGES;
+
+  if (sn_cfg_load() != 0) {
+    fprintf(stderr, "Could not open/access conf file -> %s <-\n",
+            sn_cfg_get_conf_file());
+  }
+  cn_log_open(argv[0], sn_cfg_get_minloglevel());
+
+  int opt;
+  while ((opt = getopt(argc, argv, "hH:c:f:t:n:d:")) != -1) {
+    switch (opt) {
+    case 'H':
+      host = optarg;
+      break;
+    case 'c':
+      checkid = optarg;
+      break;
+    case 'f':
+    case 't':
+      if (parse_time(optarg, opt == 't', opt == 'f' ? &from : &to) != 0) {
+        fprintf(stderr, "Invalid time -> %s <-\n", optarg);
+        return EXIT_FAILURE;
+      }
+      break;
+    case 'n':
+      min_changes = strtol(optarg, NULL, 10);
+      break;
+    case 'd':
+      dir = optarg;
+      break;
+    case 'h':
+      print_usage(argv[0]);
+      return EXIT_SUCCESS;
+    default:
+      print_usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (optind + 1 != argc || min_changes < 1 || from > to) {
+    print_usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  if (dir == NULL)
+    dir = sn_cfg_get_server_history_dir();
+
+  const char *command = argv[optind];
+  int result = 0;
+
+  if (strcmp(command, "show") == 0 && host != NULL && checkid != NULL) {
+    result = show(dir, host, checkid, from, to);
+  } else if (strcmp(command, "flapping") == 0) {
+    result = flapping(dir, from, to, (uint32_t)min_changes);
+  } else if (strcmp(command, "index") == 0) {
+    result = sn_history_index_all(dir, (int64_t)time(NULL) /
+                                           SN_HISTORY_DAY_SECS);
+    if (result >= 0)
+      printf("Indexed %d days\n", result);
+  } else {
+    print_usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  cn_log_close();
+  return result >= 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,803 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "cn_file.h"
+#include "cn_log.h"
+#include "cn_multistr.h"
+#include "cn_time.h"
+#include "sn_cfg.h"
+#include "sn_cname.h"
+#include "sn_dir.h"
+#include "sn_file.h"
+#include "sn_fname.h"
+#include "sn_fpath.h"
+#include "sn_shard.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * Synthetic load generator, and end-to-end pipeline measurement, for a
+ * sn1ff server running on the same host.
+ *
+ * Generation:
+ *   Valid sn1ff files are created with the same naming as the sn1ff_client
+ *   (sn_fname tmp path, then sn_fpath_genfull), with a configurable status
+ *   mix, body size, TTL and host / check cardinality. They are either moved
+ *   into the upload dir at the target rate, or handed to "sn1ff_client -e"
+ *   to drive the local client path.
+ *
+ * Measurement (each second):
+ *   - greeter drain rate   files removed from the upload dir per second
+ *   - cleaner expiry lag   how long expired files remain in the watch dir
+ *   - watch LIST latency   round trip of LIST to the sn1ff_service
+ *   - monitor read rate    sn_file_read of listed files per second
+ */
+
+#define DEFAULT_COUNT 1000
+#define DEFAULT_RATE 100
+#define DEFAULT_HOSTS 100
+#define DEFAULT_CHECKS 20
+#define MONITOR_READS_PER_SAMPLE 200
+#define TICK_MILLIS 10
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Usage                                                          |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+void print_usage(const char *program_name) {
+  printf("Usage: %s [OPTION]...\n", program_name);
+  printf("Options:\n");
+  printf("  -n <count>    Number of files to generate (default %d)\n",
+         DEFAULT_COUNT);
+  printf("  -r <rate>     Files per second, 0 for no limit (default %d)\n",
+         DEFAULT_RATE);
+  printf("  -m <mix>      Status mix percentages ALRT,WARN,OKAY,NONE "
+         "(default 5,10,80,5)\n");
+  printf("  -b <min-max>  Body lines per file (default 10-100)\n");
+  printf("  -t <min-max>  TTL in minutes (default 1-5)\n");
+  printf("  -H <hosts>    Number of distinct hosts (default %d)\n",
+         DEFAULT_HOSTS);
+  printf("  -C <checks>   Number of distinct checks (default %d)\n",
+         DEFAULT_CHECKS);
+  printf("  -d <dir>      Upload dir (default from config)\n");
+  printf("  -l            Drive the local client path (sn1ff_client -e)\n");
+  printf("  -w <seconds>  Measure the pipeline for this long (default 0)\n");
+  printf("  -o <file>     Write the report to this file (default stdout)\n");
+  printf("  -x <seed>     Random seed, for reproducible runs (default 1)\n");
+  printf("  -h            Show this help message\n");
+  printf("\n");
+  printf("Run as the sn1ff user, or a member of the sn1ff group\n\n");
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Options                                                        |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+typedef struct {
+  long count;
+  long rate;
+  int mix[4]; // ALRT, WARN, OKAY, NONE percentages
+  long body_min, body_max;
+  long ttl_min, ttl_max;
+  long hosts;
+  long checks;
+  const char *upload_dir;
+  bool local_client;
+  long measure_secs;
+  const char *report_path;
+  uint64_t seed;
+} OPTIONS;
+
+static const char *STATUSES[] = {"ALRT", "WARN", "OKAY", "NONE"};
+
+/**
+ * Parse "min-max", or a single value for both
+ *
+ * @return  0 success
+ *         -1 invalid range
+ */
+static int parse_range(const char *str, long *min, long *max) {
+  char *endptr = NULL;
+  *min = strtol(str, &endptr, 10);
+  if (*endptr == '-')
+    *max = strtol(endptr + 1, &endptr, 10);
+  else
+    *max = *min;
+
+  if (*endptr != '\0' || *min < 0 || *max < *min)
+    return -1;
+  return 0;
+}
+
+/**
+ * Parse "a,w,o,n" status mix percentages
+ *
+ * @return  0 success
+ *         -1 invalid mix
+ */
+static int parse_mix(const char *str, int mix[4]) {
+  if (sscanf(str, "%d,%d,%d,%d", &mix[0], &mix[1], &mix[2], &mix[3]) != 4)
+    return -1;
+
+  int total = 0;
+  for (int i = 0; i < 4; i++) {
+    if (mix[i] < 0)
+      return -1;
+    total += mix[i];
+  }
+  return total > 0 ? 0 : -1;
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Random numbers (xorshift64*, so runs are reproducible)         |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+static uint64_t RNG_STATE = 1;
+
+static uint64_t rng_next(void) {
+  RNG_STATE ^= RNG_STATE >> 12;
+  RNG_STATE ^= RNG_STATE << 25;
+  RNG_STATE ^= RNG_STATE >> 27;
+  return RNG_STATE * 0x2545F4914F6CDD1DULL;
+}
+
+static long rng_range(long min, long max) {
+  return min + (long)(rng_next() % (uint64_t)(max - min + 1));
+}
+
+static const char *rng_status(const int mix[4]) {
+  int total = mix[0] + mix[1] + mix[2] + mix[3];
+  int pick = (int)(rng_next() % (uint64_t)total);
+  for (int i = 0; i < 4; i++) {
+    if (pick < mix[i])
+      return STATUSES[i];
+    pick -= mix[i];
+  }
+  return STATUSES[3];
+}
+
+static double now_secs(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Generate                                                       |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+/**
+ * Write a synthetic sn1ff "work" file, named as "sn1ff_client -b" names it
+ *
+ * @param  dir        is the dir to create the work file in
+ * @param  file_path  is the returned work file path
+ * @return  0 success
+ *         -1 could not create the file
+ */
+static int write_work_file(const OPTIONS *opts, const char *dir,
+                           char *file_path) {
+  FName fname;
+  sn_fname_init(&fname);
+  sn_fname_set_dir(&fname, dir);
+  sn_fname_get_tmp_path(&fname, file_path);
+
+  HEADER hdr = {.host = "", .ipv4 = "", .timestamp = "", .checkid = ""};
+  long host = rng_range(0, opts->hosts - 1);
+  snprintf(hdr.host, sizeof(hdr.host), "lg-host-%05ld", host);
+  snprintf(hdr.ipv4, sizeof(hdr.ipv4), "10.%ld.%ld.%ld", (host >> 16) & 0xff,
+           (host >> 8) & 0xff, host & 0xff);
+  cn_host_utcdt(hdr.timestamp);
+  snprintf(hdr.checkid, sizeof(hdr.checkid), "loadgen/check_%03ld.sh",
+           rng_range(0, opts->checks - 1));
+
+  FILE *file = fopen(file_path, "w");
+  if (file == NULL) {
+    fprintf(stderr, "Could not create work file -> %s <-, %s\n", file_path,
+            strerror(errno));
+    return -1;
+  }
+
+  sn_file_write_header(file, &hdr);
+
+  long lines = rng_range(opts->body_min, opts->body_max);
+  for (long i = 0; i < lines; i++)
+    fprintf(file, "%5ld  synthetic check output, value=%lu\n", i,
+            (unsigned long)(rng_next() % 100000));
+
+  fclose(file);
+  return 0;
+}
+
+/**
+ * Drive the local client path, by running "sn1ff_client -e" on the file
+ *
+ * @return  0 success
+ *         -1 sn1ff_client failed
+ */
+static int run_client_end(const char *file_path, const char *status,
+                          long ttl) {
+  char ttl_str[16];
+  snprintf(ttl_str, sizeof(ttl_str), "%ld", ttl);
+
+  pid_t pid = fork();
+  if (pid == -1)
+    return -1;
+
+  if (pid == 0) {
+    execlp("sn1ff_client", "sn1ff_client", "-e", "-f", file_path, "-s", status,
+           "-t", ttl_str, (char *)NULL);
+    _exit(127);
+  }
+
+  int wstatus;
+  if (waitpid(pid, &wstatus, 0) == -1)
+    return -1;
+
+  return (WIFEXITED(wstatus) && WEXITSTATUS(wstatus) == 0) ? 0 : -1;
+}
+
+/**
+ * Generate one sn1ff file, and deliver it to the upload dir
+ *
+ * @return  0 success
+ *         -1 error
+ */
+static int generate_one(const OPTIONS *opts, const char *work_dir) {
+  char work_path[FNAME_PATH_LENGTH_D];
+  if (write_work_file(opts, work_dir, work_path) != 0)
+    return -1;
+
+  const char *status = rng_status(opts->mix);
+  long ttl = rng_range(opts->ttl_min, opts->ttl_max);
+
+  if (opts->local_client)
+    return run_client_end(work_path, status, ttl);
+
+  // Same final name as the client, so the greeter sees a real upload
+
+  char upload_path[FNAME_PATH_LENGTH_D];
+  if (sn_fpath_genfull(work_path, status, opts->upload_dir, (int)ttl,
+                       upload_path) != 0) {
+    unlink(work_path);
+    return -1;
+  }
+
+  cn_file_mode660(work_path);
+
+  if (rename(work_path, upload_path) != 0) {
+    fprintf(stderr, "Could not move -> %s <- to -> %s <-, %s\n", work_path,
+            upload_path, strerror(errno));
+    unlink(work_path);
+    return -1;
+  }
+
+  return 0;
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Service socket                                                 |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+static int connect_service(void) {
+  int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (sock < 0)
+    return -1;
+
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strncpy(addr.sun_path, sn_cfg_get_server_unix_socket(),
+          sizeof(addr.sun_path) - 1);
+
+  if (connect(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+    close(sock);
+    return -1;
+  }
+
+  return sock;
+}
+
+static int send_all(int sock, const void *data, size_t size) {
+  size_t sent = 0;
+  while (sent < size) {
+    ssize_t n = send(sock, (const char *)data + sent, size - sent, 0);
+    if (n <= 0)
+      return -1;
+    sent += (size_t)n;
+  }
+  return 0;
+}
+
+static int recv_all(int sock, void *data, size_t size) {
+  size_t received = 0;
+  while (received < size) {
+    ssize_t n = recv(sock, (char *)data + received, size - received, 0);
+    if (n <= 0)
+      return -1;
+    received += (size_t)n;
+  }
+  return 0;
+}
+
+/**
+ * Send LIST, and receive the file names in the watch dir
+ *
+ * @return  0 success
+ *         -1 the service disconnected
+ */
+static int service_list(int sock, MultiString *ms) {
+  const char *msg = "LIST";
+  uint32_t length = htonl((uint32_t)strlen(msg));
+  if (send_all(sock, &length, sizeof(length)) != 0 ||
+      send_all(sock, msg, strlen(msg)) != 0)
+    return -1;
+
+  if (recv_all(sock, &length, sizeof(length)) != 0)
+    return -1;
+  length = ntohl(length);
+
+  char *buffer = malloc(length + 1);
+  if (buffer == NULL)
+    return -1;
+
+  if (recv_all(sock, buffer, length) != 0) {
+    free(buffer);
+    return -1;
+  }
+
+  cn_multistr_deserialize(ms, buffer);
+  free(buffer);
+  return 0;
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Measure                                                        |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+typedef struct {
+  long generated;
+  long generate_errors;
+  double generate_secs;
+
+  size_t samples;
+  long upload_backlog_max;
+  double drain_rate_sum;
+  double drain_rate_max;
+
+  long expired_max;
+  double expiry_lag_max;
+  double expiry_lag_sum;
+  size_t expiry_lag_samples;
+
+  double *list_ms;
+  size_t list_samples;
+  size_t list_capacity;
+  long list_errors;
+
+  long monitor_reads;
+  double monitor_read_secs;
+} REPORT;
+
+static int count_file(const char *name, void *arg) {
+  (void)name;
+  (*(long *)arg)++;
+  return 0;
+}
+
+static long count_files(const char *dir) {
+  long count = 0;
+  return sn_dir_each_file(dir, count_file, &count) == 0 ? count : -1;
+}
+
+typedef struct {
+  time_t now;
+  long expired;
+  double lag_max;
+} EXPIRY;
+
+static int expiry_file(const char *name, void *arg) {
+  EXPIRY *expiry = arg;
+  CName cname;
+  if (sn_cname_parse_name(name, &cname) != 0)
+    return 0;
+
+  if (cname.epoch.bin < expiry->now) {
+    expiry->expired++;
+    double lag = difftime(expiry->now, cname.epoch.bin);
+    if (lag > expiry->lag_max)
+      expiry->lag_max = lag;
+  }
+  return 0;
+}
+
+/**
+ * Expired files still in the watch dir, and the lag of the oldest
+ */
+static void sample_expiry(const char *watch_dir, REPORT *report) {
+  EXPIRY expiry = {time(NULL), 0, 0};
+  if (sn_dir_each_file_sharded(watch_dir, sn_cfg_get_server_shards(),
+                               expiry_file, &expiry) != 0)
+    return;
+
+  long expired = expiry.expired;
+  double lag_max = expiry.lag_max;
+
+  if (expired > report->expired_max)
+    report->expired_max = expired;
+  if (expired > 0) {
+    report->expiry_lag_sum += lag_max;
+    report->expiry_lag_samples++;
+    if (lag_max > report->expiry_lag_max)
+      report->expiry_lag_max = lag_max;
+  }
+}
+
+/**
+ * LIST round trip, then read the listed files as the monitor does
+ */
+static void sample_service(int sock, const char *watch_dir, REPORT *report) {
+  MultiString ms;
+  cn_multistr_init(&ms);
+
+  double start = now_secs();
+  if (service_list(sock, &ms) != 0) {
+    report->list_errors++;
+    return;
+  }
+  double elapsed_ms = (now_secs() - start) * 1000.0;
+
+  if (report->list_samples == report->list_capacity) {
+    size_t capacity = report->list_capacity ? report->list_capacity * 2 : 256;
+    double *list_ms = realloc(report->list_ms, capacity * sizeof(double));
+    if (list_ms == NULL) {
+      cn_multistr_free(&ms);
+      return;
+    }
+    report->list_ms = list_ms;
+    report->list_capacity = capacity;
+  }
+  report->list_ms[report->list_samples++] = elapsed_ms;
+
+  start = now_secs();
+  long reads = 0;
+  for (size_t i = 0; i < ms.num_strings && reads < MONITOR_READS_PER_SAMPLE;
+       i++) {
+    const char *name = cn_multistr_getstr(&ms, i);
+    if (strcmp(name, "NO_FILES") == 0)
+      break;
+
+    char path[FNAME_PATH_LENGTH_D];
+    sn_shard_path(watch_dir, name, sn_cfg_get_server_shards(), path,
+                  sizeof(path));
+
+    static FILE_DATA file_data;
+    if (sn_file_read(path, &file_data) == 0)
+      reads++;
+  }
+  report->monitor_read_secs += now_secs() - start;
+  report->monitor_reads += reads;
+
+  cn_multistr_free(&ms);
+}
+
+static int compare_double(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+static double percentile(const double *sorted, size_t n, double pct) {
+  if (n == 0)
+    return 0;
+  size_t index = (size_t)(pct / 100.0 * (double)(n - 1) + 0.5);
+  return sorted[index];
+}
+
+static void write_report(FILE *out, const OPTIONS *opts, REPORT *report) {
+  qsort(report->list_ms, report->list_samples, sizeof(double), compare_double);
+
+  fprintf(out, "sn1ff load test report\n\n");
+  fprintf(out, "  Generation\n");
+  fprintf(out, "    path                       : %s\n",
+          opts->local_client ? "sn1ff_client -e" : "direct to upload dir");
+  fprintf(out, "    files generated            : %ld\n", report->generated);
+  fprintf(out, "    generate errors            : %ld\n",
+          report->generate_errors);
+  fprintf(out, "    target rate (files/s)      : %ld\n", opts->rate);
+  fprintf(out, "    achieved rate (files/s)    : %.1f\n",
+          report->generate_secs > 0
+              ? (double)report->generated / report->generate_secs
+              : 0);
+  fprintf(out, "    status mix A/W/O/N (%%)     : %d/%d/%d/%d\n",
+          opts->mix[0], opts->mix[1], opts->mix[2], opts->mix[3]);
+  fprintf(out, "    body lines                 : %ld-%ld\n", opts->body_min,
+          opts->body_max);
+  fprintf(out, "    ttl (minutes)              : %ld-%ld\n", opts->ttl_min,
+          opts->ttl_max);
+  fprintf(out, "    hosts x checks             : %ld x %ld\n", opts->hosts,
+          opts->checks);
+
+  if (report->samples == 0) {
+    fprintf(out, "\n  No measurement (-w 0)\n");
+    return;
+  }
+
+  fprintf(out, "\n  Greeter\n");
+  fprintf(out, "    drain rate avg (files/s)   : %.1f\n",
+          report->drain_rate_sum / (double)report->samples);
+  fprintf(out, "    drain rate max (files/s)   : %.1f\n",
+          report->drain_rate_max);
+  fprintf(out, "    upload backlog max         : %ld\n",
+          report->upload_backlog_max);
+
+  fprintf(out, "\n  Cleaner\n");
+  fprintf(out, "    expired files in watch max : %ld\n", report->expired_max);
+  fprintf(out, "    expiry lag avg (s)         : %.1f\n",
+          report->expiry_lag_samples
+              ? report->expiry_lag_sum / (double)report->expiry_lag_samples
+              : 0);
+  fprintf(out, "    expiry lag max (s)         : %.1f\n",
+          report->expiry_lag_max);
+
+  fprintf(out, "\n  Service\n");
+  fprintf(out, "    LIST samples               : %zu\n", report->list_samples);
+  fprintf(out, "    LIST errors                : %ld\n", report->list_errors);
+  fprintf(out, "    LIST latency p50 (ms)      : %.2f\n",
+          percentile(report->list_ms, report->list_samples, 50));
+  fprintf(out, "    LIST latency p95 (ms)      : %.2f\n",
+          percentile(report->list_ms, report->list_samples, 95));
+  fprintf(out, "    LIST latency max (ms)      : %.2f\n",
+          percentile(report->list_ms, report->list_samples, 100));
+
+  fprintf(out, "\n  Monitor\n");
+  fprintf(out, "    files read                 : %ld\n", report->monitor_reads);
+  fprintf(out, "    read rate (files/s)        : %.1f\n",
+          report->monitor_read_secs > 0
+              ? (double)report->monitor_reads / report->monitor_read_secs
+              : 0);
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Main                                                           |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+int main(int argc, char *argv[]) {
+  OPTIONS opts = {.count = DEFAULT_COUNT,
+                  .rate = DEFAULT_RATE,
+                  .mix = {5, 10, 80, 5},
+                  .body_min = 10,
+                  .body_max = 100,
+                  .ttl_min = 1,
+                  .ttl_max = 5,
+                  .hosts = DEFAULT_HOSTS,
+                  .checks = DEFAULT_CHECKS,
+                  .upload_dir = NULL,
+                  .local_client = false,
+                  .measure_secs = 0,
+                  .report_path = NULL,
+                  .seed = 1};
+
+  int opt;
+  while ((opt = getopt(argc, argv, "hn:r:m:b:t:H:C:d:lw:o:x:")) != -1) {
+    switch (opt) {
+    case 'n':
+      opts.count = strtol(optarg, NULL, 10);
+      break;
+    case 'r':
+      opts.rate = strtol(optarg, NULL, 10);
+      break;
+    case 'm':
+      if (parse_mix(optarg, opts.mix) != 0) {
+        fprintf(stderr, "Invalid status mix -> %s <-\n", optarg);
+        return EXIT_FAILURE;
+      }
+      break;
+    case 'b':
+      if (parse_range(optarg, &opts.body_min, &opts.body_max) != 0) {
+        fprintf(stderr, "Invalid body lines -> %s <-\n", optarg);
+        return EXIT_FAILURE;
+      }
+      break;
+    case 't':
+      if (parse_range(optarg, &opts.ttl_min, &opts.ttl_max) != 0) {
+        fprintf(stderr, "Invalid TTL -> %s <-\n", optarg);
+        return EXIT_FAILURE;
+      }
+      break;
+    case 'H':
+      opts.hosts = strtol(optarg, NULL, 10);
+      break;
+    case 'C':
+      opts.checks = strtol(optarg, NULL, 10);
+      break;
+    case 'd':
+      opts.upload_dir = optarg;
+      break;
+    case 'l':
+      opts.local_client = true;
+      break;
+    case 'w':
+      opts.measure_secs = strtol(optarg, NULL, 10);
+      break;
+    case 'o':
+      opts.report_path = optarg;
+      break;
+    case 'x':
+      opts.seed = strtoull(optarg, NULL, 10);
+      break;
+    case 'h':
+      print_usage(argv[0]);
+      return EXIT_SUCCESS;
+    default:
+      print_usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (opts.count < 0 || opts.rate < 0 || opts.hosts < 1 || opts.checks < 1 ||
+      opts.measure_secs < 0) {
+    print_usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  if (sn_cfg_load() != 0) {
+    fprintf(stderr, "Could not open/access conf file -> %s <-\n",
+            sn_cfg_get_conf_file());
+  }
+  cn_log_open(argv[0], sn_cfg_get_minloglevel());
+
+  if (opts.upload_dir == NULL)
+    opts.upload_dir = sn_cfg_get_server_upload_dir();
+
+  RNG_STATE = opts.seed ? opts.seed : 1;
+
+  // Work files are created in the client sn1ff dir, as sn1ff_client does
+
+  char work_dir[256];
+  if (sn_dir_client(work_dir, sizeof(work_dir)) != 0) {
+    fprintf(stderr, "Could not get client sn1ff dir\n");
+    return EXIT_FAILURE;
+  }
+
+  REPORT report;
+  memset(&report, 0, sizeof(report));
+
+  const char *watch_dir = sn_cfg_get_server_watch_dir();
+  int sock = opts.measure_secs > 0 ? connect_service() : -1;
+  if (opts.measure_secs > 0 && sock < 0)
+    fprintf(stderr, "Could not connect to sn1ff_service -> %s <-, LIST and "
+                    "monitor reads are not measured\n",
+            sn_cfg_get_server_unix_socket());
+
+  double start = now_secs();
+  double next_sample = start + 1.0;
+  long prev_backlog = opts.measure_secs > 0 ? count_files(opts.upload_dir) : 0;
+  long generated_since_sample = 0;
+
+  while (true) {
+    double now = now_secs();
+    double elapsed = now - start;
+
+    // Generate the files due by now, for the target rate
+
+    if (report.generated + report.generate_errors < opts.count) {
+      long due = opts.rate > 0 ? (long)(elapsed * (double)opts.rate) + 1
+                               : opts.count;
+      if (due > opts.count)
+        due = opts.count;
+
+      while (report.generated + report.generate_errors < due) {
+        if (generate_one(&opts, work_dir) == 0) {
+          report.generated++;
+          generated_since_sample++;
+        } else {
+          report.generate_errors++;
+        }
+      }
+      report.generate_secs = now_secs() - start;
+    } else if (elapsed >= (double)opts.measure_secs) {
+      break;
+    }
+
+    // Sample the pipeline every second
+
+    if (opts.measure_secs > 0 && now >= next_sample) {
+      long backlog = count_files(opts.upload_dir);
+      double drained = (double)(generated_since_sample - (backlog - prev_backlog));
+      if (drained < 0)
+        drained = 0;
+
+      report.samples++;
+      report.drain_rate_sum += drained;
+      if (drained > report.drain_rate_max)
+        report.drain_rate_max = drained;
+      if (backlog > report.upload_backlog_max)
+        report.upload_backlog_max = backlog;
+
+      prev_backlog = backlog;
+      generated_since_sample = 0;
+
+      sample_expiry(watch_dir, &report);
+      if (sock >= 0)
+        sample_service(sock, watch_dir, &report);
+
+      next_sample += 1.0;
+    }
+
+    cn_time_sleep_millis(TICK_MILLIS);
+  }
+
+  if (sock >= 0) {
+    const char *msg = "QUIT";
+    uint32_t length = htonl((uint32_t)strlen(msg));
+    send_all(sock, &length, sizeof(length));
+    send_all(sock, msg, strlen(msg));
+    close(sock);
+  }
+
+  FILE *out = stdout;
+  if (opts.report_path != NULL) {
+    out = fopen(opts.report_path, "w");
+    if (out == NULL) {
+      fprintf(stderr, "Could not open report file -> %s <-\n",
+              opts.report_path);
+      out = stdout;
+    }
+  }
+
+  write_report(out, &opts, &report);
+
+  if (out != stdout)
+    fclose(out);
+
+  free(report.list_ms);
+  cn_log_close();
+
+  return report.generate_errors == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
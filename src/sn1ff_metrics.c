@@ -0,0 +1,298 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _DEFAULT_SOURCE // For timegm
+
+#include "cn_log.h"
+#include "cn_multistr.h"
+#include "sn_cfg.h"
+#include "sn_file.h"
+#include "sn_metrics.h"
+#include "sn_tsdb.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * Query the numeric metrics of checks, kept by sn1ff_greeter when
+ * "greeter_metrics_enabled=true" (see sn_metrics.h and sn_tsdb.h)
+ */
+
+#define DAY_SECS 86400
+#define DEFAULT_SECS DAY_SECS
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Usage                                                          |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+void print_usage(const char *program_name) {
+  printf("Usage: %s <command> [OPTION]...\n", program_name);
+  printf("Commands:\n");
+  printf("  list          Metrics kept, as Host, CheckID and Metric\n");
+  printf("  query         Buckets of one metric, needs -H, -c and -m\n");
+  printf("  extract FILE  Metrics the rules extract from a result file\n");
+  printf("Options:\n");
+  printf("  -H <host>     Host of the check\n");
+  printf("  -c <checkid>  CheckID of the check\n");
+  printf("  -m <metric>   Metric of the check\n");
+  printf("  -r <res>      query, bucket of 1m, 1h or 1d (default the finest "
+         "kept\n");
+  printf("                for the whole range)\n");
+  printf("  -f <from>     From YYYY-MM-DD, or epoch seconds (default 1 day "
+         "ago)\n");
+  printf("  -t <to>       To YYYY-MM-DD (inclusive), or epoch seconds "
+         "(default now)\n");
+  printf("  -d <dir>      Metrics dir (default %s)\n",
+         sn_cfg_get_server_metrics_dir());
+  printf("  -R <file>     Rules file (default %s)\n",
+         sn_cfg_get_server_metrics_rules_file());
+  printf("  -h            Show this help message\n\n");
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Arguments                                                      |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+/**
+ * Parse a time of YYYY-MM-DD (UTC), or epoch seconds. A date "to" is the
+ * end of the day
+ *
+ * @return  0 success
+ *         -1 not a time
+ */
+static int parse_time(const char *arg, bool end_of_day, time_t *when) {
+  int year, month, mday;
+  char extra;
+
+  if (sscanf(arg, "%4d-%2d-%2d%c", &year, &month, &mday, &extra) == 3) {
+    struct tm tm = {0};
+    tm.tm_year = year - 1900;
+    tm.tm_mon = month - 1;
+    tm.tm_mday = mday;
+    *when = timegm(&tm) + (end_of_day ? DAY_SECS - 1 : 0);
+    return 0;
+  }
+
+  char *endptr = NULL;
+  long long epoch = strtoll(arg, &endptr, 10);
+  if (*arg == '\0' || *endptr != '\0' || epoch < 0)
+    return -1;
+  *when = (time_t)epoch;
+  return 0;
+}
+
+/**
+ * Finest resolution still keeping all of "from" (1 day of 1m buckets, 90
+ * days of 1h)
+ */
+static int auto_resolution(time_t from) {
+  time_t age = time(NULL) - from;
+  if (age <= DAY_SECS)
+    return SN_TSDB_RES_1M;
+  if (age <= 90 * DAY_SECS)
+    return SN_TSDB_RES_1H;
+  return SN_TSDB_RES_1D;
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Commands                                                       |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+static int list(const char *dir) {
+  MultiString names;
+  cn_multistr_init(&names);
+  if (sn_tsdb_names(dir, &names) != 0) {
+    fprintf(stderr, "No metrics in -> %s <-\n", dir);
+    cn_multistr_free(&names);
+    return -1;
+  }
+
+  for (size_t i = 0; i < names.num_strings; i++) {
+    char name[3 * SN_TSDB_NAME_LENGTH];
+    snprintf(name, sizeof(name), "%s", cn_multistr_getstr(&names, i));
+    for (char *p = name; *p != '\0'; p++) {
+      if (*p == '\t')
+        *p = ' ';
+    }
+    printf("%s\n", name);
+  }
+
+  cn_multistr_free(&names);
+  return 0;
+}
+
+static int print_bucket(const TsdbBucket *bucket, void *arg) {
+  (void)arg;
+  struct tm tm;
+  char at[32];
+  gmtime_r(&bucket->when, &tm);
+  strftime(at, sizeof(at), "%Y-%m-%d %H:%M", &tm);
+  printf("%s\t%u\t%g\t%g\t%g\n", at, bucket->count, bucket->min, bucket->max,
+         bucket->sum / bucket->count);
+  return 0;
+}
+
+static int query(const char *dir, const char *host, const char *checkid,
+                 const char *metric, int resolution, time_t from, time_t to) {
+  int64_t series = sn_tsdb_find(dir, host, checkid, metric);
+  if (series < 0) {
+    fprintf(stderr, "No metric -> %s <- of -> %s <- on host -> %s <-\n",
+            metric, checkid, host);
+    return -1;
+  }
+
+  printf("at\tcount\tmin\tmax\tavg\n");
+  return sn_tsdb_query(dir, resolution, (uint32_t)series, from, to,
+                       print_bucket, NULL);
+}
+
+static int print_point(const char *name, double value, void *arg) {
+  (void)arg;
+  printf("%s\t%g\n", name, value);
+  return 0;
+}
+
+static int extract(const char *rules_file, const char *path) {
+  MetricRules rules;
+  if (sn_metrics_load(&rules, rules_file) < 0) {
+    fprintf(stderr, "Could not load rules file -> %s <-\n", rules_file);
+    return -1;
+  }
+
+  FILE_DATA *file_data = calloc(1, sizeof(FILE_DATA));
+  int result = -1;
+  if (file_data != NULL && sn_file_read(path, file_data) == 0) {
+    sn_metrics_extract(&rules, file_data, print_point, NULL);
+    result = 0;
+  } else {
+    fprintf(stderr, "Could not read result file -> %s <-\n", path);
+  }
+
+  free(file_data);
+  sn_metrics_free(&rules);
+  return result;
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Main                                                           |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+int main(int argc, char *argv[]) {
+  const char *dir = NULL;
+  const char *rules_file = NULL;
+  const char *host = NULL;
+  const char *checkid = NULL;
+  const char *metric = NULL;
+  int resolution = -1;
+  time_t to = time(NULL);
+  time_t from = to - DEFAULT_SECS;
+
+  if (sn_cfg_load() != 0) {
+    fprintf(stderr, "Could not open/access conf file -> %s <-\n",
+            sn_cfg_get_conf_file());
+  }
+  cn_log_open(argv[0], sn_cfg_get_minloglevel());
+
+  int opt;
+  while ((opt = getopt(argc, argv, "hH:c:m:r:f:t:d:R:")) != -1) {
+    switch (opt) {
+    case 'H':
+      host = optarg;
+      break;
+    case 'c':
+      checkid = optarg;
+      break;
+    case 'm':
+      metric = optarg;
+      break;
+    case 'r':
+      resolution = sn_tsdb_resolution(optarg);
+      if (resolution < 0) {
+        fprintf(stderr, "Invalid resolution -> %s <-\n", optarg);
+        return EXIT_FAILURE;
+      }
+      break;
+    case 'f':
+    case 't':
+      if (parse_time(optarg, opt == 't', opt == 'f' ? &from : &to) != 0) {
+        fprintf(stderr, "Invalid time -> %s <-\n", optarg);
+        return EXIT_FAILURE;
+      }
+      break;
+    case 'd':
+      dir = optarg;
+      break;
+    case 'R':
+      rules_file = optarg;
+      break;
+    case 'h':
+      print_usage(argv[0]);
+      return EXIT_SUCCESS;
+    default:
+      print_usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (optind >= argc || from > to) {
+    print_usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  if (dir == NULL)
+    dir = sn_cfg_get_server_metrics_dir();
+  if (rules_file == NULL)
+    rules_file = sn_cfg_get_server_metrics_rules_file();
+  if (resolution < 0)
+    resolution = auto_resolution(from);
+
+  const char *command = argv[optind];
+  int result = 0;
+
+  if (strcmp(command, "list") == 0 && optind + 1 == argc) {
+    result = list(dir);
+  } else if (strcmp(command, "query") == 0 && optind + 1 == argc &&
+             host != NULL && checkid != NULL && metric != NULL) {
+    result = query(dir, host, checkid, metric, resolution, from, to);
+  } else if (strcmp(command, "extract") == 0 && optind + 2 == argc) {
+    result = extract(rules_file, argv[optind + 1]);
+  } else {
+    print_usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  cn_log_close();
+  return result >= 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
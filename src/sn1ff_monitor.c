@@ -28,10 +28,15 @@ SOFTWARE.
 #include "cn_multistr.h"
 #include "cn_time.h"
 #include "sn_cfg.h"
+#include "sn_cname.h"
 #include "sn_file.h"
+#include "sn_prefetch.h"
+#include "sn_shard.h"
+#include "sn_sink.h"
 #include "sn_ui.h"
 #include <arpa/inet.h>
 #include <errno.h>
+#include <getopt.h>
 #include <ncurses.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -44,6 +49,9 @@ SOFTWARE.
 #define MSG_RESPONSE_BUFFER_SIZE 1024
 #define USER_DISPLAY_PAUSE_SECS 1
 
+#define SNAPSHOT_JSON 0
+#define SNAPSHOT_TSV 1
+
 char LOG_MSG[1024] = {'\0'};
 
 void print_usage(int level, char *program_name) {
@@ -52,6 +60,9 @@ void print_usage(int level, char *program_name) {
              "  Display this info ...\n"
              "    %s -h\n"
              "\n"
+             "  Print the results in watch once, and exit ...\n"
+             "    %s --snapshot [--format json|tsv] [--body]\n"
+             "\n"
              "\n"
              "  See man pages:\n"
              "    man (1) sn1ff_monitor\n"
@@ -61,7 +72,7 @@ void print_usage(int level, char *program_name) {
              "    man (8) sn1ff_cleaner\n"
              "    man (1) sn1ff_client\n"
              "  \n\n",
-             program_name);
+             program_name, program_name);
 }
 
 /*----------------------------------------------------------------.
@@ -179,6 +190,127 @@ void receive_message_response(int sock, MultiString *ms) {
   free(received_buffer);
 }
 
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Snapshot                                                       |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+static char RECORD[SN_SINK_RECORD_MAX];
+
+/**
+ * Print "length" bytes of a TSV field, escaping tabs, newlines and
+ * backslashes
+ */
+static void print_tsv_field(const char *str, size_t length) {
+  for (const char *c = str; c < str + length; c++) {
+    if (*c == '\t')
+      fputs("\\t", stdout);
+    else if (*c == '\n')
+      fputs("\\n", stdout);
+    else if (*c == '\\')
+      fputs("\\\\", stdout);
+    else
+      putchar(*c);
+  }
+}
+
+/**
+ * Print a result as a TSV line: file name, status, expiry (epoch), Host,
+ * IPv4, At, CheckID, and its body lines joined by "\n" when given
+ */
+static void print_tsv(const char *name, const CName *cname,
+                      const HEADER *hdr, const FILE_DATA *file_data) {
+  printf("%s\t%s\t%lld\t", name, cname->status,
+         (long long)cname->epoch.bin);
+  print_tsv_field(hdr->host, strlen(hdr->host));
+  putchar('\t');
+  print_tsv_field(hdr->ipv4, strlen(hdr->ipv4));
+  putchar('\t');
+  print_tsv_field(hdr->timestamp, strlen(hdr->timestamp));
+  putchar('\t');
+  print_tsv_field(hdr->checkid, strlen(hdr->checkid));
+
+  if (file_data != NULL) {
+    putchar('\t');
+    for (size_t i = 0; i < file_data->body_lines; i++) {
+      if (i > 0)
+        fputs("\\n", stdout);
+      print_tsv_field(file_data->body[i],
+                      sn_sink_line_length(file_data->body[i]));
+    }
+  }
+  putchar('\n');
+}
+
+/**
+ * Print the results in "watch" to stdout once, as NDJSON records (see
+ * sn_sink.h) or TSV lines, from a single LIST to the service. Only the
+ * header of each result is read, unless its body is wanted. A result
+ * expired since the LIST is skipped
+ *
+ * @return  number of results printed
+ *         -1 no response from the service
+ */
+static int snapshot(int sock, const char *files_dir, int format,
+                    bool with_body) {
+  MultiString ms;
+  cn_multistr_init(&ms);
+
+  send_message(sock, "LIST");
+  receive_message_response(sock, &ms);
+
+  if (ms.num_strings == 0) {
+    cn_log_msg(LOG_ERR, __func__, "No response to LIST from the service");
+    return -1;
+  }
+
+  FILE_DATA *file_data = with_body ? malloc(sizeof(FILE_DATA)) : NULL;
+  if (with_body && file_data == NULL) {
+    cn_log_msg(LOG_ERR, __func__,
+               "'malloc' gave NULL, strerror(errno) -> %m <-");
+    cn_multistr_free(&ms);
+    return -1;
+  }
+
+  int printed = 0;
+  for (size_t i = 0; i < ms.num_strings; i++) {
+    const char *name = cn_multistr_getstr(&ms, i);
+    char path[256];
+    CName cname;
+    HEADER hdr;
+
+    if (sn_cname_parse_name(name, &cname) != CNAME_PARSE_OK ||
+        sn_shard_path(files_dir, name, sn_cfg_get_server_shards(), path,
+                      sizeof(path)) != 0)
+      continue; // "NO_FILES", when "watch" is empty
+
+    if (with_body) {
+      if (sn_file_read(path, file_data) != 0)
+        continue;
+      hdr = file_data->header;
+    } else if (sn_file_read_header(path, &hdr) != 0) {
+      continue;
+    }
+
+    if (format == SNAPSHOT_TSV) {
+      print_tsv(name, &cname, &hdr, file_data);
+    } else {
+      int length = sn_sink_format(RECORD, sizeof(RECORD), name, &cname, &hdr,
+                                  file_data, 0);
+      if (length < 0)
+        continue;
+      fwrite(RECORD, 1, (size_t)length, stdout);
+    }
+    printed++;
+  }
+
+  fflush(stdout);
+  free(file_data);
+  cn_multistr_free(&ms);
+  return printed;
+}
+
 /*----------------------------------------------------------------.
  |                                                                |
  | Cleanup                                                        |
@@ -186,13 +318,16 @@ void receive_message_response(int sock, MultiString *ms) {
  '----------------------------------------------------------------*/
 
 static int SOCKET;
+static bool UI_OPEN = false; // Not in snapshot mode
 
 void cleanup(void) {
   cn_log_msg(LOG_DEBUG, __func__, "Exiting ...");
   cn_log_close();
 
-  sn_ui_close();
-  endwin();
+  if (UI_OPEN) {
+    sn_ui_close();
+    endwin();
+  }
 
   close(SOCKET);
 }
@@ -243,44 +378,74 @@ int main(int argc, char *argv[]) {
    * Process arguments
    */
 
-  // Check we have required number of arguments
-
-  if (argc >= 2) {
-    cn_log_msg(LOG_ERR, __func__, "Too many arguments provided");
-
-    print_usage(LOG_ERR, argv[0]);
-    return EXIT_FAILURE;
-  }
-
   // Loop through any command-line arguments using getopt
 
-  bool is_help = false; // Help requested
+  bool is_help = false;     // Help requested
+  bool is_snapshot = false; // Print the results once, without the UI
+  bool with_body = false;   // Snapshot the bodies too
+  int format = -1;          // Snapshot format
+
+  static const struct option long_options[] = {
+      {"help", no_argument, NULL, 'h'},
+      {"snapshot", no_argument, NULL, 's'},
+      {"format", required_argument, NULL, 'f'},
+      {"body", no_argument, NULL, 'b'},
+      {NULL, 0, NULL, 0}};
 
   int opt;
-  while ((opt = getopt(argc, argv, "h")) != -1) {
+  while ((opt = getopt_long(argc, argv, "hsf:b", long_options, NULL)) !=
+         -1) {
     switch (opt) {
     case 'h': // help
       is_help = true;
       break;
 
+    case 's':
+      is_snapshot = true;
+      break;
+
+    case 'f':
+      if (strcmp(optarg, "json") == 0) {
+        format = SNAPSHOT_JSON;
+      } else if (strcmp(optarg, "tsv") == 0) {
+        format = SNAPSHOT_TSV;
+      } else {
+        cn_log_msg(LOG_ERR, __func__, "Format not recognized -> %s <-",
+                   optarg);
+        print_usage(LOG_ERR, argv[0]);
+        return EXIT_FAILURE;
+      }
+      break;
+
+    case 'b':
+      with_body = true;
+      break;
+
     default:
       cn_log_msg(LOG_ERR, __func__, "Option not recognized -> %c <-", opt);
       print_usage(LOG_ERR, argv[0]);
       return EXIT_FAILURE;
     }
+  }
 
-    // Process options
+  // Process options
 
-    if (is_help) {
-      print_usage(LOG_INFO, argv[0]);
-      return EXIT_SUCCESS;
-    }
+  if (optind < argc) {
+    cn_log_msg(LOG_ERR, __func__, "Too many arguments provided");
 
-    else {
-      cn_log_msg(LOG_ERR, __func__, "Option not recognized -> %c <-", opt);
-      print_usage(LOG_ERR, argv[0]);
-      return EXIT_FAILURE;
-    }
+    print_usage(LOG_ERR, argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  if (is_help) {
+    print_usage(LOG_INFO, argv[0]);
+    return EXIT_SUCCESS;
+  }
+
+  if (!is_snapshot && (format != -1 || with_body)) {
+    cn_log_msg(LOG_ERR, __func__, "--format and --body need --snapshot");
+    print_usage(LOG_ERR, argv[0]);
+    return EXIT_FAILURE;
   }
 
   /*
@@ -305,11 +470,22 @@ int main(int argc, char *argv[]) {
     return EXIT_FAILURE;
   }
 
+  /*
+   * Snapshot, for scripts, without the UI
+   */
+
+  if (is_snapshot) {
+    int printed = snapshot(SOCKET, sn1ff_files_dir,
+                           format == -1 ? SNAPSHOT_JSON : format, with_body);
+    return printed < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+  }
+
   /*
    * Setup UI (NCurses)
    */
 
   sn_ui_init();
+  UI_OPEN = true;
 
   /*
    * Processing loop:
@@ -351,45 +527,27 @@ int main(int argc, char *argv[]) {
       continue;
     }
 
-    // Display received file names
-
-    for (size_t i = 0; i < ms.num_strings; ++i) {
-      // Handle sn1ff file having expired
-
-      char full_filename[256] = "";
-      strcat(full_filename, sn1ff_files_dir);
-      strcat(full_filename, cn_multistr_getstr(&ms, i));
-
-      // Display sn1ff file contents
-
-      FILE_DATA file_data;
-      if (sn_file_read(full_filename, &file_data) != 0) {
-        // Skip non existing file - possibly deleted by
-        // cleaner process if TTL expired
-        if (errno == ENOENT) {
-          cn_log_msg(LOG_ERR, __func__, "Skipping file not existing %s",
-                     full_filename);
-          cn_multistr_free(&ms);
-          continue;
-        }
-        // Skip file as it just could not be opened
-        // for some reason
-        else {
-          cn_log_msg(LOG_ERR, __func__,
-                     "'fopen' gave an error opening file -> %s <-, "
-                     "strerror(errno) -> %m <-",
-                     full_filename);
-          cn_multistr_free(&ms);
-          continue;
-        };
-      }
+    // Display received file names, the next ones being read meanwhile
+
+    Prefetch prefetch;
+    if (sn_prefetch_start(&prefetch, sn1ff_files_dir,
+                          sn_cfg_get_server_shards(), &ms,
+                          SN_PREFETCH_DEPTH) != 0) {
+      cn_multistr_free(&ms);
+      return EXIT_FAILURE;
+    }
+
+    const char *name;
+    FILE_DATA *file_data;
 
-      sn_ui_display_file(cn_multistr_getstr(&ms, i), &file_data, &user_cmd);
+    // Files not read, or deleted since (possibly by the cleaner process if
+    // TTL expired), are skipped
+
+    while (sn_prefetch_next(&prefetch, &name, &file_data) == 0) {
+      sn_ui_display_file(name, file_data, &user_cmd);
 
       if (user_cmd == USER_CMD_QUIT) {
         cn_log_msg(LOG_DEBUG, __func__, "User requested 'QUIT'");
-
-        cn_multistr_free(&ms);
         break;
       }
 
@@ -397,7 +555,7 @@ int main(int argc, char *argv[]) {
         cn_log_msg(LOG_DEBUG, __func__, "Sending command 'DELETE' to server");
         char delete_msg[128];
         strcpy(delete_msg, "DELETE ");
-        strcat(delete_msg, cn_multistr_getstr(&ms, i));
+        strcat(delete_msg, name);
         send_message(SOCKET, delete_msg);
       }
 
@@ -407,6 +565,7 @@ int main(int argc, char *argv[]) {
       sleep(1);
     }
 
+    sn_prefetch_stop(&prefetch);
     cn_multistr_free(&ms);
 
     if (user_cmd == USER_CMD_QUIT) {
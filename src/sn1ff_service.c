@@ -31,6 +31,7 @@ SOFTWARE.
 #include "sn_cfg.h"
 #include "sn_dir.h"
 #include "sn_file.h"
+#include "sn_index.h"
 #include <arpa/inet.h>
 #include <dirent.h>
 #include <linux/prctl.h>
@@ -173,6 +174,18 @@ int get_message(int client_sock, char *msg_buffer) {
   return 0;
 }
 
+/*
+ * Index of the "watch" dir, for a client process. It starts from the
+ * cleaner's checkpoint, and each LIST only rescans the dirs that changed
+ */
+static Index watch_index;
+static bool watch_indexed = false;
+
+static int append_entry(const IndexEntry *entry, void *arg) {
+  cn_multistr_append((MultiString *)arg, entry->name);
+  return 0;
+}
+
 /**
  * Handle message (msg) LIST from client - by supplying the names of
  * available sn1ff files
@@ -185,9 +198,17 @@ int handle_msg_list(int client_sock, const char *sn1ff_watch_files_dir) {
   MultiString ms;
   cn_multistr_init(&ms);
 
-  // Get list of sn1ff files
+  // Get list of sn1ff files, from the index if there is one
 
-  int status = sn_dir_list_files(sn1ff_watch_files_dir, &ms);
+  int status;
+  if (watch_indexed) {
+    status = sn_index_refresh(&watch_index) < 0
+                 ? 1
+                 : sn_index_each(&watch_index, append_entry, &ms);
+  } else {
+    status = sn_dir_list_files_sharded(sn1ff_watch_files_dir,
+                                       sn_cfg_get_server_shards(), &ms);
+  }
 
   if (status != 0) {
     cn_log_msg(LOG_ERR, __func__,
@@ -268,7 +289,8 @@ int handle_msg(int client_sock, const char *sn1ff_watch_files_dir) {
       // TODO: Add error handling here
       char *tokens[3];
       cn_string_split(msg_buffer, tokens);
-      sn_file_delete(sn1ff_watch_files_dir, tokens[1]);
+      sn_file_delete_sharded(sn1ff_watch_files_dir,
+                             sn_cfg_get_server_shards(), tokens[1]);
     }
 
     return 0;
@@ -339,6 +361,11 @@ int handle_client(int client_sock, const char *sn1ff_watch_files_dir) {
     return EXIT_FAILURE;
   }
 
+  watch_indexed = sn_index_init(&watch_index, sn1ff_watch_files_dir,
+                                 sn_cfg_get_server_shards()) == 0;
+  if (watch_indexed && sn_cfg_index_checkpoint_enabled())
+    sn_index_load(&watch_index, sn_cfg_get_server_watch_index_file());
+
   while (1) {
     int status = handle_msg(client_sock, sn1ff_watch_files_dir);
 
@@ -350,6 +377,9 @@ int handle_client(int client_sock, const char *sn1ff_watch_files_dir) {
     }
   }
 
+  if (watch_indexed)
+    sn_index_free(&watch_index);
+
   return EXIT_SUCCESS;
 }
 
@@ -360,12 +390,13 @@ int handle_client(int client_sock, const char *sn1ff_watch_files_dir) {
 '----------------------------------------------------------------*/
 
 static int server_sock = 0;
+static pid_t service_pid = 0; // Its forked children leave the socket be
 
 void cleanup() {
   if (server_sock)
     close(server_sock);
 
-  if (sn_cfg_get_server_unix_socket())
+  if (getpid() == service_pid && sn_cfg_get_server_unix_socket())
     unlink(sn_cfg_get_server_unix_socket());
 
   cn_log_msg(LOG_DEBUG, __func__, "Exiting ...");
@@ -386,6 +417,7 @@ int main(int argc, char *argv[]) {
    * Setup cleanup handler
    */
 
+  service_pid = getpid();
   atexit(cleanup);
 
   /*
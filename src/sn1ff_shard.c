@@ -0,0 +1,260 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "cn_log.h"
+#include "cn_multistr.h"
+#include "sn_cfg.h"
+#include "sn_dir.h"
+#include "sn_shard.h"
+#include <ctype.h>
+#include <dirent.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/*
+ * One-shot migration of the "watch" and "export" dirs, between the flat
+ * layout and 256 / 4096 shards (see sn_shard.h)
+ *
+ * Stop the sn1ff service before migrating, then set "server_shards" in
+ * the config file to the new number of shards, and start it again
+ */
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Usage                                                          |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+void print_usage(const char *program_name) {
+  printf("Usage: %s -s <shards> [OPTION]...\n", program_name);
+  printf("Options:\n");
+  printf("  -s <shards>  Layout to migrate to: 0 (flat), 256 or 4096\n");
+  printf("  -d <dir>     Migrate only this dir (default watch and export "
+         "dirs from config)\n");
+  printf("  -n           Dry run, only print what would be moved\n");
+  printf("  -h           Show this help message\n");
+  printf("\n");
+  printf("Stop the sn1ff service first, and afterwards set "
+         "'server_shards=<shards>'\n");
+  printf("in %s\n\n", sn_cfg_get_conf_file());
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Migrate                                                        |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+/**
+ * Is "name" a shard dir name, of 2 or 3 hex characters
+ */
+static bool is_shard_name(const char *name) {
+  size_t len = strlen(name);
+  if (len != 2 && len != 3)
+    return false;
+
+  for (size_t i = 0; i < len; i++) {
+    if (!isxdigit((unsigned char)name[i]))
+      return false;
+  }
+  return true;
+}
+
+/**
+ * Move the sn1ff files of one dir (flat, or a shard dir) to where they
+ * belong with the new number of shards
+ *
+ * @return  0 success
+ *         -1 could not list the dir
+ *         -2 could not move one or more files
+ */
+static int migrate_files(const char *from_dir, const char *base_dir,
+                         int shards, bool dry_run, long *moved) {
+  MultiString ms;
+  cn_multistr_init(&ms);
+
+  if (sn_dir_list_files(from_dir, &ms) != 0) {
+    cn_multistr_free(&ms);
+    return -1;
+  }
+
+  int result = 0;
+  char from[2048];
+  char to[2048];
+
+  for (size_t i = 0; i < ms.num_strings; i++) {
+    const char *name = cn_multistr_getstr(&ms, i);
+    snprintf(from, sizeof(from), "%s/%s", from_dir, name);
+
+    if (sn_shard_path(base_dir, name, shards, to, sizeof(to)) != 0) {
+      fprintf(stderr, "Skipping file without a GUID -> %s <-\n", from);
+      continue;
+    }
+
+    // Already in the right place
+
+    char shard_dir[2048];
+    sn_shard_dir(base_dir, name, shards, shard_dir, sizeof(shard_dir));
+    size_t len = strlen(shard_dir);
+    if (len > 0 && shard_dir[len - 1] == '/')
+      shard_dir[len - 1] = '\0';
+    if (strcmp(from_dir, shard_dir) == 0)
+      continue;
+
+    if (dry_run) {
+      printf("%s -> %s\n", from, to);
+    } else if (rename(from, to) == -1) {
+      fprintf(stderr, "Could not move -> %s <- to -> %s <-, %s\n", from, to,
+              strerror(errno));
+      result = -2;
+      continue;
+    }
+    (*moved)++;
+  }
+
+  cn_multistr_free(&ms);
+  return result;
+}
+
+/**
+ * Migrate a whole dir: the flat files, and the files in every existing
+ * shard dir. Shard dirs left empty are removed
+ *
+ * @return  0 success
+ *         -1 error
+ */
+static int migrate_dir(const char *dir, int shards, bool dry_run) {
+  // Strip a trailing '/', so dir names compare the same
+
+  char base_dir[1024];
+  snprintf(base_dir, sizeof(base_dir), "%s", dir);
+  size_t len = strlen(base_dir);
+  if (len > 1 && base_dir[len - 1] == '/')
+    base_dir[len - 1] = '\0';
+
+  if (!dry_run && sn_shard_create_dirs(base_dir, shards) != 0) {
+    fprintf(stderr, "Could not create shard dirs in -> %s <-\n", base_dir);
+    return -1;
+  }
+
+  long moved = 0;
+  int result = migrate_files(base_dir, base_dir, shards, dry_run, &moved);
+
+  DIR *d = opendir(base_dir);
+  if (d == NULL) {
+    fprintf(stderr, "Could not open dir -> %s <-, %s\n", base_dir,
+            strerror(errno));
+    return -1;
+  }
+
+  struct dirent *entry;
+  char shard_dir[2048];
+  while ((entry = readdir(d)) != NULL) {
+    if (!is_shard_name(entry->d_name))
+      continue;
+
+    snprintf(shard_dir, sizeof(shard_dir), "%s/%s", base_dir, entry->d_name);
+    if (migrate_files(shard_dir, base_dir, shards, dry_run, &moved) != 0)
+      result = -1;
+
+    // Shard dirs of the old layout are removed once empty
+
+    bool keep = (shards == SN_SHARD_256 && strlen(entry->d_name) == 2) ||
+                (shards == SN_SHARD_4096 && strlen(entry->d_name) == 3);
+    if (!keep && !dry_run)
+      rmdir(shard_dir);
+  }
+  closedir(d);
+
+  printf("%s: %s %ld files, for %d shards\n", base_dir,
+         dry_run ? "would move" : "moved", moved, shards);
+
+  return result == 0 ? 0 : -1;
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Main                                                           |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+int main(int argc, char *argv[]) {
+  int shards = -1;
+  const char *dir = NULL;
+  bool dry_run = false;
+
+  if (sn_cfg_load() != 0) {
+    fprintf(stderr, "Could not open/access conf file -> %s <-\n",
+            sn_cfg_get_conf_file());
+  }
+  cn_log_open(argv[0], sn_cfg_get_minloglevel());
+
+  int opt;
+  while ((opt = getopt(argc, argv, "hs:d:n")) != -1) {
+    switch (opt) {
+    case 's':
+      shards = (int)strtol(optarg, NULL, 10);
+      break;
+    case 'd':
+      dir = optarg;
+      break;
+    case 'n':
+      dry_run = true;
+      break;
+    case 'h':
+      print_usage(argv[0]);
+      return EXIT_SUCCESS;
+    default:
+      print_usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (!sn_shard_valid(shards)) {
+    fprintf(stderr, "Invalid number of shards, expected 0, 256 or 4096\n");
+    print_usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  int result = 0;
+  if (dir != NULL) {
+    result = migrate_dir(dir, shards, dry_run);
+  } else {
+    result |= migrate_dir(sn_cfg_get_server_watch_dir(), shards, dry_run);
+    result |= migrate_dir(sn_cfg_get_server_export_dir(), shards, dry_run);
+  }
+
+  if (result == 0 && !dry_run)
+    printf("Now set 'server_shards=%d' in %s\n", shards,
+           sn_cfg_get_conf_file());
+
+  cn_log_close();
+  return result == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,184 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "sn_batch.h"
+#include "cn_log.h"
+#include "cn_string.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Setup                                                          |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+/**
+ * Initialize a batch, for up to "capacity" operations
+ *
+ * @return  0 success
+ *         -1 invalid capacity
+ *         -2 could not allocate the operations
+ */
+int sn_batch_init(Batch *batch, size_t capacity) {
+  batch->ops = NULL;
+  batch->count = 0;
+  batch->capacity = 0;
+  if (capacity < 1 || capacity > SN_BATCH_CAPACITY) {
+    cn_log_msg(LOG_ERR, __func__, "Invalid batch capacity -> %zu <-",
+               capacity);
+    return -1;
+  }
+
+  batch->ops = malloc(capacity * sizeof(BatchOp));
+  if (batch->ops == NULL) {
+    cn_log_msg(LOG_ERR, __func__, "Could not allocate batch -> %zu <-",
+               capacity);
+    return -2;
+  }
+  batch->capacity = capacity;
+
+  return 0;
+}
+
+void sn_batch_free(Batch *batch) {
+  free(batch->ops);
+  batch->ops = NULL;
+  batch->count = 0;
+  batch->capacity = 0;
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Add operations                                                 |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+/**
+ * @return  0 success
+ *         -1 batch is full
+ *         -2 path too long
+ */
+static int sn_batch_add(Batch *batch, int op, const char *from,
+                        const char *to, bool link_next) {
+  if (batch->count >= batch->capacity)
+    return -1;
+
+  BatchOp *batch_op = &batch->ops[batch->count];
+  batch_op->op = op;
+  batch_op->link_next = link_next;
+  batch_op->result = 0;
+  batch_op->to[0] = '\0';
+
+  if (cn_string_cp(batch_op->from, sizeof(batch_op->from), from) != 0)
+    return -2;
+  if (to != NULL && cn_string_cp(batch_op->to, sizeof(batch_op->to), to) != 0)
+    return -2;
+
+  batch->count++;
+  return 0;
+}
+
+int sn_batch_add_link(Batch *batch, const char *from, const char *to,
+                      bool link_next) {
+  return sn_batch_add(batch, SN_BATCH_OP_LINK, from, to, link_next);
+}
+
+int sn_batch_add_rename(Batch *batch, const char *from, const char *to,
+                        bool link_next) {
+  return sn_batch_add(batch, SN_BATCH_OP_RENAME, from, to, link_next);
+}
+
+int sn_batch_add_unlink(Batch *batch, const char *path, bool link_next) {
+  return sn_batch_add(batch, SN_BATCH_OP_UNLINK, path, NULL, link_next);
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Submit                                                         |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+static void sn_batch_run_syscalls(Batch *batch) {
+  bool cancelled = false;
+
+  for (size_t i = 0; i < batch->count; i++) {
+    BatchOp *op = &batch->ops[i];
+    int result = 0;
+
+    if (cancelled) {
+      op->result = -ECANCELED;
+    } else {
+      switch (op->op) {
+      case SN_BATCH_OP_LINK:
+        result = linkat(AT_FDCWD, op->from, AT_FDCWD, op->to, 0);
+        break;
+      case SN_BATCH_OP_RENAME:
+        result = renameat(AT_FDCWD, op->from, AT_FDCWD, op->to);
+        break;
+      default:
+        result = unlinkat(AT_FDCWD, op->from, 0);
+        break;
+      }
+      op->result = result == 0 ? 0 : -errno;
+    }
+
+    // A chain ends at the first op without "link_next"
+
+    if (!op->link_next)
+      cancelled = false;
+    else if (op->result != 0)
+      cancelled = true;
+  }
+}
+
+/**
+ * Run every operation in the batch. The result of each operation is in
+ * "ops[i].result", until sn_batch_reset
+ *
+ * @return  the number of operations that failed
+ */
+size_t sn_batch_submit(Batch *batch) {
+  if (batch->count == 0)
+    return 0;
+
+  sn_batch_run_syscalls(batch);
+
+  size_t failed = 0;
+  for (size_t i = 0; i < batch->count; i++) {
+    if (batch->ops[i].result != 0)
+      failed++;
+  }
+  return failed;
+}
+
+/**
+ * Empty the batch, for reuse
+ */
+void sn_batch_reset(Batch *batch) { batch->count = 0; }
@@ -27,6 +27,8 @@ SOFTWARE.
 #include "sn_cfg.h"
 #include "cn_log.h"
 #include "cn_string.h"
+#include "sn_shard.h"
+#include "sn_sink.h"
 
 #define CONFIG_FILE_SZ 128
 char CONFIG_FILE[CONFIG_FILE_SZ] = "/etc/sn1ff/sn1ff.conf";
@@ -39,6 +41,26 @@ char CONFIG_FILE[CONFIG_FILE_SZ] = "/etc/sn1ff/sn1ff.conf";
  * server_address=192.0.2.0
  * watch=true
  * export=false
+ * greeter_workers=4
+ * server_shards=0
+ * index_checkpoint_enabled=true
+ * greeter_journal_enabled=true
+ * greeter_dedup_enabled=true
+ * greeter_transitions_only=false
+ * greeter_heartbeat_mins=60
+ * greeter_history_enabled=false
+ * greeter_metrics_enabled=false
+ * greeter_search_enabled=false
+ * greeter_sink_path=
+ * greeter_sink_type=fifo
+ * greeter_sink_body=false
+ * greeter_sink_buffer_kb=1024
+ * client_suppress=false
+ * client_file_format=1
+ * agent_schedule=60:/etc/sn1ff/checks/hourly
+ * agent_schedule=1440:/etc/sn1ff/checks/daily
+ * agent_jobs=8
+ * agent_timeout_secs=300
  */
 #define MIN_LOG_LEVEL_STR_SZ 10
 char MIN_LOG_LEVEL_STR[MIN_LOG_LEVEL_STR_SZ];
@@ -53,6 +75,54 @@ char SERVER_ADDRESS_STR[SERVER_ADDRESS_STR_SZ];
 bool watch_enabled = true;
 bool export_enabled = false;
 
+#define GREETER_WORKERS_MAX 64
+int greeter_workers = 4;
+
+int server_shards = SN_SHARD_NONE;
+
+bool index_checkpoint_enabled = true;
+
+bool greeter_journal_enabled = true;
+
+bool greeter_dedup_enabled = true;
+
+bool greeter_transitions_only = false;
+
+#define GREETER_HEARTBEAT_MINS_MAX (7 * 24 * 60)
+int greeter_heartbeat_mins = 60;
+
+bool greeter_history_enabled = false;
+
+bool greeter_metrics_enabled = false;
+
+bool greeter_search_enabled = false;
+
+// FIFO or UNIX socket the greeter streams results to, empty none, see
+// sn_sink.h
+char GREETER_SINK_PATH_STR[SN_SINK_PATH_LENGTH] = "";
+int greeter_sink_type = SN_SINK_FIFO;
+bool greeter_sink_body = false;
+
+#define GREETER_SINK_BUFFER_KB_MIN 64
+#define GREETER_SINK_BUFFER_KB_MAX 65536
+int greeter_sink_buffer_kb = 1024;
+
+bool client_suppress = false;
+
+// Format of result files begun, see sn_file.h
+int client_file_format = 1;
+
+// One "agent_schedule" entry per line, "<period mins>:<checks dir>"
+#define AGENT_SCHEDULE_STR_SZ 200
+char AGENT_SCHEDULE_STR[SN_CFG_AGENT_SCHEDULES_MAX][AGENT_SCHEDULE_STR_SZ];
+int agent_schedule_count = 0;
+
+#define AGENT_JOBS_MAX 64
+int agent_jobs = 8;
+
+#define AGENT_TIMEOUT_SECS_MAX 86400
+int agent_timeout_secs = 300;
+
 /*
  * Directories
  */
@@ -70,6 +140,24 @@ const char *SERVER_UPLOAD_BASE_DIR = "/upload";
 #define SERVER_WATCH_DIR_SZ (sizeof(SERVER_WATCH_DIR))
 #define SERVER_EXPORT_DIR_SZ (sizeof(SERVER_EXPORT_DIR))
 
+/*
+ * State kept across restarts
+ */
+
+#define SERVER_STATE_DIR "/var/lib/sn1ff/"
+#define SERVER_WATCH_INDEX_FILE SERVER_STATE_DIR "watch.idx"
+#define SERVER_INGEST_JOURNAL_FILE SERVER_STATE_DIR "ingest.journal"
+#define SERVER_CHECK_STATE_FILE SERVER_STATE_DIR "checks.state"
+#define SERVER_HISTORY_DIR SERVER_STATE_DIR "history"
+#define SERVER_METRICS_DIR SERVER_STATE_DIR "metrics"
+#define SERVER_SEARCH_DIR SERVER_STATE_DIR "search"
+
+/*
+ * Rules to extract numeric metrics from result bodies, see sn_metrics.h
+ */
+
+#define SERVER_METRICS_RULES_FILE "/etc/sn1ff/metrics.conf"
+
 /*
  * User, group
  */
@@ -182,6 +270,243 @@ int sn_cfg_load(void) {
         fclose(file);
         return -1;
       }
+    } else if (key && value && strcmp(key, "greeter_workers") == 0) {
+      char *endptr = NULL;
+      long workers = strtol(value, &endptr, 10);
+      if (*endptr != '\0' || workers < 1 || workers > GREETER_WORKERS_MAX) {
+        cn_log_msg(LOG_WARNING, __func__,
+                   "Invalid value for 'greeter_workers', expected 1 to %d, "
+                   "got -> %s <-",
+                   GREETER_WORKERS_MAX, value);
+        fclose(file);
+        return -1;
+      }
+      greeter_workers = (int)workers;
+    } else if (key && value && strcmp(key, "server_shards") == 0) {
+      char *endptr = NULL;
+      long shards = strtol(value, &endptr, 10);
+      if (*endptr != '\0' || !sn_shard_valid((int)shards)) {
+        cn_log_msg(LOG_WARNING, __func__,
+                   "Invalid value for 'server_shards', expected 0, 256 or "
+                   "4096, got -> %s <-",
+                   value);
+        fclose(file);
+        return -1;
+      }
+      server_shards = (int)shards;
+    } else if (key && value && strcmp(key, "index_checkpoint_enabled") == 0) {
+      if (strcmp(value, "true") == 0) {
+        index_checkpoint_enabled = true;
+      } else if (strcmp(value, "false") == 0) {
+        index_checkpoint_enabled = false;
+      } else {
+        cn_log_msg(LOG_WARNING, __func__,
+                   "Invalid value for 'index_checkpoint_enabled', expected "
+                   "'true' or 'false', got -> %s <-",
+                   value);
+        fclose(file);
+        return -1;
+      }
+    } else if (key && value && strcmp(key, "greeter_journal_enabled") == 0) {
+      if (strcmp(value, "true") == 0) {
+        greeter_journal_enabled = true;
+      } else if (strcmp(value, "false") == 0) {
+        greeter_journal_enabled = false;
+      } else {
+        cn_log_msg(LOG_WARNING, __func__,
+                   "Invalid value for 'greeter_journal_enabled', expected "
+                   "'true' or 'false', got -> %s <-",
+                   value);
+        fclose(file);
+        return -1;
+      }
+    } else if (key && value && strcmp(key, "greeter_dedup_enabled") == 0) {
+      if (strcmp(value, "true") == 0) {
+        greeter_dedup_enabled = true;
+      } else if (strcmp(value, "false") == 0) {
+        greeter_dedup_enabled = false;
+      } else {
+        cn_log_msg(LOG_WARNING, __func__,
+                   "Invalid value for 'greeter_dedup_enabled', expected "
+                   "'true' or 'false', got -> %s <-",
+                   value);
+        fclose(file);
+        return -1;
+      }
+    } else if (key && value && strcmp(key, "greeter_transitions_only") == 0) {
+      if (strcmp(value, "true") == 0) {
+        greeter_transitions_only = true;
+      } else if (strcmp(value, "false") == 0) {
+        greeter_transitions_only = false;
+      } else {
+        cn_log_msg(LOG_WARNING, __func__,
+                   "Invalid value for 'greeter_transitions_only', expected "
+                   "'true' or 'false', got -> %s <-",
+                   value);
+        fclose(file);
+        return -1;
+      }
+    } else if (key && value && strcmp(key, "greeter_heartbeat_mins") == 0) {
+      char *endptr = NULL;
+      long mins = strtol(value, &endptr, 10);
+      if (*endptr != '\0' || mins < 0 || mins > GREETER_HEARTBEAT_MINS_MAX) {
+        cn_log_msg(LOG_WARNING, __func__,
+                   "Invalid value for 'greeter_heartbeat_mins', expected 0 "
+                   "to %d, got -> %s <-",
+                   GREETER_HEARTBEAT_MINS_MAX, value);
+        fclose(file);
+        return -1;
+      }
+      greeter_heartbeat_mins = (int)mins;
+    } else if (key && value && strcmp(key, "greeter_history_enabled") == 0) {
+      if (strcmp(value, "true") == 0) {
+        greeter_history_enabled = true;
+      } else if (strcmp(value, "false") == 0) {
+        greeter_history_enabled = false;
+      } else {
+        cn_log_msg(LOG_WARNING, __func__,
+                   "Invalid value for 'greeter_history_enabled', expected "
+                   "'true' or 'false', got -> %s <-",
+                   value);
+        fclose(file);
+        return -1;
+      }
+    } else if (key && value && strcmp(key, "greeter_metrics_enabled") == 0) {
+      if (strcmp(value, "true") == 0) {
+        greeter_metrics_enabled = true;
+      } else if (strcmp(value, "false") == 0) {
+        greeter_metrics_enabled = false;
+      } else {
+        cn_log_msg(LOG_WARNING, __func__,
+                   "Invalid value for 'greeter_metrics_enabled', expected "
+                   "'true' or 'false', got -> %s <-",
+                   value);
+        fclose(file);
+        return -1;
+      }
+    } else if (key && value && strcmp(key, "greeter_search_enabled") == 0) {
+      if (strcmp(value, "true") == 0) {
+        greeter_search_enabled = true;
+      } else if (strcmp(value, "false") == 0) {
+        greeter_search_enabled = false;
+      } else {
+        cn_log_msg(LOG_WARNING, __func__,
+                   "Invalid value for 'greeter_search_enabled', expected "
+                   "'true' or 'false', got -> %s <-",
+                   value);
+        fclose(file);
+        return -1;
+      }
+    } else if (key && value && strcmp(key, "greeter_sink_path") == 0) {
+      if (strlen(value) >= SN_SINK_PATH_LENGTH) {
+        cn_log_msg(LOG_WARNING, __func__,
+                   "Invalid value for 'greeter_sink_path', at most %d "
+                   "characters, got -> %s <-",
+                   SN_SINK_PATH_LENGTH - 1, value);
+        fclose(file);
+        return -1;
+      }
+      strcpy(GREETER_SINK_PATH_STR, value);
+    } else if (key && value && strcmp(key, "greeter_sink_type") == 0) {
+      int type = sn_sink_type(value);
+      if (type < 0) {
+        cn_log_msg(LOG_WARNING, __func__,
+                   "Invalid value for 'greeter_sink_type', expected 'fifo', "
+                   "'stream' or 'dgram', got -> %s <-",
+                   value);
+        fclose(file);
+        return -1;
+      }
+      greeter_sink_type = type;
+    } else if (key && value && strcmp(key, "greeter_sink_body") == 0) {
+      if (strcmp(value, "true") == 0) {
+        greeter_sink_body = true;
+      } else if (strcmp(value, "false") == 0) {
+        greeter_sink_body = false;
+      } else {
+        cn_log_msg(LOG_WARNING, __func__,
+                   "Invalid value for 'greeter_sink_body', expected 'true' "
+                   "or 'false', got -> %s <-",
+                   value);
+        fclose(file);
+        return -1;
+      }
+    } else if (key && value && strcmp(key, "greeter_sink_buffer_kb") == 0) {
+      char *endptr = NULL;
+      long kb = strtol(value, &endptr, 10);
+      if (*endptr != '\0' || kb < GREETER_SINK_BUFFER_KB_MIN ||
+          kb > GREETER_SINK_BUFFER_KB_MAX) {
+        cn_log_msg(LOG_WARNING, __func__,
+                   "Invalid value for 'greeter_sink_buffer_kb', expected %d "
+                   "to %d, got -> %s <-",
+                   GREETER_SINK_BUFFER_KB_MIN, GREETER_SINK_BUFFER_KB_MAX,
+                   value);
+        fclose(file);
+        return -1;
+      }
+      greeter_sink_buffer_kb = (int)kb;
+    } else if (key && value && strcmp(key, "client_suppress") == 0) {
+      if (strcmp(value, "true") == 0) {
+        client_suppress = true;
+      } else if (strcmp(value, "false") == 0) {
+        client_suppress = false;
+      } else {
+        cn_log_msg(LOG_WARNING, __func__,
+                   "Invalid value for 'client_suppress', expected 'true' or "
+                   "'false', got -> %s <-",
+                   value);
+        fclose(file);
+        return -1;
+      }
+    } else if (key && value && strcmp(key, "client_file_format") == 0) {
+      if (strcmp(value, "1") == 0) {
+        client_file_format = 1;
+      } else if (strcmp(value, "2") == 0) {
+        client_file_format = 2;
+      } else {
+        cn_log_msg(LOG_WARNING, __func__,
+                   "Invalid value for 'client_file_format', expected '1' or "
+                   "'2', got -> %s <-",
+                   value);
+        fclose(file);
+        return -1;
+      }
+    } else if (key && value && strcmp(key, "agent_schedule") == 0) {
+      if (agent_schedule_count >= SN_CFG_AGENT_SCHEDULES_MAX ||
+          cn_string_cp(AGENT_SCHEDULE_STR[agent_schedule_count],
+                       AGENT_SCHEDULE_STR_SZ, value) != 0) {
+        cn_log_msg(LOG_WARNING, __func__,
+                   "Invalid value for 'agent_schedule', at most %d entries, "
+                   "config file line -> %s <-",
+                   SN_CFG_AGENT_SCHEDULES_MAX, line);
+        fclose(file);
+        return -1;
+      }
+      agent_schedule_count++;
+    } else if (key && value && strcmp(key, "agent_jobs") == 0) {
+      char *endptr = NULL;
+      long jobs = strtol(value, &endptr, 10);
+      if (*endptr != '\0' || jobs < 1 || jobs > AGENT_JOBS_MAX) {
+        cn_log_msg(LOG_WARNING, __func__,
+                   "Invalid value for 'agent_jobs', expected 1 to %d, got -> "
+                   "%s <-",
+                   AGENT_JOBS_MAX, value);
+        fclose(file);
+        return -1;
+      }
+      agent_jobs = (int)jobs;
+    } else if (key && value && strcmp(key, "agent_timeout_secs") == 0) {
+      char *endptr = NULL;
+      long secs = strtol(value, &endptr, 10);
+      if (*endptr != '\0' || secs < 1 || secs > AGENT_TIMEOUT_SECS_MAX) {
+        cn_log_msg(LOG_WARNING, __func__,
+                   "Invalid value for 'agent_timeout_secs', expected 1 to %d, "
+                   "got -> %s <-",
+                   AGENT_TIMEOUT_SECS_MAX, value);
+        fclose(file);
+        return -1;
+      }
+      agent_timeout_secs = (int)secs;
     } else {
       fprintf(stderr, "%s: config entry -> %s <- not recognized", __func__,
               line);
@@ -204,6 +529,52 @@ bool sn_cfg_watch_enabled(void) { return watch_enabled; }
 
 bool sn_cfg_export_enabled(void) { return export_enabled; }
 
+int sn_cfg_get_greeter_workers(void) { return greeter_workers; }
+
+int sn_cfg_get_server_shards(void) { return server_shards; }
+
+bool sn_cfg_index_checkpoint_enabled(void) { return index_checkpoint_enabled; }
+
+bool sn_cfg_greeter_journal_enabled(void) { return greeter_journal_enabled; }
+
+bool sn_cfg_greeter_dedup_enabled(void) { return greeter_dedup_enabled; }
+
+bool sn_cfg_greeter_transitions_only(void) { return greeter_transitions_only; }
+
+int sn_cfg_get_greeter_heartbeat_mins(void) { return greeter_heartbeat_mins; }
+
+bool sn_cfg_greeter_history_enabled(void) { return greeter_history_enabled; }
+
+bool sn_cfg_greeter_metrics_enabled(void) { return greeter_metrics_enabled; }
+
+bool sn_cfg_greeter_search_enabled(void) { return greeter_search_enabled; }
+
+const char *sn_cfg_get_greeter_sink_path(void) {
+  return GREETER_SINK_PATH_STR;
+}
+
+int sn_cfg_get_greeter_sink_type(void) { return greeter_sink_type; }
+
+bool sn_cfg_greeter_sink_body(void) { return greeter_sink_body; }
+
+int sn_cfg_get_greeter_sink_buffer_kb(void) { return greeter_sink_buffer_kb; }
+
+bool sn_cfg_client_suppress(void) { return client_suppress; }
+
+int sn_cfg_get_client_file_format(void) { return client_file_format; }
+
+int sn_cfg_get_agent_schedule_count(void) { return agent_schedule_count; }
+
+const char *sn_cfg_get_agent_schedule(int index) {
+  if (index < 0 || index >= agent_schedule_count)
+    return NULL;
+  return AGENT_SCHEDULE_STR[index];
+}
+
+int sn_cfg_get_agent_jobs(void) { return agent_jobs; }
+
+int sn_cfg_get_agent_timeout_secs(void) { return agent_timeout_secs; }
+
 /*
  * Server directories
  */
@@ -218,6 +589,32 @@ const char *sn_cfg_get_server_watch_dir(void) { return SERVER_WATCH_DIR; }
 
 const char *sn_cfg_get_server_export_dir(void) { return SERVER_EXPORT_DIR; }
 
+/*
+ * Server state files
+ */
+
+const char *sn_cfg_get_server_watch_index_file(void) {
+  return SERVER_WATCH_INDEX_FILE;
+}
+
+const char *sn_cfg_get_server_ingest_journal_file(void) {
+  return SERVER_INGEST_JOURNAL_FILE;
+}
+
+const char *sn_cfg_get_server_check_state_file(void) {
+  return SERVER_CHECK_STATE_FILE;
+}
+
+const char *sn_cfg_get_server_history_dir(void) { return SERVER_HISTORY_DIR; }
+
+const char *sn_cfg_get_server_metrics_dir(void) { return SERVER_METRICS_DIR; }
+
+const char *sn_cfg_get_server_search_dir(void) { return SERVER_SEARCH_DIR; }
+
+const char *sn_cfg_get_server_metrics_rules_file(void) {
+  return SERVER_METRICS_RULES_FILE;
+}
+
 /*
  * Server user
  */
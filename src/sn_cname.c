@@ -27,6 +27,7 @@ SOFTWARE.
 #include "sn_cname.h"
 #include "cn_log.h"
 #include "sn_status.h"
+#include <strings.h>
 
 /*
  * Sn1ff fname:
@@ -74,12 +75,15 @@ void sn_cname_get_guid_bin(CName *cname, uuid_t *guid_bin) {
 
 void sn_cname_set_status(CName *cname, const char *status) {
   strncpy(cname->status, status, CNAME_STATUS_LENGTH);
+  cname->status_id = sn_status_from_chars(cname->status);
 }
 
 void sn_cname_get_status(CName *cname, char *status) {
   strncpy(status, cname->status, CNAME_STATUS_LENGTH);
 }
 
+Status sn_cname_get_status_id(CName *cname) { return cname->status_id; }
+
 /*----------------------------------------------------------------.
  |                                                                |
  | Epoch                                                          |
@@ -111,60 +115,148 @@ void sn_cname_incr_epoch_bin(CName *cname, int incr_minutes) {
  |                                                                |
  '----------------------------------------------------------------*/
 
+/*
+ * Hex digit values plus 1, so 0 marks a character that is not a hex digit
+ */
+static const unsigned char HEX_VALUE[256] = {
+    ['0'] = 1,   ['1'] = 2,   ['2'] = 3,   ['3'] = 4,   ['4'] = 5,
+    ['5'] = 6,   ['6'] = 7,   ['7'] = 8,   ['8'] = 9,   ['9'] = 10,
+    ['a'] = 11,  ['b'] = 12,  ['c'] = 13,  ['d'] = 14,  ['e'] = 15,
+    ['f'] = 16,  ['A'] = 11,  ['B'] = 12,  ['C'] = 13,  ['D'] = 14,
+    ['E'] = 15,  ['F'] = 16};
+
+/*
+ * Offsets of the 16 hex digit pairs, in a GUID string:
+ *   xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx
+ */
+static const unsigned char GUID_PAIRS[16] = {0,  2,  4,  6,  9,  11, 14, 16,
+                                             19, 21, 24, 26, 28, 30, 32, 34};
+
+/**
+ * Decode a 36 character GUID string, as uuid_parse does
+ *
+ * @return  0 success
+ *         -1 not a GUID
+ */
+static int parse_guid(const char *str, uuid_t bin) {
+  if (str[8] != '-' || str[13] != '-' || str[18] != '-' || str[23] != '-')
+    return -1;
+
+  unsigned char bad = 0;
+  for (int i = 0; i < 16; i++) {
+    unsigned char hi = HEX_VALUE[(unsigned char)str[GUID_PAIRS[i]]];
+    unsigned char lo = HEX_VALUE[(unsigned char)str[GUID_PAIRS[i] + 1]];
+    bad |= (unsigned char)(hi == 0) | (unsigned char)(lo == 0);
+    bin[i] = (unsigned char)(((hi - 1) << 4) | (lo - 1));
+  }
+
+  return bad ? -1 : 0;
+}
+
+/**
+ * Decode the 10 digit epoch
+ *
+ * @return  0 success
+ *         -1 not all digits
+ */
+static int parse_epoch(const char *str, time_t *epoch_bin) {
+  time_t value = 0;
+  for (int i = 0; i < CNAME_EPOCH_LENGTH; i++) {
+    unsigned int digit = (unsigned char)str[i] - (unsigned int)'0';
+    if (digit > 9)
+      return -1;
+    value = value * 10 + (time_t)digit;
+  }
+  *epoch_bin = value;
+  return 0;
+}
+
+/**
+ * Describe a sn_cname_parse_name return code
+ */
+const char *sn_cname_parse_error(int code) {
+  switch (code) {
+  case CNAME_PARSE_OK:
+    return "ok";
+  case CNAME_PARSE_ERR_LENGTH:
+    return "wrong name length";
+  case CNAME_PARSE_ERR_GUID:
+    return "invalid GUID";
+  case CNAME_PARSE_ERR_SEPARATOR:
+    return "missing '_' separator";
+  case CNAME_PARSE_ERR_STATUS:
+    return "unknown status";
+  case CNAME_PARSE_ERR_EPOCH:
+    return "invalid epoch";
+  case CNAME_PARSE_ERR_EXTENSION:
+    return "missing .snff extension";
+  default:
+    return "unknown error";
+  }
+}
+
 /**
  * Parse sn1ff filename into an object representation, so the caller
  * can then access, or change the name component values
  *
+ * The layout is fixed, so the name is checked and decoded in one pass with
+ * no copies other than into cname. cname is only changed on success
+ *
  * @param name_str    i    sn1ff file name in format -
  * <guid>_<status>_<epoch>.snff
  * @param name        i/o  object representation of the file name
  * @return                 status code:
- *                           0  success
- *                          -1  error parsing file name
+ *                           0  success (CNAME_PARSE_OK)
+ *                          -1  name is not CNAME_FILE_NAME_LENGTH long
  *                          -2  error parsing GUID
+ *                          -3  '_' separator missing
+ *                          -4  status not ALRT|WARN|OKAY|NONE
+ *                          -5  epoch not 10 digits
+ *                          -6  .snff extension missing (any case)
  */
 int sn_cname_parse_name(const char *name_str, CName *cname) {
-  char guid_str[CNAME_GUID_LENGTH_D];
-  uuid_t guid_bin;
-
-  char status[CNAME_STATUS_LENGTH_D];
+  const char *guid = name_str;
+  const char *status = guid + CNAME_GUID_LENGTH + 1;
+  const char *epoch = status + CNAME_STATUS_LENGTH + 1;
+  const char *ext = epoch + CNAME_EPOCH_LENGTH;
 
-  char epoch_str[CNAME_EPOCH_LENGTH_D];
+  uuid_t guid_bin;
   time_t epoch_bin;
-
-  int ret = 0;
-
-  // Use sscanf to split the string based on the format
-  // <GUID>_<STATUS>_<EPOCH>.snff
-
-  ret = sscanf(name_str, "%36s_%4s_%10s.snff", guid_str, status, epoch_str);
-  if (ret != 3) {
-    cn_log_msg(LOG_ERR, __func__, "Could not parse name_str -> %s <-",
-               name_str);
-    return -1;
+  Status status_id;
+  int ret = CNAME_PARSE_OK;
+
+  if (strnlen(name_str, CNAME_FILE_NAME_LENGTH + 1) != CNAME_FILE_NAME_LENGTH)
+    ret = CNAME_PARSE_ERR_LENGTH;
+  else if (parse_guid(guid, guid_bin) != 0)
+    ret = CNAME_PARSE_ERR_GUID;
+  else if (status[-1] != '_' || epoch[-1] != '_')
+    ret = CNAME_PARSE_ERR_SEPARATOR;
+  else if ((status_id = sn_status_from_chars(status)) == SN_STATUS_INVALID)
+    ret = CNAME_PARSE_ERR_STATUS;
+  else if (parse_epoch(epoch, &epoch_bin) != 0)
+    ret = CNAME_PARSE_ERR_EPOCH;
+  else if (strcasecmp(ext, CNAME_EXTENSION) != 0)
+    ret = CNAME_PARSE_ERR_EXTENSION;
+
+  if (ret != CNAME_PARSE_OK) {
+    cn_log_msg(LOG_ERR, __func__, "Could not parse name_str -> %s <-, %s",
+               name_str, sn_cname_parse_error(ret));
+    return ret;
   }
 
-  // GUID
-
-  strncpy(cname->guid.str, guid_str, CNAME_GUID_LENGTH);
-  if (uuid_parse(guid_str, guid_bin) != 0) {
-    cn_log_msg(LOG_ERR, __func__, "Could not parse guid_str -> %s <-",
-               guid_str);
-    return -2;
-  }
+  memcpy(cname->guid.str, guid, CNAME_GUID_LENGTH);
+  cname->guid.str[CNAME_GUID_LENGTH] = '\0';
   memcpy(cname->guid.bin, guid_bin, sizeof(uuid_t));
 
-  // Status
-
-  strncpy(cname->status, status, CNAME_STATUS_LENGTH);
-
-  // Epoch
+  memcpy(cname->status, status, CNAME_STATUS_LENGTH);
+  cname->status[CNAME_STATUS_LENGTH] = '\0';
+  cname->status_id = status_id;
 
-  strncpy(cname->epoch.str, epoch_str, CNAME_EPOCH_LENGTH);
-  epoch_bin = (time_t)strtol(epoch_str, NULL, 10);
+  memcpy(cname->epoch.str, epoch, CNAME_EPOCH_LENGTH);
+  cname->epoch.str[CNAME_EPOCH_LENGTH] = '\0';
   cname->epoch.bin = epoch_bin;
 
-  return 0;
+  return CNAME_PARSE_OK;
 }
 
 /**
@@ -239,6 +331,7 @@ int sn_cname_parse_guid_name(const char *guid_name_str, const char *status_str,
   }
 
   strncpy(cname->status, status_str, CNAME_STATUS_LENGTH);
+  cname->status_id = sn_status_from_chars(cname->status);
 
   // Get current epoch time value
 
@@ -0,0 +1,438 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "sn_dedup.h"
+#include "cn_hash.h"
+#include "cn_log.h"
+#include "sn_file.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define DEDUP_INITIAL_CAPACITY 256
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Hash a sn1ff file                                              |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+/**
+ * Read a whole file, of at most SN_DEDUP_MAX_FILE_SIZE bytes
+ *
+ * @return  buffer to free, NULL on error
+ */
+static char *read_file(const char *path, size_t *length) {
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    cn_log_msg(LOG_ERR, __func__,
+               "'open' gave error for file -> %s <-, strerror(errno) -> %m <-",
+               path);
+    return NULL;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) == -1 || st.st_size > SN_DEDUP_MAX_FILE_SIZE) {
+    close(fd);
+    return NULL;
+  }
+
+  char *buffer = malloc((size_t)st.st_size + 1);
+  if (buffer == NULL) {
+    close(fd);
+    return NULL;
+  }
+
+  size_t done = 0;
+  while (done < (size_t)st.st_size) {
+    ssize_t got = read(fd, buffer + done, (size_t)st.st_size - done);
+    if (got == -1 && errno == EINTR)
+      continue;
+    if (got <= 0)
+      break;
+    done += (size_t)got;
+  }
+  close(fd);
+
+  buffer[done] = '\0';
+  *length = done;
+  return buffer;
+}
+
+/**
+ * Hash the Host and CheckID header values of a sn1ff file as its key, and
+ * the file less its "At: " header line as its body. For a v2 file the body
+ * is the IPv4 header value and the text body, the preamble (times, status,
+ * line count) is left out
+ *
+ * @param  seed  seeds the body hash, so results that differ other than in
+ *               the file (i.e. their status) do not match
+ * @return  0 success
+ *         -1 could not read the file
+ *         -2 no Host, or no CheckID header value
+ */
+int sn_dedup_hash_file(const char *path, uint64_t seed, uint64_t *key,
+                       uint64_t *body) {
+  size_t length = 0;
+  char *buffer = read_file(path, &length);
+  if (buffer == NULL)
+    return -1;
+
+  PREAMBLE preamble;
+  HEADER hdr;
+  int format = sn_file_parse_preamble((const unsigned char *)buffer, length,
+                                      &preamble, &hdr);
+  if (format != 1) {
+    if (format == 0) {
+      *key = cn_hash_xxh64(hdr.checkid, strlen(hdr.checkid),
+                           cn_hash_xxh64(hdr.host, strlen(hdr.host), 0));
+      *body = cn_hash_xxh64(buffer + preamble.body_offset,
+                            length - preamble.body_offset,
+                            cn_hash_xxh64(hdr.ipv4, strlen(hdr.ipv4), seed));
+    }
+    free(buffer);
+    return format == 0 ? 0 : -2;
+  }
+
+  const char *host = NULL, *checkid = NULL, *at = NULL;
+  size_t host_len = 0, checkid_len = 0, at_len = 0;
+
+  // Header lines, up to the first empty line
+
+  const char *line = buffer;
+  const char *end = buffer + length;
+
+  while (line < end) {
+    const char *eol = memchr(line, '\n', (size_t)(end - line));
+    size_t line_len = eol ? (size_t)(eol - line) : (size_t)(end - line);
+
+    if (line_len == 0)
+      break;
+
+    if (line_len >= 6 && strncmp(line, "Host: ", 6) == 0) {
+      host = line + 6;
+      host_len = line_len - 6;
+    } else if (line_len >= 9 && strncmp(line, "CheckID: ", 9) == 0) {
+      checkid = line + 9;
+      checkid_len = line_len - 9;
+    } else if (line_len >= 4 && strncmp(line, "At: ", 4) == 0) {
+      at = line;
+      at_len = eol ? line_len + 1 : line_len;
+    }
+
+    if (eol == NULL)
+      break;
+    line = eol + 1;
+  }
+
+  if (host == NULL || checkid == NULL) {
+    free(buffer);
+    return -2;
+  }
+
+  // Chained, so "ab" + "c" does not match "a" + "bc"
+
+  *key = cn_hash_xxh64(checkid, checkid_len,
+                       cn_hash_xxh64(host, host_len, 0));
+
+  if (at == NULL) {
+    *body = cn_hash_xxh64(buffer, length, seed);
+  } else {
+    size_t before = (size_t)(at - buffer);
+    *body = cn_hash_xxh64(at + at_len, length - before - at_len,
+                          cn_hash_xxh64(buffer, before, seed));
+  }
+
+  free(buffer);
+  return 0;
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Table                                                          |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+/**
+ * @param  transitions_only  only put results in "watch" on a change of
+ *                           status, while WARN / ALRT, or for a heartbeat
+ * @param  heartbeat         seconds between results of a check put in
+ *                           "watch" regardless, 0 for none
+ * @return  0 success
+ *         -1 could not allocate
+ */
+int sn_dedup_init(Dedup *dedup, bool transitions_only, long heartbeat) {
+  dedup->count = 0;
+  dedup->capacity = DEDUP_INITIAL_CAPACITY;
+  dedup->transitions_only = transitions_only;
+  dedup->heartbeat = heartbeat;
+  dedup->dirty = false;
+  dedup->entries = calloc(dedup->capacity, sizeof(DedupEntry));
+  return dedup->entries == NULL ? -1 : 0;
+}
+
+void sn_dedup_free(Dedup *dedup) {
+  free(dedup->entries);
+  dedup->entries = NULL;
+  dedup->capacity = 0;
+  dedup->count = 0;
+}
+
+/**
+ * Find the slot of "key", or the empty slot to put it in (linear probing)
+ */
+static DedupEntry *find_slot(DedupEntry *entries, size_t capacity,
+                             uint64_t key) {
+  size_t i = (size_t)key & (capacity - 1);
+  while (entries[i].key != 0 && entries[i].key != key)
+    i = (i + 1) & (capacity - 1);
+  return &entries[i];
+}
+
+/**
+ * Grow the table to hold at least "count" entries, keeping it at most 3/4
+ * full
+ */
+static int reserve(Dedup *dedup, size_t count) {
+  size_t capacity = dedup->capacity;
+  while (count * 4 > capacity * 3)
+    capacity *= 2;
+  if (capacity == dedup->capacity)
+    return 0;
+
+  DedupEntry *entries = calloc(capacity, sizeof(DedupEntry));
+  if (entries == NULL)
+    return -1;
+
+  for (size_t i = 0; i < dedup->capacity; i++) {
+    if (dedup->entries[i].key != 0)
+      *find_slot(entries, capacity, dedup->entries[i].key) =
+          dedup->entries[i];
+  }
+
+  free(dedup->entries);
+  dedup->entries = entries;
+  dedup->capacity = capacity;
+  return 0;
+}
+
+/**
+ * Is a result for "watch", given the last result of its check
+ */
+static bool for_watch(const Dedup *dedup, const DedupEntry *entry,
+                      Status status, time_t now) {
+  return !dedup->transitions_only || status != entry->status ||
+         status == SN_STATUS_WARN || status == SN_STATUS_ALRT ||
+         (dedup->heartbeat > 0 && now - entry->watched >= dedup->heartbeat);
+}
+
+/**
+ * Check a received sn1ff file against the last result of its check, and
+ * record it as the last result
+ *
+ * A file older than the last result (by the epoch of its name), or the
+ * same file again, is not recorded, and is for "watch"
+ *
+ * @param  dir       dir the file is in
+ * @param  now       current epoch, for the heartbeat
+ * @param  previous  returns for SN_DEDUP_REPEAT, the name of the last
+ *                   result, that this file repeats, must be at least
+ *                   CNAME_NAME_LENGTH_D
+ * @return  >= 0 SN_DEDUP_ flags
+ *            -1 file name does not parse
+ *            -2 could not read or hash the file
+ *            -3 could not allocate
+ */
+int sn_dedup_check(Dedup *dedup, const char *dir, const char *name,
+                   time_t now, char *previous) {
+  CName cname;
+  if (strlen(name) >= CNAME_NAME_LENGTH_D ||
+      sn_cname_parse_name(name, &cname) != CNAME_PARSE_OK)
+    return -1;
+
+  char path[1024];
+  int written = snprintf(path, sizeof(path), "%s/%s", dir, name);
+  if (written < 0 || (size_t)written >= sizeof(path))
+    return -2;
+
+  uint64_t key, body;
+  if (sn_dedup_hash_file(path, (uint64_t)cname.status_id, &key, &body) != 0)
+    return -2;
+  if (key == 0)
+    key = 1;
+
+  if (reserve(dedup, dedup->count + 1) != 0)
+    return -3;
+
+  DedupEntry *entry = find_slot(dedup->entries, dedup->capacity, key);
+  int64_t expiry = (int64_t)cname.epoch.bin;
+  Status status = cname.status_id;
+  int flags = 0;
+
+  if (entry->key == 0) {
+    dedup->count++;
+    entry->key = key;
+    flags = SN_DEDUP_WATCH;
+  } else if (expiry < entry->expiry || strcmp(entry->name, name) == 0) {
+    return SN_DEDUP_WATCH;
+  } else if (for_watch(dedup, entry, status, now)) {
+    flags = SN_DEDUP_WATCH;
+    if (entry->body == body && (entry->flags & SN_DEDUP_ENTRY_WATCHED)) {
+      flags |= SN_DEDUP_REPEAT;
+      strcpy(previous, entry->name);
+    }
+  }
+
+  if (flags & SN_DEDUP_WATCH) {
+    strcpy(entry->name, name);
+    entry->watched = (int64_t)now;
+    entry->flags |= SN_DEDUP_ENTRY_WATCHED;
+  } else if (entry->body != body) {
+    entry->flags &= ~SN_DEDUP_ENTRY_WATCHED;
+  }
+
+  entry->body = body;
+  entry->expiry = expiry;
+  entry->status = status;
+  dedup->dirty = true;
+  return flags;
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | State file                                                     |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+/**
+ * Save the table to a state file. It is written to a temp file, synced,
+ * and renamed over the old one
+ *
+ * @return  0 success
+ *         -1 could not write the state file
+ */
+int sn_dedup_save(Dedup *dedup, const char *path) {
+  char tmp_path[1024];
+  snprintf(tmp_path, sizeof(tmp_path), "%s.%ld.tmp", path, (long)getpid());
+
+  FILE *file = fopen(tmp_path, "w");
+  if (file == NULL) {
+    cn_log_msg(LOG_ERR, __func__,
+               "'fopen' gave error for state file -> %s <-, "
+               "strerror(errno) -> %m <-",
+               tmp_path);
+    return -1;
+  }
+
+  DedupHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, SN_DEDUP_MAGIC, SN_DEDUP_MAGIC_LENGTH);
+  header.version = SN_DEDUP_VERSION;
+  header.count = dedup->count;
+
+  bool written = fwrite(&header, sizeof(header), 1, file) == 1;
+  for (size_t i = 0; written && i < dedup->capacity; i++) {
+    if (dedup->entries[i].key != 0)
+      written = fwrite(&dedup->entries[i], sizeof(DedupEntry), 1, file) == 1;
+  }
+
+  written = written && fflush(file) == 0 && fsync(fileno(file)) == 0;
+
+  if (fclose(file) != 0 || !written || rename(tmp_path, path) != 0) {
+    cn_log_msg(LOG_ERR, __func__,
+               "Error writing state file -> %s <-, strerror(errno) -> %m <-",
+               path);
+    unlink(tmp_path);
+    return -1;
+  }
+
+  dedup->dirty = false;
+  return 0;
+}
+
+/**
+ * Load the table from a state file written by sn_dedup_save, replacing its
+ * entries. On error the table is left empty
+ *
+ * @return  0 success
+ *         -1 could not open the state file
+ *         -2 not a valid state file
+ *         -3 could not allocate
+ */
+int sn_dedup_load(Dedup *dedup, const char *path) {
+  memset(dedup->entries, 0, dedup->capacity * sizeof(DedupEntry));
+  dedup->count = 0;
+  dedup->dirty = false;
+
+  FILE *file = fopen(path, "r");
+  if (file == NULL) {
+    cn_log_msg(LOG_DEBUG, __func__,
+               "No state file -> %s <-, strerror(errno) -> %m <-", path);
+    return -1;
+  }
+
+  DedupHeader header;
+  struct stat st;
+  int result = 0;
+
+  if (fstat(fileno(file), &st) == -1 ||
+      fread(&header, sizeof(header), 1, file) != 1 ||
+      memcmp(header.magic, SN_DEDUP_MAGIC, SN_DEDUP_MAGIC_LENGTH) != 0 ||
+      header.version != SN_DEDUP_VERSION ||
+      header.count > (uint64_t)st.st_size / sizeof(DedupEntry) ||
+      (uint64_t)st.st_size !=
+          sizeof(DedupHeader) + header.count * sizeof(DedupEntry))
+    result = -2;
+  else if (reserve(dedup, (size_t)header.count) != 0)
+    result = -3;
+
+  DedupEntry entry;
+  for (uint64_t i = 0; result == 0 && i < header.count; i++) {
+    if (fread(&entry, sizeof(entry), 1, file) != 1 || entry.key == 0) {
+      result = -2;
+      break;
+    }
+    entry.name[CNAME_NAME_LENGTH] = '\0';
+
+    DedupEntry *slot = find_slot(dedup->entries, dedup->capacity, entry.key);
+    if (slot->key == 0)
+      dedup->count++;
+    *slot = entry;
+  }
+
+  fclose(file);
+
+  if (result != 0) {
+    cn_log_msg(LOG_WARNING, __func__, "Ignoring state file -> %s <-", path);
+    memset(dedup->entries, 0, dedup->capacity * sizeof(DedupEntry));
+    dedup->count = 0;
+  }
+  return result;
+}
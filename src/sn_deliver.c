@@ -0,0 +1,403 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "sn_deliver.h"
+#include "cn_file.h"
+#include "cn_log.h"
+#include "cn_multistr.h"
+#include "cn_remotefe.h"
+#include "sn_cfg.h"
+#include "sn_dir.h"
+#include "sn_file.h"
+#include "sn_fpath.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Suppress unchanged results                                     |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+static int suppress_state_path(char *path, size_t path_sz) {
+  char client_dir[256];
+  if (sn_dir_client(client_dir, sizeof(client_dir)) != 0)
+    return -1;
+
+  snprintf(path, path_sz, "%s/%s", client_dir, SN_SUPPRESS_FILE_NAME);
+  return 0;
+}
+
+/**
+ * Check if a result is unchanged from the last one sent, and need not be
+ * sent (see sn_suppress.h). A suppressed file is deleted, as if sent
+ *
+ * @param  server  remote sn1ff server, NULL for this host
+ * @param  record  returns the record to pass to sn_deliver_suppress_end once
+ *                 sent
+ * @return  SN_SUPPRESS_SEND  send it, then call sn_deliver_suppress_end
+ *          SN_SUPPRESS_SKIP  suppressed, do not send it
+ *         -1 send it, suppression is off or not possible
+ */
+int sn_deliver_suppress_begin(const char *file_path, const char *status,
+                               const char *ttl, const char *server,
+                               SuppressRecord *record) {
+  char state_path[512];
+  char *endptr = NULL;
+  long ttl_mins = strtol(ttl, &endptr, 10);
+
+  if (!sn_cfg_client_suppress() || *endptr != '\0' || ttl_mins < 0 ||
+      suppress_state_path(state_path, sizeof(state_path)) != 0)
+    return -1;
+
+  int result = sn_suppress_check(
+      state_path, file_path, server != NULL ? server : "",
+      sn_status_from_chars(status), (int)ttl_mins, time(NULL), record);
+
+  if (result == SN_SUPPRESS_SKIP) {
+    cn_log_msg(LOG_INFO, __func__,
+               "Upload suppressed, result unchanged from the last one sent "
+               "-> %s <-",
+               file_path);
+    cn_file_delete(file_path);
+  }
+  return result;
+}
+
+/**
+ * Record a result as sent
+ */
+void sn_deliver_suppress_end(const SuppressRecord *record) {
+  char state_path[512];
+  if (suppress_state_path(state_path, sizeof(state_path)) == 0)
+    sn_suppress_record(state_path, record);
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Deliver to this host                                           |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+/**
+ * Move an ended sn1ff file into the upload dir of the sn1ff server on this
+ * host
+ *
+ * The file only appears in the upload dir whole, with the server group and
+ * mode 660 already set, see sn_file_move
+ *
+ * @param  status    [ALRT|WARN|OKAY|NONE]
+ * @param  ttl_mins  TTL in minutes
+ * @return  0 success
+ *         -1 error
+ */
+int sn_deliver_local(const char *file_path, const char *status,
+                     int ttl_mins) {
+  // Build destination file path
+
+  char new_dir_path[FNAME_PATH_LENGTH_D] = {'\0'};
+  memset(new_dir_path, '\0', (FNAME_PATH_LENGTH_D) * sizeof(char));
+
+  sn_fpath_genfull(file_path, status, sn_cfg_get_server_upload_dir(), ttl_mins,
+                   new_dir_path);
+
+  // Move the file
+
+  if (sn_file_move(file_path, new_dir_path, sn_cfg_get_server_group()) ==
+      -1) {
+    cn_log_msg(LOG_ERR, __func__, "Move of file failed, from -> %s  to -> %s",
+               file_path, new_dir_path);
+    return -1;
+  }
+
+  return 0;
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Deliver through the outbox                                     |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+typedef struct {
+  const char *dir;
+  MultiString *paths;
+} OUTBOX;
+
+static int collect_outbox_file(const char *name, void *arg) {
+  OUTBOX *outbox = arg;
+  char path[FNAME_PATH_LENGTH_D];
+
+  snprintf(path, sizeof(path), "%s/%s", outbox->dir, name);
+  cn_multistr_append(outbox->paths, path);
+  return 0;
+}
+
+/**
+ * Path of the outbox dir, where results wait until sent to a remote sn1ff
+ * server, created if need be
+ *
+ * @return  0 success
+ *         -1 error
+ */
+int sn_deliver_outbox_dir(char *outbox_dir, size_t outbox_dir_sz) {
+  char client_dir[256];
+  if (sn_dir_client(client_dir, sizeof(client_dir)) != 0)
+    return -1;
+
+  snprintf(outbox_dir, outbox_dir_sz, "%s/outbox", client_dir);
+  if (mkdir(outbox_dir, 0700) != 0 && errno != EEXIST) {
+    cn_log_msg(LOG_ERR, __func__,
+               "Could not create dir -> %s <-, strerror(errno) -> %m <-",
+               outbox_dir);
+    return -1;
+  }
+
+  return 0;
+}
+
+/**
+ * Lock the outbox dir, so only one run sends from it at a time
+ *
+ * @return  file descriptor, to close to unlock, -1 on error
+ */
+static int lock_outbox(const char *outbox_dir) {
+  int fd = open(outbox_dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (fd == -1) {
+    cn_log_msg(LOG_ERR, __func__,
+               "'open' gave error for dir -> %s <-, strerror(errno) -> %m <-",
+               outbox_dir);
+    return -1;
+  }
+
+  if (flock(fd, LOCK_EX) == -1) {
+    cn_log_msg(LOG_ERR, __func__,
+               "'flock' gave error for dir -> %s <-, strerror(errno) -> %m <-",
+               outbox_dir);
+    close(fd);
+    return -1;
+  }
+
+  return fd;
+}
+
+/**
+ * Send the results in the outbox to a remote sn1ff server, in SCPs of up
+ * to SN_DELIVER_SCP_BATCH files. Anything left there by an earlier failed
+ * send goes with them. The outbox is locked while it is sent, so a run
+ * does not send the files of another run that is sending them
+ *
+ * @return  0 success
+ *         -1 error
+ */
+int sn_deliver_send_outbox(const char *outbox_dir, const char *server) {
+  int lock_fd = lock_outbox(outbox_dir);
+  if (lock_fd == -1)
+    return -1;
+
+  MultiString paths;
+  cn_multistr_init(&paths);
+
+  OUTBOX outbox = {outbox_dir, &paths};
+  int result = sn_dir_each_file(outbox_dir, collect_outbox_file, &outbox);
+
+  const char **files = NULL;
+  if (result == 0 && paths.num_strings > 0) {
+    files = malloc(paths.num_strings * sizeof(*files));
+    if (files == NULL)
+      result = -1;
+  }
+
+  if (files != NULL) {
+    for (size_t i = 0; i < paths.num_strings; i++)
+      files[i] = cn_multistr_getstr(&paths, i);
+
+    char scp_dest[FNAME_PATH_LENGTH + 128];
+    snprintf(scp_dest, sizeof(scp_dest), "%s@%s:%s/", sn_cfg_get_server_user(),
+             server, sn_cfg_get_server_upload_base_dir());
+
+    for (size_t i = 0; i < paths.num_strings; i += SN_DELIVER_SCP_BATCH) {
+      size_t count = paths.num_strings - i;
+      if (count > SN_DELIVER_SCP_BATCH)
+        count = SN_DELIVER_SCP_BATCH;
+
+      if (cn_remotefe_scp_files(&files[i], count, scp_dest,
+                                SN_DELIVER_SCP_TIMEOUT) != 0) {
+        cn_log_msg(LOG_ERR, __func__,
+                   "Remote copy with scp failed, -> %zu <- files kept in -> "
+                   "%s <- for the next run",
+                   paths.num_strings - i, outbox_dir);
+        result = -1;
+        break;
+      }
+    }
+    free(files);
+  }
+
+  cn_multistr_free(&paths);
+  close(lock_fd);
+  return result != 0 ? -1 : 0;
+}
+
+/**
+ * Deliver an ended sn1ff file, either to the sn1ff server on this host, or
+ * into the outbox to be sent to a remote one. It is cleaned, and is
+ * subject to client_suppress, as with "sn1ff_client -e"
+ *
+ * @param  ttl_mins    TTL in minutes, -1 for that of the status in
+ *                     client_ttls
+ * @param  outbox_dir  NULL for this host
+ * @param  server      remote sn1ff server, NULL for this host
+ * @param  sent        returns true if a record for suppression is pending,
+ *                     to pass to sn_deliver_suppress_end once sent
+ * @return  0 success
+ *         -1 error
+ */
+int sn_deliver_file(const char *file_path, Status status, int ttl_mins,
+                    const char *outbox_dir, const char *server,
+                    SuppressRecord *record, bool *sent) {
+  static const char *const STATUS_CHARS[] = {"NONE", "OKAY", "WARN", "ALRT"};
+  *sent = false;
+
+  if (status < SN_STATUS_NONE || status > SN_STATUS_ALRT) {
+    cn_log_msg(LOG_ERR, __func__, "Invalid status -> %d <-", (int)status);
+    return -1;
+  }
+  const char *status_chars = STATUS_CHARS[status];
+
+  if (ttl_mins < 0)
+    ttl_mins = sn_run_ttl(sn_cfg_get_client_ttls(), status);
+  if (ttl_mins < 0) {
+    cn_log_msg(LOG_ERR, __func__, "Invalid client_ttls in config -> %s <-",
+               sn_cfg_get_client_ttls());
+    return -1;
+  }
+
+  if (sn_file_finish(file_path, status) != 0)
+    return -1;
+
+  char ttl[16];
+  snprintf(ttl, sizeof(ttl), "%d", ttl_mins);
+
+  int suppress =
+      sn_deliver_suppress_begin(file_path, status_chars, ttl, server, record);
+  if (suppress == SN_SUPPRESS_SKIP)
+    return 0;
+
+  if (outbox_dir == NULL) {
+    if (sn_deliver_local(file_path, status_chars, ttl_mins) != 0)
+      return -1;
+  } else {
+    char outbox_path[FNAME_PATH_LENGTH_D] = {'\0'};
+    sn_fpath_genfull(file_path, status_chars, outbox_dir, ttl_mins,
+                     outbox_path);
+
+    if (rename(file_path, outbox_path) != 0) {
+      cn_log_msg(LOG_ERR, __func__,
+                 "Could not move file -> %s <- to -> %s <-, strerror(errno) -> "
+                 "%m <-",
+                 file_path, outbox_path);
+      return -1;
+    }
+  }
+
+  *sent = (suppress == SN_SUPPRESS_SEND);
+  return 0;
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Deliver the results of a run                                   |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+/**
+ * Deliver the results of a run (see sn_run.h), either to the sn1ff server
+ * on this host, or through the outbox to a remote one. Each result is
+ * cleaned, and is subject to client_suppress, as with "sn1ff_client -e"
+ *
+ * @param  server  remote sn1ff server, NULL for this host
+ * @return  0 success
+ *         -1 a check could not be run, or its result delivered
+ */
+int sn_deliver_run(const Run *run, const char *server) {
+  int result = 0;
+
+  // Outbox, results wait here until sent to a remote sn1ff server
+
+  char outbox_dir[512] = {'\0'};
+  if (server != NULL &&
+      sn_deliver_outbox_dir(outbox_dir, sizeof(outbox_dir)) != 0)
+    return -1;
+
+  SuppressRecord *records =
+      calloc(run->count ? run->count : 1, sizeof(*records));
+  bool *sent = calloc(run->count ? run->count : 1, sizeof(*sent));
+  if (records == NULL || sent == NULL) {
+    cn_log_msg(LOG_ERR, __func__, "Could not allocate for -> %zu <- checks",
+               run->count);
+    free(records);
+    free(sent);
+    return -1;
+  }
+
+  size_t counts[4] = {0};
+
+  for (size_t i = 0; i < run->count; i++) {
+    const RunCheck *check = &run->checks[i];
+    if (check->file_path[0] == '\0') { // Not begun
+      result = -1;
+      continue;
+    }
+
+    counts[check->status]++;
+    if (sn_deliver_file(check->file_path, check->status, -1,
+                        server != NULL ? outbox_dir : NULL, server,
+                        &records[i], &sent[i]) != 0)
+      result = -1;
+  }
+
+  if (server != NULL && sn_deliver_send_outbox(outbox_dir, server) != 0) {
+    result = -1;
+    memset(sent, 0, run->count * sizeof(*sent));
+  }
+
+  for (size_t i = 0; i < run->count; i++)
+    if (sent[i])
+      sn_deliver_suppress_end(&records[i]);
+
+  cn_log_msg(LOG_INFO, __func__,
+             "Ran -> %zu <- checks, ALRT %zu WARN %zu OKAY %zu NONE %zu",
+             run->count, counts[SN_STATUS_ALRT], counts[SN_STATUS_WARN],
+             counts[SN_STATUS_OKAY], counts[SN_STATUS_NONE]);
+
+  free(records);
+  free(sent);
+  return result;
+}
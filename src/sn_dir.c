@@ -22,11 +22,17 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 
-#define _POSIX_C_SOURCE 200809L
+#define _GNU_SOURCE // For getdents64
 
 #include "sn_dir.h"
 #include "cn_dir.h"
 #include "cn_log.h"
+#include "sn_shard.h"
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 /*
  * Check if a filename has the .snff extension
@@ -48,36 +54,189 @@ int sn_dir_file_has_ext(const char *filename) {
 }
 
 /*
- * List files with .snff extension and return them as a string
+ * Check the .snff extension of a name whose length is known, the exact
+ * lower case match is tried first as that is what sn1ff writes
+ */
+static int has_ext_len(const char *name, size_t len) {
+  const size_t ext_len = sizeof(EXTENSION) - 1;
+  if (len < ext_len)
+    return 0;
+
+  const char *ext = name + len - ext_len;
+  if (memcmp(ext, EXTENSION, ext_len) == 0)
+    return 1;
+
+  for (size_t i = 0; i < ext_len; i++) {
+    if (tolower((unsigned char)ext[i]) != EXTENSION[i])
+      return 0;
+  }
+  return 1;
+}
+
+/*
+ * Is a directory entry a regular file, file systems that do not fill in
+ * d_type are asked with fstatat
+ */
+static int is_regular(int dir_fd, const struct dirent64 *entry) {
+  if (entry->d_type == DT_REG)
+    return 1;
+  if (entry->d_type != DT_UNKNOWN)
+    return 0;
+
+  struct stat st;
+  if (fstatat(dir_fd, entry->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0)
+    return 0;
+  return S_ISREG(st.st_mode);
+}
+
+/*
+ * Call fn for each regular file with .snff extension in a dir, as the
+ * names are read. Entries are read with getdents64 into a fixed buffer,
+ * so memory does not grow with the number of files in the dir
+ *
+ * The names are only valid during the call of fn. Files created or deleted
+ * in the dir during the iteration, may or may not be seen
  *
  * @param dir_path
- * @param ms  Multi string containing the file names
+ * @param fn   called for each file name, returns 0 to continue, or non
+ *             zero to stop the iteration
+ * @param arg  passed on to fn
  *
  * @return  0 success
- *          1 error opening directory
+ *          1 error opening or reading directory
+ *          2 stopped by fn
  */
-int sn_dir_list_files(const char *dir_path, MultiString *ms) {
-  DIR *dir = opendir(dir_path);
-  if (!dir) {
+int sn_dir_each_file(const char *dir_path, DirFileFn fn, void *arg) {
+  int dir_fd = open(dir_path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (dir_fd == -1) {
     cn_log_msg(LOG_ERR, __func__,
-               "'opendir' gave error opening directory -> %s <-, "
+               "'open' gave error opening directory -> %s <-, "
                "strerror(errno) -> %m <-",
                dir_path);
     return 1;
   }
 
-  struct dirent *entry;
-  while ((entry = readdir(dir)) != NULL) {
-    if (sn_dir_file_has_ext(entry->d_name)) {
-      cn_multistr_append(ms, entry->d_name);
+  char *buffer = malloc(SN_DIR_BUFFER_SIZE);
+  if (buffer == NULL) {
+    cn_log_msg(LOG_ERR, __func__, "Could not allocate dir buffer");
+    close(dir_fd);
+    return 1;
+  }
+
+  int result = 0;
+  while (result == 0) {
+    ssize_t nread = getdents64(dir_fd, buffer, SN_DIR_BUFFER_SIZE);
+    if (nread == 0)
+      break;
+
+    if (nread == -1) {
+      cn_log_msg(LOG_ERR, __func__,
+                 "'getdents64' gave error reading directory -> %s <-, "
+                 "strerror(errno) -> %m <-",
+                 dir_path);
+      result = 1;
+      break;
     }
+
+    for (ssize_t pos = 0; pos < nread;) {
+      struct dirent64 *entry = (struct dirent64 *)(buffer + pos);
+      pos += entry->d_reclen;
+
+      if (!has_ext_len(entry->d_name, strlen(entry->d_name)) ||
+          !is_regular(dir_fd, entry))
+        continue;
+
+      if (fn(entry->d_name, arg) != 0) {
+        result = 2;
+        break;
+      }
+    }
+  }
+
+  free(buffer);
+  close(dir_fd);
+  return result;
+}
+
+/*
+ * As sn_dir_each_file, for a dir with the sharded layout (see sn_shard.h).
+ * Only the file names are passed to fn, the shard of each can be got from
+ * its name
+ *
+ * @param dir_path
+ * @param shards  0, 256 or 4096
+ * @param fn
+ * @param arg
+ *
+ * @return  0 success
+ *          1 error opening or reading directory, or invalid number of
+ *            shards
+ *          2 stopped by fn
+ */
+int sn_dir_each_file_sharded(const char *dir_path, int shards, DirFileFn fn,
+                             void *arg) {
+  if (shards == SN_SHARD_NONE)
+    return sn_dir_each_file(dir_path, fn, arg);
+
+  if (!sn_shard_valid(shards)) {
+    cn_log_msg(LOG_ERR, __func__, "Invalid number of shards -> %d <-",
+               shards);
+    return 1;
+  }
+
+  char shard_dir[1024];
+  for (int i = 0; i < shards; i++) {
+    sn_shard_index_dir(dir_path, shards, i, shard_dir, sizeof(shard_dir));
+
+    // A shard dir that does not exist yet, has no files
+
+    if (access(shard_dir, F_OK) == -1 && errno == ENOENT)
+      continue;
+
+    int result = sn_dir_each_file(shard_dir, fn, arg);
+    if (result != 0)
+      return result;
   }
 
-  closedir(dir);
+  return 0;
+}
 
+static int append_name(const char *name, void *arg) {
+  cn_multistr_append((MultiString *)arg, name);
   return 0;
 }
 
+/*
+ * List files with .snff extension and return them as a string
+ *
+ * Prefer sn_dir_each_file, when the names do not all need to be held
+ *
+ * @param dir_path
+ * @param ms  Multi string containing the file names
+ *
+ * @return  0 success
+ *          1 error opening directory
+ */
+int sn_dir_list_files(const char *dir_path, MultiString *ms) {
+  return sn_dir_each_file(dir_path, append_name, ms);
+}
+
+/*
+ * List files with .snff extension in a dir with the sharded layout (see
+ * sn_shard.h)
+ *
+ * @param dir_path
+ * @param shards  0, 256 or 4096
+ * @param ms  Multi string containing the file names
+ *
+ * @return  0 success
+ *          1 error opening directory, or invalid number of shards
+ */
+int sn_dir_list_files_sharded(const char *dir_path, int shards,
+                              MultiString *ms) {
+  return sn_dir_each_file_sharded(dir_path, shards, append_name, ms);
+}
+
 /**
  * Get a sn1ff client process's 'sn1ff' dir, for sn1ff files:
  *   <HOME dir>/sn1ff
@@ -22,15 +22,21 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 
-#define _POSIX_C_SOURCE 200809L
+#define _GNU_SOURCE // For copy_file_range
 
 #include "sn_file.h"
 #include "cn_fpath.h"
 #include "cn_host.h"
 #include "cn_log.h"
 #include "cn_string.h"
+#include "sn_cfg.h"
 #include "sn_const.h"
 #include "sn_dir.h"
+#include "sn_shard.h"
+#include <errno.h>
+#include <linux/fs.h>
+#include <pthread.h>
+#include <sys/ioctl.h>
 
 /**
  * A sn1ff file can exist in 2 places:
@@ -52,7 +58,65 @@ SOFTWARE.
  '----------------------------------------------------------------*/
 
 /**
- * Write header for a snff file
+ * Little endian numbers, for the v2 preamble
+ */
+static void put_le(unsigned char *dest, uint64_t value, size_t size) {
+  for (size_t i = 0; i < size; i++)
+    dest[i] = (unsigned char)(value >> (8 * i));
+}
+
+static uint64_t get_le(const unsigned char *src, size_t size) {
+  uint64_t value = 0;
+  for (size_t i = 0; i < size; i++)
+    value |= (uint64_t)src[i] << (8 * i);
+  return value;
+}
+
+static void write_header_v1(FILE *file, const HEADER *hdr) {
+  fprintf(file, "App: sn1ff\n");
+  fprintf(file, "Ver: %s\n", VERSION);
+  fprintf(file, "Host: %s\n", hdr->host);
+  fprintf(file, "IPv4: %s\n", hdr->ipv4);
+  fprintf(file, "At: %s\n", hdr->timestamp);
+  fprintf(file, "CheckID: %s\n", hdr->checkid);
+  fprintf(file, "\n\n");
+}
+
+static int write_header_v2(FILE *file, const HEADER *hdr) {
+  const char *values[] = {VERSION, hdr->host, hdr->ipv4, hdr->timestamp,
+                          hdr->checkid};
+  unsigned char block[SN_FILE_V2_PREAMBLE_SZ + SN_FILE_V2_HEADER_MAX] = {0};
+  size_t pos = SN_FILE_V2_PREAMBLE_SZ;
+
+  // Header block, each value length prefixed
+
+  for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+    size_t len = strlen(values[i]);
+    if (pos + 2 + len > sizeof(block))
+      return -1;
+    put_le(block + pos, len, 2);
+    memcpy(block + pos + 2, values[i], len);
+    pos += 2 + len;
+  }
+
+  // Preamble, the line count, status and finish time are set by
+  // sn_file_finish
+
+  memcpy(block, SN_FILE_V2_MAGIC, 4);
+  put_le(block + 4, SN_FILE_FORMAT_V2, 2);
+  put_le(block + 6, pos - SN_FILE_V2_PREAMBLE_SZ, 2);
+  put_le(block + 8, pos, 4);
+  put_le(block + 24, (uint64_t)time(NULL), 8);
+
+  // The body starts with an empty line, as with v1
+
+  if (fwrite(block, 1, pos, file) != pos || fputc('\n', file) == EOF)
+    return -1;
+  return 0;
+}
+
+/**
+ * Write header for a snff file, in the client_file_format of the config
  *
  * @param  file    is the Linux FILE for the sn1ff file
  * @param  header  is the sn1ff file header info to write from to the file
@@ -61,6 +125,19 @@ SOFTWARE.
  *         2 header param is not valid
  */
 int sn_file_write_header(FILE *file, const HEADER *hdr) {
+  return sn_file_write_header_fmt(file, hdr, sn_cfg_get_client_file_format());
+}
+
+/**
+ * Write header for a snff file, in the given format
+ *
+ * @param  format  SN_FILE_FORMAT_V1 | SN_FILE_FORMAT_V2
+ * @return 0 success
+ *         1 file param is null
+ *         2 header param is not valid
+ *         3 format param is not valid, or the header could not be written
+ */
+int sn_file_write_header_fmt(FILE *file, const HEADER *hdr, int format) {
   if (file == NULL) {
     cn_log_msg(LOG_ERR, __func__, "Argument 'file' is NULL");
     return 1;
@@ -71,17 +148,156 @@ int sn_file_write_header(FILE *file, const HEADER *hdr) {
     return 2;
   }
 
-  fprintf(file, "App: sn1ff\n");
-  fprintf(file, "Ver: %s\n", VERSION);
-  fprintf(file, "Host: %s\n", hdr->host);
-  fprintf(file, "IPv4: %s\n", hdr->ipv4);
-  fprintf(file, "At: %s\n", hdr->timestamp);
-  fprintf(file, "CheckID: %s\n", hdr->checkid);
-  fprintf(file, "\n\n");
+  if (format == SN_FILE_FORMAT_V1) {
+    write_header_v1(file, hdr);
+    return 0;
+  }
+
+  if (format == SN_FILE_FORMAT_V2 && write_header_v2(file, hdr) == 0)
+    return 0;
+
+  cn_log_msg(LOG_ERR, __func__, "Could not write header in format -> %d <-",
+             format);
+  return 3;
+}
+
+/**
+ * Parse the v2 preamble and header block at the start of a sn1ff file
+ *
+ * @param  buffer     start of the file
+ * @param  length     bytes in "buffer", at least the body offset
+ * @param  hdr        header values, can be NULL
+ * @return  0 success
+ *          1 not a v2 file
+ *         -1 not a valid v2 preamble, or header block
+ */
+int sn_file_parse_preamble(const unsigned char *buffer, size_t length,
+                           PREAMBLE *preamble, HEADER *hdr) {
+  if (length < 4 || memcmp(buffer, SN_FILE_V2_MAGIC, 4) != 0)
+    return 1;
+
+  if (length < SN_FILE_V2_PREAMBLE_SZ ||
+      get_le(buffer + 4, 2) != SN_FILE_FORMAT_V2)
+    return -1;
+
+  preamble->header_len = (uint16_t)get_le(buffer + 6, 2);
+  preamble->body_offset = (uint32_t)get_le(buffer + 8, 4);
+  preamble->line_count = (uint32_t)get_le(buffer + 12, 4);
+  preamble->status = buffer[16];
+  preamble->begun = (int64_t)get_le(buffer + 24, 8);
+  preamble->finished = (int64_t)get_le(buffer + 32, 8);
+
+  if (preamble->header_len > SN_FILE_V2_HEADER_MAX ||
+      preamble->body_offset !=
+          SN_FILE_V2_PREAMBLE_SZ + (uint32_t)preamble->header_len ||
+      length < preamble->body_offset)
+    return -1;
+
+  if (hdr == NULL)
+    return 0;
+
+  // Header block values, Ver is not kept
+
+  struct {
+    char *dest;
+    size_t size;
+  } values[] = {{NULL, 0},
+                {hdr->host, sizeof(hdr->host)},
+                {hdr->ipv4, sizeof(hdr->ipv4)},
+                {hdr->timestamp, sizeof(hdr->timestamp)},
+                {hdr->checkid, sizeof(hdr->checkid)}};
+
+  size_t pos = SN_FILE_V2_PREAMBLE_SZ;
+  for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+    if (pos + 2 > preamble->body_offset)
+      return -1;
+    size_t len = (size_t)get_le(buffer + pos, 2);
+    pos += 2;
+    if (pos + len > preamble->body_offset)
+      return -1;
+
+    if (values[i].dest != NULL) {
+      if (len >= values[i].size)
+        return -1;
+      memcpy(values[i].dest, buffer + pos, len);
+      values[i].dest[len] = '\0';
+    }
+    pos += len;
+  }
 
   return 0;
 }
 
+/*----------------------------------------------------------------.
+ |                                                                |
+ |  Host metadata                                                 |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+// Host name and ip addr for the header of files begun, found once per
+// process, or again when sn1ff_agent sees them change. Guarded by
+// host_lock, as files are begun by threads of libsn1ff users
+
+static HEADER host_cache = {.host = "No hostname", .ipv4 = "No ip for eth0"};
+static bool host_cached = false;
+static pthread_mutex_t host_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Find the host name and ip addr again, for the header of files begun
+ *
+ * @return  0 success
+ *         -1 could not get the host name, or ip addr, the default is used
+ */
+int sn_file_host_refresh(void) {
+  char hostname[CN_HOST_HOSTNAME_LENGTH_D] = {'\0'};
+  int host_name_result = cn_host_hostname(hostname);
+
+  char ip_addr[CN_HOST_IPV4_LENGTH_D] = {'\0'};
+  int ip_addr_result = cn_host_ipv4("eth0", ip_addr);
+
+  pthread_mutex_lock(&host_lock);
+  if (host_name_result == 0)
+    strncpy(host_cache.host, hostname, CN_HOST_HOSTNAME_LENGTH);
+  if (ip_addr_result == 0)
+    strncpy(host_cache.ipv4, ip_addr, CN_HOST_IPV4_LENGTH);
+  host_cached = true;
+  pthread_mutex_unlock(&host_lock);
+
+  return (host_name_result == 0 && ip_addr_result == 0) ? 0 : -1;
+}
+
+/**
+ * Copy the host name and ip addr into the header of a file being begun,
+ * finding them first if need be
+ */
+static void host_header(HEADER *hdr) {
+  pthread_mutex_lock(&host_lock);
+  bool cached = host_cached;
+  pthread_mutex_unlock(&host_lock);
+
+  if (!cached)
+    sn_file_host_refresh();
+
+  pthread_mutex_lock(&host_lock);
+  strncpy(hdr->host, host_cache.host, CN_HOST_HOSTNAME_LENGTH);
+  strncpy(hdr->ipv4, host_cache.ipv4, CN_HOST_IPV4_LENGTH);
+  pthread_mutex_unlock(&host_lock);
+}
+
+/**
+ * Host name for the header of files begun. Not to be used while another
+ * thread may refresh it
+ */
+const char *sn_file_host_name(void) {
+  pthread_mutex_lock(&host_lock);
+  bool cached = host_cached;
+  pthread_mutex_unlock(&host_lock);
+
+  if (!cached)
+    sn_file_host_refresh();
+  return host_cache.host;
+}
+
 /*----------------------------------------------------------------.
  |                                                                |
  |  Create (begin) sn1ff file                                     |
@@ -103,7 +319,7 @@ int sn_file_begin(char *file_path, const char *checkid) {
 
   int result = sn_dir_client(sn1ff_client_dir, sn1ff_client_dir_sz);
 
-  cn_log_msg(LOG_ERR, __func__, "sn_dir_client path -> %s <-",
+  cn_log_msg(LOG_DEBUG, __func__, "sn_dir_client path -> %s <-",
              sn1ff_client_dir);
 
   if (result != 0) {
@@ -125,19 +341,9 @@ int sn_file_begin(char *file_path, const char *checkid) {
                 .timestamp = "_______ __, 20__ __:__:__",
                 .checkid = "N/A"};
 
-  // Set actual hostname in header
-
-  char hostname[CN_HOST_HOSTNAME_LENGTH_D] = {'\0'};
-  int status = cn_host_hostname(hostname);
-  if (status == 0)
-    strncpy(hdr.host, hostname, CN_HOST_HOSTNAME_LENGTH);
-
-  // Set actual ip addr in header
+  // Set actual hostname and ip addr in header
 
-  char ip_addr[CN_HOST_IPV4_LENGTH_D] = {'\0'};
-  result = cn_host_ipv4("eth0", ip_addr);
-  if (result == 0)
-    strncpy(hdr.ipv4, ip_addr, CN_HOST_IPV4_LENGTH);
+  host_header(&hdr);
 
   // Set actual timestamp in header
 
@@ -174,12 +380,181 @@ int sn_file_begin(char *file_path, const char *checkid) {
   return 0;
 }
 
+/*----------------------------------------------------------------.
+ |                                                                |
+ |  Finish sn1ff file                                             |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+/**
+ * Count the body lines of a v2 file, a last line without a newline counts
+ */
+static uint32_t count_lines(int fd, off_t offset) {
+  char buffer[8192];
+  uint32_t lines = 0;
+  char last = '\n';
+  ssize_t n;
+
+  while ((n = pread(fd, buffer, sizeof(buffer), offset)) > 0) {
+    for (ssize_t i = 0; i < n; i++)
+      if (buffer[i] == '\n')
+        lines++;
+    last = buffer[n - 1];
+    offset += n;
+  }
+
+  return last == '\n' ? lines : lines + 1;
+}
+
+/**
+ * Finish an ended sn1ff file, before it is delivered. Non printable chars
+ * are cleaned from the body, and for v2 the line count, status and finish
+ * time are set in the preamble
+ *
+ * @return  0 success
+ *         -1 error
+ */
+int sn_file_finish(const char *file_path, Status status) {
+  int fd = open(file_path, O_RDWR);
+  if (fd == -1) {
+    cn_log_msg(LOG_ERR, __func__,
+               "'open' gave an error opening file -> %s <-, strerror(errno) "
+               "-> %m <-",
+               file_path);
+    return -1;
+  }
+
+  unsigned char head[SN_FILE_V2_PREAMBLE_SZ + SN_FILE_V2_HEADER_MAX];
+  ssize_t head_len = pread(fd, head, sizeof(head), 0);
+
+  PREAMBLE preamble;
+  int format = sn_file_parse_preamble(head, head_len > 0 ? (size_t)head_len : 0,
+                                      &preamble, NULL);
+  if (format == -1) {
+    cn_log_msg(LOG_ERR, __func__, "Not a valid v2 preamble, file -> %s <-",
+               file_path);
+    close(fd);
+    return -1;
+  }
+
+  // Clean the body, the v2 preamble and header block are binary
+
+  long body_offset = format == 0 ? (long)preamble.body_offset : 0;
+  if (cn_file_clean_from(file_path, body_offset) != 0) {
+    cn_log_msg(LOG_ERR, __func__,
+               "Error cleaning non-printable chars from file ->%s<-",
+               file_path);
+    close(fd);
+    return -1;
+  }
+
+  if (format == 1) {
+    close(fd);
+    return 0;
+  }
+
+  unsigned char counts[5];
+  unsigned char finished[8];
+  put_le(counts, count_lines(fd, body_offset), 4);
+  counts[4] = (unsigned char)status;
+  put_le(finished, (uint64_t)time(NULL), 8);
+
+  if (pwrite(fd, counts, sizeof(counts), 12) != sizeof(counts) ||
+      pwrite(fd, finished, sizeof(finished), 32) != sizeof(finished)) {
+    cn_log_msg(LOG_ERR, __func__,
+               "'pwrite' gave an error on file -> %s <-, strerror(errno) -> "
+               "%m <-",
+               file_path);
+    close(fd);
+    return -1;
+  }
+
+  close(fd);
+  return 0;
+}
+
 /*----------------------------------------------------------------.
  |                                                                |
  |  Read sn1ff file                                               |
  |                                                                |
  '----------------------------------------------------------------*/
 
+/**
+ * Read v1 header lines, up to the empty line after them
+ *
+ * @return  0 success
+ *         -4 .. -7 as sn_file_read
+ */
+static int read_header_v1(FILE *file, HEADER *hdr) {
+  char line[512];
+
+  while (fgets(line, sizeof(line), file)) {
+    cn_string_trim_newline(line);
+
+    // Empty line, done with the header
+
+    if (strlen(line) == 0)
+      break;
+
+    if (strncmp(line, "Host: ", 6) == 0) {
+      if (cn_string_cp(hdr->host, sizeof(hdr->host), line + 6) != 0)
+        return -4;
+    } else if (strncmp(line, "IPv4: ", 6) == 0) {
+      if (cn_string_cp(hdr->ipv4, sizeof(hdr->ipv4), line + 6) != 0)
+        return -5;
+    } else if (strncmp(line, "At: ", 4) == 0) {
+      if (cn_string_cp(hdr->timestamp, sizeof(hdr->timestamp), line + 4) != 0)
+        return -6;
+    } else if (strncmp(line, "CheckID: ", 9) == 0) {
+      if (cn_string_cp(hdr->checkid, sizeof(hdr->checkid), line + 9) != 0)
+        return -7;
+    }
+  }
+
+  return 0;
+}
+
+/**
+ * Read the header of an open sn1ff file, of either format, leaving the file
+ * at the start of the body
+ *
+ * @return  0 success
+ *         -4 .. -7 as sn_file_read
+ *         -8 not a valid v2 preamble, or header block
+ */
+static int read_header(FILE *file, HEADER *hdr) {
+  unsigned char head[SN_FILE_V2_PREAMBLE_SZ + SN_FILE_V2_HEADER_MAX];
+  size_t head_len = fread(head, 1, sizeof(head), file);
+
+  PREAMBLE preamble;
+  int result = sn_file_parse_preamble(head, head_len, &preamble, hdr);
+  if (result == 0)
+    return fseek(file, preamble.body_offset, SEEK_SET) == 0 ? 0 : -8;
+  if (result == -1)
+    return -8;
+
+  rewind(file);
+  return read_header_v1(file, hdr);
+}
+
+/**
+ * Read just the header of a sn1ff file, of either format
+ *
+ * @return  0 success
+ *         -1 could not open the file
+ *         -4 .. -8 as sn_file_read
+ */
+int sn_file_read_header(const char *file_path, HEADER *hdr) {
+  FILE *file = fopen(file_path, "r");
+  if (file == NULL)
+    return -1;
+
+  memset(hdr, 0, sizeof(*hdr));
+  int result = read_header(file, hdr);
+  fclose(file);
+  return result;
+}
+
 /**
  * Parse file
  *
@@ -195,6 +570,7 @@ int sn_file_begin(char *file_path, const char *checkid) {
  *         -5 Failed to extract header value 'IPv4: '
  *         -6 Failed to extract header value 'At: '
  *         -7 Failed to extract header value 'CheckID: '
+ *         -8 Not a valid v2 preamble, or header block
  */
 int sn_file_read(const char *filename, FILE_DATA *file_data) {
   FILE *file = fopen(filename, "r");
@@ -250,50 +626,41 @@ int sn_file_read(const char *filename, FILE_DATA *file_data) {
   sn_cname_get_status(&name, file_data->attributes.status);
 
   /*
-   * Parse file header values
+   * Parse file header values, from the v2 preamble, else v1 header lines
    */
 
-  while (fgets(line, sizeof(line), file)) {
-    cn_string_trim_newline(line);
+  result = read_header(file, &file_data->header);
+  if (result != 0) {
+    if (result == -8)
+      cn_log_msg(LOG_ERR, __func__, "Not a valid v2 preamble, file -> %s <-",
+                 filename);
+    fclose(file);
+    return result;
+  }
 
-    // Empty line, done with the header
+  // Parse file body values
 
-    if (strlen(line) == 0)
+  while (fgets(line, sizeof(line), file)) {
+    if (file_data->body_lines == SN_FILE_MAX_BODY_LINES) {
+      file_data->body_truncated = true;
       break;
-
-    if (strncmp(line, "Host: ", 6) == 0) {
-      if (cn_string_cp(file_data->header.host, sizeof(file_data->header.host),
-                       line + 6) != 0) {
-        fclose(file);
-        return -4;
-      }
-    } else if (strncmp(line, "IPv4: ", 6) == 0) {
-      if (cn_string_cp(file_data->header.ipv4, sizeof(file_data->header.ipv4),
-                       line + 6) != 0) {
-        fclose(file);
-        return -5;
-      }
-    } else if (strncmp(line, "At: ", 4) == 0) {
-      if (cn_string_cp(file_data->header.timestamp,
-                       sizeof(file_data->header.timestamp), line + 4) != 0) {
-        fclose(file);
-        return -6;
-      }
-    } else if (strncmp(line, "CheckID: ", 9) == 0) {
-      if (cn_string_cp(file_data->header.checkid,
-                       sizeof(file_data->header.checkid), line + 9) != 0) {
-        fclose(file);
-        return -7;
-      }
     }
-  }
 
-  // Parse file body values
+    // The rest of a line longer than "line" is skipped, not read as a line
+    // of its own
+
+    size_t read_len = strlen(line);
+    if (read_len > 0 && line[read_len - 1] != '\n' && !feof(file)) {
+      int c;
+      while ((c = fgetc(file)) != EOF && c != '\n')
+        ;
+      file_data->body_truncated = true;
+    }
 
-  while (fgets(line, sizeof(line), file) &&
-         file_data->body_lines < SN_FILE_MAX_BODY_LINES) {
     cn_string_trim_newline(line);
     size_t len = strlen(line);
+    if (len > SN_FILE_MAX_BODY_LENGTH)
+      file_data->body_truncated = true;
 
     // Copy at most 80 characters and pad with spaces
 
@@ -324,6 +691,53 @@ int sn_file_read(const char *filename, FILE_DATA *file_data) {
   return 0;
 }
 
+/**
+ * Read the body of a sn1ff file, of either format, as it was written:
+ * every line, at its full length, where sn_file_read keeps only the first
+ * SN_FILE_MAX_BODY_LINES lines, cut to SN_FILE_MAX_BODY_LENGTH
+ *
+ * @return  0 success, "*body" (null terminated) to free
+ *          1 success, but the body is cut to "max" bytes
+ *         -1 could not open, or read the file
+ *         -2 could not allocate
+ *         -4 .. -8 as sn_file_read
+ */
+int sn_file_read_body(const char *file_path, size_t max, char **body,
+                      size_t *body_len) {
+  FILE *file = fopen(file_path, "r");
+  if (file == NULL)
+    return -1;
+
+  HEADER hdr;
+  memset(&hdr, 0, sizeof(hdr));
+  int result = read_header(file, &hdr);
+  if (result != 0) {
+    fclose(file);
+    return result;
+  }
+
+  struct stat st;
+  long start = ftell(file);
+  if (start < 0 || fstat(fileno(file), &st) != 0) {
+    fclose(file);
+    return -1;
+  }
+
+  size_t remaining = st.st_size > start ? (size_t)(st.st_size - start) : 0;
+  size_t length = remaining < max ? remaining : max;
+
+  *body = malloc(length + 1);
+  if (*body == NULL) {
+    fclose(file);
+    return -2;
+  }
+
+  *body_len = fread(*body, 1, length, file);
+  (*body)[*body_len] = '\0';
+  fclose(file);
+  return remaining > max ? 1 : 0;
+}
+
 /*----------------------------------------------------------------.
  |                                                                |
  |  Delete sn1ff file                                             |
@@ -389,6 +803,23 @@ void sn_file_delete(const char *file_dir, const char *file_name) {
   close(fd);
 }
 
+/**
+ * Delete a sn1ff file from a dir with the sharded layout (see sn_shard.h)
+ */
+void sn_file_delete_sharded(const char *file_dir, int shards,
+                            const char *file_name) {
+  char shard_dir[1024];
+  if (sn_shard_dir(file_dir, file_name, shards, shard_dir, sizeof(shard_dir)) !=
+      0) {
+    cn_log_msg(LOG_ERR, __func__,
+               "Could not get shard dir for file -> %s <-, shards -> %d <-",
+               file_name, shards);
+    return;
+  }
+
+  sn_file_delete(shard_dir, file_name);
+}
+
 /*----------------------------------------------------------------.
  |                                                                |
  |  Copy sn1ff file                                               |
@@ -469,3 +900,300 @@ cleanup:
   unlink(tmp_path); // Remove incomplete temp file on error
   return result;
 }
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ |  Publish sn1ff file                                            |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+/**
+ * Copy the contents of "input" to "output", cheapest method first
+ *
+ * @return  SN_FILE_PUBLISH_REFLINK     shared extents (FICLONE)
+ *          SN_FILE_PUBLISH_COPY_RANGE  copied in the kernel
+ *          SN_FILE_PUBLISH_SENDFILE    copied with sendfile
+ *         -1 error
+ */
+static int sn_file_copy_fd(int input, int output, off_t size) {
+  if (ioctl(output, FICLONE, input) == 0)
+    return SN_FILE_PUBLISH_REFLINK;
+
+  // copy_file_range, unless the kernel / filesystem does not support it
+
+  off_t offset = 0;
+  while (offset < size) {
+    ssize_t copied = copy_file_range(input, NULL, output, NULL,
+                                     (size_t)(size - offset), 0);
+    if (copied <= 0)
+      break;
+    offset += copied;
+  }
+
+  if (offset == size)
+    return SN_FILE_PUBLISH_COPY_RANGE;
+
+  if (lseek(input, offset, SEEK_SET) == -1 ||
+      lseek(output, offset, SEEK_SET) == -1)
+    return -1;
+
+  while (offset < size) {
+    ssize_t sent = sendfile(output, input, &offset, (size_t)(size - offset));
+    if (sent <= 0)
+      return -1;
+  }
+
+  return SN_FILE_PUBLISH_SENDFILE;
+}
+
+/**
+ * Publish a sn1ff file into another directory, without copying its bytes
+ * where possible
+ *
+ * "upload", "watch" and "export" are on the same filesystem, so normally
+ * the file is hard linked. Across filesystems it is reflinked, or copied in
+ * the kernel, and only byte copied as a last resort. The link / copy is
+ * made under a temp name and renamed, so readers never see a partial file,
+ * and a file already published is replaced
+ *
+ * With a hard link, the published file shares its inode (owner, mode and
+ * contents) with the source file
+ *
+ * @return  SN_FILE_PUBLISH_LINK        hard linked
+ *          SN_FILE_PUBLISH_REFLINK     reflinked
+ *          SN_FILE_PUBLISH_COPY_RANGE  copied with copy_file_range
+ *          SN_FILE_PUBLISH_SENDFILE    copied with sendfile
+ *         -1 error
+ */
+int sn_file_publish(const char *from_dir, const char *to_dir,
+                    const char *file_name) {
+  char source_path[1024];
+  char dest_path[1024];
+  char tmp_path[1024];
+
+  snprintf(source_path, sizeof(source_path), "%s/%s", from_dir, file_name);
+  snprintf(dest_path, sizeof(dest_path), "%s/%s", to_dir, file_name);
+  snprintf(tmp_path, sizeof(tmp_path), "%s/.%s.tmp", to_dir, file_name);
+
+  // Hard link, removing a temp file left over from an earlier failure
+
+  int result = linkat(AT_FDCWD, source_path, AT_FDCWD, tmp_path, 0);
+  if (result == -1 && errno == EEXIST) {
+    unlink(tmp_path);
+    result = linkat(AT_FDCWD, source_path, AT_FDCWD, tmp_path, 0);
+  }
+
+  if (result == 0) {
+    if (rename(tmp_path, dest_path) == -1) {
+      cn_log_msg(LOG_ERR, __func__,
+                 "'rename' gave an error from -> %s <-, to -> %s <-, "
+                 "strerror(errno) -> %m <-",
+                 tmp_path, dest_path);
+      unlink(tmp_path);
+      return -1;
+    }
+
+    // rename does nothing when dest is already a link to the same file
+
+    unlink(tmp_path);
+    return SN_FILE_PUBLISH_LINK;
+  }
+
+  // Only fall back to copying, when a hard link is not possible
+
+  if (errno != EXDEV && errno != EPERM && errno != EMLINK &&
+      errno != EOPNOTSUPP) {
+    cn_log_msg(LOG_ERR, __func__,
+               "'linkat' gave an error from -> %s <-, to -> %s <-, "
+               "strerror(errno) -> %m <-",
+               source_path, tmp_path);
+    return -1;
+  }
+
+  int input = open(source_path, O_RDONLY);
+  if (input == -1) {
+    cn_log_msg(LOG_ERR, __func__,
+               "'open' gave an error opening -> %s <-, strerror(errno) -> %m "
+               "<-",
+               source_path);
+    return -1;
+  }
+
+  int output = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC,
+                    S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP);
+  if (output == -1) {
+    cn_log_msg(LOG_ERR, __func__,
+               "'open' gave an error creating -> %s <-, strerror(errno) -> "
+               "%m <-",
+               tmp_path);
+    close(input);
+    return -1;
+  }
+
+  struct stat file_stat;
+  result = -1;
+  if (fstat(input, &file_stat) == 0)
+    result = sn_file_copy_fd(input, output, file_stat.st_size);
+
+  close(input);
+  close(output);
+
+  if (result == -1 || rename(tmp_path, dest_path) == -1) {
+    cn_log_msg(LOG_ERR, __func__,
+               "Could not copy -> %s <- to -> %s <-, strerror(errno) -> %m <-",
+               source_path, dest_path);
+    unlink(tmp_path);
+    return -1;
+  }
+
+  return result;
+}
+
+/**
+ * Create an unnamed file in "dir", with O_TMPFILE, else a temp name from
+ * "dest_path" that is renamed over it once written
+ *
+ * @param  tmp_path  Set to the temp name, empty for an unnamed file
+ * @return  fd, -1 error
+ */
+static int sn_file_open_staging(const char *dir, const char *dest_path,
+                                char *tmp_path, size_t tmp_path_sz) {
+  mode_t mode = S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP;
+
+  tmp_path[0] = '\0';
+  int fd = open(dir, O_TMPFILE | O_WRONLY, mode);
+  if (fd != -1)
+    return fd;
+
+  // Not every filesystem supports O_TMPFILE
+
+  if (errno != EOPNOTSUPP && errno != EISDIR && errno != EINVAL) {
+    cn_log_msg(LOG_ERR, __func__,
+               "'open' gave an error with O_TMPFILE in -> %s <-, "
+               "strerror(errno) -> %m <-",
+               dir);
+    return -1;
+  }
+
+  const char *dest_name = strrchr(dest_path, '/');
+  dest_name = dest_name != NULL ? dest_name + 1 : dest_path;
+  snprintf(tmp_path, tmp_path_sz, "%s/.%s.tmp", dir, dest_name);
+
+  fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC, mode);
+  if (fd == -1)
+    cn_log_msg(LOG_ERR, __func__,
+               "'open' gave an error creating -> %s <-, strerror(errno) -> "
+               "%m <-",
+               tmp_path);
+  return fd;
+}
+
+/**
+ * Move an ended sn1ff file to "dest_path", with group "group" and mode 660
+ *
+ * Group and mode are set before the file appears under "dest_path", and it
+ * appears whole, so a reader of the dest dir never sees a partial file, or
+ * one it cannot read
+ *
+ * On the same filesystem the file is renamed. Otherwise it is written once
+ * into an unnamed O_TMPFILE in the dest dir, then linked in with linkat. On
+ * a filesystem without O_TMPFILE, a temp name is written and renamed
+ *
+ * @return  SN_FILE_PUBLISH_RENAME      renamed
+ *          SN_FILE_PUBLISH_REFLINK     reflinked
+ *          SN_FILE_PUBLISH_COPY_RANGE  copied with copy_file_range
+ *          SN_FILE_PUBLISH_SENDFILE    copied with sendfile
+ *         -1 error
+ */
+int sn_file_move(const char *file_path, const char *dest_path,
+                 const char *group) {
+  int input = open(file_path, O_RDONLY);
+  if (input == -1) {
+    cn_log_msg(LOG_ERR, __func__,
+               "'open' gave an error opening -> %s <-, strerror(errno) -> %m "
+               "<-",
+               file_path);
+    return -1;
+  }
+
+  // Rename, with group and mode set on the file first
+
+  if (cn_file_fchgrp(input, group) != 0 || cn_file_fmode660(input) != 0) {
+    close(input);
+    return -1;
+  }
+
+  if (rename(file_path, dest_path) == 0) {
+    close(input);
+    return SN_FILE_PUBLISH_RENAME;
+  }
+
+  if (errno != EXDEV) {
+    cn_log_msg(LOG_ERR, __func__,
+               "'rename' gave an error from -> %s <-, to -> %s <-, "
+               "strerror(errno) -> %m <-",
+               file_path, dest_path);
+    close(input);
+    return -1;
+  }
+
+  // Across filesystems, write the file once in the dest dir
+
+  char dir[1024];
+  snprintf(dir, sizeof(dir), "%s", dest_path);
+  char *slash = strrchr(dir, '/');
+  if (slash == NULL) {
+    close(input);
+    return -1;
+  }
+  *slash = '\0';
+
+  char tmp_path[1024];
+  int output = sn_file_open_staging(dir, dest_path, tmp_path, sizeof(tmp_path));
+  if (output == -1) {
+    close(input);
+    return -1;
+  }
+
+  struct stat file_stat;
+  int result = -1;
+  if (cn_file_fchgrp(output, group) == 0 && cn_file_fmode660(output) == 0 &&
+      fstat(input, &file_stat) == 0)
+    result = sn_file_copy_fd(input, output, file_stat.st_size);
+
+  // Publish the file, by name for O_TMPFILE, else by rename
+
+  int published = -1;
+  if (result != -1) {
+    if (tmp_path[0] == '\0') {
+      char fd_path[64];
+      snprintf(fd_path, sizeof(fd_path), "/proc/self/fd/%d", output);
+      published = linkat(AT_FDCWD, fd_path, AT_FDCWD, dest_path,
+                         AT_SYMLINK_FOLLOW);
+    } else {
+      published = rename(tmp_path, dest_path);
+    }
+  }
+
+  close(input);
+  close(output);
+
+  if (published == -1) {
+    cn_log_msg(LOG_ERR, __func__,
+               "Could not copy -> %s <- to -> %s <-, strerror(errno) -> %m <-",
+               file_path, dest_path);
+    if (tmp_path[0] != '\0')
+      unlink(tmp_path);
+    return -1;
+  }
+
+  if (unlink(file_path) == -1) {
+    cn_log_msg(LOG_ERR, __func__,
+               "'unlink' gave error deleting moved file -> %s <-, "
+               "strerror(errno) -> %m <-",
+               file_path);
+    return -1;
+  }
+
+  return result;
+}
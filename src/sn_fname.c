@@ -33,8 +33,10 @@ SOFTWARE.
  *   - cname
  *       - components:
  *           <guid>_<status>_<epoch>
+ *   - shards
  *   - path:
  *       dir / cname
+ *       dir / shard / cname  (sharded)
  */
 
 /*----------------------------------------------------------------.
@@ -69,6 +71,7 @@ int sn_fname_init(FName *fname) {
   // name -> status
 
   memset(fname->cname.status, '\0', CNAME_STATUS_LENGTH_D * sizeof(char));
+  fname->cname.status_id = SN_STATUS_INVALID;
 
   // name -> epoch
 
@@ -86,6 +89,10 @@ int sn_fname_init(FName *fname) {
   }
   sprintf(fname->cname.epoch.str, "%ld", fname->cname.epoch.bin);
 
+  // shards
+
+  fname->shards = SN_SHARD_NONE;
+
   return 0;
 }
 
@@ -116,6 +123,16 @@ void sn_fname_get_dir(const FName *fname, char *dir) {
   strncpy(dir, fname->dir, FNAME_DIR_LENGTH);
 }
 
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Shards                                                         |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+void sn_fname_set_shards(FName *fname, int shards) { fname->shards = shards; }
+
+int sn_fname_get_shards(const FName *fname) { return fname->shards; }
+
 /*----------------------------------------------------------------.
  |                                                                |
  | Path                                                           |
@@ -138,18 +155,26 @@ void sn_fname_get_tmp_path(const FName *fname, char *tmp_path) {
  *
  * If there is no prefix - <dir>/<guid>_<status>_<epoch>.snff
  * If there is a prefix  - <dir>/<prefix><guid>_<status>_<epoch>.snff
+ *
+ * When sharded, the shard dir is between <dir> and the file name
  */
 void sn_fname_get_path(const FName *fname, char *path) {
+  char name[CNAME_NAME_LENGTH + 6 + 3];
+
   if (fname->cname.prefix[0] != '\0') {
     // prefix set
-    snprintf(path, FNAME_PATH_LENGTH, "%s/%s%s_%s_%s.snff", fname->dir,
-             fname->cname.prefix, fname->cname.guid.str, fname->cname.status,
+    snprintf(name, sizeof(name), "%s%s_%s_%s.snff", fname->cname.prefix,
+             fname->cname.guid.str, fname->cname.status,
              fname->cname.epoch.str);
   } else {
     // no prefix
     // Valgrind gives an error for this, but it is in fact okay
-    snprintf(path, FNAME_PATH_LENGTH, "%s/%s_%s_%s.snff", fname->dir,
-             fname->cname.guid.str, fname->cname.status,
-             fname->cname.epoch.str);
+    snprintf(name, sizeof(name), "%s_%s_%s.snff", fname->cname.guid.str,
+             fname->cname.status, fname->cname.epoch.str);
   }
+
+  if (fname->shards == SN_SHARD_NONE ||
+      sn_shard_path(fname->dir, name, fname->shards, path,
+                    FNAME_PATH_LENGTH) != 0)
+    snprintf(path, FNAME_PATH_LENGTH, "%s/%s", fname->dir, name);
 }
@@ -0,0 +1,198 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "sn_frame.h"
+#include <string.h>
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Text                                                           |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+/**
+ * Drop control characters, bar tab, from text in place
+ *
+ * @return  new length in bytes
+ */
+size_t sn_frame_clean(char *text) {
+  size_t out = 0;
+  for (size_t in = 0; text[in] != '\0'; in++) {
+    unsigned char c = (unsigned char)text[in];
+    if ((c >= 0x20 && c != 0x7f) || c == '\t')
+      text[out++] = text[in];
+  }
+  text[out] = '\0';
+  return out;
+}
+
+// Width of UTF-8 text in characters, as the shell's ${#text}
+static size_t chars(const char *text) {
+  size_t count = 0;
+  for (; *text != '\0'; text++)
+    if (((unsigned char)*text & 0xc0) != 0x80)
+      count++;
+  return count;
+}
+
+static void repeat(FILE *out, char c, size_t count) {
+  for (size_t i = 0; i < count; i++)
+    fputc(c, out);
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Formats                                                        |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+/**
+ * Title, spaced out and centered in a box
+ */
+static void write_title(FILE *out, const char *text) {
+  // Space out the characters, up to one more than fits in the widest box
+
+  char spaced[SN_FRAME_WIDTH * 4 + 1];
+  size_t spaced_len = 0;
+  size_t spaced_chars = 0;
+
+  for (const char *p = text;
+       *p != '\0' && spaced_chars < SN_FRAME_WIDTH - 3;) {
+    size_t len = 1;
+    while (((unsigned char)p[len] & 0xc0) == 0x80)
+      len++;
+
+    if (spaced_chars > 0) {
+      spaced[spaced_len++] = ' ';
+      spaced_chars++;
+    }
+    memcpy(spaced + spaced_len, p, len);
+    spaced_len += len;
+    spaced_chars++;
+    p += len;
+  }
+  spaced[spaced_len] = '\0';
+
+  // Too wide, cut to fit a box 2 narrower than the width
+
+  if (spaced_chars + 4 > SN_FRAME_WIDTH) {
+    size_t keep = SN_FRAME_WIDTH - 6;
+    size_t count = 0;
+    for (spaced_len = 0; spaced[spaced_len] != '\0'; spaced_len++)
+      if (((unsigned char)spaced[spaced_len] & 0xc0) != 0x80 &&
+          count++ == keep)
+        break;
+    spaced[spaced_len] = '\0';
+    spaced_chars = keep;
+  }
+
+  size_t box_width = spaced_chars + 4;
+  size_t margin = (SN_FRAME_WIDTH - box_width) / 2;
+  size_t inner = box_width - 2;
+  size_t pad_left = (inner - spaced_chars) / 2;
+  size_t pad_right = inner - spaced_chars - pad_left;
+
+  repeat(out, ' ', margin);
+  fputc('.', out);
+  repeat(out, '-', inner);
+  fputs(".\n", out);
+
+  repeat(out, ' ', margin);
+  fputc('|', out);
+  repeat(out, ' ', inner);
+  fputs("|\n", out);
+
+  repeat(out, ' ', margin);
+  fputc('|', out);
+  repeat(out, ' ', pad_left);
+  fputs(spaced, out);
+  repeat(out, ' ', pad_right);
+  fputs("|\n", out);
+
+  repeat(out, ' ', margin);
+  fputc('|', out);
+  repeat(out, ' ', inner);
+  fputs("|\n", out);
+
+  repeat(out, ' ', margin);
+  fputc('\'', out);
+  repeat(out, '-', inner);
+  fputs("'\n\n", out);
+}
+
+static void write_center(FILE *out, const char *text) {
+  size_t len = chars(text);
+  if (len < SN_FRAME_WIDTH)
+    repeat(out, ' ', (SN_FRAME_WIDTH - len) / 2);
+  fprintf(out, "%s\n\n\n", text);
+}
+
+static void write_trailer(FILE *out) {
+  fputc('\n', out);
+  repeat(out, '-', SN_FRAME_WIDTH);
+  fputs("\n\n", out);
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Commands                                                       |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+/**
+ * Write the output of a command line (see sn_frame.h). The line is
+ * changed, its text cleaned
+ *
+ * @param  line  without its newline
+ * @return  0 success
+ *         -1 command not recognized
+ */
+int sn_frame_line(FILE *out, char *line) {
+  char *text = strchr(line, ' ');
+  if (text != NULL)
+    *text++ = '\0';
+  else
+    text = line + strlen(line);
+
+  sn_frame_clean(text);
+
+  if (strcmp(line, "message") == 0)
+    fprintf(out, "%s\n", text);
+  else if (strcmp(line, "header") == 0)
+    fprintf(out, "\n\n%s\n\n", text);
+  else if (strcmp(line, "first") == 0)
+    fprintf(out, "%s\n\n", text);
+  else if (strcmp(line, "title") == 0)
+    write_title(out, text);
+  else if (strcmp(line, "center") == 0)
+    write_center(out, text);
+  else if (strcmp(line, "trailer") == 0)
+    write_trailer(out);
+  else
+    return -1;
+
+  return 0;
+}
@@ -0,0 +1,691 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _DEFAULT_SOURCE // For timegm
+
+#include "sn_history.h"
+#include "cn_log.h"
+#include "cn_string.h"
+#include "sn_varint.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define HISTORY_INITIAL_CAPACITY 1024
+
+// A record in the log is at most 2 varints, of a series id and status,
+// then the seconds into the day
+#define HISTORY_RECORD_MAX (2 * SN_VARINT_MAX)
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Files                                                          |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+/**
+ * Path of the "log" or "idx" file of a day, "<dir>/YYYYMMDD.<ext>"
+ */
+static void day_path(const char *dir, int64_t day, const char *ext,
+                     char *path, size_t path_sz) {
+  time_t epoch = (time_t)(day * SN_HISTORY_DAY_SECS);
+  struct tm tm;
+  gmtime_r(&epoch, &tm);
+  snprintf(path, path_sz, "%s/%04d%02d%02d.%s", dir, tm.tm_year + 1900,
+           tm.tm_mon + 1, tm.tm_mday, ext);
+}
+
+/**
+ * Day of a "YYYYMMDD.log" file name
+ *
+ * @return  0 success
+ *         -1 not a log file name
+ */
+static int parse_day(const char *name, int64_t *day) {
+  int year, month, mday;
+  char ext[8];
+  if (strlen(name) != 12 ||
+      sscanf(name, "%4d%2d%2d.%3s", &year, &month, &mday, ext) != 4 ||
+      strcmp(ext, "log") != 0 || month < 1 || month > 12 || mday < 1 ||
+      mday > 31)
+    return -1;
+
+  struct tm tm = {0};
+  tm.tm_year = year - 1900;
+  tm.tm_mon = month - 1;
+  tm.tm_mday = mday;
+  *day = (int64_t)timegm(&tm) / SN_HISTORY_DAY_SECS;
+  return 0;
+}
+
+/**
+ * Read a whole file
+ *
+ * @return  buffer to free, NULL could not read it (or it is empty)
+ */
+static unsigned char *read_file(const char *path, size_t *length) {
+  int fd = open(path, O_RDONLY);
+  if (fd == -1)
+    return NULL;
+
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
+    close(fd);
+    return NULL;
+  }
+
+  size_t size = (size_t)file_stat.st_size;
+  unsigned char *buffer = malloc(size);
+  size_t done = 0;
+  while (buffer != NULL && done < size) {
+    ssize_t n = read(fd, buffer + done, size - done);
+    if (n <= 0)
+      break;
+    done += (size_t)n;
+  }
+  close(fd);
+
+  if (buffer != NULL && done == 0) {
+    free(buffer);
+    return NULL;
+  }
+  *length = done;
+  return buffer;
+}
+
+/**
+ * "<Host>\t<CheckID>", see sn_series.h
+ */
+static void series_name(const char *host, const char *checkid, char *name,
+                        size_t name_sz) {
+  const char *parts[] = {host, checkid};
+  sn_series_name(parts, 2, name, name_sz);
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Records                                                        |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+typedef struct {
+  uint32_t series;
+  uint32_t seq;   // Order in the log
+  uint32_t value; // Seconds into the day << 2 | status
+} LogRecord;
+
+/**
+ * Decode the records of a day log
+ *
+ * @return  records to free, NULL none, or could not read them
+ */
+static LogRecord *read_log(const char *path, size_t *count) {
+  size_t length = 0;
+  unsigned char *buffer = read_file(path, &length);
+  *count = 0;
+  if (buffer == NULL)
+    return NULL;
+
+  // At least 2 bytes a record
+
+  LogRecord *records = malloc((length / 2 + 1) * sizeof(LogRecord));
+  if (records == NULL) {
+    free(buffer);
+    return NULL;
+  }
+
+  const unsigned char *p = buffer;
+  const unsigned char *end = buffer + length;
+  while (p < end) {
+    uint64_t id, secs;
+    if (sn_varint_get(&p, end, &id) != 0 ||
+        sn_varint_get(&p, end, &secs) != 0 || id >> 2 > UINT32_MAX ||
+        secs >= SN_HISTORY_DAY_SECS)
+      break; // A record part written when stopped, the rest is lost
+
+    records[*count].series = (uint32_t)(id >> 2);
+    records[*count].seq = (uint32_t)*count;
+    records[*count].value = (uint32_t)(secs << 2 | (id & 0x3));
+    (*count)++;
+  }
+
+  free(buffer);
+  return records;
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Record                                                         |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+/**
+ * Grow the last status of each series, to hold "series"
+ *
+ * @return  0 success
+ *         -1 could not allocate
+ */
+static int grow_states(History *history, uint32_t series) {
+  if (series < history->states_capacity)
+    return 0;
+
+  size_t capacity = history->states_capacity;
+  while (series >= capacity)
+    capacity *= 2;
+
+  HistoryState *states = realloc(history->states, capacity * sizeof(*states));
+  if (states == NULL)
+    return -1;
+  memset(states + history->states_capacity, 0,
+         (capacity - history->states_capacity) * sizeof(*states));
+  history->states = states;
+  history->states_capacity = capacity;
+  return 0;
+}
+
+/**
+ * Open the history store in "dir", creating it if need be
+ *
+ * @return  0 success
+ *         -1 could not create the dir, or open its files
+ *         -2 could not allocate
+ */
+int sn_history_open(History *history, const char *dir) {
+  memset(history, 0, sizeof(*history));
+  history->state_fd = -1;
+  history->log_fd = -1;
+  history->log_day = -1;
+
+  if (cn_string_cp(history->dir, sizeof(history->dir), dir) != 0 ||
+      (mkdir(dir, 0770) != 0 && errno != EEXIST)) {
+    cn_log_msg(LOG_ERR, __func__,
+               "Could not create history dir -> %s <-, strerror(errno) -> "
+               "%m <-",
+               dir);
+    return -1;
+  }
+
+  // Series interned so far
+
+  int result = sn_series_open(&history->series, dir);
+  if (result != 0)
+    return result;
+
+  history->states_capacity = HISTORY_INITIAL_CAPACITY;
+  history->states = calloc(history->states_capacity, sizeof(HistoryState));
+  if (history->states == NULL ||
+      (history->series.count > 0 &&
+       grow_states(history, history->series.count - 1) != 0)) {
+    sn_history_close(history);
+    return -2;
+  }
+
+  // Last status of each series
+
+  char path[SN_HISTORY_NAME_LENGTH + 32];
+  snprintf(path, sizeof(path), "%s/series.state", dir);
+  history->state_fd = open(path, O_RDWR | O_CREAT, 0660);
+
+  if (history->state_fd == -1) {
+    cn_log_msg(LOG_ERR, __func__,
+               "Could not open history files in -> %s <-, strerror(errno) -> "
+               "%m <-",
+               dir);
+    sn_history_close(history);
+    return -1;
+  }
+
+  ssize_t n = pread(history->state_fd, history->states,
+                    history->series.count * sizeof(HistoryState), 0);
+  if (n < 0)
+    n = 0;
+  memset((char *)history->states + n, 0,
+         history->series.count * sizeof(HistoryState) - (size_t)n);
+
+  return 0;
+}
+
+void sn_history_close(History *history) {
+  sn_series_close(&history->series);
+  if (history->state_fd != -1)
+    close(history->state_fd);
+  if (history->log_fd != -1)
+    close(history->log_fd);
+  free(history->states);
+  history->state_fd = -1;
+  history->log_fd = -1;
+  history->states = NULL;
+}
+
+/**
+ * Open the log of "day" to append to, indexing the day before once over
+ */
+static int open_log(History *history, int64_t day) {
+  if (history->log_fd != -1) {
+    close(history->log_fd);
+    history->log_fd = -1;
+    if (day > history->log_day)
+      sn_history_index_day(history->dir, history->log_day);
+  }
+
+  char path[SN_HISTORY_NAME_LENGTH + 32];
+  day_path(history->dir, day, "log", path, sizeof(path));
+
+  history->log_fd = open(path, O_WRONLY | O_CREAT | O_APPEND, 0660);
+  if (history->log_fd == -1) {
+    cn_log_msg(LOG_ERR, __func__,
+               "'open' gave an error for history log -> %s <-, "
+               "strerror(errno) -> %m <-",
+               path);
+    return -1;
+  }
+
+  history->log_day = day;
+  return 0;
+}
+
+/**
+ * Record a result of a (Host, CheckID), if it is the first result of it,
+ * or a change of its status
+ *
+ * @return  1 recorded
+ *          0 same status as the last record, not recorded
+ *         -1 error
+ */
+int sn_history_record(History *history, const char *host,
+                      const char *checkid, Status status, time_t when) {
+  if (status < SN_STATUS_NONE || status > SN_STATUS_ALRT || when < 0)
+    return -1;
+
+  char name[2 * SN_HISTORY_NAME_LENGTH];
+  series_name(host, checkid, name, sizeof(name));
+
+  int64_t interned = sn_series_intern(&history->series, name);
+  if (interned < 0 || grow_states(history, (uint32_t)interned) != 0)
+    return -1;
+
+  uint32_t series = (uint32_t)interned;
+  HistoryState *state = &history->states[series];
+  if (state->last != 0 && state->status == (int32_t)status)
+    return 0;
+
+  // Append to the log of the day
+
+  int64_t day = (int64_t)when / SN_HISTORY_DAY_SECS;
+  if (day != history->log_day && open_log(history, day) != 0)
+    return -1;
+
+  unsigned char record[HISTORY_RECORD_MAX];
+  size_t n = sn_varint_put(record, (uint64_t)series << 2 | (uint64_t)status);
+  n += sn_varint_put(record + n,
+                     (uint64_t)(when - day * SN_HISTORY_DAY_SECS));
+
+  if (write(history->log_fd, record, n) != (ssize_t)n) {
+    cn_log_msg(LOG_ERR, __func__,
+               "'write' gave an error for history log, strerror(errno) -> "
+               "%m <-");
+    return -1;
+  }
+
+  state->last = (int64_t)when;
+  state->status = (int32_t)status;
+  pwrite(history->state_fd, state, sizeof(*state),
+         (off_t)series * (off_t)sizeof(*state));
+  return 1;
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Index                                                          |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+static int compare_records(const void *a, const void *b) {
+  const LogRecord *ra = a;
+  const LogRecord *rb = b;
+  if (ra->series != rb->series)
+    return ra->series < rb->series ? -1 : 1;
+  return ra->seq < rb->seq ? -1 : ra->seq > rb->seq;
+}
+
+/**
+ * Write the index of the log of "day", its records grouped by series
+ *
+ * It is written to a temp file and renamed, so a reader never sees it part
+ * written
+ *
+ * @return  0 success
+ *         -1 no log for the day, or could not read it
+ *         -2 could not write the index
+ */
+int sn_history_index_day(const char *dir, int64_t day) {
+  char path[SN_HISTORY_NAME_LENGTH + 32];
+  char tmp_path[SN_HISTORY_NAME_LENGTH + 40];
+
+  day_path(dir, day, "log", path, sizeof(path));
+  size_t count = 0;
+  LogRecord *records = read_log(path, &count);
+  if (records == NULL)
+    return -1;
+
+  qsort(records, count, sizeof(LogRecord), compare_records);
+
+  size_t num_series = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (i == 0 || records[i].series != records[i - 1].series)
+      num_series++;
+  }
+
+  HistoryIndexSeries *series = calloc(num_series + 1, sizeof(*series));
+  uint32_t *values = malloc((count + 1) * sizeof(uint32_t));
+  if (series == NULL || values == NULL) {
+    free(series);
+    free(values);
+    free(records);
+    return -2;
+  }
+
+  size_t s = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (i > 0 && records[i].series != records[i - 1].series)
+      s++;
+    if (series[s].count == 0) {
+      series[s].series = records[i].series;
+      series[s].first = i;
+    }
+    series[s].count++;
+    values[i] = records[i].value;
+  }
+  free(records);
+
+  HistoryIndexHeader header = {0};
+  memcpy(header.magic, SN_HISTORY_MAGIC, SN_HISTORY_MAGIC_LENGTH);
+  header.version = SN_HISTORY_VERSION;
+  header.day = day;
+  header.num_series = num_series;
+  header.num_records = count;
+
+  day_path(dir, day, "idx", path, sizeof(path));
+  snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+
+  FILE *file = fopen(tmp_path, "w");
+  bool written =
+      file != NULL && fwrite(&header, sizeof(header), 1, file) == 1 &&
+      fwrite(series, sizeof(*series), num_series, file) == num_series &&
+      fwrite(values, sizeof(uint32_t), count, file) == count;
+
+  free(series);
+  free(values);
+
+  if (file == NULL || fclose(file) != 0 || !written ||
+      rename(tmp_path, path) != 0) {
+    cn_log_msg(LOG_ERR, __func__,
+               "Could not write history index -> %s <-, strerror(errno) -> "
+               "%m <-",
+               path);
+    unlink(tmp_path);
+    return -2;
+  }
+
+  return 0;
+}
+
+/**
+ * Index the log of each day before "today" that has no index
+ *
+ * @return  number of days indexed
+ *         -1 could not list the dir
+ */
+int sn_history_index_all(const char *dir, int64_t today) {
+  DIR *d = opendir(dir);
+  if (d == NULL)
+    return -1;
+
+  int indexed = 0;
+  struct dirent *entry;
+  while ((entry = readdir(d)) != NULL) {
+    int64_t day;
+    if (parse_day(entry->d_name, &day) != 0 || day >= today)
+      continue;
+
+    char path[SN_HISTORY_NAME_LENGTH + 32];
+    day_path(dir, day, "idx", path, sizeof(path));
+    if (access(path, F_OK) != 0 && sn_history_index_day(dir, day) == 0)
+      indexed++;
+  }
+
+  closedir(d);
+  return indexed;
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Query                                                          |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+typedef struct {
+  void *map;
+  size_t size;
+  const HistoryIndexHeader *header;
+  const HistoryIndexSeries *series;
+  const uint32_t *values;
+} DayIndex;
+
+/**
+ * Map the index of "day"
+ *
+ * @return  0 success
+ *         -1 no index, or not valid
+ */
+static int map_index(const char *dir, int64_t day, DayIndex *index) {
+  char path[SN_HISTORY_NAME_LENGTH + 32];
+  day_path(dir, day, "idx", path, sizeof(path));
+
+  int fd = open(path, O_RDONLY);
+  if (fd == -1)
+    return -1;
+
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0 ||
+      (size_t)file_stat.st_size < sizeof(HistoryIndexHeader)) {
+    close(fd);
+    return -1;
+  }
+
+  index->size = (size_t)file_stat.st_size;
+  index->map = mmap(NULL, index->size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (index->map == MAP_FAILED)
+    return -1;
+
+  index->header = index->map;
+  index->series = (const HistoryIndexSeries *)(index->header + 1);
+  index->values = (const uint32_t *)(index->series + index->header->num_series);
+
+  const HistoryIndexHeader *header = index->header;
+  if (memcmp(header->magic, SN_HISTORY_MAGIC, SN_HISTORY_MAGIC_LENGTH) != 0 ||
+      header->version != SN_HISTORY_VERSION || header->day != day ||
+      index->size != sizeof(*header) +
+                         header->num_series * sizeof(HistoryIndexSeries) +
+                         header->num_records * sizeof(uint32_t)) {
+    munmap(index->map, index->size);
+    return -1;
+  }
+  return 0;
+}
+
+/**
+ * Directory entry of "series" in a day index, by binary search
+ */
+static const HistoryIndexSeries *find_series(const DayIndex *index,
+                                             uint32_t series) {
+  size_t low = 0;
+  size_t high = index->header->num_series;
+  while (low < high) {
+    size_t mid = low + (high - low) / 2;
+    if (index->series[mid].series < series)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+
+  if (low < index->header->num_series && index->series[low].series == series)
+    return &index->series[low];
+  return NULL;
+}
+
+/**
+ * Call "fn" for each record of "series" from "from" to "to" (inclusive),
+ * in time order
+ *
+ * A day over is read from its index, the current day from its log
+ *
+ * @return  0 success
+ *          else the non zero value "fn" returned, to stop
+ */
+int sn_history_each(const char *dir, uint32_t series, time_t from, time_t to,
+                    HistoryRecordFn fn, void *arg) {
+  if (from < 0)
+    from = 0;
+
+  for (int64_t day = from / SN_HISTORY_DAY_SECS;
+       day <= (int64_t)to / SN_HISTORY_DAY_SECS; day++) {
+    int64_t base = day * SN_HISTORY_DAY_SECS;
+    DayIndex index;
+
+    if (map_index(dir, day, &index) == 0) {
+      const HistoryIndexSeries *entry = find_series(&index, series);
+      int result = 0;
+      for (uint32_t i = 0; entry != NULL && i < entry->count && result == 0;
+           i++) {
+        uint32_t value = index.values[entry->first + i];
+        int64_t when = base + (value >> 2);
+        if (when >= from && when <= to)
+          result = fn(when, (Status)(value & 0x3), arg);
+      }
+      munmap(index.map, index.size);
+      if (result != 0)
+        return result;
+      continue;
+    }
+
+    char path[SN_HISTORY_NAME_LENGTH + 32];
+    day_path(dir, day, "log", path, sizeof(path));
+    size_t count = 0;
+    LogRecord *records = read_log(path, &count);
+
+    int result = 0;
+    for (size_t i = 0; i < count && result == 0; i++) {
+      int64_t when = base + (records[i].value >> 2);
+      if (records[i].series == series && when >= from && when <= to)
+        result = fn(when, (Status)(records[i].value & 0x3), arg);
+    }
+    free(records);
+    if (result != 0)
+      return result;
+  }
+
+  return 0;
+}
+
+/**
+ * Add up the records of each series from "from" to "to" (inclusive), as
+ * to find flapping checks. "counts" is indexed by series
+ *
+ * @return  0 success
+ */
+int sn_history_counts(const char *dir, time_t from, time_t to,
+                      uint32_t *counts, size_t num_series) {
+  if (from < 0)
+    from = 0;
+
+  for (int64_t day = from / SN_HISTORY_DAY_SECS;
+       day <= (int64_t)to / SN_HISTORY_DAY_SECS; day++) {
+    int64_t base = day * SN_HISTORY_DAY_SECS;
+    bool whole_day = base >= from && base + SN_HISTORY_DAY_SECS - 1 <= to;
+    DayIndex index;
+
+    if (map_index(dir, day, &index) == 0) {
+      for (uint64_t s = 0; s < index.header->num_series; s++) {
+        const HistoryIndexSeries *entry = &index.series[s];
+        if (entry->series >= num_series)
+          continue;
+        if (whole_day) {
+          counts[entry->series] += entry->count;
+          continue;
+        }
+        for (uint32_t i = 0; i < entry->count; i++) {
+          int64_t when = base + (index.values[entry->first + i] >> 2);
+          if (when >= from && when <= to)
+            counts[entry->series]++;
+        }
+      }
+      munmap(index.map, index.size);
+      continue;
+    }
+
+    char path[SN_HISTORY_NAME_LENGTH + 32];
+    day_path(dir, day, "log", path, sizeof(path));
+    size_t count = 0;
+    LogRecord *records = read_log(path, &count);
+
+    for (size_t i = 0; i < count; i++) {
+      int64_t when = base + (records[i].value >> 2);
+      if (records[i].series < num_series && when >= from && when <= to)
+        counts[records[i].series]++;
+    }
+    free(records);
+  }
+
+  return 0;
+}
+
+/**
+ * Series id of a (Host, CheckID)
+ *
+ * @return  series id
+ *         -1 no history of it
+ */
+int64_t sn_history_find(const char *dir, const char *host,
+                        const char *checkid) {
+  char name[2 * SN_HISTORY_NAME_LENGTH];
+  series_name(host, checkid, name, sizeof(name));
+  return sn_series_find(dir, name);
+}
+
+/**
+ * "<Host>\t<CheckID>" of each series, in series id order
+ *
+ * @return  0 success
+ *         -1 no history
+ */
+int sn_history_names(const char *dir, MultiString *names) {
+  return sn_series_names(dir, names);
+}
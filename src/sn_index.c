@@ -0,0 +1,433 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "sn_index.h"
+#include "cn_log.h"
+#include "sn_cname.h"
+#include "sn_dir.h"
+#include "sn_shard.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SN_INDEX_PATH_LENGTH 1024
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Index                                                          |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+/**
+ * Path of the index's dir "i", the dir itself, or its shard dir "i"
+ */
+static void index_dir_path(const Index *index, size_t i, char *path,
+                           size_t path_sz) {
+  if (index->shards == SN_SHARD_NONE)
+    snprintf(path, path_sz, "%s", index->dir);
+  else
+    sn_shard_index_dir(index->dir, index->shards, (int)i, path, path_sz);
+}
+
+/**
+ * Initialize an empty index, for the sn1ff files in a dir
+ *
+ * @param index
+ * @param dir     dir the sn1ff files are in
+ * @param shards  0, 256 or 4096
+ *
+ * @return  0 success
+ *         -1 invalid number of shards
+ *         -2 dir path too long
+ *         -3 could not allocate
+ */
+int sn_index_init(Index *index, const char *dir, int shards) {
+  memset(index, 0, sizeof(*index));
+
+  if (!sn_shard_valid(shards))
+    return -1;
+  if (strlen(dir) >= SN_INDEX_DIR_LENGTH)
+    return -2;
+
+  strcpy(index->dir, dir);
+  index->shards = shards;
+  index->num_dirs = shards == SN_SHARD_NONE ? 1 : (size_t)shards;
+
+  index->dirs = calloc(index->num_dirs, sizeof(IndexDir));
+  if (index->dirs == NULL) {
+    cn_log_msg(LOG_ERR, __func__, "Could not allocate -> %zu <- index dirs",
+               index->num_dirs);
+    return -3;
+  }
+
+  return 0;
+}
+
+static void clear_dirs(Index *index) {
+  for (size_t i = 0; i < index->num_dirs; i++) {
+    free(index->dirs[i].entries);
+    memset(&index->dirs[i], 0, sizeof(IndexDir));
+  }
+  index->count = 0;
+}
+
+void sn_index_free(Index *index) {
+  if (index->dirs != NULL)
+    clear_dirs(index);
+  free(index->dirs);
+  index->dirs = NULL;
+  index->num_dirs = 0;
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Refresh                                                        |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+/**
+ * Add a file name read from a dir, to the dir's new entries
+ */
+static int scan_name(const char *name, void *arg) {
+  IndexDir *scan = arg;
+
+  if (strlen(name) > SN_INDEX_NAME_LENGTH) {
+    cn_log_msg(LOG_DEBUG, __func__, "Name too long to index -> %s <-", name);
+    return 0;
+  }
+
+  if (scan->record.count == scan->capacity) {
+    size_t capacity = scan->capacity == 0 ? 64 : scan->capacity * 2;
+    IndexEntry *entries =
+        realloc(scan->entries, capacity * sizeof(IndexEntry));
+    if (entries == NULL) {
+      cn_log_msg(LOG_ERR, __func__, "Could not grow index to -> %zu <-",
+                 capacity);
+      return -1;
+    }
+    scan->entries = entries;
+    scan->capacity = capacity;
+  }
+
+  IndexEntry *entry = &scan->entries[scan->record.count++];
+  memset(entry, 0, sizeof(IndexEntry));
+  strcpy(entry->name, name);
+  entry->status = SN_STATUS_INVALID;
+
+  CName cname;
+  if (sn_cname_parse_name(name, &cname) == CNAME_PARSE_OK) {
+    entry->expiry = (int64_t)cname.epoch.bin;
+    entry->status = cname.status_id;
+  }
+
+  return 0;
+}
+
+/**
+ * Replace the entries of dir "i", by rescanning it
+ *
+ * @param st  stat of the dir, NULL if it does not exist
+ */
+static int rescan_dir(Index *index, size_t i, const char *path,
+                      const struct stat *st) {
+  IndexDir scan;
+  memset(&scan, 0, sizeof(scan));
+
+  if (st != NULL) {
+    if (sn_dir_each_file(path, scan_name, &scan) != 0) {
+      free(scan.entries);
+      return -1;
+    }
+
+    scan.record.dev = (uint64_t)st->st_dev;
+    scan.record.ino = (uint64_t)st->st_ino;
+
+    // Only trust an mtime old enough, that no later change can share it
+
+    if (time(NULL) - st->st_mtim.tv_sec >= SN_INDEX_RACY_SECS) {
+      scan.record.mtime_sec = (int64_t)st->st_mtim.tv_sec;
+      scan.record.mtime_nsec = (int64_t)st->st_mtim.tv_nsec;
+    }
+  }
+
+  IndexDir *dir = &index->dirs[i];
+  index->count = index->count - dir->record.count + scan.record.count;
+  free(dir->entries);
+  *dir = scan;
+  index->dirty = true;
+  return 0;
+}
+
+/**
+ * Bring the index up to date with its dir, rescanning only the dirs whose
+ * identity or mtime changed since they were scanned
+ *
+ * @return  >= 0 number of dirs rescanned
+ *          -1 error reading a dir
+ */
+int sn_index_refresh(Index *index) {
+  char path[SN_INDEX_PATH_LENGTH];
+  int rescanned = 0;
+
+  for (size_t i = 0; i < index->num_dirs; i++) {
+    IndexDirRecord *record = &index->dirs[i].record;
+    index_dir_path(index, i, path, sizeof(path));
+
+    struct stat st;
+    if (stat(path, &st) == -1) {
+      if (errno != ENOENT) {
+        cn_log_msg(LOG_ERR, __func__,
+                   "'stat' gave error for dir -> %s <-, "
+                   "strerror(errno) -> %m <-",
+                   path);
+        return -1;
+      }
+
+      // A dir that does not exist has no files
+
+      if (record->ino != 0 || record->count != 0) {
+        rescan_dir(index, i, path, NULL);
+        rescanned++;
+      }
+      continue;
+    }
+
+    if (record->mtime_sec != 0 && record->dev == (uint64_t)st.st_dev &&
+        record->ino == (uint64_t)st.st_ino &&
+        record->mtime_sec == (int64_t)st.st_mtim.tv_sec &&
+        record->mtime_nsec == (int64_t)st.st_mtim.tv_nsec)
+      continue;
+
+    if (rescan_dir(index, i, path, &st) != 0)
+      return -1;
+    rescanned++;
+  }
+
+  return rescanned;
+}
+
+/**
+ * Call fn for each indexed file
+ *
+ * @param fn   returns 0 to continue, or non zero to stop
+ *
+ * @return  0 success
+ *          2 stopped by fn
+ */
+int sn_index_each(const Index *index, IndexEntryFn fn, void *arg) {
+  for (size_t i = 0; i < index->num_dirs; i++) {
+    const IndexDir *dir = &index->dirs[i];
+    for (size_t j = 0; j < dir->record.count; j++) {
+      if (fn(&dir->entries[j], arg) != 0)
+        return 2;
+    }
+  }
+  return 0;
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Checkpoint                                                     |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+static int write_all(int fd, const void *buf, size_t len) {
+  const char *pos = buf;
+  while (len > 0) {
+    ssize_t written = write(fd, pos, len);
+    if (written == -1) {
+      if (errno == EINTR)
+        continue;
+      return -1;
+    }
+    pos += written;
+    len -= (size_t)written;
+  }
+  return 0;
+}
+
+/**
+ * Write the index to a checkpoint file, replacing any earlier one
+ *
+ * @param path  checkpoint file path
+ *
+ * @return  0 success
+ *         -1 error writing the checkpoint
+ */
+int sn_index_save(Index *index, const char *path) {
+  char tmp_path[SN_INDEX_PATH_LENGTH];
+  snprintf(tmp_path, sizeof(tmp_path), "%s.%ld.tmp", path, (long)getpid());
+
+  int fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP);
+  if (fd == -1) {
+    cn_log_msg(LOG_ERR, __func__,
+               "'open' gave error for checkpoint -> %s <-, "
+               "strerror(errno) -> %m <-",
+               tmp_path);
+    return -1;
+  }
+
+  IndexHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, SN_INDEX_MAGIC, SN_INDEX_MAGIC_LENGTH);
+  header.version = SN_INDEX_VERSION;
+  header.shards = (uint32_t)index->shards;
+  header.num_dirs = index->num_dirs;
+  header.count = index->count;
+  strcpy(header.dir, index->dir);
+
+  int result = write_all(fd, &header, sizeof(header));
+
+  for (size_t i = 0; result == 0 && i < index->num_dirs; i++)
+    result = write_all(fd, &index->dirs[i].record, sizeof(IndexDirRecord));
+
+  for (size_t i = 0; result == 0 && i < index->num_dirs; i++) {
+    const IndexDir *dir = &index->dirs[i];
+    if (dir->record.count > 0)
+      result = write_all(fd, dir->entries,
+                         dir->record.count * sizeof(IndexEntry));
+  }
+
+  if (result == 0)
+    result = fsync(fd);
+
+  if (close(fd) != 0 || result != 0 || rename(tmp_path, path) != 0) {
+    cn_log_msg(LOG_ERR, __func__,
+               "Error writing checkpoint -> %s <-, strerror(errno) -> %m <-",
+               path);
+    unlink(tmp_path);
+    return -1;
+  }
+
+  index->dirty = false;
+  return 0;
+}
+
+/**
+ * Load the index from a checkpoint file, written by sn_index_save for the
+ * same dir and number of shards. Follow with sn_index_refresh, to rescan
+ * the dirs that changed since
+ *
+ * On error the index is left empty, so a refresh rescans every dir
+ *
+ * @param path  checkpoint file path
+ *
+ * @return  0 success
+ *         -1 could not open or map the checkpoint
+ *         -2 not a valid checkpoint for this index
+ *         -3 could not allocate
+ */
+int sn_index_load(Index *index, const char *path) {
+  clear_dirs(index);
+
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    cn_log_msg(LOG_DEBUG, __func__,
+               "No checkpoint -> %s <-, strerror(errno) -> %m <-", path);
+    return -1;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) == -1 || (size_t)st.st_size < sizeof(IndexHeader)) {
+    close(fd);
+    return -2;
+  }
+
+  size_t size = (size_t)st.st_size;
+  void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    cn_log_msg(LOG_ERR, __func__,
+               "'mmap' gave error for checkpoint -> %s <-, "
+               "strerror(errno) -> %m <-",
+               path);
+    return -1;
+  }
+
+  const IndexHeader *header = map;
+  const IndexDirRecord *records =
+      (const IndexDirRecord *)((const char *)map + sizeof(IndexHeader));
+  const IndexEntry *entries =
+      (const IndexEntry *)(records + index->num_dirs);
+
+  int result = 0;
+
+  if (memcmp(header->magic, SN_INDEX_MAGIC, SN_INDEX_MAGIC_LENGTH) != 0 ||
+      header->version != SN_INDEX_VERSION ||
+      header->shards != (uint32_t)index->shards ||
+      header->num_dirs != index->num_dirs ||
+      header->count > size / sizeof(IndexEntry) ||
+      strncmp(header->dir, index->dir, SN_INDEX_DIR_LENGTH) != 0 ||
+      size != sizeof(IndexHeader) +
+                  index->num_dirs * sizeof(IndexDirRecord) +
+                  header->count * sizeof(IndexEntry))
+    result = -2;
+
+  uint64_t total = 0;
+  for (size_t i = 0; result == 0 && i < index->num_dirs; i++)
+    total += records[i].count;
+  if (result == 0 && total != header->count)
+    result = -2;
+
+  for (size_t i = 0; result == 0 && i < index->num_dirs; i++) {
+    IndexDir *dir = &index->dirs[i];
+    size_t count = (size_t)records[i].count;
+
+    if (count > 0) {
+      dir->entries = malloc(count * sizeof(IndexEntry));
+      if (dir->entries == NULL) {
+        result = -3;
+        break;
+      }
+      memcpy(dir->entries, entries, count * sizeof(IndexEntry));
+      for (size_t j = 0; j < count; j++)
+        dir->entries[j].name[SN_INDEX_NAME_LENGTH] = '\0';
+    }
+
+    dir->record = records[i];
+    dir->capacity = count;
+    index->count += count;
+    entries += count;
+  }
+
+  munmap(map, size);
+
+  if (result != 0) {
+    cn_log_msg(LOG_WARNING, __func__,
+               "Ignoring checkpoint -> %s <-, result -> %d <-", path, result);
+    clear_dirs(index);
+    return result;
+  }
+
+  index->dirty = false;
+  return 0;
+}
@@ -0,0 +1,570 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _GNU_SOURCE // For syncfs
+
+#include "sn_ingest.h"
+#include "cn_log.h"
+#include "cn_time.h"
+#include "sn_file.h"
+#include "sn_shard.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Ingest one file                                                |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+/**
+ * Publish a file from "upload" to "watch" and/or "export"
+ *
+ * @return  0 success
+ *         -1 publish to "watch" failed
+ *         -2 publish to "export" failed
+ */
+static int publish_file(const char *upload_dir, const char *watch_dir,
+                        const char *export_dir, int shards,
+                        const char *file_name) {
+  char shard_dir[SN_BATCH_PATH_LENGTH];
+
+  if (watch_dir != NULL &&
+      (sn_shard_dir(watch_dir, file_name, shards, shard_dir,
+                    sizeof(shard_dir)) != 0 ||
+       sn_file_publish(upload_dir, shard_dir, file_name) < 0)) {
+    cn_log_msg(LOG_ERR, __func__,
+               "Could not publish file -> %s <- to watch dir -> %s <-",
+               file_name, watch_dir);
+    return -1;
+  }
+
+  if (export_dir != NULL &&
+      (sn_shard_dir(export_dir, file_name, shards, shard_dir,
+                    sizeof(shard_dir)) != 0 ||
+       sn_file_publish(upload_dir, shard_dir, file_name) < 0)) {
+    cn_log_msg(LOG_ERR, __func__,
+               "Could not publish file -> %s <- to export dir -> %s <-",
+               file_name, export_dir);
+    return -2;
+  }
+
+  return 0;
+}
+
+/**
+ * Publish a file from "upload" to "watch" and "export", then delete it
+ *
+ * Publishing hard links the file where possible (see sn_file_publish). The
+ * file is only deleted after every publish succeeded, so a failed publish
+ * is retried on the next pass
+ *
+ * @param  watch_dir   NULL to not publish to "watch"
+ * @param  export_dir  NULL to not publish to "export"
+ * @param  shards      layout of "watch" and "export", see sn_shard.h
+ * @return  0 success
+ *         -1 publish to "watch" failed, file not deleted
+ *         -2 publish to "export" failed, file not deleted
+ */
+int sn_ingest_file(const char *upload_dir, const char *watch_dir,
+                   const char *export_dir, int shards, const char *file_name) {
+  cn_log_msg(LOG_DEBUG, __func__, "Inspecting file %s", file_name);
+
+  int result =
+      publish_file(upload_dir, watch_dir, export_dir, shards, file_name);
+  if (result != 0)
+    return result;
+
+  cn_log_msg(LOG_DEBUG, __func__, "Deleting file %s", file_name);
+  sn_file_delete(upload_dir, file_name);
+  return 0;
+}
+
+/**
+ * Flush the file systems of "watch" and "export", so the files published
+ * to them survive a crash. One syncfs covers a whole batch of files
+ */
+static void sync_dirs(const char *watch_dir, const char *export_dir) {
+  const char *dirs[] = {watch_dir, export_dir};
+
+  for (size_t i = 0; i < 2; i++) {
+    if (dirs[i] == NULL)
+      continue;
+
+    int fd = open(dirs[i], O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd == -1 || syncfs(fd) != 0)
+      cn_log_msg(LOG_ERR, __func__,
+                 "Could not sync dir -> %s <-, strerror(errno) -> %m <-",
+                 dirs[i]);
+    if (fd != -1)
+      close(fd);
+  }
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Recovery                                                       |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+typedef struct {
+  const char *upload_dir;
+  const char *watch_dir;
+  const char *export_dir;
+  int shards;
+  int resumed;
+  MultiString *resumed_names;
+} RECOVERY;
+
+/**
+ * Resume a file from its last journal state, only doing the steps that
+ * were not done
+ */
+static void recover_file(const char *name, int state, void *arg) {
+  RECOVERY *recovery = arg;
+  char path[SN_BATCH_PATH_LENGTH];
+
+  snprintf(path, sizeof(path), "%s/%s", recovery->upload_dir, name);
+  if (access(path, F_OK) != 0) {
+    cn_log_msg(LOG_DEBUG, __func__, "Already removed -> %s <-", name);
+    return;
+  }
+
+  // Not yet published, left for the next pass to ingest
+
+  if (state == SN_JOURNAL_STAGED)
+    return;
+
+  // Published to "watch", but not "export". Only "export" is redone, so
+  // the file does not reappear in "watch", e.g. after the cleaner or a
+  // monitor deleted it
+
+  if (state == SN_JOURNAL_WATCH && recovery->export_dir != NULL &&
+      publish_file(recovery->upload_dir, NULL, recovery->export_dir,
+                   recovery->shards, name) != 0)
+    return;
+
+  cn_log_msg(LOG_INFO, __func__, "Resumed ingest of -> %s <-", name);
+  sn_file_delete(recovery->upload_dir, name);
+  recovery->resumed++;
+  if (recovery->resumed_names != NULL)
+    cn_multistr_append(recovery->resumed_names, name);
+}
+
+/**
+ * Resume the files part way through ingest when the greeter stopped, from
+ * its journal. Call before sn_journal_open resets the journal
+ *
+ * @param  journal_path   the ingest journal file
+ * @param  resumed_names  returns the names of the files resumed, as they
+ *                        are published, NULL for none
+ * @return  >= 0 number of files resumed
+ *          -1 could not read the journal
+ */
+int sn_ingest_recover(const char *journal_path, const char *upload_dir,
+                      const char *watch_dir, const char *export_dir,
+                      int shards, MultiString *resumed_names) {
+  RECOVERY recovery = {upload_dir, watch_dir, export_dir, shards, 0,
+                       resumed_names};
+
+  int result = sn_journal_replay(journal_path, recover_file, &recovery);
+  if (result < 0) {
+    cn_log_msg(LOG_ERR, __func__, "Could not replay journal -> %s <-",
+               journal_path);
+    return -1;
+  }
+
+  if (recovery.resumed > 0)
+    sync_dirs(watch_dir, export_dir);
+  return recovery.resumed;
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Worker pool                                                    |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+/**
+ * Queued file
+ */
+typedef struct {
+  bool watch; // false, publish to "export" only
+  char name[];
+} INGEST_ITEM;
+
+/**
+ * Journal a state for the files in a batch, and commit them together
+ */
+static void journal_files(Ingest *ingest, int state, INGEST_ITEM **items,
+                          const bool *which, size_t count, bool commit) {
+  uint64_t seq = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (which == NULL || which[i]) {
+      uint64_t appended =
+          sn_journal_append(ingest->journal, state, items[i]->name);
+      seq = appended > seq ? appended : seq;
+    }
+  }
+  if (commit)
+    sn_journal_commit(ingest->journal, seq);
+}
+
+/**
+ * Publish files, then delete them from "upload"
+ *
+ * The publishes are hard links, in one batch submit, each file a chain of:
+ * link to "watch" (unless it is for "export" only), then link to "export".
+ * A file whose chain fails (e.g. it is already published, or is on another
+ * filesystem) falls back to publish_file. Without a batch, every file goes
+ * through publish_file.
+ *
+ * With a journal, the files are journaled STAGED before publishing. After
+ * publishing, the file systems are synced once for the batch, and the
+ * files journaled as published, before they are deleted from "upload"
+ */
+static void sn_ingest_batch(Ingest *ingest, Batch *batch, INGEST_ITEM **items,
+                            size_t count) {
+  size_t first_op[SN_INGEST_BATCH_FILES + 1];
+  bool added[SN_INGEST_BATCH_FILES];
+  bool watched[SN_INGEST_BATCH_FILES];
+  bool published[SN_INGEST_BATCH_FILES];
+  char from[SN_BATCH_PATH_LENGTH];
+  char to[SN_BATCH_PATH_LENGTH];
+
+  if (ingest->journal != NULL)
+    journal_files(ingest, SN_JOURNAL_STAGED, items, NULL, count, true);
+
+  if (batch != NULL) {
+    sn_batch_reset(batch);
+
+    for (size_t i = 0; i < count; i++) {
+      first_op[i] = batch->count;
+      snprintf(from, sizeof(from), "%s/%s", ingest->upload_dir,
+               items[i]->name);
+
+      // The watch link is linked to the export link only, so a chain never
+      // runs into the next file's
+
+      int result = 0;
+      if (ingest->watch_dir != NULL && items[i]->watch) {
+        result |= sn_shard_path(ingest->watch_dir, items[i]->name,
+                                ingest->shards, to, sizeof(to));
+        result |= sn_batch_add_link(batch, from, to,
+                                    ingest->export_dir != NULL);
+      }
+      if (ingest->export_dir != NULL) {
+        result |= sn_shard_path(ingest->export_dir, items[i]->name,
+                                ingest->shards, to, sizeof(to));
+        result |= sn_batch_add_link(batch, from, to, false);
+      }
+
+      // Not added, drop any part of its chain
+
+      added[i] = result == 0;
+      if (!added[i])
+        batch->count = first_op[i];
+    }
+    first_op[count] = batch->count;
+
+    sn_batch_submit(batch);
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    const char *watch_dir = items[i]->watch ? ingest->watch_dir : NULL;
+
+    published[i] = batch != NULL && added[i];
+    for (size_t op = first_op[i]; published[i] && op < first_op[i + 1]; op++)
+      published[i] = batch->ops[op].result == 0;
+
+    int result = 0;
+    if (!published[i]) {
+      result = publish_file(ingest->upload_dir, watch_dir, ingest->export_dir,
+                            ingest->shards, items[i]->name);
+      published[i] = result == 0;
+    }
+
+    // "watch" is done, unless its publish failed
+
+    watched[i] = watch_dir != NULL && result != -1;
+  }
+
+  if (ingest->journal != NULL) {
+    sync_dirs(ingest->watch_dir, ingest->export_dir);
+    journal_files(ingest, SN_JOURNAL_WATCH, items, watched, count,
+                  ingest->export_dir == NULL);
+    if (ingest->export_dir != NULL)
+      journal_files(ingest, SN_JOURNAL_EXPORT, items, published, count, true);
+  }
+
+  // Delete the published files from "upload"
+
+  if (batch != NULL) {
+    sn_batch_reset(batch);
+    for (size_t i = 0; i < count; i++) {
+      if (!published[i])
+        continue;
+      snprintf(from, sizeof(from), "%s/%s", ingest->upload_dir,
+               items[i]->name);
+      sn_batch_add_unlink(batch, from, false);
+    }
+    sn_batch_submit(batch);
+  } else {
+    for (size_t i = 0; i < count; i++) {
+      if (published[i])
+        sn_file_delete(ingest->upload_dir, items[i]->name);
+    }
+  }
+
+  if (ingest->journal != NULL)
+    journal_files(ingest, SN_JOURNAL_REMOVED, items, published, count, false);
+
+  for (size_t i = 0; i < count; i++)
+    atomic_fetch_add(published[i] ? &ingest->published : &ingest->failed, 1);
+
+  // Keep the names of the files published somewhere
+
+  if (ingest->kept != NULL) {
+    pthread_mutex_lock(&ingest->kept_lock);
+    for (size_t i = 0; i < count; i++)
+      if (published[i] && ((items[i]->watch && ingest->watch_dir != NULL) ||
+                           ingest->export_dir != NULL))
+        cn_multistr_append(ingest->kept, items[i]->name);
+    pthread_mutex_unlock(&ingest->kept_lock);
+  }
+}
+
+static void *sn_ingest_worker(void *arg) {
+  Ingest *ingest = arg;
+  INGEST_ITEM *items[SN_INGEST_BATCH_FILES];
+  bool stopping = false;
+
+  Batch batch;
+  bool batched = sn_batch_init(&batch, SN_INGEST_BATCH_FILES * 3) == 0;
+  size_t max_files = batched ? SN_INGEST_BATCH_FILES : 1;
+
+  while (!stopping) {
+    while (sem_wait(&ingest->items) == -1 && errno == EINTR)
+      ;
+
+    void *item;
+    size_t count = 0;
+    if (cn_queue_pop(&ingest->queue, &item) != 0) {
+      if (atomic_load(&ingest->stop))
+        break;
+      continue;
+    }
+    items[count++] = item;
+
+    // Take more of the queued files, without waiting
+
+    while (count < max_files && sem_trywait(&ingest->items) == 0) {
+      if (cn_queue_pop(&ingest->queue, &item) != 0) {
+        stopping = atomic_load(&ingest->stop);
+        break;
+      }
+      items[count++] = item;
+    }
+
+    sn_ingest_batch(ingest, batched ? &batch : NULL, items, count);
+
+    for (size_t i = 0; i < count; i++)
+      free(items[i]);
+
+    // Last pending files, wake up sn_ingest_drain
+
+    if (atomic_fetch_sub(&ingest->pending, count) == count) {
+      pthread_mutex_lock(&ingest->idle_lock);
+      pthread_cond_broadcast(&ingest->idle);
+      pthread_mutex_unlock(&ingest->idle_lock);
+    }
+  }
+
+  if (batched)
+    sn_batch_free(&batch);
+  return NULL;
+}
+
+/**
+ * Start the worker pool
+ *
+ * @param  shards       layout of "watch" and "export", see sn_shard.h
+ * @param  journal      ingest journal, NULL for none
+ * @param  num_workers  1 .. SN_INGEST_MAX_WORKERS
+ * @return  0 success
+ *         -1 invalid number of workers
+ *         -2 could not create the queue
+ *         -3 could not create the worker threads
+ */
+int sn_ingest_start(Ingest *ingest, const char *upload_dir,
+                    const char *watch_dir, const char *export_dir,
+                    int shards, Journal *journal, size_t num_workers) {
+  if (num_workers < 1 || num_workers > SN_INGEST_MAX_WORKERS) {
+    cn_log_msg(LOG_ERR, __func__, "Invalid number of workers -> %zu <-",
+               num_workers);
+    return -1;
+  }
+
+  ingest->upload_dir = upload_dir;
+  ingest->watch_dir = watch_dir;
+  ingest->export_dir = export_dir;
+  ingest->shards = shards;
+  ingest->journal = journal;
+
+  if (cn_queue_init(&ingest->queue, SN_INGEST_QUEUE_CAPACITY) != 0)
+    return -2;
+
+  sem_init(&ingest->items, 0, 0);
+  pthread_mutex_init(&ingest->idle_lock, NULL);
+  pthread_cond_init(&ingest->idle, NULL);
+  atomic_init(&ingest->pending, 0);
+  atomic_init(&ingest->published, 0);
+  atomic_init(&ingest->failed, 0);
+  atomic_init(&ingest->stop, false);
+  pthread_mutex_init(&ingest->kept_lock, NULL);
+  ingest->kept = NULL;
+
+  ingest->workers = calloc(num_workers, sizeof(pthread_t));
+  ingest->num_workers = 0;
+  if (ingest->workers == NULL) {
+    sn_ingest_stop(ingest);
+    return -3;
+  }
+
+  for (size_t i = 0; i < num_workers; i++) {
+    int result =
+        pthread_create(&ingest->workers[i], NULL, sn_ingest_worker, ingest);
+    if (result != 0) {
+      cn_log_msg(LOG_ERR, __func__,
+                 "Could not create worker thread -> %zu <-, error -> %s <-", i,
+                 strerror(result));
+      sn_ingest_stop(ingest);
+      return -3;
+    }
+    ingest->num_workers++;
+  }
+
+  cn_log_msg(LOG_INFO, __func__, "Started -> %zu <- ingest workers",
+             num_workers);
+  return 0;
+}
+
+/**
+ * Keep the names of the files published from now on, in "names". Read it
+ * only when drained, as workers append to it
+ *
+ * @param  names  NULL to stop keeping them
+ */
+void sn_ingest_keep_published(Ingest *ingest, MultiString *names) {
+  pthread_mutex_lock(&ingest->kept_lock);
+  ingest->kept = names;
+  pthread_mutex_unlock(&ingest->kept_lock);
+}
+
+/**
+ * Submit a file name from the "upload" dir. When the queue is full, this
+ * waits for the workers to make room
+ *
+ * @param  watch  false to publish to "export" only
+ * @return  0 success
+ *         -1 could not copy the file name
+ */
+static int submit(Ingest *ingest, const char *file_name, bool watch) {
+  size_t length = strlen(file_name) + 1;
+  INGEST_ITEM *item = malloc(sizeof(INGEST_ITEM) + length);
+  if (item == NULL) {
+    cn_log_msg(LOG_ERR, __func__, "Could not copy file name -> %s <-",
+               file_name);
+    return -1;
+  }
+  item->watch = watch;
+  memcpy(item->name, file_name, length);
+
+  atomic_fetch_add(&ingest->pending, 1);
+
+  while (cn_queue_push(&ingest->queue, item) != 0)
+    cn_time_sleep_millis(1);
+
+  sem_post(&ingest->items);
+  return 0;
+}
+
+/**
+ * Submit a file name from the "upload" dir, to publish to "watch" and
+ * "export"
+ *
+ * @return  0 success
+ *         -1 could not copy the file name
+ */
+int sn_ingest_submit(Ingest *ingest, const char *file_name) {
+  return submit(ingest, file_name, true);
+}
+
+/**
+ * Submit a file name from the "upload" dir, to publish to "export" only.
+ * With "export" disabled, it is just removed from "upload"
+ *
+ * @return  0 success
+ *         -1 could not copy the file name
+ */
+int sn_ingest_submit_export(Ingest *ingest, const char *file_name) {
+  return submit(ingest, file_name, false);
+}
+
+/**
+ * Wait until every submitted file has been processed
+ */
+void sn_ingest_drain(Ingest *ingest) {
+  pthread_mutex_lock(&ingest->idle_lock);
+  while (atomic_load(&ingest->pending) > 0)
+    pthread_cond_wait(&ingest->idle, &ingest->idle_lock);
+  pthread_mutex_unlock(&ingest->idle_lock);
+}
+
+/**
+ * Drain, then stop and join the workers, and free the queue
+ */
+void sn_ingest_stop(Ingest *ingest) {
+  sn_ingest_drain(ingest);
+
+  atomic_store(&ingest->stop, true);
+  for (size_t i = 0; i < ingest->num_workers; i++)
+    sem_post(&ingest->items);
+
+  for (size_t i = 0; i < ingest->num_workers; i++)
+    pthread_join(ingest->workers[i], NULL);
+
+  free(ingest->workers);
+  ingest->workers = NULL;
+  ingest->num_workers = 0;
+
+  pthread_cond_destroy(&ingest->idle);
+  pthread_mutex_destroy(&ingest->idle_lock);
+  pthread_mutex_destroy(&ingest->kept_lock);
+  sem_destroy(&ingest->items);
+  cn_queue_free(&ingest->queue);
+}
@@ -0,0 +1,316 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "sn_journal.h"
+#include "cn_log.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Records                                                        |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+/**
+ * FNV-1a of a record's state and name
+ */
+static uint32_t record_check(const JournalRecord *record) {
+  uint32_t hash = 2166136261u;
+  const unsigned char *state = (const unsigned char *)&record->state;
+  for (size_t i = 0; i < sizeof(record->state); i++)
+    hash = (hash ^ state[i]) * 16777619u;
+  for (size_t i = 0; i < SN_JOURNAL_NAME_LENGTH_D; i++)
+    hash = (hash ^ (unsigned char)record->name[i]) * 16777619u;
+  return hash;
+}
+
+static bool record_valid(const JournalRecord *record) {
+  return record->magic == SN_JOURNAL_MAGIC &&
+         record->state >= SN_JOURNAL_STAGED &&
+         record->state <= SN_JOURNAL_REMOVED &&
+         record->name[SN_JOURNAL_NAME_LENGTH] == '\0' &&
+         record->check == record_check(record);
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Journal                                                        |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+/**
+ * Open the journal for appending. Any records already in it are kept, so
+ * replay them first, then sn_journal_reset
+ *
+ * @return  0 success
+ *         -1 could not open the journal file
+ */
+int sn_journal_open(Journal *journal, const char *path) {
+  memset(journal, 0, sizeof(*journal));
+
+  journal->fd = open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC,
+                     S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP);
+  if (journal->fd == -1) {
+    cn_log_msg(LOG_ERR, __func__,
+               "'open' gave error for journal -> %s <-, "
+               "strerror(errno) -> %m <-",
+               path);
+    return -1;
+  }
+
+  pthread_mutex_init(&journal->append_lock, NULL);
+  pthread_mutex_init(&journal->commit_lock, NULL);
+  return 0;
+}
+
+/**
+ * Commit any appended records, and close the journal
+ */
+void sn_journal_close(Journal *journal) {
+  sn_journal_commit(journal, journal->appended);
+  close(journal->fd);
+  free(journal->buffer);
+  journal->buffer = NULL;
+  pthread_mutex_destroy(&journal->append_lock);
+  pthread_mutex_destroy(&journal->commit_lock);
+}
+
+/**
+ * Append a record, it is not durable until committed
+ *
+ * @param state  SN_JOURNAL_STAGED .. SN_JOURNAL_REMOVED
+ *
+ * @return  > 0 sequence number of the record, to commit up to
+ *            0 not appended, name too long or could not allocate
+ */
+uint64_t sn_journal_append(Journal *journal, int state, const char *name) {
+  if (strlen(name) > SN_JOURNAL_NAME_LENGTH) {
+    cn_log_msg(LOG_WARNING, __func__, "Name too long to journal -> %s <-",
+               name);
+    return 0;
+  }
+
+  pthread_mutex_lock(&journal->append_lock);
+
+  if (journal->count == journal->capacity) {
+    size_t capacity = journal->capacity == 0 ? 64 : journal->capacity * 2;
+    JournalRecord *buffer =
+        realloc(journal->buffer, capacity * sizeof(JournalRecord));
+    if (buffer == NULL) {
+      pthread_mutex_unlock(&journal->append_lock);
+      cn_log_msg(LOG_ERR, __func__, "Could not grow journal buffer");
+      return 0;
+    }
+    journal->buffer = buffer;
+    journal->capacity = capacity;
+  }
+
+  JournalRecord *record = &journal->buffer[journal->count++];
+  memset(record, 0, sizeof(*record));
+  record->magic = SN_JOURNAL_MAGIC;
+  record->state = (uint32_t)state;
+  strcpy(record->name, name);
+  record->check = record_check(record);
+
+  uint64_t seq = ++journal->appended;
+  pthread_mutex_unlock(&journal->append_lock);
+  return seq;
+}
+
+static int write_all(int fd, const void *buf, size_t len) {
+  const char *pos = buf;
+  while (len > 0) {
+    ssize_t written = write(fd, pos, len);
+    if (written == -1) {
+      if (errno == EINTR)
+        continue;
+      return -1;
+    }
+    pos += written;
+    len -= (size_t)written;
+  }
+  return 0;
+}
+
+/**
+ * Make every record up to "seq" durable. Records appended by other workers
+ * are written and synced with them, and a worker whose records were made
+ * durable by another's commit returns without syncing
+ *
+ * @param seq  from sn_journal_append, 0 does nothing
+ *
+ * @return  0 success
+ *         -1 error writing or syncing the journal
+ */
+int sn_journal_commit(Journal *journal, uint64_t seq) {
+  if (seq == 0)
+    return 0;
+
+  pthread_mutex_lock(&journal->commit_lock);
+  if (journal->durable >= seq) {
+    pthread_mutex_unlock(&journal->commit_lock);
+    return 0;
+  }
+
+  // Take the buffer, so appends carry on while this write syncs
+
+  pthread_mutex_lock(&journal->append_lock);
+  JournalRecord *records = journal->buffer;
+  size_t count = journal->count;
+  uint64_t last = journal->appended;
+  journal->buffer = NULL;
+  journal->count = 0;
+  journal->capacity = 0;
+  pthread_mutex_unlock(&journal->append_lock);
+
+  int result = 0;
+  if (count > 0 &&
+      (write_all(journal->fd, records, count * sizeof(JournalRecord)) != 0 ||
+       fdatasync(journal->fd) != 0)) {
+    cn_log_msg(LOG_ERR, __func__,
+               "Error writing journal, strerror(errno) -> %m <-");
+    result = -1;
+  }
+  free(records);
+
+  journal->durable = last;
+  pthread_mutex_unlock(&journal->commit_lock);
+  return result;
+}
+
+/**
+ * Empty the journal, when no file is part way through ingest
+ *
+ * @return  0 success
+ *         -1 could not truncate the journal
+ */
+int sn_journal_reset(Journal *journal) {
+  pthread_mutex_lock(&journal->commit_lock);
+  pthread_mutex_lock(&journal->append_lock);
+
+  journal->count = 0;
+  journal->durable = journal->appended;
+  int result = ftruncate(journal->fd, 0);
+
+  pthread_mutex_unlock(&journal->append_lock);
+  pthread_mutex_unlock(&journal->commit_lock);
+
+  if (result != 0) {
+    cn_log_msg(LOG_ERR, __func__,
+               "'ftruncate' gave error for journal, strerror(errno) -> %m <-");
+    return -1;
+  }
+  return 0;
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Replay                                                         |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+typedef struct {
+  const JournalRecord *record;
+  size_t order;
+} ReplayItem;
+
+static int compare_items(const void *a, const void *b) {
+  const ReplayItem *item_a = a;
+  const ReplayItem *item_b = b;
+  int result = strcmp(item_a->record->name, item_b->record->name);
+  if (result != 0)
+    return result;
+  return item_a->order < item_b->order ? -1 : item_a->order > item_b->order;
+}
+
+/**
+ * Call fn with the last state of each file in a journal, that did not
+ * reach SN_JOURNAL_REMOVED. Reading stops at the first invalid record, as
+ * a torn write can only be at the end
+ *
+ * @return  >= 0 number of files passed to fn
+ *          -1 could not read the journal, a missing journal is 0 files
+ *          -2 could not allocate
+ */
+int sn_journal_replay(const char *path, JournalReplayFn fn, void *arg) {
+  FILE *file = fopen(path, "rb");
+  if (file == NULL)
+    return errno == ENOENT ? 0 : -1;
+
+  JournalRecord *records = NULL;
+  size_t count = 0;
+  size_t capacity = 0;
+  JournalRecord record;
+
+  while (fread(&record, sizeof(record), 1, file) == 1 &&
+         record_valid(&record)) {
+    if (count == capacity) {
+      capacity = capacity == 0 ? 256 : capacity * 2;
+      JournalRecord *grown = realloc(records, capacity * sizeof(record));
+      if (grown == NULL) {
+        free(records);
+        fclose(file);
+        return -2;
+      }
+      records = grown;
+    }
+    records[count++] = record;
+  }
+  fclose(file);
+
+  ReplayItem *items = malloc((count > 0 ? count : 1) * sizeof(ReplayItem));
+  if (items == NULL) {
+    free(records);
+    return -2;
+  }
+  for (size_t i = 0; i < count; i++) {
+    items[i].record = &records[i];
+    items[i].order = i;
+  }
+  qsort(items, count, sizeof(ReplayItem), compare_items);
+
+  // The last record of each name, is its state
+
+  int files = 0;
+  for (size_t i = 0; i < count; i++) {
+    bool last = i + 1 == count ||
+                strcmp(items[i].record->name, items[i + 1].record->name) != 0;
+    if (last && items[i].record->state != SN_JOURNAL_REMOVED) {
+      fn(items[i].record->name, (int)items[i].record->state, arg);
+      files++;
+    }
+  }
+
+  free(items);
+  free(records);
+  return files;
+}
@@ -0,0 +1,312 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "sn_metrics.h"
+#include "cn_log.h"
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define METRICS_INITIAL_CAPACITY 16
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Rules                                                          |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+/**
+ * Copy the next space separated field of "*p" to "dest", moving "*p" past
+ * it
+ *
+ * @return  0 success
+ *         -1 no field, or it does not fit
+ */
+static int next_field(const char **p, char *dest, size_t dest_sz) {
+  while (isspace((unsigned char)**p))
+    (*p)++;
+
+  size_t len = 0;
+  while ((*p)[len] != '\0' && !isspace((unsigned char)(*p)[len]))
+    len++;
+
+  if (len == 0 || len >= dest_sz)
+    return -1;
+
+  memcpy(dest, *p, len);
+  dest[len] = '\0';
+  *p += len;
+  return 0;
+}
+
+static bool valid_name(const char *name) {
+  for (const char *p = name; *p != '\0'; p++) {
+    if (!isalnum((unsigned char)*p) && *p != '_' && *p != '.' && *p != '-')
+      return false;
+  }
+  return true;
+}
+
+/**
+ * Parse a line of a rules file
+ *
+ * @return  0 a rule, to free with the rules it is added to
+ *          1 blank or comment line
+ *         -1 not a valid rule
+ */
+int sn_metrics_parse_rule(const char *line, MetricRule *rule) {
+  memset(rule, 0, sizeof(*rule));
+
+  const char *p = line;
+  while (isspace((unsigned char)*p))
+    p++;
+  if (*p == '\0' || *p == '#')
+    return 1;
+
+  char kind[8];
+  if (next_field(&p, rule->checkid, sizeof(rule->checkid)) != 0 ||
+      next_field(&p, rule->name, sizeof(rule->name)) != 0 ||
+      next_field(&p, kind, sizeof(kind)) != 0 || !valid_name(rule->name))
+    return -1;
+
+  // The rest of the line, less surrounding space
+
+  while (isspace((unsigned char)*p))
+    p++;
+  size_t len = strlen(p);
+  while (len > 0 && isspace((unsigned char)p[len - 1]))
+    len--;
+  if (len == 0 || len >= sizeof(rule->key))
+    return -1;
+
+  char rest[SN_FILE_MAX_BODY_LENGTH + 1];
+  memcpy(rest, p, len);
+  rest[len] = '\0';
+
+  if (strcmp(kind, "key") == 0) {
+    rule->kind = SN_METRICS_RULE_KEY;
+    strcpy(rule->key, rest);
+    return 0;
+  }
+
+  if (strcmp(kind, "regex") == 0) {
+    rule->kind = SN_METRICS_RULE_REGEX;
+    if (regcomp(&rule->regex, rest, REG_EXTENDED) != 0)
+      return -1;
+    if (rule->regex.re_nsub < 1) {
+      regfree(&rule->regex);
+      return -1;
+    }
+    return 0;
+  }
+
+  return -1;
+}
+
+/**
+ * Load the rules of a rules file, an invalid rule is logged and skipped
+ *
+ * @return >=0 number of rules
+ *         -1 could not open the file
+ *         -2 could not allocate
+ */
+int sn_metrics_load(MetricRules *rules, const char *path) {
+  memset(rules, 0, sizeof(*rules));
+
+  FILE *file = fopen(path, "r");
+  if (file == NULL)
+    return -1;
+
+  char *line = NULL;
+  size_t line_sz = 0;
+  size_t line_no = 0;
+  int result = 0;
+
+  while (getline(&line, &line_sz, file) > 0) {
+    line_no++;
+
+    MetricRule rule;
+    int parsed = sn_metrics_parse_rule(line, &rule);
+    if (parsed == 1)
+      continue;
+    if (parsed != 0) {
+      cn_log_msg(LOG_WARNING, __func__,
+                 "Invalid metrics rule, line -> %zu <- of -> %s <-", line_no,
+                 path);
+      continue;
+    }
+
+    if (rules->count == rules->capacity) {
+      size_t capacity = rules->capacity == 0 ? METRICS_INITIAL_CAPACITY
+                                             : rules->capacity * 2;
+      MetricRule *grown = realloc(rules->rules, capacity * sizeof(MetricRule));
+      if (grown == NULL) {
+        if (rule.kind == SN_METRICS_RULE_REGEX)
+          regfree(&rule.regex);
+        result = -2;
+        break;
+      }
+      rules->rules = grown;
+      rules->capacity = capacity;
+    }
+    rules->rules[rules->count++] = rule;
+  }
+
+  free(line);
+  fclose(file);
+
+  if (result != 0) {
+    sn_metrics_free(rules);
+    return result;
+  }
+  return (int)rules->count;
+}
+
+void sn_metrics_free(MetricRules *rules) {
+  for (size_t i = 0; i < rules->count; i++) {
+    if (rules->rules[i].kind == SN_METRICS_RULE_REGEX)
+      regfree(&rules->rules[i].regex);
+  }
+  free(rules->rules);
+  rules->rules = NULL;
+  rules->count = 0;
+  rules->capacity = 0;
+}
+
+static bool rule_applies(const MetricRule *rule, const char *checkid) {
+  return strcmp(rule->checkid, "*") == 0 ||
+         strcmp(rule->checkid, checkid) == 0;
+}
+
+/**
+ * Whether any rule applies to results of "checkid", so its results need
+ * reading
+ */
+bool sn_metrics_applies(const MetricRules *rules, const char *checkid) {
+  for (size_t i = 0; i < rules->count; i++) {
+    if (rule_applies(&rules->rules[i], checkid))
+      return true;
+  }
+  return false;
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Extract                                                        |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+/**
+ * Parse a value, a number with an optional K, M, G, T or P suffix
+ *
+ * @return  0 success
+ *         -1 not a number
+ */
+int sn_metrics_parse_value(const char *text, double *value) {
+  char *end = NULL;
+  double number = strtod(text, &end);
+  if (end == text || !isfinite(number))
+    return -1;
+
+  const char *suffix = *end != '\0' ? strchr("KMGTP", *end) : NULL;
+  if (suffix != NULL) {
+    for (const char *p = "KMGTP"; p <= suffix; p++)
+      number *= 1024.0;
+  }
+
+  *value = number;
+  return 0;
+}
+
+/**
+ * Value of "line" for a rule, if it matches
+ *
+ * @return  0 matched, "value" set
+ *         -1 no match
+ */
+static int match_line(const MetricRule *rule, const char *line,
+                      double *value) {
+  if (rule->kind == SN_METRICS_RULE_KEY) {
+    size_t key_len = strlen(rule->key);
+    if (strncmp(line, rule->key, key_len) != 0)
+      return -1;
+    const char *p = line + key_len;
+    while (*p == ' ' || *p == '\t')
+      p++;
+    if (*p != ':' && *p != '=')
+      return -1;
+    return sn_metrics_parse_value(p + 1, value);
+  }
+
+  regmatch_t match[2];
+  if (regexec(&rule->regex, line, 2, match, 0) != 0 || match[1].rm_so < 0)
+    return -1;
+
+  char text[SN_FILE_MAX_BODY_LENGTH + 1];
+  size_t len = (size_t)(match[1].rm_eo - match[1].rm_so);
+  memcpy(text, line + match[1].rm_so, len);
+  text[len] = '\0';
+  return sn_metrics_parse_value(text, value);
+}
+
+/**
+ * Apply the rules for the CheckID of a result to its body, calling "fn"
+ * for each point
+ *
+ * @return  number of points
+ */
+int sn_metrics_extract(const MetricRules *rules, const FILE_DATA *file_data,
+                       MetricPointFn fn, void *arg) {
+  int points = 0;
+
+  for (size_t r = 0; r < rules->count; r++) {
+    const MetricRule *rule = &rules->rules[r];
+    if (!rule_applies(rule, file_data->header.checkid))
+      continue;
+
+    for (size_t i = 0; i < file_data->body_lines; i++) {
+
+      // Lines are read padded with spaces, take them off for anchors
+
+      char line[SN_FILE_MAX_BODY_LENGTH + 1];
+      strcpy(line, file_data->body[i]);
+      size_t len = strlen(line);
+      while (len > 0 && line[len - 1] == ' ')
+        line[--len] = '\0';
+
+      double value;
+      if (match_line(rule, line, &value) == 0) {
+        fn(rule->name, value, arg);
+        points++;
+        break;
+      }
+    }
+  }
+
+  return points;
+}
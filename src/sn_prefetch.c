@@ -0,0 +1,229 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "sn_prefetch.h"
+#include "cn_log.h"
+#include "cn_time.h"
+#include "sn_cname.h"
+#include "sn_shard.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Worker                                                         |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+/**
+ * Read and parse a file into its slot, "ok" only when it is read
+ */
+static void read_slot(const Prefetch *prefetch, PrefetchSlot *slot,
+                      const char *name) {
+  CName cname;
+
+  slot->ok = strlen(name) < sizeof(slot->name) &&
+             sn_cname_parse_name(name, &cname) == CNAME_PARSE_OK &&
+             sn_shard_path(prefetch->dir, name, prefetch->shards, slot->path,
+                           sizeof(slot->path)) == 0 &&
+             sn_file_read(slot->path, &slot->data) == 0;
+
+  if (!slot->ok) {
+    cn_log_msg(LOG_DEBUG, __func__,
+               "Dropping file not read -> %s <-, strerror(errno) -> %m <-",
+               name);
+    return;
+  }
+
+  strcpy(slot->name, name);
+  slot->expires = cname.epoch.bin;
+  slot->read_at = time(NULL);
+}
+
+/**
+ * Read the files of the list in order, keeping at most "depth" read ahead
+ * of the one taken last
+ */
+static void *prefetch_worker(void *arg) {
+  Prefetch *prefetch = arg;
+
+  pthread_mutex_lock(&prefetch->lock);
+  while (!prefetch->stop && prefetch->read_next < prefetch->count) {
+    if (prefetch->read_next - prefetch->take_next >= prefetch->depth) {
+      pthread_cond_wait(&prefetch->space, &prefetch->lock);
+      continue;
+    }
+
+    // The slot is not seen by the taker, until "read_next" passes it
+
+    size_t i = prefetch->read_next;
+    PrefetchSlot *slot = &prefetch->slots[i % (prefetch->depth + 1)];
+    const char *name = cn_multistr_getstr(prefetch->names, i);
+    pthread_mutex_unlock(&prefetch->lock);
+
+    read_slot(prefetch, slot, name);
+
+    pthread_mutex_lock(&prefetch->lock);
+    prefetch->read_next++;
+    pthread_cond_signal(&prefetch->ready);
+  }
+  pthread_mutex_unlock(&prefetch->lock);
+  return NULL;
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Start / next / stop                                            |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+/**
+ * Start reading ahead the files "names" of "dir", in that order. "names"
+ * must not change until sn_prefetch_stop
+ *
+ * @return  0 success
+ *         -1 invalid dir or depth
+ *         -2 could not allocate the ring
+ *         -3 could not start the worker
+ */
+int sn_prefetch_start(Prefetch *prefetch, const char *dir, int shards,
+                      MultiString *names, size_t depth) {
+  memset(prefetch, 0, sizeof(*prefetch));
+
+  if (depth < 1 || depth > SN_PREFETCH_MAX_DEPTH ||
+      strlen(dir) >= sizeof(prefetch->dir)) {
+    cn_log_msg(LOG_ERR, __func__, "Invalid dir -> %s <-, depth -> %zu <-",
+               dir, depth);
+    return -1;
+  }
+
+  strcpy(prefetch->dir, dir);
+  prefetch->shards = shards;
+  prefetch->names = names;
+  prefetch->count = names->num_strings;
+  prefetch->depth = depth;
+  prefetch->recheck_secs = SN_PREFETCH_RECHECK_SECS;
+
+  prefetch->slots = calloc(depth + 1, sizeof(PrefetchSlot));
+  if (prefetch->slots == NULL) {
+    cn_log_msg(LOG_ERR, __func__,
+               "Calloc error for -> %zu <- slots, strerror(errno) -> %m <-",
+               depth + 1);
+    return -2;
+  }
+
+  pthread_mutex_init(&prefetch->lock, NULL);
+  pthread_cond_init(&prefetch->ready, NULL);
+  pthread_cond_init(&prefetch->space, NULL);
+
+  int result =
+      pthread_create(&prefetch->worker, NULL, prefetch_worker, prefetch);
+  if (result != 0) {
+    errno = result;
+    cn_log_msg(LOG_ERR, __func__,
+               "'pthread_create' failed, strerror(errno) -> %m <-");
+    pthread_cond_destroy(&prefetch->space);
+    pthread_cond_destroy(&prefetch->ready);
+    pthread_mutex_destroy(&prefetch->lock);
+    free(prefetch->slots);
+    prefetch->slots = NULL;
+    return -3;
+  }
+  return 0;
+}
+
+/**
+ * A file read, is still to be shown, when not expired since, and, once
+ * read a while ago, still there
+ */
+static bool still_there(const Prefetch *prefetch, const PrefetchSlot *slot) {
+  if (cn_time_epoch_expired((long)slot->expires))
+    return false;
+  if (time(NULL) - slot->read_at < prefetch->recheck_secs)
+    return true;
+  return access(slot->path, F_OK) == 0;
+}
+
+/**
+ * Take the next file to show, waiting for it to be read. It is kept until
+ * the next call, files dropped being skipped
+ *
+ * @return  0 success, "name" and "data" set
+ *          1 no more files
+ */
+int sn_prefetch_next(Prefetch *prefetch, const char **name,
+                     FILE_DATA **data) {
+  pthread_mutex_lock(&prefetch->lock);
+
+  while (prefetch->take_next < prefetch->count) {
+    while (prefetch->take_next == prefetch->read_next)
+      pthread_cond_wait(&prefetch->ready, &prefetch->lock);
+
+    PrefetchSlot *slot =
+        &prefetch->slots[prefetch->take_next % (prefetch->depth + 1)];
+    prefetch->take_next++;
+    pthread_cond_signal(&prefetch->space);
+    pthread_mutex_unlock(&prefetch->lock);
+
+    // Checked unlocked, the worker leaves the slot taken last alone
+
+    if (slot->ok && still_there(prefetch, slot)) {
+      *name = slot->name;
+      *data = &slot->data;
+      return 0;
+    }
+
+    if (slot->ok)
+      cn_log_msg(LOG_DEBUG, __func__, "Dropping file deleted -> %s <-",
+                 slot->name);
+    pthread_mutex_lock(&prefetch->lock);
+  }
+
+  pthread_mutex_unlock(&prefetch->lock);
+  return 1;
+}
+
+/**
+ * Stop the worker, and free the ring
+ */
+void sn_prefetch_stop(Prefetch *prefetch) {
+  if (prefetch->slots == NULL)
+    return;
+
+  pthread_mutex_lock(&prefetch->lock);
+  prefetch->stop = true;
+  pthread_cond_broadcast(&prefetch->space);
+  pthread_mutex_unlock(&prefetch->lock);
+
+  pthread_join(prefetch->worker, NULL);
+  pthread_cond_destroy(&prefetch->space);
+  pthread_cond_destroy(&prefetch->ready);
+  pthread_mutex_destroy(&prefetch->lock);
+  free(prefetch->slots);
+  prefetch->slots = NULL;
+}
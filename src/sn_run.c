@@ -0,0 +1,415 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "sn_run.h"
+#include "cn_log.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Discover checks                                                |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+static int compare_checks(const void *a, const void *b) {
+  return strcmp(((const RunCheck *)a)->script, ((const RunCheck *)b)->script);
+}
+
+/**
+ * CheckID of a script: its path under the run dir, less any extension
+ */
+static void set_checkid(RunCheck *check, const char *relative) {
+  snprintf(check->checkid, sizeof(check->checkid), "%s", relative);
+
+  char *dot = strrchr(check->checkid, '.');
+  char *slash = strrchr(check->checkid, '/');
+  if (dot != NULL && dot != check->checkid && (slash == NULL || dot > slash))
+    *dot = '\0';
+}
+
+/**
+ * Add the executable files under "dir", "relative" being its path under
+ * the run dir ("" for the run dir itself)
+ */
+static int discover_dir(Run *run, const char *dir, const char *relative,
+                        size_t *capacity) {
+  DIR *d = opendir(dir);
+  if (d == NULL) {
+    cn_log_msg(LOG_ERR, __func__,
+               "'opendir' gave error for dir -> %s <-, strerror(errno) -> "
+               "%m <-",
+               dir);
+    return -1;
+  }
+
+  int result = 0;
+  struct dirent *entry;
+
+  while (result == 0 && (entry = readdir(d)) != NULL) {
+    if (entry->d_name[0] == '.')
+      continue;
+
+    char path[SN_RUN_PATH_LENGTH_D];
+    char sub_relative[SN_RUN_PATH_LENGTH_D];
+    int written = snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+    int sub_written =
+        relative[0] == '\0'
+            ? snprintf(sub_relative, sizeof(sub_relative), "%s", entry->d_name)
+            : snprintf(sub_relative, sizeof(sub_relative), "%s/%s", relative,
+                       entry->d_name);
+    if (written < 0 || (size_t)written >= sizeof(path) || sub_written < 0 ||
+        (size_t)sub_written >= sizeof(sub_relative))
+      continue;
+
+    struct stat st;
+    if (stat(path, &st) != 0)
+      continue;
+
+    if (S_ISDIR(st.st_mode)) {
+      result = discover_dir(run, path, sub_relative, capacity);
+      continue;
+    }
+
+    if (!S_ISREG(st.st_mode) || access(path, X_OK) != 0)
+      continue;
+
+    if (run->count == SN_RUN_MAX_CHECKS) {
+      cn_log_msg(LOG_WARNING, __func__,
+                 "More than -> %d <- checks, ignoring -> %s <-",
+                 SN_RUN_MAX_CHECKS, path);
+      continue;
+    }
+
+    if (run->count == *capacity) {
+      size_t new_capacity = *capacity == 0 ? 16 : *capacity * 2;
+      RunCheck *checks = realloc(run->checks, new_capacity * sizeof(RunCheck));
+      if (checks == NULL) {
+        result = -2;
+        break;
+      }
+      run->checks = checks;
+      *capacity = new_capacity;
+    }
+
+    RunCheck *check = &run->checks[run->count++];
+    memset(check, 0, sizeof(*check));
+    strcpy(check->script, path);
+    set_checkid(check, sub_relative);
+    check->status = SN_STATUS_ALRT;
+  }
+
+  closedir(d);
+  return result;
+}
+
+/**
+ * Find the checks under "dir", in order of path
+ *
+ * @return  0 success
+ *         -1 could not read a dir
+ *         -2 could not allocate
+ */
+int sn_run_discover(Run *run, const char *dir) {
+  size_t capacity = 0;
+  run->checks = NULL;
+  run->count = 0;
+
+  int result = discover_dir(run, dir, "", &capacity);
+  if (result != 0) {
+    sn_run_free(run);
+    return result;
+  }
+
+  if (run->count > 1)
+    qsort(run->checks, run->count, sizeof(RunCheck), compare_checks);
+  return 0;
+}
+
+void sn_run_free(Run *run) {
+  free(run->checks);
+  run->checks = NULL;
+  run->count = 0;
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Status and TTL                                                 |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+/**
+ * Status of a check's exit code, as sn_exit_with_message in
+ * examples/lib/sn1ff_lib.sh exits
+ */
+Status sn_run_status(int exit_code) {
+  switch (exit_code) {
+  case 0:
+    return SN_STATUS_OKAY;
+  case 1:
+    return SN_STATUS_NONE;
+  case 2:
+    return SN_STATUS_WARN;
+  default:
+    return SN_STATUS_ALRT;
+  }
+}
+
+/**
+ * TTL of a status, from the "client_ttls" config value:
+ *   <ALRT>,<WARN>,<OKAY>,<NONE>  minutes
+ *
+ * @return  >= 0 TTL in minutes
+ *          -1 invalid value, or status
+ */
+int sn_run_ttl(const char *ttls, Status status) {
+  static const Status ORDER[] = {SN_STATUS_ALRT, SN_STATUS_WARN,
+                                 SN_STATUS_OKAY, SN_STATUS_NONE};
+  const char *p = ttls;
+
+  for (size_t i = 0; i < sizeof(ORDER) / sizeof(ORDER[0]); i++) {
+    char *end = NULL;
+    long ttl = strtol(p, &end, 10);
+    if (end == p || ttl < 0 || (*end != ',' && *end != '\0'))
+      return -1;
+    if (ORDER[i] == status)
+      return (int)ttl;
+    if (*end == '\0')
+      return -1;
+    p = end + 1;
+  }
+
+  return -1;
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Run checks                                                     |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+static long monotonic_ms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/**
+ * Add a line to the end of a check's result
+ */
+static void append_line(const RunCheck *check, const char *line) {
+  FILE *file = fopen(check->file_path, "a");
+  if (file == NULL)
+    return;
+  fprintf(file, "\n%s\n", line);
+  fclose(file);
+}
+
+/**
+ * Begin the result file of a check, and start it writing to it. The check
+ * is started with the signal mask "mask", and SN_RUN_ENV and
+ * SN_RUN_FILE_ENV set, so it writes into this result file, and leaves it
+ * to the runner to send
+ *
+ * @return  0 started
+ *         -1 could not begin the result file, or start the check
+ */
+static int start_check(RunCheck *check, int timeout_secs,
+                       const sigset_t *mask) {
+  if (sn_file_begin(check->file_path, check->checkid) != 0) {
+    cn_log_msg(LOG_ERR, __func__, "Could not begin result file, for -> %s <-",
+               check->script);
+    check->file_path[0] = '\0';
+    return -1;
+  }
+
+  int output = open(check->file_path, O_WRONLY | O_APPEND | O_CLOEXEC);
+  if (output == -1) {
+    cn_log_msg(LOG_ERR, __func__,
+               "'open' gave error for -> %s <-, strerror(errno) -> %m <-",
+               check->file_path);
+    return -1;
+  }
+
+  pid_t pid = fork();
+  if (pid == -1) {
+    cn_log_msg(LOG_ERR, __func__,
+               "'fork' gave error, for -> %s <-, strerror(errno) -> %m <-",
+               check->script);
+    close(output);
+    append_line(check, "sn1ff: could not start check");
+    return -1;
+  }
+
+  if (pid == 0) {
+    // Own process group, so a timeout kills all it started
+
+    setpgid(0, 0);
+
+    int input = open("/dev/null", O_RDONLY);
+    if (input != -1)
+      dup2(input, STDIN_FILENO);
+    dup2(output, STDOUT_FILENO);
+    dup2(output, STDERR_FILENO);
+
+    sigprocmask(SIG_SETMASK, mask, NULL);
+    setenv(SN_RUN_ENV, "1", 1);
+    setenv(SN_RUN_FILE_ENV, check->file_path, 1);
+
+    execl(check->script, check->script, (char *)NULL);
+
+    dprintf(STDERR_FILENO, "sn1ff: could not run check -> %s <-\n",
+            check->script);
+    _exit(127);
+  }
+
+  // Also set here, so it is set before any kill
+
+  setpgid(pid, pid);
+  close(output);
+
+  check->pid = pid;
+  check->deadline = monotonic_ms() + (long)timeout_secs * 1000;
+  return 0;
+}
+
+/**
+ * Record the end of a check, and its status
+ */
+static void end_check(RunCheck *check, int wait_status, int timeout_secs) {
+  char line[128];
+
+  check->pid = 0;
+  check->wait_status = wait_status;
+
+  if (check->timed_out) {
+    check->status = SN_STATUS_ALRT;
+    snprintf(line, sizeof(line), "sn1ff: check timed out after %d seconds",
+             timeout_secs);
+    append_line(check, line);
+  } else if (WIFEXITED(wait_status)) {
+    check->status = sn_run_status(WEXITSTATUS(wait_status));
+  } else {
+    check->status = SN_STATUS_ALRT;
+    snprintf(line, sizeof(line), "sn1ff: check ended by signal %d",
+             WIFSIGNALED(wait_status) ? WTERMSIG(wait_status) : 0);
+    append_line(check, line);
+  }
+
+  cn_log_msg(LOG_DEBUG, __func__, "Check -> %s <- ended, status -> %d <-",
+             check->script, check->status);
+}
+
+/**
+ * Run the checks, up to "jobs" at once, each into its own result file
+ *
+ * A check that could not be started, has status ALRT, and a result file if
+ * one could be begun
+ *
+ * @param  jobs          1 .. SN_RUN_MAX_JOBS
+ * @param  timeout_secs  > 0, a check is killed after this long
+ * @return  0 success
+ *         -1 invalid jobs or timeout
+ */
+int sn_run_checks(Run *run, size_t jobs, int timeout_secs) {
+  if (jobs < 1 || jobs > SN_RUN_MAX_JOBS || timeout_secs <= 0)
+    return -1;
+
+  // SIGCHLD is blocked, so a check ending is waited for with sigtimedwait,
+  // rather than polled. Checks are started with the mask as it was
+
+  sigset_t child_mask;
+  sigset_t mask;
+  sigemptyset(&child_mask);
+  sigaddset(&child_mask, SIGCHLD);
+  sigprocmask(SIG_BLOCK, &child_mask, &mask);
+
+  size_t next = 0;
+  size_t running = 0;
+
+  while (next < run->count || running > 0) {
+    while (running < jobs && next < run->count) {
+      if (start_check(&run->checks[next], timeout_secs, &mask) == 0)
+        running++;
+      next++;
+    }
+
+    // Collect every check ended
+
+    int wait_status;
+    pid_t pid;
+    while ((pid = waitpid(-1, &wait_status, WNOHANG)) > 0) {
+      for (size_t i = 0; i < next; i++) {
+        if (run->checks[i].pid == pid) {
+          end_check(&run->checks[i], wait_status, timeout_secs);
+          running--;
+          break;
+        }
+      }
+    }
+
+    if (pid == -1 && errno == ECHILD)
+      running = 0;
+    if (running == 0 || (running < jobs && next < run->count))
+      continue;
+
+    // Kill checks past their deadline, then wait for a check to end, or
+    // the next deadline. A check killed is waited for, for up to a second
+
+    long now = monotonic_ms();
+    long wake = now + 1000;
+    for (size_t i = 0; i < next; i++) {
+      RunCheck *check = &run->checks[i];
+      if (check->pid <= 0 || check->timed_out)
+        continue;
+
+      if (now >= check->deadline) {
+        cn_log_msg(LOG_WARNING, __func__, "Check -> %s <- timed out",
+                   check->script);
+        kill(-check->pid, SIGKILL);
+        check->timed_out = true;
+      } else if (check->deadline < wake) {
+        wake = check->deadline;
+      }
+    }
+
+    long wait_ms = wake > now ? wake - now : 0;
+    struct timespec timeout = {wait_ms / 1000, (wait_ms % 1000) * 1000000};
+    sigtimedwait(&child_mask, NULL, &timeout);
+  }
+
+  sigprocmask(SIG_SETMASK, &mask, NULL);
+  return 0;
+}
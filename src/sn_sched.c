@@ -0,0 +1,86 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "sn_sched.h"
+#include "cn_hash.h"
+#include "cn_string.h"
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Splay of a schedule for a host, an offset into its period
+ *
+ * @param  period  in seconds, > 0
+ * @return  0 to period - 1 seconds
+ */
+long sn_sched_splay(const char *host, const char *dir, long period) {
+  uint64_t hash = cn_hash_xxh64(host, strlen(host), 0);
+  hash = cn_hash_xxh64(dir, strlen(dir), hash);
+  return (long)(hash % (uint64_t)period);
+}
+
+/**
+ * Next time after "now", a splay into a period
+ *
+ * Periods are counted from the epoch, so a daily schedule with a splay of
+ * an hour runs at 01:00 UTC each day
+ *
+ * @return  the earliest time > now, at splay seconds into a period
+ */
+time_t sn_sched_next(time_t now, long period, long splay) {
+  long into = (long)((now - splay) % period);
+  if (into < 0)
+    into += period;
+
+  return now - into + period;
+}
+
+/**
+ * Parse a schedule, "<period mins>:<checks dir>", from the agent_schedule
+ * config value, and set when it next runs
+ *
+ * @return  0 success
+ *         -1 invalid period
+ *         -2 invalid dir
+ */
+int sn_sched_parse(const char *value, const char *host, time_t now,
+                   Schedule *schedule) {
+  char *endptr = NULL;
+  long mins = strtol(value, &endptr, 10);
+  if (endptr == value || *endptr != ':' || mins < 1 ||
+      mins > SN_SCHED_PERIOD_MINS_MAX)
+    return -1;
+
+  const char *dir = endptr + 1;
+  if (*dir != '/' ||
+      cn_string_cp(schedule->dir, sizeof(schedule->dir), dir) != 0)
+    return -2;
+
+  schedule->period = mins * 60;
+  schedule->splay = sn_sched_splay(host, dir, schedule->period);
+  schedule->next = sn_sched_next(now, schedule->period, schedule->splay);
+  return 0;
+}
@@ -0,0 +1,251 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "sn_series.h"
+#include "cn_hash.h"
+#include "cn_log.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define SERIES_INITIAL_CAPACITY 1024
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Names                                                          |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+/**
+ * Name of a series, its parts joined by tabs, with any tab or newline in
+ * them made a space
+ */
+void sn_series_name(const char *const *parts, size_t num_parts, char *name,
+                    size_t name_sz) {
+  size_t len = 0;
+
+  for (size_t i = 0; i < num_parts; i++) {
+    if (i > 0 && len + 1 < name_sz)
+      name[len++] = '\t';
+    for (const char *p = parts[i]; *p != '\0' && len + 1 < name_sz; p++)
+      name[len++] = (*p == '\t' || *p == '\n') ? ' ' : *p;
+  }
+  name[len] = '\0';
+}
+
+static void series_path(const char *dir, char *path, size_t path_sz) {
+  snprintf(path, path_sz, "%s/%s", dir, SN_SERIES_FILE_NAME);
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Intern                                                         |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+/**
+ * Find the slot of "key", or the empty slot to put it in (linear probing)
+ */
+static SeriesSlot *find_slot(SeriesSlot *slots, size_t capacity,
+                             uint64_t key) {
+  size_t i = (size_t)key & (capacity - 1);
+  while (slots[i].key != 0 && slots[i].key != key)
+    i = (i + 1) & (capacity - 1);
+  return &slots[i];
+}
+
+static uint64_t series_key(const char *name) {
+  uint64_t key = cn_hash_xxh64(name, strlen(name), 0);
+  return key != 0 ? key : 1;
+}
+
+/**
+ * Add a series to the in memory table, as the next series id
+ *
+ * @return  0 success
+ *         -1 could not allocate
+ */
+static int add_series(SeriesTable *table, uint64_t key) {
+  if ((table->count + 1) * 2 > table->capacity) {
+    size_t capacity = table->capacity * 2;
+    SeriesSlot *slots = calloc(capacity, sizeof(SeriesSlot));
+    if (slots == NULL)
+      return -1;
+    for (size_t i = 0; i < table->capacity; i++) {
+      if (table->slots[i].key != 0)
+        *find_slot(slots, capacity, table->slots[i].key) = table->slots[i];
+    }
+    free(table->slots);
+    table->slots = slots;
+    table->capacity = capacity;
+  }
+
+  SeriesSlot *slot = find_slot(table->slots, table->capacity, key);
+  slot->key = key;
+  slot->series = table->count++;
+  return 0;
+}
+
+/**
+ * Open the series of the store in "dir", reading those interned so far
+ *
+ * @return  0 success
+ *         -1 could not open the "series" file
+ *         -2 could not allocate
+ */
+int sn_series_open(SeriesTable *table, const char *dir) {
+  memset(table, 0, sizeof(*table));
+
+  table->capacity = SERIES_INITIAL_CAPACITY;
+  table->slots = calloc(table->capacity, sizeof(SeriesSlot));
+  if (table->slots == NULL)
+    return -2;
+
+  char path[1024];
+  series_path(dir, path, sizeof(path));
+
+  FILE *file = fopen(path, "r");
+  if (file != NULL) {
+    char *line = NULL;
+    size_t line_sz = 0;
+    ssize_t len;
+    while ((len = getline(&line, &line_sz, file)) > 0) {
+      if (line[len - 1] == '\n')
+        line[len - 1] = '\0';
+      if (add_series(table, series_key(line)) != 0) {
+        free(line);
+        fclose(file);
+        sn_series_close(table);
+        return -2;
+      }
+    }
+    free(line);
+    fclose(file);
+  }
+
+  table->file = fopen(path, "a");
+  if (table->file == NULL) {
+    cn_log_msg(LOG_ERR, __func__,
+               "Could not open series -> %s <-, strerror(errno) -> %m <-",
+               path);
+    sn_series_close(table);
+    return -1;
+  }
+  return 0;
+}
+
+void sn_series_close(SeriesTable *table) {
+  if (table->file != NULL)
+    fclose(table->file);
+  free(table->slots);
+  table->file = NULL;
+  table->slots = NULL;
+  table->capacity = 0;
+  table->count = 0;
+}
+
+/**
+ * Series id of a name, interning it as the next id if it is new
+ *
+ * @return >=0 series id
+ *         -1 could not append it to the "series" file, or allocate
+ */
+int64_t sn_series_intern(SeriesTable *table, const char *name) {
+  uint64_t key = series_key(name);
+
+  SeriesSlot *slot = find_slot(table->slots, table->capacity, key);
+  if (slot->key == 0) {
+    if (fprintf(table->file, "%s\n", name) < 0 || fflush(table->file) != 0 ||
+        add_series(table, key) != 0)
+      return -1;
+    slot = find_slot(table->slots, table->capacity, key);
+  }
+  return slot->series;
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Query                                                          |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+/**
+ * Series id of a name, from the "series" file of the store in "dir"
+ *
+ * @return >=0 series id
+ *         -1 no such series
+ */
+int64_t sn_series_find(const char *dir, const char *name) {
+  char path[1024];
+  series_path(dir, path, sizeof(path));
+  FILE *file = fopen(path, "r");
+  if (file == NULL)
+    return -1;
+
+  char *line = NULL;
+  size_t line_sz = 0;
+  ssize_t len;
+  int64_t series = 0;
+  int64_t found = -1;
+
+  while (found == -1 && (len = getline(&line, &line_sz, file)) > 0) {
+    if (line[len - 1] == '\n')
+      line[len - 1] = '\0';
+    if (strcmp(line, name) == 0)
+      found = series;
+    series++;
+  }
+
+  free(line);
+  fclose(file);
+  return found;
+}
+
+/**
+ * Name of each series of the store in "dir", in series id order
+ *
+ * @return  0 success
+ *         -1 no "series" file
+ */
+int sn_series_names(const char *dir, MultiString *names) {
+  char path[1024];
+  series_path(dir, path, sizeof(path));
+  FILE *file = fopen(path, "r");
+  if (file == NULL)
+    return -1;
+
+  char *line = NULL;
+  size_t line_sz = 0;
+  ssize_t len;
+  while ((len = getline(&line, &line_sz, file)) > 0) {
+    if (line[len - 1] == '\n')
+      line[len - 1] = '\0';
+    cn_multistr_append(names, line);
+  }
+
+  free(line);
+  fclose(file);
+  return 0;
+}
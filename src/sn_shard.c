@@ -0,0 +1,181 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "sn_shard.h"
+#include "cn_log.h"
+#include "sn_cname.h"
+#include <ctype.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+/**
+ * @return  true 0, 256 or 4096 shards
+ */
+bool sn_shard_valid(int shards) {
+  return shards == SN_SHARD_NONE || shards == SN_SHARD_256 ||
+         shards == SN_SHARD_4096;
+}
+
+static size_t sn_shard_digits(int shards) {
+  return shards == SN_SHARD_4096 ? 3 : shards == SN_SHARD_256 ? 2 : 0;
+}
+
+/**
+ * Get the shard sub dir name of a sn1ff file name:
+ *   [<prefix>]<guid>_<status>_<epoch>.snff
+ *
+ * @param  shard  returns the shard name, "" for 0 shards, must be at least
+ *                SN_SHARD_NAME_LENGTH_D
+ * @return  0 success
+ *         -1 invalid number of shards
+ *         -2 file name does not have a GUID
+ */
+int sn_shard_name(const char *file_name, int shards, char *shard) {
+  shard[0] = '\0';
+
+  if (!sn_shard_valid(shards))
+    return -1;
+  if (shards == SN_SHARD_NONE)
+    return 0;
+
+  // The GUID is just before the first '_', after any prefix
+
+  const char *underscore = strchr(file_name, '_');
+  if (underscore == NULL || underscore - file_name < CNAME_GUID_LENGTH)
+    return -2;
+
+  const char *guid = underscore - CNAME_GUID_LENGTH;
+  size_t digits = sn_shard_digits(shards);
+
+  for (size_t i = 0; i < digits; i++) {
+    if (!isxdigit((unsigned char)guid[i])) {
+      shard[0] = '\0';
+      return -2;
+    }
+    shard[i] = (char)tolower((unsigned char)guid[i]);
+  }
+  shard[digits] = '\0';
+
+  return 0;
+}
+
+/**
+ * Get the dir a sn1ff file is kept in: <dir> or <dir>/<shard>
+ *
+ * @return  0 success
+ *         -1 invalid number of shards, or file name does not have a GUID
+ *         -2 shard dir too long
+ */
+int sn_shard_dir(const char *dir, const char *file_name, int shards,
+                 char *shard_dir, size_t shard_dir_sz) {
+  char shard[SN_SHARD_NAME_LENGTH_D];
+  if (sn_shard_name(file_name, shards, shard) != 0)
+    return -1;
+
+  // Avoid a double '/', as dirs from config end with one
+
+  size_t dir_len = strlen(dir);
+  const char *sep = (dir_len > 0 && dir[dir_len - 1] == '/') ? "" : "/";
+
+  int written = shard[0] == '\0'
+                    ? snprintf(shard_dir, shard_dir_sz, "%s", dir)
+                    : snprintf(shard_dir, shard_dir_sz, "%s%s%s", dir, sep,
+                               shard);
+
+  return (written < 0 || (size_t)written >= shard_dir_sz) ? -2 : 0;
+}
+
+/**
+ * Get the full path of a sn1ff file: <dir>[/<shard>]/<file name>
+ *
+ * @return  0 success
+ *         -1 invalid number of shards, or file name does not have a GUID
+ *         -2 path too long
+ */
+int sn_shard_path(const char *dir, const char *file_name, int shards,
+                  char *path, size_t path_sz) {
+  char shard_dir[1024];
+  int result = sn_shard_dir(dir, file_name, shards, shard_dir,
+                            sizeof(shard_dir));
+  if (result != 0)
+    return result;
+
+  size_t dir_len = strlen(shard_dir);
+  const char *sep =
+      (dir_len > 0 && shard_dir[dir_len - 1] == '/') ? "" : "/";
+
+  int written = snprintf(path, path_sz, "%s%s%s", shard_dir, sep, file_name);
+  return (written < 0 || (size_t)written >= path_sz) ? -2 : 0;
+}
+
+/**
+ * Get the shard dir, for the shard number "index" (0 .. shards - 1)
+ *
+ * @return  0 success
+ *         -1 invalid number of shards, or index
+ *         -2 shard dir too long
+ */
+int sn_shard_index_dir(const char *dir, int shards, int index, char *shard_dir,
+                       size_t shard_dir_sz) {
+  if (!sn_shard_valid(shards) || shards == SN_SHARD_NONE || index < 0 ||
+      index >= shards)
+    return -1;
+
+  int written = snprintf(shard_dir, shard_dir_sz, "%s/%0*x", dir,
+                         (int)sn_shard_digits(shards), (unsigned int)index);
+  return (written < 0 || (size_t)written >= shard_dir_sz) ? -2 : 0;
+}
+
+/**
+ * Create every shard sub dir of "dir", that does not already exist
+ *
+ * @return  0 success
+ *         -1 invalid number of shards
+ *         -2 could not create a shard dir
+ */
+int sn_shard_create_dirs(const char *dir, int shards) {
+  if (!sn_shard_valid(shards))
+    return -1;
+
+  char shard_dir[1024];
+
+  for (int i = 0; i < shards; i++) {
+    if (sn_shard_index_dir(dir, shards, i, shard_dir, sizeof(shard_dir)) != 0)
+      return -2;
+
+    if (mkdir(shard_dir, S_IRWXU | S_IRWXG) == -1 && errno != EEXIST) {
+      cn_log_msg(LOG_ERR, __func__,
+                 "'mkdir' gave error creating shard dir -> %s <-, "
+                 "strerror(errno) -> %m <-",
+                 shard_dir);
+      return -2;
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,414 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "sn_sink.h"
+#include "cn_log.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define SINK_MIN_CAPACITY 4096
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Open / close                                                   |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+/**
+ * Sink type of a name, "fifo", "stream" or "dgram"
+ *
+ * @return  SN_SINK_FIFO, SN_SINK_STREAM or SN_SINK_DGRAM
+ *         -1 not a sink type
+ */
+int sn_sink_type(const char *name) {
+  if (strcmp(name, "fifo") == 0)
+    return SN_SINK_FIFO;
+  if (strcmp(name, "stream") == 0)
+    return SN_SINK_STREAM;
+  if (strcmp(name, "dgram") == 0)
+    return SN_SINK_DGRAM;
+  return -1;
+}
+
+/**
+ * Set up a sink, with a buffer of "capacity" bytes. The FIFO or socket is
+ * opened by the first flush with records to write
+ *
+ * @return  0 success
+ *         -1 invalid path or type
+ *         -2 could not allocate the buffer
+ */
+int sn_sink_open(Sink *sink, const char *path, int type, size_t capacity,
+                 bool body) {
+  memset(sink, 0, sizeof(*sink));
+  sink->fd = -1;
+
+  if (type < SN_SINK_FIFO || type > SN_SINK_DGRAM || path[0] == '\0' ||
+      strlen(path) >= sizeof(sink->path)) {
+    cn_log_msg(LOG_ERR, __func__, "Invalid sink -> %s <-, type -> %d <-",
+               path, type);
+    return -1;
+  }
+  strcpy(sink->path, path);
+  sink->type = type;
+  sink->body = body;
+
+  sink->capacity = capacity < SINK_MIN_CAPACITY ? SINK_MIN_CAPACITY : capacity;
+  sink->buffer = malloc(sink->capacity);
+  if (sink->buffer == NULL) {
+    cn_log_msg(LOG_ERR, __func__,
+               "Malloc error for -> %zu <- bytes, strerror(errno) -> %m <-",
+               sink->capacity);
+    return -2;
+  }
+  return 0;
+}
+
+/**
+ * Close the FIFO or socket, and free the buffer. Records not yet written
+ * are lost
+ */
+void sn_sink_close(Sink *sink) {
+  if (sink->fd != -1)
+    close(sink->fd);
+  sink->fd = -1;
+  free(sink->buffer);
+  sink->buffer = NULL;
+  sink->length = 0;
+}
+
+/**
+ * Open the FIFO, or connect to the socket, without blocking
+ *
+ * @return  0 success
+ *         -1 not there, no reader, or not accepting
+ */
+static int sink_connect(Sink *sink) {
+  int fd;
+
+  if (sink->type == SN_SINK_FIFO) {
+    fd = open(sink->path, O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+  } else {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, sink->path, strlen(sink->path));
+
+    fd = socket(AF_UNIX,
+                sink->type == SN_SINK_STREAM ? SOCK_STREAM : SOCK_DGRAM, 0);
+    if (fd != -1 && (fcntl(fd, F_SETFD, FD_CLOEXEC) != 0 ||
+                     fcntl(fd, F_SETFL, O_NONBLOCK) != 0 ||
+                     connect(fd, (struct sockaddr *)&addr, sizeof(addr)) !=
+                         0)) {
+      close(fd);
+      fd = -1;
+    }
+  }
+
+  if (fd == -1) {
+    cn_log_msg(LOG_DEBUG, __func__,
+               "Sink not ready -> %s <-, strerror(errno) -> %m <-",
+               sink->path);
+    return -1;
+  }
+
+  sink->fd = fd;
+  sink->partial = false;
+  cn_log_msg(LOG_INFO, __func__, "Sink connected -> %s <-", sink->path);
+  return 0;
+}
+
+/**
+ * Close a FIFO or socket gone bad, to open it again later. A record part
+ * written to a stream is dropped, so the next reader starts on a record
+ */
+static void sink_disconnect(Sink *sink) {
+  cn_log_msg(LOG_WARNING, __func__,
+             "Sink closed -> %s <-, strerror(errno) -> %m <-", sink->path);
+  close(sink->fd);
+  sink->fd = -1;
+  sink->retry_at = time(NULL) + SN_SINK_RETRY_SECS;
+
+  if (sink->partial) {
+    const char *end = memchr(sink->buffer + sink->start, '\n', sink->length);
+    size_t skip = (size_t)(end - (sink->buffer + sink->start)) + 1;
+    sink->start += skip;
+    sink->length -= skip;
+    sink->dropped++;
+    sink->partial = false;
+  }
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Records                                                        |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+typedef struct {
+  char *out;
+  size_t length;
+  size_t capacity;
+  bool full;
+} RECORD;
+
+static void put(RECORD *record, const char *data, size_t length) {
+  if (record->full || length > record->capacity - record->length) {
+    record->full = true;
+    return;
+  }
+  memcpy(record->out + record->length, data, length);
+  record->length += length;
+}
+
+static void put_str(RECORD *record, const char *str) {
+  put(record, str, strlen(str));
+}
+
+/**
+ * Put "length" bytes of a JSON string, escaping quotes, backslashes and
+ * control characters. Other bytes are put as they are, result files being
+ * UTF-8
+ */
+static void put_json_n(RECORD *record, const char *str, size_t length) {
+  const char *run = str;
+  const char *c;
+
+  put(record, "\"", 1);
+  for (c = str; c < str + length; c++) {
+    unsigned char byte = (unsigned char)*c;
+    if (byte >= 0x20 && byte != '"' && byte != '\\' && byte != 0x7f)
+      continue;
+
+    put(record, run, (size_t)(c - run));
+    run = c + 1;
+
+    char escaped[8];
+    switch (byte) {
+    case '"':
+      put(record, "\\\"", 2);
+      break;
+    case '\\':
+      put(record, "\\\\", 2);
+      break;
+    case '\n':
+      put(record, "\\n", 2);
+      break;
+    case '\t':
+      put(record, "\\t", 2);
+      break;
+    default:
+      snprintf(escaped, sizeof(escaped), "\\u%04x", byte);
+      put(record, escaped, 6);
+    }
+  }
+  put(record, run, (size_t)(c - run));
+  put(record, "\"", 1);
+}
+
+static void put_json(RECORD *record, const char *str) {
+  put_json_n(record, str, strlen(str));
+}
+
+/**
+ * Length of a body line, without the spaces it is padded with when read
+ */
+size_t sn_sink_line_length(const char *line) {
+  size_t length = strlen(line);
+  while (length > 0 && line[length - 1] == ' ')
+    length--;
+  return length;
+}
+
+/**
+ * Format the JSON record of a result, ending in a newline, into "out" (not
+ * NUL terminated). The body is added when "file_data" is given, and the
+ * "received" time when not 0
+ *
+ * @return  length of the record
+ *         -1 it does not fit in "out_sz" bytes
+ */
+int sn_sink_format(char *out, size_t out_sz, const char *name,
+                   const CName *cname, const HEADER *hdr,
+                   const FILE_DATA *file_data, time_t received) {
+  RECORD record = {out, 0, out_sz, false};
+  char number[32];
+
+  put_str(&record, "{\"name\":");
+  put_json(&record, name);
+  put_str(&record, ",\"guid\":");
+  put_json(&record, cname->guid.str);
+  put_str(&record, ",\"status\":");
+  put_json(&record, cname->status);
+  snprintf(number, sizeof(number), "%lld", (long long)cname->epoch.bin);
+  put_str(&record, ",\"expires\":");
+  put_str(&record, number);
+  if (received != 0) {
+    snprintf(number, sizeof(number), "%lld", (long long)received);
+    put_str(&record, ",\"received\":");
+    put_str(&record, number);
+  }
+  put_str(&record, ",\"host\":");
+  put_json(&record, hdr->host);
+  put_str(&record, ",\"ipv4\":");
+  put_json(&record, hdr->ipv4);
+  put_str(&record, ",\"at\":");
+  put_json(&record, hdr->timestamp);
+  put_str(&record, ",\"checkid\":");
+  put_json(&record, hdr->checkid);
+
+  if (file_data != NULL) {
+    put_str(&record, ",\"body\":[");
+    for (size_t i = 0; i < file_data->body_lines; i++) {
+      if (i > 0)
+        put(&record, ",", 1);
+      put_json_n(&record, file_data->body[i],
+                 sn_sink_line_length(file_data->body[i]));
+    }
+    put(&record, "]", 1);
+
+    // A body cut by sn_file_read is marked, so a consumer knows it is not
+    // whole
+
+    if (file_data->body_truncated)
+      put_str(&record, ",\"truncated\":true");
+  }
+  put(&record, "}\n", 2);
+
+  return record.full ? -1 : (int)record.length;
+}
+
+/**
+ * Add the record of a result to the buffer, its body too when the sink
+ * sends bodies and "file_data" is given. The buffer is flushed once a
+ * quarter full
+ *
+ * @return  0 added
+ *         -1 dropped, the buffer being full
+ */
+int sn_sink_add(Sink *sink, const char *name, const CName *cname,
+                const HEADER *hdr, const FILE_DATA *file_data,
+                time_t received) {
+  if (sink->start > 0) {
+    memmove(sink->buffer, sink->buffer + sink->start, sink->length);
+    sink->start = 0;
+  }
+
+  int length = sn_sink_format(sink->buffer + sink->length,
+                              sink->capacity - sink->length, name, cname, hdr,
+                              sink->body ? file_data : NULL, received);
+  if (length < 0) {
+    sink->dropped++;
+    return -1;
+  }
+
+  sink->length += (size_t)length;
+  if (sink->length >= sink->capacity / 4)
+    sn_sink_flush(sink);
+  return 0;
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Flush                                                          |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+/**
+ * Write the buffered records, as many as the consumer takes without
+ * blocking. The rest stay buffered, for a later flush
+ *
+ * @return  number of records written
+ *         -1 the FIFO or socket is not open, records stay buffered
+ */
+int sn_sink_flush(Sink *sink) {
+  if (sink->length == 0)
+    return 0;
+
+  if (sink->fd == -1) {
+    time_t now = time(NULL);
+    if (now < sink->retry_at)
+      return -1;
+    if (sink_connect(sink) != 0) {
+      sink->retry_at = now + SN_SINK_RETRY_SECS;
+      return -1;
+    }
+  }
+
+  int written = 0;
+  while (sink->length > 0) {
+    const char *data = sink->buffer + sink->start;
+    size_t length = sink->length;
+    ssize_t n;
+
+    // A datagram a record, without its newline
+
+    if (sink->type == SN_SINK_DGRAM) {
+      length = (size_t)((const char *)memchr(data, '\n', length) - data);
+      n = send(sink->fd, data, length, MSG_NOSIGNAL);
+      if (n == -1 && errno == EMSGSIZE) {
+        sink->dropped++;
+        sink->start += length + 1;
+        sink->length -= length + 1;
+        continue;
+      }
+      if (n != -1)
+        n = (ssize_t)length + 1;
+    } else if (sink->type == SN_SINK_STREAM) {
+      n = send(sink->fd, data, length, MSG_NOSIGNAL);
+    } else {
+      n = write(sink->fd, data, length);
+    }
+
+    if (n == -1 && errno == EINTR)
+      continue;
+    if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+      break; // The consumer is behind
+    if (n == -1) {
+      sink_disconnect(sink);
+      break;
+    }
+
+    for (ssize_t i = 0; i < n; i++) {
+      if (data[i] == '\n')
+        written++;
+    }
+    sink->partial = data[n - 1] != '\n';
+    sink->start += (size_t)n;
+    sink->length -= (size_t)n;
+  }
+
+  if (sink->length == 0)
+    sink->start = 0;
+  sink->sent += (size_t)written;
+  return written;
+}
@@ -50,3 +50,30 @@ int sn_status_isvalid(const char *value) {
 
   return 0;
 }
+
+/**
+ * Map the 4 status characters to their Status, the characters need not be
+ * NUL terminated
+ *
+ * @param chars  at least SN_STATUS_LENGTH characters
+ *
+ * @return  status, SN_STATUS_INVALID if not ALRT|WARN|OKAY|NONE
+ */
+Status sn_status_from_chars(const char *chars) {
+  switch (chars[0]) {
+  case 'A':
+    return memcmp(chars, "ALRT", SN_STATUS_LENGTH) == 0 ? SN_STATUS_ALRT
+                                                        : SN_STATUS_INVALID;
+  case 'W':
+    return memcmp(chars, "WARN", SN_STATUS_LENGTH) == 0 ? SN_STATUS_WARN
+                                                        : SN_STATUS_INVALID;
+  case 'O':
+    return memcmp(chars, "OKAY", SN_STATUS_LENGTH) == 0 ? SN_STATUS_OKAY
+                                                        : SN_STATUS_INVALID;
+  case 'N':
+    return memcmp(chars, "NONE", SN_STATUS_LENGTH) == 0 ? SN_STATUS_NONE
+                                                        : SN_STATUS_INVALID;
+  default:
+    return SN_STATUS_INVALID;
+  }
+}
@@ -0,0 +1,226 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "sn_suppress.h"
+#include "cn_hash.h"
+#include "cn_log.h"
+#include "cn_string.h"
+#include "sn_dedup.h"
+#include "sn_file.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Records                                                        |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+static uint64_t record_check(const SuppressRecord *record) {
+  uint64_t check =
+      cn_hash_xxh64(record, offsetof(SuppressRecord, check), 0);
+  return check == 0 ? 1 : check;
+}
+
+/**
+ * Open and lock the state file
+ *
+ * @param  lock  LOCK_SH or LOCK_EX
+ * @return  file descriptor, -1 on error
+ */
+static int open_state(const char *state_path, int lock) {
+  int fd = open(state_path, O_RDWR | O_CREAT | O_CLOEXEC, S_IRUSR | S_IWUSR);
+  if (fd == -1) {
+    cn_log_msg(LOG_ERR, __func__,
+               "'open' gave error for state file -> %s <-, "
+               "strerror(errno) -> %m <-",
+               state_path);
+    return -1;
+  }
+
+  if (flock(fd, lock) == -1) {
+    cn_log_msg(LOG_ERR, __func__,
+               "'flock' gave error for state file -> %s <-, "
+               "strerror(errno) -> %m <-",
+               state_path);
+    close(fd);
+    return -1;
+  }
+
+  return fd;
+}
+
+/**
+ * Find the record of "key"
+ *
+ * @param  slot  returns the index of the record of "key", else of the
+ *               first unused record, else of the oldest record
+ * @return  true found
+ */
+static bool find_record(int fd, uint64_t key, SuppressRecord *found,
+                        size_t *slot) {
+  SuppressRecord record;
+  size_t index = 0;
+  size_t free_slot = SN_SUPPRESS_MAX_RECORDS;
+  size_t oldest_slot = 0;
+  int64_t oldest = INT64_MAX;
+
+  while (index < SN_SUPPRESS_MAX_RECORDS &&
+         pread(fd, &record, sizeof(record),
+               (off_t)(index * sizeof(record))) == (ssize_t)sizeof(record)) {
+    bool valid = record.check == record_check(&record);
+
+    if (valid && record.key == key) {
+      *found = record;
+      *slot = index;
+      return true;
+    }
+    if (!valid && free_slot == SN_SUPPRESS_MAX_RECORDS)
+      free_slot = index;
+    if (valid && record.sent < oldest) {
+      oldest = record.sent;
+      oldest_slot = index;
+    }
+    index++;
+  }
+
+  // Append, unless full
+
+  if (free_slot == SN_SUPPRESS_MAX_RECORDS)
+    free_slot = index < SN_SUPPRESS_MAX_RECORDS ? index : oldest_slot;
+
+  *slot = free_slot;
+  return false;
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Check and record                                               |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+/**
+ * Get the CheckID header value of a sn1ff file, of either format
+ *
+ * @return  0 success
+ *         -1 could not read the file, or it has no CheckID
+ */
+static int read_checkid(const char *file_path, char *checkid,
+                        size_t checkid_sz) {
+  HEADER hdr;
+  if (sn_file_read_header(file_path, &hdr) != 0 || hdr.checkid[0] == '\0')
+    return -1;
+
+  return cn_string_cp(checkid, checkid_sz, hdr.checkid) == 0 ? 0 : -1;
+}
+
+/**
+ * Check if a result is unchanged from the last one sent for its CheckID
+ * and server, and so need not be sent
+ *
+ * @param  server    server the result is for, "" for this host
+ * @param  status    status of the result
+ * @param  ttl_mins  TTL of the result
+ * @param  record    returns the record of this result, to pass to
+ *                   sn_suppress_record once it is sent
+ * @return  SN_SUPPRESS_SEND  send it
+ *          SN_SUPPRESS_SKIP  unchanged, do not send it
+ *         -1 can not be suppressed (no CheckID, or could not read it), send
+ *            it, but do not record it
+ */
+int sn_suppress_check(const char *state_path, const char *file_path,
+                      const char *server, Status status, int ttl_mins,
+                      time_t now, SuppressRecord *record) {
+  char checkid[SN_FILE_HEADER_CHECKID_LENGTH_D];
+  if (read_checkid(file_path, checkid, sizeof(checkid)) != 0 ||
+      checkid[0] == '\0' || strcmp(checkid, "N/A") == 0)
+    return -1;
+
+  uint64_t host_key;
+  memset(record, 0, sizeof(*record));
+  if (sn_dedup_hash_file(file_path, (uint64_t)status, &host_key,
+                         &record->body) != 0)
+    return -1;
+
+  record->key = cn_hash_xxh64(checkid, strlen(checkid),
+                              cn_hash_xxh64(server, strlen(server), 0));
+  record->sent = (int64_t)now;
+  record->expiry = (int64_t)now + (int64_t)ttl_mins * 60;
+  record->check = record_check(record);
+
+  int fd = open_state(state_path, LOCK_SH);
+  if (fd == -1)
+    return SN_SUPPRESS_SEND;
+
+  SuppressRecord last;
+  size_t slot;
+  bool found = find_record(fd, record->key, &last, &slot);
+  close(fd);
+
+  // Unchanged, and the last result still has half of this one's TTL left
+
+  if (found && last.body == record->body && last.sent <= record->sent &&
+      (last.expiry - record->sent) * 2 >= (int64_t)ttl_mins * 60)
+    return SN_SUPPRESS_SKIP;
+
+  return SN_SUPPRESS_SEND;
+}
+
+/**
+ * Record a result as sent
+ *
+ * @param  record  from sn_suppress_check
+ * @return  0 success
+ *         -1 could not write the state file
+ */
+int sn_suppress_record(const char *state_path, const SuppressRecord *record) {
+  int fd = open_state(state_path, LOCK_EX);
+  if (fd == -1)
+    return -1;
+
+  SuppressRecord last;
+  size_t slot;
+  find_record(fd, record->key, &last, &slot);
+
+  int result = 0;
+  if (pwrite(fd, record, sizeof(*record), (off_t)(slot * sizeof(*record))) !=
+      (ssize_t)sizeof(*record)) {
+    cn_log_msg(LOG_ERR, __func__,
+               "'pwrite' gave error for state file -> %s <-, "
+               "strerror(errno) -> %m <-",
+               state_path);
+    result = -1;
+  }
+
+  close(fd);
+  return result;
+}
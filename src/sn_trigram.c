@@ -0,0 +1,1341 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "sn_trigram.h"
+#include "cn_log.h"
+#include "cn_string.h"
+#include "sn_cname.h"
+#include "sn_varint.h"
+#include <ctype.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <regex.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Trigrams taken from a pattern, enough for any body line
+#define TRIGRAM_PATTERN_MAX 128
+
+// Documents rewritten by a compaction, between flushes
+#define TRIGRAM_COMPACT_BATCH 4096
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Encoding                                                       |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+static unsigned char fold(unsigned char c) {
+  return (c >= 'A' && c <= 'Z') ? (unsigned char)(c - 'A' + 'a') : c;
+}
+
+static uint32_t trigram_at(const char *p) {
+  return (uint32_t)fold((unsigned char)p[0]) << 16 |
+         (uint32_t)fold((unsigned char)p[1]) << 8 |
+         (uint32_t)fold((unsigned char)p[2]);
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Documents                                                      |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+typedef struct {
+  TrigramDoc doc;
+  char *buffer; // Holds the strings below, to free
+  char *host;
+  char *checkid;
+  char *name;
+  char *body;
+} LOADED_DOC;
+
+/**
+ * Read document "id" from "docs.dat"
+ *
+ * @return  0 success, free "loaded->buffer"
+ *         -1 could not read it
+ */
+static int load_doc(int docs_fd, int offsets_fd, uint32_t id,
+                    LOADED_DOC *loaded) {
+  uint64_t offset;
+  if (pread(offsets_fd, &offset, sizeof(offset),
+            (off_t)id * (off_t)sizeof(offset)) != (ssize_t)sizeof(offset) ||
+      pread(docs_fd, &loaded->doc, sizeof(loaded->doc), (off_t)offset) !=
+          (ssize_t)sizeof(loaded->doc))
+    return -1;
+
+  const TrigramDoc *doc = &loaded->doc;
+  size_t size = (size_t)doc->host_len + doc->checkid_len + doc->name_len +
+                doc->body_len;
+
+  // Read 3 bytes in, so each string can be moved down to make room for
+  // the null terminators of those before it
+
+  loaded->buffer = malloc(size + 4);
+  if (loaded->buffer == NULL ||
+      pread(docs_fd, loaded->buffer + 3, size,
+            (off_t)(offset + sizeof(loaded->doc))) != (ssize_t)size) {
+    free(loaded->buffer);
+    return -1;
+  }
+
+  char *src = loaded->buffer + 3;
+  char *dest = loaded->buffer;
+  char **strings[] = {&loaded->host, &loaded->checkid, &loaded->name,
+                      &loaded->body};
+  size_t lengths[] = {doc->host_len, doc->checkid_len, doc->name_len,
+                      doc->body_len};
+
+  for (size_t i = 0; i < 4; i++) {
+    memmove(dest, src, lengths[i]);
+    dest[lengths[i]] = '\0';
+    *strings[i] = dest;
+    src += lengths[i];
+    dest += lengths[i] + 1;
+  }
+  return 0;
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Segments                                                       |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+typedef struct {
+  uint32_t first;
+  uint32_t end;
+} SEGMENT_NAME;
+
+typedef struct {
+  void *map;
+  size_t size;
+  const TrigramSegment *header;
+  const TrigramEntry *entries;
+} SEGMENT;
+
+static void segment_path(const char *dir, uint32_t first, uint32_t end,
+                         char *path, size_t path_sz) {
+  snprintf(path, path_sz, "%s/%010u-%010u.tri", dir, first, end);
+}
+
+static int compare_names(const void *a, const void *b) {
+  const SEGMENT_NAME *x = a;
+  const SEGMENT_NAME *y = b;
+  if (x->first != y->first)
+    return x->first < y->first ? -1 : 1;
+  if (x->end != y->end)
+    return x->end > y->end ? -1 : 1; // Widest first
+  return 0;
+}
+
+/**
+ * Segments of "dir" by first id, leaving out any within a wider one (a
+ * merge not yet cleared away)
+ *
+ * @return  number of segments, "*names" to free
+ *         -1 could not read the dir, or allocate
+ */
+static int list_segments(const char *dir, SEGMENT_NAME **names) {
+  DIR *d = opendir(dir);
+  if (d == NULL)
+    return -1;
+
+  size_t count = 0;
+  size_t capacity = 16;
+  SEGMENT_NAME *found = malloc(capacity * sizeof(SEGMENT_NAME));
+  struct dirent *entry;
+
+  while (found != NULL && (entry = readdir(d)) != NULL) {
+    unsigned int first, end;
+    char ext[8];
+    if (strlen(entry->d_name) != 25 ||
+        sscanf(entry->d_name, "%10u-%10u.%3s", &first, &end, ext) != 3 ||
+        strcmp(ext, "tri") != 0 || end <= first)
+      continue;
+
+    if (count == capacity) {
+      capacity *= 2;
+      SEGMENT_NAME *grown = realloc(found, capacity * sizeof(SEGMENT_NAME));
+      if (grown == NULL) {
+        free(found);
+        found = NULL;
+        break;
+      }
+      found = grown;
+    }
+    found[count].first = first;
+    found[count].end = end;
+    count++;
+  }
+  closedir(d);
+
+  if (found == NULL)
+    return -1;
+
+  qsort(found, count, sizeof(SEGMENT_NAME), compare_names);
+
+  size_t kept = 0;
+  uint32_t covered = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (kept > 0 && found[i].first < covered)
+      continue;
+    found[kept++] = found[i];
+    covered = found[i].end;
+  }
+
+  *names = found;
+  return (int)kept;
+}
+
+/**
+ * Map a segment, checking its table is within it
+ *
+ * @return  0 success
+ *         -1 no segment, or not valid
+ */
+static int map_segment(const char *dir, const SEGMENT_NAME *name,
+                       SEGMENT *segment) {
+  char path[SN_TRIGRAM_NAME_LENGTH + 32];
+  segment_path(dir, name->first, name->end, path, sizeof(path));
+
+  int fd = open(path, O_RDONLY);
+  if (fd == -1)
+    return -1;
+
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0 ||
+      (size_t)file_stat.st_size < sizeof(TrigramSegment)) {
+    close(fd);
+    return -1;
+  }
+
+  segment->size = (size_t)file_stat.st_size;
+  segment->map = mmap(NULL, segment->size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (segment->map == MAP_FAILED)
+    return -1;
+
+  segment->header = segment->map;
+  segment->entries = (const TrigramEntry *)(segment->header + 1);
+
+  const TrigramSegment *header = segment->header;
+  size_t table_end = sizeof(TrigramSegment) +
+                     (size_t)header->num_trigrams * sizeof(TrigramEntry);
+  if (memcmp(header->magic, SN_TRIGRAM_MAGIC, SN_TRIGRAM_MAGIC_LENGTH) != 0 ||
+      header->version != SN_TRIGRAM_VERSION || header->first != name->first ||
+      header->end != name->end || table_end > segment->size) {
+    munmap(segment->map, segment->size);
+    return -1;
+  }
+
+  for (uint32_t i = 0; i < header->num_trigrams; i++) {
+    if (segment->entries[i].offset < table_end ||
+        segment->entries[i].offset > segment->size) {
+      munmap(segment->map, segment->size);
+      return -1;
+    }
+  }
+  return 0;
+}
+
+static void unmap_segment(SEGMENT *segment) {
+  munmap(segment->map, segment->size);
+}
+
+/**
+ * Entry of "trigram" in a segment, by binary search
+ */
+static const TrigramEntry *find_entry(const SEGMENT *segment,
+                                      uint32_t trigram) {
+  size_t low = 0;
+  size_t high = segment->header->num_trigrams;
+  while (low < high) {
+    size_t mid = low + (high - low) / 2;
+    if (segment->entries[mid].trigram < trigram)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+
+  if (low < segment->header->num_trigrams &&
+      segment->entries[low].trigram == trigram)
+    return &segment->entries[low];
+  return NULL;
+}
+
+/**
+ * Decode the postings of an entry into "ids", room for entry->count
+ *
+ * @return  0 success
+ *         -1 not valid
+ */
+static int decode_postings(const SEGMENT *segment, const TrigramEntry *entry,
+                           uint32_t *ids) {
+  const unsigned char *map = (const unsigned char *)segment->map;
+  const unsigned char *src = map + entry->offset;
+  const unsigned char *end = map + segment->size;
+  uint32_t prev = segment->header->first;
+
+  for (uint32_t i = 0; i < entry->count; i++) {
+    uint32_t delta;
+    if (sn_varint_get_32(&src, end, &delta) != 0)
+      return -1;
+    prev += delta;
+    ids[i] = prev;
+  }
+  return 0;
+}
+
+/**
+ * Write a segment from its table and postings, to a temporary file renamed
+ * into place
+ *
+ * @return  0 success
+ *         -1 could not write it
+ */
+static int write_segment(const char *dir, uint32_t first, uint32_t end,
+                         TrigramEntry *entries, uint32_t num_trigrams,
+                         const unsigned char *postings, size_t postings_sz) {
+  TrigramSegment header = {0};
+  memcpy(header.magic, SN_TRIGRAM_MAGIC, SN_TRIGRAM_MAGIC_LENGTH);
+  header.version = SN_TRIGRAM_VERSION;
+  header.num_trigrams = num_trigrams;
+  header.first = first;
+  header.end = end;
+
+  // Entry offsets are from the start of the postings until now
+
+  uint64_t base =
+      sizeof(header) + (uint64_t)num_trigrams * sizeof(TrigramEntry);
+  for (uint32_t i = 0; i < num_trigrams; i++)
+    entries[i].offset += base;
+
+  char path[SN_TRIGRAM_NAME_LENGTH + 32];
+  char tmp_path[SN_TRIGRAM_NAME_LENGTH + 40];
+  segment_path(dir, first, end, path, sizeof(path));
+  snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+
+  FILE *file = fopen(tmp_path, "w");
+  if (file == NULL) {
+    cn_log_msg(LOG_ERR, __func__,
+               "Could not create trigram segment -> %s <-, strerror(errno) "
+               "-> %m <-",
+               tmp_path);
+    return -1;
+  }
+
+  bool written =
+      fwrite(&header, sizeof(header), 1, file) == 1 &&
+      (num_trigrams == 0 ||
+       fwrite(entries, sizeof(TrigramEntry), num_trigrams, file) ==
+           num_trigrams) &&
+      (postings_sz == 0 || fwrite(postings, postings_sz, 1, file) == 1);
+
+  if (fclose(file) != 0 || !written || rename(tmp_path, path) != 0) {
+    cn_log_msg(LOG_ERR, __func__,
+               "Could not write trigram segment -> %s <-, strerror(errno) -> "
+               "%m <-",
+               path);
+    unlink(tmp_path);
+    return -1;
+  }
+  return 0;
+}
+
+static int compare_pairs(const void *a, const void *b) {
+  uint64_t x = *(const uint64_t *)a;
+  uint64_t y = *(const uint64_t *)b;
+  return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+/**
+ * Add (trigram << 32 | id) for each trigram of each line of "body"
+ */
+static int add_pairs(const char *body, uint32_t id, uint64_t **pairs,
+                     size_t *count, size_t *capacity) {
+  const char *line = body;
+  while (*line != '\0') {
+    size_t len = strcspn(line, "\n");
+    for (size_t i = 0; i + 3 <= len; i++) {
+      if (*count == *capacity) {
+        size_t grown_capacity = *capacity == 0 ? 4096 : *capacity * 2;
+        uint64_t *grown = realloc(*pairs, grown_capacity * sizeof(uint64_t));
+        if (grown == NULL)
+          return -1;
+        *pairs = grown;
+        *capacity = grown_capacity;
+      }
+      (*pairs)[(*count)++] = (uint64_t)trigram_at(line + i) << 32 | id;
+    }
+    line += len;
+    if (*line == '\n')
+      line++;
+  }
+  return 0;
+}
+
+/**
+ * Index documents "first" to "end" (exclusive) into a new segment
+ *
+ * @return  0 success
+ *         -1 could not read the documents, or write the segment
+ *         -2 could not allocate
+ */
+static int build_segment(const TrigramIndex *index, uint32_t first,
+                         uint32_t end) {
+  uint64_t *pairs = NULL;
+  size_t count = 0;
+  size_t capacity = 0;
+
+  for (uint32_t id = first; id < end; id++) {
+    LOADED_DOC loaded;
+    if (load_doc(index->docs_fd, index->offsets_fd, id, &loaded) != 0) {
+      free(pairs);
+      return -1;
+    }
+    int added = add_pairs(loaded.body, id, &pairs, &count, &capacity);
+    free(loaded.buffer);
+    if (added != 0) {
+      free(pairs);
+      return -2;
+    }
+  }
+
+  // Sorted by trigram then id, each pair once
+
+  qsort(pairs, count, sizeof(uint64_t), compare_pairs);
+  size_t unique = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (unique == 0 || pairs[i] != pairs[unique - 1])
+      pairs[unique++] = pairs[i];
+  }
+
+  TrigramEntry *entries = malloc((unique + 1) * sizeof(TrigramEntry));
+  unsigned char *postings = malloc(unique * SN_VARINT_MAX_32 + 1);
+  if (entries == NULL || postings == NULL) {
+    free(pairs);
+    free(entries);
+    free(postings);
+    return -2;
+  }
+
+  uint32_t num_trigrams = 0;
+  size_t postings_sz = 0;
+  uint32_t prev = first;
+
+  for (size_t i = 0; i < unique; i++) {
+    uint32_t trigram = (uint32_t)(pairs[i] >> 32);
+    uint32_t id = (uint32_t)pairs[i];
+
+    if (num_trigrams == 0 || entries[num_trigrams - 1].trigram != trigram) {
+      entries[num_trigrams].trigram = trigram;
+      entries[num_trigrams].count = 0;
+      entries[num_trigrams].offset = postings_sz;
+      num_trigrams++;
+      prev = first;
+    }
+    postings_sz += sn_varint_put(postings + postings_sz, id - prev);
+    prev = id;
+    entries[num_trigrams - 1].count++;
+  }
+
+  int result = write_segment(index->dir, first, end, entries, num_trigrams,
+                             postings, postings_sz);
+  free(pairs);
+  free(entries);
+  free(postings);
+  return result;
+}
+
+/**
+ * Re-encode the postings of an entry into "out", continuing from "*prev"
+ */
+static int append_postings(const SEGMENT *segment, const TrigramEntry *entry,
+                           unsigned char *out, size_t *out_sz,
+                           uint32_t *prev) {
+  const unsigned char *map = (const unsigned char *)segment->map;
+  const unsigned char *src = map + entry->offset;
+  const unsigned char *end = map + segment->size;
+  uint32_t id = segment->header->first;
+
+  for (uint32_t i = 0; i < entry->count; i++) {
+    uint32_t delta;
+    if (sn_varint_get_32(&src, end, &delta) != 0)
+      return -1;
+    id += delta;
+    *out_sz += sn_varint_put(out + *out_sz, id - *prev);
+    *prev = id;
+  }
+  return 0;
+}
+
+/**
+ * Merge two adjacent segments, "older" then "newer", into one
+ *
+ * @return  0 success
+ *         -1 could not read or write them
+ *         -2 could not allocate
+ */
+static int merge_segments(const char *dir, const SEGMENT_NAME *older,
+                          const SEGMENT_NAME *newer) {
+  SEGMENT a, b;
+  if (map_segment(dir, older, &a) != 0)
+    return -1;
+  if (map_segment(dir, newer, &b) != 0) {
+    unmap_segment(&a);
+    return -1;
+  }
+
+  // A document id may take more bytes, as its delta is from an older id
+
+  size_t max_trigrams =
+      (size_t)a.header->num_trigrams + b.header->num_trigrams;
+  TrigramEntry *entries = malloc((max_trigrams + 1) * sizeof(TrigramEntry));
+  unsigned char *postings =
+      malloc(a.size + b.size + max_trigrams * SN_VARINT_MAX_32 + 1);
+  if (entries == NULL || postings == NULL) {
+    free(entries);
+    free(postings);
+    unmap_segment(&a);
+    unmap_segment(&b);
+    return -2;
+  }
+
+  uint32_t i = 0;
+  uint32_t j = 0;
+  uint32_t num_trigrams = 0;
+  size_t postings_sz = 0;
+  int result = 0;
+
+  while (result == 0 &&
+         (i < a.header->num_trigrams || j < b.header->num_trigrams)) {
+    const TrigramEntry *from_a =
+        i < a.header->num_trigrams ? &a.entries[i] : NULL;
+    const TrigramEntry *from_b =
+        j < b.header->num_trigrams ? &b.entries[j] : NULL;
+
+    if (from_a != NULL && from_b != NULL) {
+      if (from_a->trigram < from_b->trigram)
+        from_b = NULL;
+      else if (from_b->trigram < from_a->trigram)
+        from_a = NULL;
+    }
+
+    TrigramEntry *entry = &entries[num_trigrams++];
+    entry->trigram = from_a != NULL ? from_a->trigram : from_b->trigram;
+    entry->count = 0;
+    entry->offset = postings_sz;
+
+    uint32_t prev = older->first;
+    if (from_a != NULL) {
+      result = append_postings(&a, from_a, postings, &postings_sz, &prev);
+      entry->count += from_a->count;
+      i++;
+    }
+    if (from_b != NULL && result == 0) {
+      result = append_postings(&b, from_b, postings, &postings_sz, &prev);
+      entry->count += from_b->count;
+      j++;
+    }
+  }
+
+  if (result == 0)
+    result = write_segment(dir, older->first, newer->end, entries,
+                           num_trigrams, postings, postings_sz);
+
+  free(entries);
+  free(postings);
+  unmap_segment(&a);
+  unmap_segment(&b);
+
+  // The merged segment is in place, before the two are removed
+
+  if (result == 0) {
+    char path[SN_TRIGRAM_NAME_LENGTH + 32];
+    segment_path(dir, older->first, older->end, path, sizeof(path));
+    unlink(path);
+    segment_path(dir, newer->first, newer->end, path, sizeof(path));
+    unlink(path);
+  }
+  return result;
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Index                                                          |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+/**
+ * Open the index in "dir", creating it if need be
+ *
+ * @return  0 success
+ *         -1 could not create the dir, or open its files
+ */
+int sn_trigram_open(TrigramIndex *index, const char *dir) {
+  memset(index, 0, sizeof(*index));
+  index->docs_fd = -1;
+  index->offsets_fd = -1;
+
+  // A compaction stopped between its renames, left its index in ".new"
+
+  char new_dir[SN_TRIGRAM_NAME_LENGTH + 8];
+  snprintf(new_dir, sizeof(new_dir), "%s.new", dir);
+  if (access(dir, F_OK) != 0 && access(new_dir, F_OK) == 0)
+    rename(new_dir, dir);
+
+  if (cn_string_cp(index->dir, sizeof(index->dir), dir) != 0 ||
+      (mkdir(dir, 0770) != 0 && errno != EEXIST)) {
+    cn_log_msg(LOG_ERR, __func__,
+               "Could not create search dir -> %s <-, strerror(errno) -> "
+               "%m <-",
+               dir);
+    return -1;
+  }
+
+  char path[SN_TRIGRAM_NAME_LENGTH + 32];
+  snprintf(path, sizeof(path), "%s/docs.dat", dir);
+  index->docs_fd = open(path, O_RDWR | O_CREAT, 0660);
+  snprintf(path, sizeof(path), "%s/docs.off", dir);
+  index->offsets_fd = open(path, O_RDWR | O_CREAT, 0660);
+
+  struct stat docs_stat, offsets_stat;
+  if (index->docs_fd == -1 || index->offsets_fd == -1 ||
+      fstat(index->docs_fd, &docs_stat) != 0 ||
+      fstat(index->offsets_fd, &offsets_stat) != 0) {
+    cn_log_msg(LOG_ERR, __func__,
+               "Could not open search files in -> %s <-, strerror(errno) -> "
+               "%m <-",
+               dir);
+    sn_trigram_close(index);
+    return -1;
+  }
+
+  // A document part written, is written over by the next
+
+  uint64_t num_docs = (uint64_t)offsets_stat.st_size / sizeof(uint64_t);
+  if (num_docs > UINT32_MAX) {
+    cn_log_msg(LOG_ERR, __func__,
+               "More search documents than ids in -> %s <-", dir);
+    sn_trigram_close(index);
+    return -1;
+  }
+
+  index->docs_size = (uint64_t)docs_stat.st_size;
+  index->num_docs = (uint32_t)num_docs;
+
+  SEGMENT_NAME *names;
+  int count = list_segments(dir, &names);
+  if (count > 0) {
+    uint32_t indexed = names[count - 1].end;
+    index->indexed = indexed <= index->num_docs ? indexed : index->num_docs;
+  }
+  if (count >= 0)
+    free(names);
+  return 0;
+}
+
+void sn_trigram_close(TrigramIndex *index) {
+  if (index->docs_fd != -1)
+    close(index->docs_fd);
+  if (index->offsets_fd != -1)
+    close(index->offsets_fd);
+  index->docs_fd = -1;
+  index->offsets_fd = -1;
+}
+
+/**
+ * Add a result as a document, indexed by the next sn_trigram_flush. The
+ * body is as sn_file_read_body gives it, every line at its full length
+ *
+ * @return  0 success
+ *         -1 could not write it
+ *         -2 could not allocate
+ */
+int sn_trigram_add(TrigramIndex *index, const HEADER *hdr, const char *name,
+                   time_t when, const char *body, size_t body_len) {
+  if (index->num_docs == UINT32_MAX) {
+    cn_log_msg(LOG_ERR, __func__,
+               "No document ids left in search index -> %s <-", index->dir);
+    return -1;
+  }
+
+  size_t host_len = strlen(hdr->host);
+  size_t checkid_len = strlen(hdr->checkid);
+  size_t name_len = strlen(name);
+
+  // Less the newline ending the last line
+
+  if (body_len > 0 && body[body_len - 1] == '\n')
+    body_len--;
+  if (body_len > UINT32_MAX)
+    body_len = UINT32_MAX;
+
+  size_t size =
+      sizeof(TrigramDoc) + host_len + checkid_len + name_len + body_len;
+
+  unsigned char *record = malloc(size);
+  if (record == NULL)
+    return -2;
+
+  TrigramDoc doc = {0};
+  doc.when = (int64_t)when;
+  doc.host_len = (uint16_t)host_len;
+  doc.checkid_len = (uint16_t)checkid_len;
+  doc.name_len = (uint16_t)name_len;
+
+  size_t n = sizeof(doc);
+  memcpy(record + n, hdr->host, host_len);
+  n += host_len;
+  memcpy(record + n, hdr->checkid, checkid_len);
+  n += checkid_len;
+  memcpy(record + n, name, name_len);
+  n += name_len;
+
+  memcpy(record + n, body, body_len);
+  n += body_len;
+  doc.body_len = (uint32_t)body_len;
+  memcpy(record, &doc, sizeof(doc));
+
+  // The document before its offset, so an offset is to a whole document
+
+  uint64_t offset = index->docs_size;
+  int result = 0;
+  if (pwrite(index->docs_fd, record, n, (off_t)offset) != (ssize_t)n ||
+      pwrite(index->offsets_fd, &offset, sizeof(offset),
+             (off_t)index->num_docs * (off_t)sizeof(offset)) !=
+          (ssize_t)sizeof(offset)) {
+    cn_log_msg(LOG_ERR, __func__,
+               "'pwrite' gave an error for search document, strerror(errno) "
+               "-> %m <-");
+    result = -1;
+  } else {
+    index->docs_size += n;
+    index->num_docs++;
+  }
+
+  free(record);
+  return result;
+}
+
+/**
+ * Index the documents added since the last flush into a new segment, then
+ * merge the newest segments while the newest is as large as the one
+ * before it
+ *
+ * @return >=0 documents indexed
+ *         -1 could not read or write the index
+ *         -2 could not allocate
+ */
+int sn_trigram_flush(TrigramIndex *index) {
+  if (index->indexed >= index->num_docs)
+    return 0;
+
+  uint32_t added = index->num_docs - index->indexed;
+  int result = build_segment(index, index->indexed, index->num_docs);
+  if (result != 0)
+    return result;
+  index->indexed = index->num_docs;
+
+  while (true) {
+    SEGMENT_NAME *names;
+    int count = list_segments(index->dir, &names);
+    if (count < 0)
+      return -2;
+
+    bool merge = count >= 2 && names[count - 2].end == names[count - 1].first &&
+                 names[count - 1].end - names[count - 1].first >=
+                     names[count - 2].end - names[count - 2].first;
+    if (merge)
+      result = merge_segments(index->dir, &names[count - 2],
+                              &names[count - 1]);
+    free(names);
+
+    if (!merge || result != 0)
+      break;
+  }
+
+  return result == 0 ? (int)added : result;
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Compaction                                                     |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+/**
+ * Epoch the result of document "id" expires, from its file name
+ *
+ * @return  0 success
+ *         -1 could not read it
+ *         -2 not a sn1ff file name, its expiry is not known
+ */
+static int doc_expiry(int docs_fd, int offsets_fd, uint32_t id,
+                      time_t *expiry) {
+  uint64_t offset;
+  TrigramDoc doc;
+  if (pread(offsets_fd, &offset, sizeof(offset),
+            (off_t)id * (off_t)sizeof(offset)) != (ssize_t)sizeof(offset) ||
+      pread(docs_fd, &doc, sizeof(doc), (off_t)offset) !=
+          (ssize_t)sizeof(doc))
+    return -1;
+
+  char name[CNAME_NAME_LENGTH_D + CNAME_EXTENSION_LENGTH];
+  if (doc.name_len >= sizeof(name))
+    return -2;
+
+  off_t at = (off_t)(offset + sizeof(doc) + doc.host_len + doc.checkid_len);
+  if (pread(docs_fd, name, doc.name_len, at) != (ssize_t)doc.name_len)
+    return -1;
+  name[doc.name_len] = '\0';
+
+  CName cname;
+  if (sn_cname_parse_name(name, &cname) != CNAME_PARSE_OK)
+    return -2;
+  sn_cname_get_epoch_bin(&cname, expiry);
+  return 0;
+}
+
+static bool doc_expired(const TrigramIndex *index, uint32_t id, time_t now) {
+  time_t expiry;
+  return doc_expiry(index->docs_fd, index->offsets_fd, id, &expiry) == 0 &&
+         expiry < now;
+}
+
+/**
+ * Remove a dir of index files
+ */
+static void remove_dir(const char *dir) {
+  DIR *d = opendir(dir);
+  if (d == NULL)
+    return;
+
+  struct dirent *entry;
+  char path[SN_TRIGRAM_NAME_LENGTH + 288];
+  while ((entry = readdir(d)) != NULL) {
+    if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+      continue;
+    snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+    unlink(path);
+  }
+  closedir(d);
+  rmdir(dir);
+}
+
+/**
+ * Write the documents of "index" not expired by "now" to a new index in
+ * "dir", renumbered from 0, and index them
+ *
+ * @return  0 success
+ *         -1 could not read or write them
+ *         -2 could not allocate
+ */
+static int copy_live_docs(const TrigramIndex *index, const char *dir,
+                          time_t now) {
+  TrigramIndex compacted;
+  if (sn_trigram_open(&compacted, dir) != 0)
+    return -1;
+
+  int result = 0;
+  for (uint32_t id = 0; id < index->num_docs && result == 0; id++) {
+    if (doc_expired(index, id, now))
+      continue;
+
+    LOADED_DOC loaded;
+    if (load_doc(index->docs_fd, index->offsets_fd, id, &loaded) != 0) {
+      result = -1;
+      break;
+    }
+
+    HEADER hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    cn_string_cp(hdr.host, sizeof(hdr.host), loaded.host);
+    cn_string_cp(hdr.checkid, sizeof(hdr.checkid), loaded.checkid);
+    result = sn_trigram_add(&compacted, &hdr, loaded.name,
+                            (time_t)loaded.doc.when, loaded.body,
+                            loaded.doc.body_len);
+    free(loaded.buffer);
+
+    // Indexed as it goes, as a greeter pass would, to bound the memory
+
+    if (result == 0 &&
+        compacted.num_docs - compacted.indexed >= TRIGRAM_COMPACT_BATCH)
+      result = sn_trigram_flush(&compacted) < 0 ? -1 : 0;
+  }
+
+  if (result == 0) {
+    int flushed = sn_trigram_flush(&compacted);
+    result = flushed < 0 ? flushed : 0;
+  }
+  sn_trigram_close(&compacted);
+  return result;
+}
+
+/**
+ * Drop the documents of results expired by "now", once at least a quarter
+ * of them have, or half the ids are used. The documents kept are written,
+ * renumbered from 0, to a new index in "<dir>.new", swapped in for the
+ * old. A search open on the old index still reads its files
+ *
+ * @return >=0 documents dropped
+ *         -1 could not read or write the index, it is as it was
+ *         -2 could not allocate, the index is as it was
+ *         -3 could not open the compacted index, "index" is closed
+ */
+int sn_trigram_compact(TrigramIndex *index, time_t now) {
+  uint32_t expired = 0;
+  for (uint32_t id = 0; id < index->num_docs; id++)
+    if (doc_expired(index, id, now))
+      expired++;
+
+  if (expired == 0 ||
+      (expired < index->num_docs / 4 && index->num_docs < UINT32_MAX / 2))
+    return 0;
+
+  char dir[SN_TRIGRAM_NAME_LENGTH];
+  char new_dir[SN_TRIGRAM_NAME_LENGTH + 8];
+  char old_dir[SN_TRIGRAM_NAME_LENGTH + 8];
+  memcpy(dir, index->dir, sizeof(dir));
+  snprintf(new_dir, sizeof(new_dir), "%s.new", dir);
+  snprintf(old_dir, sizeof(old_dir), "%s.old", dir);
+
+  // Any left by a compaction stopped part way
+
+  remove_dir(new_dir);
+  remove_dir(old_dir);
+
+  int result = copy_live_docs(index, new_dir, now);
+  if (result != 0) {
+    cn_log_msg(LOG_ERR, __func__, "Could not compact search index -> %s <-",
+               dir);
+    remove_dir(new_dir);
+    return result;
+  }
+
+  sn_trigram_close(index);
+
+  if (rename(dir, old_dir) != 0) {
+    cn_log_msg(LOG_ERR, __func__,
+               "'rename' gave an error for search dir -> %s <-, "
+               "strerror(errno) -> %m <-",
+               dir);
+    remove_dir(new_dir);
+    result = -1;
+  } else if (rename(new_dir, dir) != 0) {
+    cn_log_msg(LOG_ERR, __func__,
+               "'rename' gave an error for search dir -> %s <-, "
+               "strerror(errno) -> %m <-",
+               new_dir);
+    rename(old_dir, dir);
+    remove_dir(new_dir);
+    result = -1;
+  } else {
+    remove_dir(old_dir);
+  }
+
+  if (sn_trigram_open(index, dir) != 0)
+    return -3;
+  return result == 0 ? (int)expired : result;
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Pattern                                                        |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+static size_t add_trigrams(const char *run, size_t len, uint32_t *trigrams,
+                           size_t count, size_t max_trigrams) {
+  for (size_t i = 0; i + 3 <= len && count < max_trigrams; i++) {
+    uint32_t trigram = trigram_at(run + i);
+    bool seen = false;
+    for (size_t j = 0; j < count && !seen; j++)
+      seen = trigrams[j] == trigram;
+    if (!seen)
+      trigrams[count++] = trigram;
+  }
+  return count;
+}
+
+/**
+ * Index of the ']' closing the bracket expression at "p[i]"
+ */
+static size_t skip_bracket(const char *p, size_t i) {
+  size_t j = i + 1;
+  if (p[j] == '^')
+    j++;
+  if (p[j] == ']')
+    j++;
+  while (p[j] != '\0' && p[j] != ']')
+    j++;
+  return p[j] == '\0' ? j - 1 : j;
+}
+
+/**
+ * Index of the ')' closing the group at "p[i]"
+ */
+static size_t skip_group(const char *p, size_t i) {
+  int depth = 0;
+  size_t j = i;
+  for (; p[j] != '\0'; j++) {
+    if (p[j] == '\\' && p[j + 1] != '\0')
+      j++;
+    else if (p[j] == '[')
+      j = skip_bracket(p, j);
+    else if (p[j] == '(')
+      depth++;
+    else if (p[j] == ')' && --depth == 0)
+      return j;
+  }
+  return j - 1;
+}
+
+/**
+ * Trigrams every match of a pattern must contain, from the runs of literal
+ * text it must match (outside groups, brackets and optional characters)
+ *
+ * @return >0 number of trigrams
+ *          0 none, every document may match
+ */
+int sn_trigram_required(const char *pattern, int flags, uint32_t *trigrams,
+                        size_t max_trigrams) {
+  size_t count = 0;
+
+  if (flags & SN_TRIGRAM_FIXED)
+    return (int)add_trigrams(pattern, strlen(pattern), trigrams, 0,
+                             max_trigrams);
+
+  // An alternative at the top level, and no run must match
+
+  for (size_t i = 0; pattern[i] != '\0'; i++) {
+    if (pattern[i] == '\\' && pattern[i + 1] != '\0')
+      i++;
+    else if (pattern[i] == '[')
+      i = skip_bracket(pattern, i);
+    else if (pattern[i] == '(')
+      i = skip_group(pattern, i);
+    else if (pattern[i] == '|')
+      return 0;
+  }
+
+  char run[SN_FILE_MAX_BODY_LENGTH + 1];
+  size_t run_len = 0;
+
+  for (size_t i = 0;; i++) {
+    char c = pattern[i];
+    bool literal = false;
+
+    if (c == '\\' && pattern[i + 1] != '\0' &&
+        !isalnum((unsigned char)pattern[i + 1])) {
+      c = pattern[++i];
+      literal = true;
+    } else if (c != '\0' && strchr("\\.[]()^$*+?{}|", c) == NULL) {
+      literal = true;
+    }
+
+    // A character made optional by what follows it, is not in the run
+
+    char next = c != '\0' ? pattern[i + 1] : '\0';
+    if (literal && (next == '*' || next == '?' || next == '{'))
+      literal = false;
+
+    if (literal && run_len < sizeof(run)) {
+      run[run_len++] = c;
+      continue;
+    }
+
+    count = add_trigrams(run, run_len, trigrams, count, max_trigrams);
+    run_len = 0;
+
+    if (c == '\0')
+      break;
+    if (c == '[')
+      i = skip_bracket(pattern, i);
+    else if (c == '(')
+      i = skip_group(pattern, i);
+  }
+
+  return (int)count;
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Search                                                         |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+typedef struct {
+  const TrigramQuery *query;
+  regex_t regex;
+  char folded[SN_FILE_MAX_BODY_LENGTH * 4]; // Fixed string, ICASE
+  int docs_fd;
+  int offsets_fd;
+  TrigramMatchFn fn;
+  void *arg;
+  int matched; // Documents
+  int stop;    // Non zero "fn" returned
+} SEARCH;
+
+static bool line_matches(SEARCH *search, const char *line) {
+  const TrigramQuery *query = search->query;
+
+  if (!(query->flags & SN_TRIGRAM_FIXED))
+    return regexec(&search->regex, line, 0, NULL, 0) == 0;
+
+  if (!(query->flags & SN_TRIGRAM_ICASE))
+    return strstr(line, query->pattern) != NULL;
+
+  // Folded as it is compared, as a line can be any length
+
+  for (const char *start = line; *start != '\0'; start++) {
+    size_t k = 0;
+    while (search->folded[k] != '\0' &&
+           fold((unsigned char)start[k]) == (unsigned char)search->folded[k])
+      k++;
+    if (search->folded[k] == '\0')
+      return true;
+  }
+  return search->folded[0] == '\0';
+}
+
+/**
+ * Check a candidate document against the query, calling "fn" for each
+ * matching line
+ */
+static void check_doc(SEARCH *search, uint32_t id) {
+  const TrigramQuery *query = search->query;
+  LOADED_DOC loaded;
+  if (load_doc(search->docs_fd, search->offsets_fd, id, &loaded) != 0)
+    return;
+
+  if ((query->host != NULL && strcmp(loaded.host, query->host) != 0) ||
+      (query->checkid != NULL && strcmp(loaded.checkid, query->checkid) != 0) ||
+      loaded.doc.when < (int64_t)query->from ||
+      loaded.doc.when > (int64_t)query->to) {
+    free(loaded.buffer);
+    return;
+  }
+
+  TrigramMatch match = {0};
+  match.doc = id;
+  match.when = (time_t)loaded.doc.when;
+  match.host = loaded.host;
+  match.checkid = loaded.checkid;
+  match.name = loaded.name;
+  bool matched = false;
+  char *line = loaded.body;
+
+  while (line != NULL && search->stop == 0) {
+    char *newline = strchr(line, '\n');
+    if (newline != NULL)
+      *newline = '\0';
+    match.line_no++;
+
+    if (line_matches(search, line)) {
+      matched = true;
+      match.line = line;
+      search->stop = search->fn(&match, search->arg);
+      if (query->flags & SN_TRIGRAM_FIRST)
+        break;
+    }
+    line = newline != NULL ? newline + 1 : NULL;
+  }
+
+  if (matched)
+    search->matched++;
+  free(loaded.buffer);
+}
+
+static int compare_entries(const void *a, const void *b) {
+  const TrigramEntry *x = *(const TrigramEntry *const *)a;
+  const TrigramEntry *y = *(const TrigramEntry *const *)b;
+  return x->count < y->count ? -1 : (x->count > y->count ? 1 : 0);
+}
+
+/**
+ * Check the documents of a segment with all the trigrams, by intersecting
+ * their postings from the shortest
+ *
+ * @return  0 success
+ *         -2 could not allocate
+ */
+static int search_segment(SEARCH *search, const SEGMENT *segment,
+                          const uint32_t *trigrams, size_t num_trigrams) {
+  const TrigramEntry *entries[TRIGRAM_PATTERN_MAX];
+  for (size_t i = 0; i < num_trigrams; i++) {
+    entries[i] = find_entry(segment, trigrams[i]);
+    if (entries[i] == NULL)
+      return 0; // No document has them all
+  }
+  qsort(entries, num_trigrams, sizeof(entries[0]), compare_entries);
+
+  uint32_t *ids = malloc(entries[0]->count * sizeof(uint32_t));
+  uint32_t *other = malloc(entries[0]->count * sizeof(uint32_t));
+  if (ids == NULL || other == NULL) {
+    free(ids);
+    free(other);
+    return -2;
+  }
+
+  size_t count = entries[0]->count;
+  if (decode_postings(segment, entries[0], ids) != 0)
+    count = 0;
+
+  for (size_t t = 1; t < num_trigrams && count > 0; t++) {
+
+    // Walk the longer list, keeping the ids in both
+
+    const TrigramEntry *entry = entries[t];
+    const unsigned char *src =
+        (const unsigned char *)segment->map + entry->offset;
+    const unsigned char *end =
+        (const unsigned char *)segment->map + segment->size;
+    uint32_t id = segment->header->first;
+    size_t kept = 0;
+    size_t i = 0;
+
+    for (uint32_t k = 0; k < entry->count && i < count; k++) {
+      uint32_t delta;
+      if (sn_varint_get_32(&src, end, &delta) != 0)
+        break;
+      id += delta;
+      while (i < count && ids[i] < id)
+        i++;
+      if (i < count && ids[i] == id)
+        other[kept++] = ids[i++];
+    }
+
+    uint32_t *swap = ids;
+    ids = other;
+    other = swap;
+    count = kept;
+  }
+
+  for (size_t i = 0; i < count && search->stop == 0; i++)
+    check_doc(search, ids[i]);
+
+  free(ids);
+  free(other);
+  return 0;
+}
+
+/**
+ * Search the documents of the index in "dir" for lines matching a query,
+ * calling "fn" for each, in document order
+ *
+ * @return >=0 number of documents matching
+ *         -1 no index
+ *         -2 not a valid pattern
+ *         -3 could not allocate
+ */
+int sn_trigram_search(const char *dir, const TrigramQuery *query,
+                      TrigramMatchFn fn, void *arg) {
+  SEARCH search;
+  memset(&search, 0, sizeof(search));
+  search.query = query;
+  search.fn = fn;
+  search.arg = arg;
+
+  if (query->flags & SN_TRIGRAM_FIXED) {
+    size_t len = strlen(query->pattern);
+    if (len >= sizeof(search.folded))
+      return -2;
+    for (size_t i = 0; i <= len; i++)
+      search.folded[i] = (char)fold((unsigned char)query->pattern[i]);
+  } else {
+    int cflags = REG_EXTENDED | REG_NOSUB;
+    if (query->flags & SN_TRIGRAM_ICASE)
+      cflags |= REG_ICASE;
+    if (regcomp(&search.regex, query->pattern, cflags) != 0)
+      return -2;
+  }
+
+  uint32_t trigrams[TRIGRAM_PATTERN_MAX];
+  int num_trigrams = sn_trigram_required(query->pattern, query->flags,
+                                         trigrams, TRIGRAM_PATTERN_MAX);
+
+  char path[SN_TRIGRAM_NAME_LENGTH + 32];
+  snprintf(path, sizeof(path), "%s/docs.dat", dir);
+  search.docs_fd = open(path, O_RDONLY);
+  snprintf(path, sizeof(path), "%s/docs.off", dir);
+  search.offsets_fd = open(path, O_RDONLY);
+
+  struct stat offsets_stat;
+  SEGMENT_NAME *names = NULL;
+  int count = -1;
+  int result = 0;
+
+  if (search.docs_fd == -1 || search.offsets_fd == -1 ||
+      fstat(search.offsets_fd, &offsets_stat) != 0 ||
+      (count = list_segments(dir, &names)) < 0)
+    result = -1;
+
+  uint32_t num_docs =
+      result == 0 ? (uint32_t)((uint64_t)offsets_stat.st_size /
+                               sizeof(uint64_t))
+                  : 0;
+  uint32_t next = 0; // Documents before it are checked
+
+  for (int s = 0; result == 0 && s < count && search.stop == 0; s++) {
+
+    // Documents in no segment (not yet indexed) are all checked
+
+    for (; next < names[s].first && next < num_docs && search.stop == 0;
+         next++)
+      check_doc(&search, next);
+
+    SEGMENT segment;
+    if (num_trigrams <= 0 || map_segment(dir, &names[s], &segment) != 0)
+      continue;
+    result = search_segment(&search, &segment, trigrams,
+                            (size_t)num_trigrams) == 0
+                 ? 0
+                 : -3;
+    unmap_segment(&segment);
+    next = names[s].end;
+  }
+
+  for (; result == 0 && next < num_docs && search.stop == 0; next++)
+    check_doc(&search, next);
+
+  free(names);
+  if (search.docs_fd != -1)
+    close(search.docs_fd);
+  if (search.offsets_fd != -1)
+    close(search.offsets_fd);
+  if (!(query->flags & SN_TRIGRAM_FIXED))
+    regfree(&search.regex);
+
+  return result == 0 ? search.matched : result;
+}
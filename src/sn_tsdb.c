@@ -0,0 +1,403 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "sn_tsdb.h"
+#include "cn_log.h"
+#include "cn_string.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Series a rollup file is first mapped for, doubled as it grows
+#define TSDB_INITIAL_MAPPED 64
+
+// Bucket, count, min, max and sum
+#define TSDB_SLOT_SIZE (2 * sizeof(uint32_t) + 3 * sizeof(double))
+
+static const struct {
+  const char *name;
+  uint32_t step;
+  uint32_t slots;
+} RESOLUTIONS[SN_TSDB_RESOLUTIONS] = {
+    {"1m", 60, 1440},    // 1 day
+    {"1h", 3600, 2160},  // 90 days
+    {"1d", 86400, 1830}, // ~5 years
+};
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Files                                                          |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+/**
+ * "<Host>\t<CheckID>\t<Metric>", see sn_series.h
+ */
+static void series_name(const char *host, const char *checkid,
+                        const char *metric, char *name, size_t name_sz) {
+  const char *parts[] = {host, checkid, metric};
+  sn_series_name(parts, 3, name, name_sz);
+}
+
+static void rollup_path(const char *dir, int resolution, char *path,
+                        size_t path_sz) {
+  snprintf(path, path_sz, "%s/%s.tsdb", dir, RESOLUTIONS[resolution].name);
+}
+
+static size_t region_size(uint32_t slots) {
+  return (size_t)slots * TSDB_SLOT_SIZE;
+}
+
+/**
+ * Check the header of a rollup file is of this version and resolution
+ */
+static int check_header(const TsdbHeader *header, int resolution) {
+  if (memcmp(header->magic, SN_TSDB_MAGIC, SN_TSDB_MAGIC_LENGTH) != 0 ||
+      header->version != SN_TSDB_VERSION ||
+      header->step != RESOLUTIONS[resolution].step ||
+      header->slots != RESOLUTIONS[resolution].slots)
+    return -1;
+  return 0;
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Add                                                            |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+/**
+ * Open the rollup file of a resolution, creating it if need be
+ */
+static int open_rollup(Tsdb *tsdb, int resolution) {
+  TsdbRollup *rollup = &tsdb->rollups[resolution];
+  rollup->step = RESOLUTIONS[resolution].step;
+  rollup->slots = RESOLUTIONS[resolution].slots;
+
+  char path[SN_TSDB_NAME_LENGTH + 32];
+  rollup_path(tsdb->dir, resolution, path, sizeof(path));
+
+  rollup->fd = open(path, O_RDWR | O_CREAT, 0660);
+  if (rollup->fd == -1) {
+    cn_log_msg(LOG_ERR, __func__,
+               "Could not open metrics file -> %s <-, strerror(errno) -> "
+               "%m <-",
+               path);
+    return -1;
+  }
+
+  TsdbHeader header;
+  ssize_t n = pread(rollup->fd, &header, sizeof(header), 0);
+
+  if (n == 0) {
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SN_TSDB_MAGIC, SN_TSDB_MAGIC_LENGTH);
+    header.version = SN_TSDB_VERSION;
+    header.step = rollup->step;
+    header.slots = rollup->slots;
+    if (pwrite(rollup->fd, &header, sizeof(header), 0) !=
+        (ssize_t)sizeof(header))
+      return -1;
+  } else if (n != (ssize_t)sizeof(header) ||
+             check_header(&header, resolution) != 0) {
+    cn_log_msg(LOG_ERR, __func__, "Not a valid metrics file -> %s <-", path);
+    return -1;
+  }
+  return 0;
+}
+
+/**
+ * Map a rollup file far enough to hold "series", growing the file
+ */
+static int map_rollup(TsdbRollup *rollup, uint32_t series) {
+  if (rollup->map != NULL && series < rollup->mapped_series)
+    return 0;
+
+  uint32_t mapped = rollup->mapped_series != 0 ? rollup->mapped_series * 2
+                                               : TSDB_INITIAL_MAPPED;
+  while (series >= mapped)
+    mapped *= 2;
+
+  size_t size =
+      sizeof(TsdbHeader) + (size_t)mapped * region_size(rollup->slots);
+
+  // Unwritten regions are holes, so the file only uses what is written
+
+  struct stat file_stat;
+  if (fstat(rollup->fd, &file_stat) != 0 ||
+      ((size_t)file_stat.st_size < size &&
+       ftruncate(rollup->fd, (off_t)size) != 0)) {
+    cn_log_msg(LOG_ERR, __func__,
+               "Could not grow metrics file, strerror(errno) -> %m <-");
+    return -1;
+  }
+
+  if (rollup->map != NULL)
+    munmap(rollup->map,
+           sizeof(TsdbHeader) +
+               (size_t)rollup->mapped_series * region_size(rollup->slots));
+
+  rollup->map =
+      mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, rollup->fd, 0);
+  if (rollup->map == MAP_FAILED) {
+    cn_log_msg(LOG_ERR, __func__,
+               "'mmap' gave an error for metrics file, strerror(errno) -> "
+               "%m <-");
+    rollup->map = NULL;
+    rollup->mapped_series = 0;
+    return -1;
+  }
+  rollup->mapped_series = mapped;
+  return 0;
+}
+
+/**
+ * Open the metrics store in "dir", creating it if need be
+ *
+ * @return  0 success
+ *         -1 could not create the dir, or open its files
+ *         -2 could not allocate
+ */
+int sn_tsdb_open(Tsdb *tsdb, const char *dir) {
+  memset(tsdb, 0, sizeof(*tsdb));
+  for (int r = 0; r < SN_TSDB_RESOLUTIONS; r++)
+    tsdb->rollups[r].fd = -1;
+
+  if (cn_string_cp(tsdb->dir, sizeof(tsdb->dir), dir) != 0 ||
+      (mkdir(dir, 0770) != 0 && errno != EEXIST)) {
+    cn_log_msg(LOG_ERR, __func__,
+               "Could not create metrics dir -> %s <-, strerror(errno) -> "
+               "%m <-",
+               dir);
+    return -1;
+  }
+
+  // Series interned so far
+
+  int result = sn_series_open(&tsdb->series, dir);
+  if (result != 0)
+    return result;
+
+  for (int r = 0; r < SN_TSDB_RESOLUTIONS; r++) {
+    if (open_rollup(tsdb, r) != 0) {
+      sn_tsdb_close(tsdb);
+      return -1;
+    }
+  }
+  return 0;
+}
+
+void sn_tsdb_close(Tsdb *tsdb) {
+  for (int r = 0; r < SN_TSDB_RESOLUTIONS; r++) {
+    TsdbRollup *rollup = &tsdb->rollups[r];
+    if (rollup->map != NULL)
+      munmap(rollup->map,
+             sizeof(TsdbHeader) +
+                 (size_t)rollup->mapped_series * region_size(rollup->slots));
+    if (rollup->fd != -1)
+      close(rollup->fd);
+    rollup->map = NULL;
+    rollup->mapped_series = 0;
+    rollup->fd = -1;
+  }
+  sn_series_close(&tsdb->series);
+}
+
+/**
+ * Roll a point up into its bucket of one resolution
+ */
+static void roll_up(TsdbRollup *rollup, uint32_t series, double value,
+                    time_t when) {
+  unsigned char *region = rollup->map + sizeof(TsdbHeader) +
+                          (size_t)series * region_size(rollup->slots);
+  uint32_t *buckets = (uint32_t *)region;
+  uint32_t *counts = buckets + rollup->slots;
+  double *mins = (double *)(counts + rollup->slots);
+  double *maxs = mins + rollup->slots;
+  double *sums = maxs + rollup->slots;
+
+  uint32_t bucket = (uint32_t)(when / rollup->step);
+  size_t i = bucket % rollup->slots;
+
+  if (counts[i] == 0 || buckets[i] < bucket) {
+    buckets[i] = bucket;
+    counts[i] = 1;
+    mins[i] = maxs[i] = sums[i] = value;
+  } else if (buckets[i] == bucket) {
+    counts[i]++;
+    if (value < mins[i])
+      mins[i] = value;
+    if (value > maxs[i])
+      maxs[i] = value;
+    sums[i] += value;
+  }
+
+  // Else older than the slot keeps, dropped
+}
+
+/**
+ * Add a point to the 1 minute, 1 hour and 1 day buckets of its series
+ *
+ * @return  0 success
+ *         -1 error
+ */
+int sn_tsdb_add(Tsdb *tsdb, const char *host, const char *checkid,
+                const char *metric, double value, time_t when) {
+  if (when < 0)
+    return -1;
+
+  char name[3 * SN_TSDB_NAME_LENGTH];
+  series_name(host, checkid, metric, name, sizeof(name));
+
+  int64_t series = sn_series_intern(&tsdb->series, name);
+  if (series < 0)
+    return -1;
+
+  for (int r = 0; r < SN_TSDB_RESOLUTIONS; r++) {
+    if (map_rollup(&tsdb->rollups[r], (uint32_t)series) != 0)
+      return -1;
+    roll_up(&tsdb->rollups[r], (uint32_t)series, value, when);
+  }
+  return 0;
+}
+
+/*----------------------------------------------------------------.
+ |                                                                |
+ | Query                                                          |
+ |                                                                |
+ '----------------------------------------------------------------*/
+
+/**
+ * Resolution of its name, "1m", "1h" or "1d"
+ *
+ * @return >=0 resolution
+ *         -1 no such resolution
+ */
+int sn_tsdb_resolution(const char *name) {
+  for (int r = 0; r < SN_TSDB_RESOLUTIONS; r++) {
+    if (strcmp(name, RESOLUTIONS[r].name) == 0)
+      return r;
+  }
+  return -1;
+}
+
+uint32_t sn_tsdb_step(int resolution) { return RESOLUTIONS[resolution].step; }
+
+/**
+ * Call "fn" for each bucket of "series" from "from" to "to" (inclusive) at
+ * a resolution, in time order. Only the buckets the resolution still keeps
+ * are seen
+ *
+ * @return  0 success
+ *         -1 no store, or not valid
+ *         -2 could not allocate
+ *          else the non zero value "fn" returned, to stop
+ */
+int sn_tsdb_query(const char *dir, int resolution, uint32_t series,
+                  time_t from, time_t to, TsdbBucketFn fn, void *arg) {
+  if (resolution < 0 || resolution >= SN_TSDB_RESOLUTIONS || from < 0 ||
+      to < from)
+    return -1;
+
+  char path[SN_TSDB_NAME_LENGTH + 32];
+  rollup_path(dir, resolution, path, sizeof(path));
+  int fd = open(path, O_RDONLY);
+  if (fd == -1)
+    return -1;
+
+  TsdbHeader header;
+  if (pread(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+      check_header(&header, resolution) != 0) {
+    close(fd);
+    return -1;
+  }
+
+  // Only the columns of the series are read
+
+  size_t size = region_size(header.slots);
+  unsigned char *region = calloc(1, size);
+  if (region == NULL) {
+    close(fd);
+    return -2;
+  }
+  ssize_t n = pread(fd, region, size,
+                    (off_t)(sizeof(header) + (size_t)series * size));
+  close(fd);
+  if (n < 0)
+    n = 0;
+
+  const uint32_t *buckets = (const uint32_t *)region;
+  const uint32_t *counts = buckets + header.slots;
+  const double *mins = (const double *)(counts + header.slots);
+  const double *maxs = mins + header.slots;
+  const double *sums = maxs + header.slots;
+
+  uint64_t first = (uint64_t)from / header.step;
+  uint64_t last = (uint64_t)to / header.step;
+  if (last - first >= header.slots)
+    first = last - header.slots + 1;
+
+  int result = 0;
+  for (uint64_t bucket = first; bucket <= last && result == 0; bucket++) {
+    size_t i = bucket % header.slots;
+    if (counts[i] == 0 || buckets[i] != bucket)
+      continue;
+
+    TsdbBucket found = {(time_t)(bucket * header.step), counts[i], mins[i],
+                        maxs[i], sums[i]};
+    result = fn(&found, arg);
+  }
+
+  free(region);
+  return result;
+}
+
+/**
+ * Series id of a (Host, CheckID, Metric)
+ *
+ * @return >=0 series id
+ *         -1 no metrics of it
+ */
+int64_t sn_tsdb_find(const char *dir, const char *host, const char *checkid,
+                     const char *metric) {
+  char name[3 * SN_TSDB_NAME_LENGTH];
+  series_name(host, checkid, metric, name, sizeof(name));
+  return sn_series_find(dir, name);
+}
+
+/**
+ * "<Host>\t<CheckID>\t<Metric>" of each series, in series id order
+ *
+ * @return  0 success
+ *         -1 no metrics
+ */
+int sn_tsdb_names(const char *dir, MultiString *names) {
+  return sn_series_names(dir, names);
+}
@@ -0,0 +1,80 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "sn_varint.h"
+
+/**
+ * Write "value" as a varint
+ *
+ * @return  bytes written, at most SN_VARINT_MAX
+ */
+size_t sn_varint_put(unsigned char *dest, uint64_t value) {
+  size_t n = 0;
+  while (value >= 0x80) {
+    dest[n++] = (unsigned char)(value | 0x80);
+    value >>= 7;
+  }
+  dest[n++] = (unsigned char)value;
+  return n;
+}
+
+/**
+ * Read a varint, moving "*src" past it
+ *
+ * @return  0 success
+ *         -1 runs past "end", or too long
+ */
+int sn_varint_get(const unsigned char **src, const unsigned char *end,
+                  uint64_t *value) {
+  uint64_t result = 0;
+  const unsigned char *p = *src;
+
+  for (int shift = 0; shift < 7 * SN_VARINT_MAX && p < end; shift += 7) {
+    unsigned char byte = *p++;
+    result |= (uint64_t)(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      *src = p;
+      *value = result;
+      return 0;
+    }
+  }
+  return -1;
+}
+
+/**
+ * Read a varint that must fit a uint32_t, moving "*src" past it
+ *
+ * @return  0 success
+ *         -1 runs past "end", too long, or too large
+ */
+int sn_varint_get_32(const unsigned char **src, const unsigned char *end,
+                     uint32_t *value) {
+  uint64_t result;
+  if (sn_varint_get(src, end, &result) != 0 || result > UINT32_MAX)
+    return -1;
+  *value = (uint32_t)result;
+  return 0;
+}
@@ -0,0 +1,58 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "cn_hash.h"
+#include <criterion/criterion.h>
+#include <string.h>
+
+// Reference values, from the xxHash reference implementation
+
+Test(cn_hash, xxh64_matches_reference) {
+  cr_assert_eq(cn_hash_xxh64("", 0, 0), 0xEF46DB3751D8E999ULL);
+  cr_assert_eq(cn_hash_xxh64("a", 1, 0), 0xD24EC4F1A98C6E5BULL);
+  cr_assert_eq(cn_hash_xxh64("abc", 3, 0), 0x44BC2CF5AD770999ULL);
+
+  const char *long_str = "Nobody inspects the spammish repetition";
+  cr_assert_eq(cn_hash_xxh64(long_str, strlen(long_str), 0),
+               0xFBCEA83C8A378BF1ULL);
+
+  cr_assert_eq(cn_hash_xxh64("xxhash", 6, 20141025), 0xB559B98D844E0635ULL);
+}
+
+Test(cn_hash, xxh64_depends_on_every_byte_and_seed) {
+  char data[100];
+  memset(data, 'x', sizeof(data));
+  uint64_t hash = cn_hash_xxh64(data, sizeof(data), 0);
+
+  for (size_t i = 0; i < sizeof(data); i++) {
+    data[i] = 'y';
+    cr_assert_neq(cn_hash_xxh64(data, sizeof(data), 0), hash);
+    data[i] = 'x';
+  }
+
+  cr_assert_neq(cn_hash_xxh64(data, sizeof(data), 1), hash);
+  cr_assert_neq(cn_hash_xxh64(data, sizeof(data) - 1, 0), hash);
+}
@@ -79,3 +79,25 @@ Test(cn_host_utcdt, formats_time) {
   cr_assert(strlen(time_str) > 0, "Expected a non-empty UTC date/time string");
   cr_log_info("UTC date/time: %s\n", time_str);
 }
+
+Test(cn_host_utcdt, parses_what_it_formats) {
+  char time_str[CN_HOST_UTCDT_LENGTH_D] = {0};
+  time_t before = time(NULL);
+  cr_assert_eq(cn_host_utcdt(time_str), 0);
+
+  time_t when = 0;
+  cr_assert_eq(cn_host_utcdt_parse(time_str, &when), 0);
+  cr_assert_geq(when, before);
+  cr_assert_leq(when, time(NULL));
+
+  cr_assert_eq(cn_host_utcdt_parse("Mon October 19, 2026 12:30:05", &when), 0);
+  cr_assert_eq(when, (time_t)1792413005);
+}
+
+Test(cn_host_utcdt, parse_rejects_other_text) {
+  time_t when = 0;
+  cr_assert_eq(cn_host_utcdt_parse("_______ __, 20__ __:__:__", &when), -1);
+  cr_assert_eq(cn_host_utcdt_parse("Mon Octember 19, 2026 12:30:05", &when),
+               -1);
+  cr_assert_eq(cn_host_utcdt_parse("", &when), -1);
+}
@@ -0,0 +1,133 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "cn_queue.h"
+#include <criterion/criterion.h>
+#include <pthread.h>
+#include <stdint.h>
+
+#define PRODUCERS 4
+#define CONSUMERS 4
+#define ITEMS_PER_PRODUCER 20000
+
+Test(cn_queue, init_rejects_capacity_not_power_of_2) {
+  Queue queue;
+  cr_assert_eq(cn_queue_init(&queue, 0), -1);
+  cr_assert_eq(cn_queue_init(&queue, 1), -1);
+  cr_assert_eq(cn_queue_init(&queue, 100), -1);
+}
+
+Test(cn_queue, push_pop_in_order) {
+  Queue queue;
+  cr_assert_eq(cn_queue_init(&queue, 8), 0);
+  cr_assert_eq(cn_queue_capacity(&queue), 8);
+
+  int values[5] = {1, 2, 3, 4, 5};
+  for (int i = 0; i < 5; i++)
+    cr_assert_eq(cn_queue_push(&queue, &values[i]), 0);
+
+  for (int i = 0; i < 5; i++) {
+    void *item = NULL;
+    cr_assert_eq(cn_queue_pop(&queue, &item), 0);
+    cr_assert_eq(*(int *)item, values[i]);
+  }
+
+  cn_queue_free(&queue);
+}
+
+Test(cn_queue, full_and_empty) {
+  Queue queue;
+  cr_assert_eq(cn_queue_init(&queue, 4), 0);
+
+  void *item = NULL;
+  cr_assert_eq(cn_queue_pop(&queue, &item), -1);
+
+  int value = 42;
+  for (int i = 0; i < 4; i++)
+    cr_assert_eq(cn_queue_push(&queue, &value), 0);
+  cr_assert_eq(cn_queue_push(&queue, &value), -1);
+
+  // Room again, after one pop, and wraps around the cells
+
+  cr_assert_eq(cn_queue_pop(&queue, &item), 0);
+  cr_assert_eq(cn_queue_push(&queue, &value), 0);
+
+  for (int i = 0; i < 4; i++)
+    cr_assert_eq(cn_queue_pop(&queue, &item), 0);
+  cr_assert_eq(cn_queue_pop(&queue, &item), -1);
+
+  cn_queue_free(&queue);
+}
+
+/*
+ * Many producers and consumers, every item is received exactly once
+ */
+
+static Queue MPMC_QUEUE;
+static _Atomic uint64_t RECEIVED_SUM;
+static atomic_size_t RECEIVED_COUNT;
+
+static void *producer(void *arg) {
+  uintptr_t base = (uintptr_t)arg * ITEMS_PER_PRODUCER;
+  for (uintptr_t i = 1; i <= ITEMS_PER_PRODUCER; i++) {
+    while (cn_queue_push(&MPMC_QUEUE, (void *)(base + i)) != 0)
+      ;
+  }
+  return NULL;
+}
+
+static void *consumer(void *arg) {
+  (void)arg;
+  while (atomic_load(&RECEIVED_COUNT) < PRODUCERS * ITEMS_PER_PRODUCER) {
+    void *item;
+    if (cn_queue_pop(&MPMC_QUEUE, &item) == 0) {
+      atomic_fetch_add(&RECEIVED_SUM, (uint64_t)(uintptr_t)item);
+      atomic_fetch_add(&RECEIVED_COUNT, 1);
+    }
+  }
+  return NULL;
+}
+
+Test(cn_queue, mpmc_receives_every_item_once) {
+  cr_assert_eq(cn_queue_init(&MPMC_QUEUE, 64), 0);
+  atomic_init(&RECEIVED_SUM, 0);
+  atomic_init(&RECEIVED_COUNT, 0);
+
+  pthread_t producers[PRODUCERS], consumers[CONSUMERS];
+  for (uintptr_t i = 0; i < PRODUCERS; i++)
+    pthread_create(&producers[i], NULL, producer, (void *)i);
+  for (int i = 0; i < CONSUMERS; i++)
+    pthread_create(&consumers[i], NULL, consumer, NULL);
+
+  for (int i = 0; i < PRODUCERS; i++)
+    pthread_join(producers[i], NULL);
+  for (int i = 0; i < CONSUMERS; i++)
+    pthread_join(consumers[i], NULL);
+
+  uint64_t n = (uint64_t)PRODUCERS * ITEMS_PER_PRODUCER;
+  cr_assert_eq(atomic_load(&RECEIVED_COUNT), n);
+  cr_assert_eq(atomic_load(&RECEIVED_SUM), n * (n + 1) / 2);
+
+  cn_queue_free(&MPMC_QUEUE);
+}
@@ -0,0 +1,176 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "sn1ff.h"
+#include "sn_file.h"
+#include <criterion/criterion.h>
+#include <dirent.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Results are begun under $HOME/sn1ff, so HOME is pointed at a temp dir
+
+#define TEST_HOME "/tmp/test_sn1ff_api"
+
+static char *saved_home = NULL;
+
+static void setup_home(void) {
+  const char *home = getenv("HOME");
+  saved_home = home != NULL ? strdup(home) : NULL;
+  mkdir(TEST_HOME, 0700);
+  setenv("HOME", TEST_HOME, 1);
+}
+
+static void empty_dir(const char *dir_path) {
+  DIR *dir = opendir(dir_path);
+  if (dir == NULL)
+    return;
+
+  struct dirent *entry;
+  char path[512];
+  while ((entry = readdir(dir)) != NULL) {
+    snprintf(path, sizeof(path), "%s/%s", dir_path, entry->d_name);
+    unlink(path);
+  }
+  closedir(dir);
+}
+
+static void teardown_home(void) {
+  empty_dir(TEST_HOME "/sn1ff/outbox");
+  rmdir(TEST_HOME "/sn1ff/outbox");
+  empty_dir(TEST_HOME "/sn1ff");
+  rmdir(TEST_HOME "/sn1ff");
+  rmdir(TEST_HOME);
+
+  if (saved_home != NULL)
+    setenv("HOME", saved_home, 1);
+  free(saved_home);
+  saved_home = NULL;
+}
+
+/**
+ * Path of the one file in a dir, "" if there is not one
+ */
+static void only_file(const char *dir_path, char *path, size_t path_sz) {
+  path[0] = '\0';
+  DIR *dir = opendir(dir_path);
+  if (dir == NULL)
+    return;
+
+  size_t count = 0;
+  struct dirent *entry;
+  while ((entry = readdir(dir)) != NULL) {
+    if (entry->d_name[0] == '.')
+      continue;
+    snprintf(path, path_sz, "%s/%s", dir_path, entry->d_name);
+    count++;
+  }
+  closedir(dir);
+
+  if (count != 1)
+    path[0] = '\0';
+}
+
+static bool body_has_line(const FILE_DATA *data, const char *line) {
+  for (size_t i = 0; i < data->body_lines; i++)
+    if (strncmp(data->body[i], line, strlen(line)) == 0)
+      return true;
+  return false;
+}
+
+Test(sn1ff, null_result_is_rejected) {
+  cr_assert_eq(sn1ff_result_append(NULL, "line"), -1);
+  cr_assert_eq(sn1ff_result_set_status(NULL, SN1FF_OKAY), -1);
+  cr_assert_eq(sn1ff_result_set_ttl(NULL, 5), -1);
+  cr_assert_eq(sn1ff_result_finish(NULL), -1);
+  cr_assert_eq(sn1ff_result_deliver(NULL, NULL), -1);
+  cr_assert_null(sn1ff_result_path(NULL));
+  sn1ff_result_free(NULL);
+}
+
+Test(sn1ff, flush_needs_a_server) {
+  cr_assert_eq(sn1ff_flush(NULL), -1);
+}
+
+Test(sn1ff, begin_append_finish_writes_the_result, .init = setup_home,
+     .fini = teardown_home) {
+  sn1ff_result *result = sn1ff_result_begin("api/disk");
+  cr_assert_not_null(result);
+
+  const char *path = sn1ff_result_path(result);
+  cr_assert_eq(strncmp(path, TEST_HOME "/sn1ff/", strlen(TEST_HOME) + 7), 0);
+
+  cr_assert_eq(sn1ff_result_append(result, "disk 42% used"), 0);
+  cr_assert_eq(sn1ff_result_append(result, "bell\a dropped"), 0);
+  cr_assert_eq(sn1ff_result_set_status(result, SN1FF_WARN), 0);
+  cr_assert_eq(sn1ff_result_finish(result), 0);
+
+  FILE_DATA *data = malloc(sizeof(*data));
+  cr_assert_not_null(data);
+  cr_assert_eq(sn_file_read(path, data), 0);
+  cr_assert_str_eq(data->header.checkid, "api/disk");
+  cr_assert_str_eq(data->header.host, sn_file_host_name());
+  cr_assert(body_has_line(data, "disk 42% used"));
+  cr_assert(body_has_line(data, "bell dropped"));
+  free(data);
+
+  // Not delivered, so it is removed
+
+  char removed[512];
+  snprintf(removed, sizeof(removed), "%s", path);
+  sn1ff_result_free(result);
+  cr_assert_neq(access(removed, F_OK), 0);
+}
+
+Test(sn1ff, deliver_to_server_waits_in_outbox, .init = setup_home,
+     .fini = teardown_home) {
+  sn1ff_result *result = sn1ff_result_begin("api/load");
+  cr_assert_not_null(result);
+  cr_assert_eq(sn1ff_result_append(result, "load 0.5"), 0);
+  cr_assert_eq(sn1ff_result_set_status(result, SN1FF_ALRT), 0);
+  cr_assert_eq(sn1ff_result_set_ttl(result, 7), 0);
+  cr_assert_eq(sn1ff_result_deliver(result, "sn1ff.example"), 0);
+  cr_assert_eq(sn1ff_result_deliver(result, "sn1ff.example"), -1);
+  sn1ff_result_free(result);
+
+  // Named for the status and TTL, with the body kept
+
+  char path[512];
+  only_file(TEST_HOME "/sn1ff/outbox", path, sizeof(path));
+  cr_assert_neq(path[0], '\0');
+  cr_assert_not_null(strstr(path, "ALRT"));
+
+  FILE_DATA *data = malloc(sizeof(*data));
+  cr_assert_not_null(data);
+  cr_assert_eq(sn_file_read(path, data), 0);
+  cr_assert_str_eq(data->header.checkid, "api/load");
+  cr_assert(body_has_line(data, "load 0.5"));
+  free(data);
+}
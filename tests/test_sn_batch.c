@@ -0,0 +1,114 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "sn_batch.h"
+#include <criterion/criterion.h>
+#include <errno.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TEST_BATCH_DIR "/tmp/test_sn1ff_batch"
+
+static void touch(const char *path) {
+  FILE *file = fopen(path, "w");
+  cr_assert_not_null(file);
+  fclose(file);
+}
+
+static void setup_batch_dir(void) { mkdir(TEST_BATCH_DIR, 0777); }
+
+static void teardown_batch_dir(void) {
+  unlink(TEST_BATCH_DIR "/a.snff");
+  unlink(TEST_BATCH_DIR "/b.snff");
+  unlink(TEST_BATCH_DIR "/c.snff");
+  rmdir(TEST_BATCH_DIR);
+}
+
+Test(sn_batch, init_rejects_invalid_capacity) {
+  Batch batch;
+  cr_assert_eq(sn_batch_init(&batch, 0), -1);
+  cr_assert_eq(sn_batch_init(&batch, SN_BATCH_CAPACITY + 1), -1);
+}
+
+Test(sn_batch, add_fails_when_full) {
+  Batch batch;
+  cr_assert_eq(sn_batch_init(&batch, 2), 0);
+  cr_assert_eq(sn_batch_add_unlink(&batch, "/tmp/x", false), 0);
+  cr_assert_eq(sn_batch_add_unlink(&batch, "/tmp/y", false), 0);
+  cr_assert_eq(sn_batch_add_unlink(&batch, "/tmp/z", false), -1);
+
+  sn_batch_reset(&batch);
+  cr_assert_eq(batch.count, 0);
+  sn_batch_free(&batch);
+}
+
+Test(sn_batch, link_rename_unlink, .init = setup_batch_dir,
+     .fini = teardown_batch_dir) {
+  touch(TEST_BATCH_DIR "/a.snff");
+
+  Batch batch;
+  cr_assert_eq(sn_batch_init(&batch, 8), 0);
+  sn_batch_add_link(&batch, TEST_BATCH_DIR "/a.snff", TEST_BATCH_DIR "/b.snff",
+                    true);
+  sn_batch_add_rename(&batch, TEST_BATCH_DIR "/b.snff",
+                      TEST_BATCH_DIR "/c.snff", true);
+  sn_batch_add_unlink(&batch, TEST_BATCH_DIR "/a.snff", false);
+
+  cr_assert_eq(sn_batch_submit(&batch), 0);
+  cr_assert_neq(access(TEST_BATCH_DIR "/a.snff", F_OK), 0);
+  cr_assert_neq(access(TEST_BATCH_DIR "/b.snff", F_OK), 0);
+  cr_assert_eq(access(TEST_BATCH_DIR "/c.snff", F_OK), 0);
+
+  sn_batch_free(&batch);
+}
+
+Test(sn_batch, failed_op_cancels_rest_of_chain_only, .init = setup_batch_dir,
+     .fini = teardown_batch_dir) {
+  touch(TEST_BATCH_DIR "/a.snff");
+  touch(TEST_BATCH_DIR "/c.snff");
+
+  Batch batch;
+  cr_assert_eq(sn_batch_init(&batch, 8), 0);
+
+  // Chain 1: link fails (missing source), so the unlink must not run
+
+  sn_batch_add_link(&batch, TEST_BATCH_DIR "/missing.snff",
+                    TEST_BATCH_DIR "/b.snff", true);
+  sn_batch_add_unlink(&batch, TEST_BATCH_DIR "/a.snff", false);
+
+  // Chain 2: independent, still runs
+
+  sn_batch_add_unlink(&batch, TEST_BATCH_DIR "/c.snff", false);
+
+  cr_assert_eq(sn_batch_submit(&batch), 2);
+  cr_assert_eq(batch.ops[0].result, -ENOENT);
+  cr_assert_eq(batch.ops[1].result, -ECANCELED);
+  cr_assert_eq(batch.ops[2].result, 0);
+
+  cr_assert_eq(access(TEST_BATCH_DIR "/a.snff", F_OK), 0);
+  cr_assert_neq(access(TEST_BATCH_DIR "/c.snff", F_OK), 0);
+
+  sn_batch_free(&batch);
+}
@@ -24,6 +24,7 @@ SOFTWARE.
 
 #include "sn_fname.h"
 #include <criterion/criterion.h>
+#include <stdlib.h>
 #include <string.h>
 
 /*
@@ -169,3 +170,141 @@ Test(sn_cname, parse_guid_name) {
   cr_assert_eq(strlen(fname.cname.epoch.str), 10,
                "Epoch should be 10 chars long");
 }
+
+/*
+ * parse_name, against the sscanf / uuid_parse / strtol parse it replaced
+ */
+
+static int legacy_parse_name(const char *name_str, CName *cname) {
+  char guid_str[CNAME_GUID_LENGTH_D];
+  char status[CNAME_STATUS_LENGTH_D];
+  char epoch_str[CNAME_EPOCH_LENGTH_D];
+
+  if (sscanf(name_str, "%36s_%4s_%10s.snff", guid_str, status, epoch_str) !=
+      3)
+    return -1;
+  if (uuid_parse(guid_str, cname->guid.bin) != 0)
+    return -2;
+
+  strcpy(cname->guid.str, guid_str);
+  strcpy(cname->status, status);
+  strcpy(cname->epoch.str, epoch_str);
+  cname->epoch.bin = (time_t)strtol(epoch_str, NULL, 10);
+  return 0;
+}
+
+static void assert_same_as_legacy(const char *name_str) {
+  CName cname;
+  CName legacy;
+  memset(&cname, 0, sizeof(cname));
+  memset(&legacy, 0, sizeof(legacy));
+
+  cr_assert_eq(sn_cname_parse_name(name_str, &cname), CNAME_PARSE_OK, "%s",
+               name_str);
+  cr_assert_eq(legacy_parse_name(name_str, &legacy), 0, "%s", name_str);
+
+  cr_assert_str_eq(cname.guid.str, legacy.guid.str);
+  cr_assert_eq(memcmp(cname.guid.bin, legacy.guid.bin, sizeof(uuid_t)), 0);
+  cr_assert_str_eq(cname.status, legacy.status);
+  cr_assert_str_eq(cname.epoch.str, legacy.epoch.str);
+  cr_assert_eq(cname.epoch.bin, legacy.epoch.bin);
+}
+
+Test(sn_cname, parse_name_same_as_legacy) {
+  const char *corpus[] = {
+      "e2698951-0380-4af3-a6cc-144c82aa31a7_NONE_1742198614.snff",
+      "E2698951-0380-4AF3-A6CC-144C82AA31A7_ALRT_1742198614.snff",
+      "00000000-0000-0000-0000-000000000000_OKAY_0000000000.snff",
+      "ffffffff-ffff-ffff-ffff-ffffffffffff_WARN_9999999999.snff",
+      "0123abcd-4567-89ef-ABCD-0123456789aB_OKAY_0000000001.SNFF",
+      "9f86d081-884c-4d63-9f5a-3c4e2b1a0f9e_WARN_2000000000.Snff",
+  };
+
+  for (size_t i = 0; i < sizeof(corpus) / sizeof(corpus[0]); i++)
+    assert_same_as_legacy(corpus[i]);
+
+  // Generated names
+
+  for (int i = 0; i < 1000; i++) {
+    uuid_t bin;
+    char guid[CNAME_GUID_LENGTH_D];
+    char name[CNAME_FILE_NAME_LENGTH + 1];
+    const char *statuses[] = {"ALRT", "WARN", "OKAY", "NONE"};
+
+    uuid_generate(bin);
+    uuid_unparse(bin, guid);
+    snprintf(name, sizeof(name), "%s_%s_%010ld.snff", guid, statuses[i % 4],
+             1742198614L + (long)i * 7919);
+    assert_same_as_legacy(name);
+  }
+}
+
+Test(sn_cname, parse_name_rejects_malformed) {
+  struct {
+    const char *name;
+    int code;
+  } corpus[] = {
+      {"", CNAME_PARSE_ERR_LENGTH},
+      {"e2698951-0380-4af3-a6cc-144c82aa31a7_NONE_1742198614.snf",
+       CNAME_PARSE_ERR_LENGTH},
+      {"e2698951-0380-4af3-a6cc-144c82aa31a7_NONE_1742198614.snffx",
+       CNAME_PARSE_ERR_LENGTH},
+      {"e2698951-0380-4af3-a6cc-144c82aa31a7_NONE_174219861.snff",
+       CNAME_PARSE_ERR_LENGTH},
+      {"g2698951-0380-4af3-a6cc-144c82aa31a7_NONE_1742198614.snff",
+       CNAME_PARSE_ERR_GUID},
+      {"e2698951_0380-4af3-a6cc-144c82aa31a7_NONE_1742198614.snff",
+       CNAME_PARSE_ERR_GUID},
+      {"e2698951-0380-4af3-a6cc-144c82aa31a _NONE_1742198614.snff",
+       CNAME_PARSE_ERR_GUID},
+      {"e2698951-0380-4af3-a6cc-144c82aa31a7-NONE_1742198614.snff",
+       CNAME_PARSE_ERR_SEPARATOR},
+      {"e2698951-0380-4af3-a6cc-144c82aa31a7_NONE-1742198614.snff",
+       CNAME_PARSE_ERR_SEPARATOR},
+      {"e2698951-0380-4af3-a6cc-144c82aa31a7_none_1742198614.snff",
+       CNAME_PARSE_ERR_STATUS},
+      {"e2698951-0380-4af3-a6cc-144c82aa31a7_INFO_1742198614.snff",
+       CNAME_PARSE_ERR_STATUS},
+      {"e2698951-0380-4af3-a6cc-144c82aa31a7_NONE_174219861x.snff",
+       CNAME_PARSE_ERR_EPOCH},
+      {"e2698951-0380-4af3-a6cc-144c82aa31a7_NONE_-742198614.snff",
+       CNAME_PARSE_ERR_EPOCH},
+      {"e2698951-0380-4af3-a6cc-144c82aa31a7_NONE_1742198614.txt_",
+       CNAME_PARSE_ERR_EXTENSION},
+      {"e2698951-0380-4af3-a6cc-144c82aa31a7_NONE_1742198614_snff",
+       CNAME_PARSE_ERR_EXTENSION},
+  };
+
+  for (size_t i = 0; i < sizeof(corpus) / sizeof(corpus[0]); i++) {
+    CName cname;
+    cr_assert_eq(sn_cname_parse_name(corpus[i].name, &cname), corpus[i].code,
+                 "%s", corpus[i].name);
+  }
+}
+
+Test(sn_cname, parse_name_fuzz) {
+  const char *valid =
+      "e2698951-0380-4af3-a6cc-144c82aa31a7_WARN_1742198614.snff";
+  const char alphabet[] = "0123456789abcdefABCDEF-_.snffALRTWARNxyz \xff";
+  srand(1742198614);
+
+  // Mutate 1 to 3 characters, any name accepted must be accepted by the
+  // legacy parse with the same result
+
+  for (int i = 0; i < 20000; i++) {
+    char name[CNAME_FILE_NAME_LENGTH + 1];
+    strcpy(name, valid);
+
+    int mutations = 1 + rand() % 3;
+    for (int m = 0; m < mutations; m++)
+      name[rand() % CNAME_FILE_NAME_LENGTH] =
+          alphabet[rand() % (sizeof(alphabet) - 1)];
+
+    CName cname;
+    int result = sn_cname_parse_name(name, &cname);
+    cr_assert(result <= CNAME_PARSE_OK && result >= CNAME_PARSE_ERR_EXTENSION);
+
+    if (result == CNAME_PARSE_OK)
+      assert_same_as_legacy(name);
+  }
+}
@@ -0,0 +1,305 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "sn_dedup.h"
+#include "sn_file.h"
+#include <criterion/criterion.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TEST_DEDUP_DIR "/tmp/test_sn1ff_dedup"
+
+#define NAME_1 "00000001-0000-0000-0000-000000000000_OKAY_1742198601.snff"
+#define NAME_2 "00000002-0000-0000-0000-000000000000_OKAY_1742198602.snff"
+#define NAME_3 "00000003-0000-0000-0000-000000000000_OKAY_1742198603.snff"
+#define NAME_4 "00000004-0000-0000-0000-000000000000_WARN_1742198604.snff"
+#define NAME_5 "00000005-0000-0000-0000-000000000000_WARN_1742198605.snff"
+#define NAME_6 "00000006-0000-0000-0000-000000000000_OKAY_1742198606.snff"
+
+#define TEST_STATE_FILE TEST_DEDUP_DIR "/checks.state"
+#define NOW 1742198000
+#define HOUR 3600
+
+static void write_result(const char *name, const char *host,
+                         const char *checkid, const char *at,
+                         const char *body) {
+  char path[256];
+  snprintf(path, sizeof(path), "%s/%s", TEST_DEDUP_DIR, name);
+  FILE *file = fopen(path, "w");
+  cr_assert_not_null(file);
+  fprintf(file,
+          "App: sn1ff\nVer: 1.0\nHost: %s\nIPv4: 192.0.2.1\nAt: %s\n"
+          "CheckID: %s\n\n\n%s",
+          host, at, checkid, body);
+  fclose(file);
+}
+
+static void setup_dir(void) { mkdir(TEST_DEDUP_DIR, 0777); }
+
+static void teardown_dir(void) {
+  const char *names[] = {NAME_1, NAME_2, NAME_3, NAME_4, NAME_5, NAME_6};
+  char path[256];
+  for (size_t i = 0; i < 6; i++) {
+    snprintf(path, sizeof(path), "%s/%s", TEST_DEDUP_DIR, names[i]);
+    unlink(path);
+  }
+  unlink(TEST_STATE_FILE);
+  rmdir(TEST_DEDUP_DIR);
+}
+
+Test(sn_dedup, repeat_ignores_time_only, .init = setup_dir,
+     .fini = teardown_dir) {
+  Dedup dedup;
+  char previous[CNAME_NAME_LENGTH_D];
+  cr_assert_eq(sn_dedup_init(&dedup, false, 0), 0);
+
+  write_result(NAME_1, "host1", "disk", "Mar 17, 2025 08:00:01", "ok\n");
+  write_result(NAME_2, "host1", "disk", "Mar 17, 2025 09:00:01", "ok\n");
+  write_result(NAME_3, "host1", "disk", "Mar 17, 2025 10:00:01", "full\n");
+
+  cr_assert_eq(sn_dedup_check(&dedup, TEST_DEDUP_DIR, NAME_1, NOW, previous),
+               SN_DEDUP_WATCH);
+  cr_assert_eq(sn_dedup_check(&dedup, TEST_DEDUP_DIR, NAME_2, NOW, previous),
+               SN_DEDUP_WATCH | SN_DEDUP_REPEAT);
+  cr_assert_str_eq(previous, NAME_1);
+
+  // Body changed
+
+  cr_assert_eq(sn_dedup_check(&dedup, TEST_DEDUP_DIR, NAME_3, NOW, previous),
+               SN_DEDUP_WATCH);
+  cr_assert_eq(dedup.count, 1);
+
+  sn_dedup_free(&dedup);
+}
+
+Test(sn_dedup, status_host_and_check_are_distinct, .init = setup_dir,
+     .fini = teardown_dir) {
+  Dedup dedup;
+  char previous[CNAME_NAME_LENGTH_D];
+  cr_assert_eq(sn_dedup_init(&dedup, false, 0), 0);
+
+  write_result(NAME_1, "host1", "disk", "At 1", "ok\n");
+  write_result(NAME_2, "host2", "disk", "At 2", "ok\n");
+  write_result(NAME_3, "host1", "load", "At 3", "ok\n");
+  write_result(NAME_4, "host1", "disk", "At 4", "ok\n");
+
+  cr_assert_eq(sn_dedup_check(&dedup, TEST_DEDUP_DIR, NAME_1, NOW, previous),
+               SN_DEDUP_WATCH);
+  cr_assert_eq(sn_dedup_check(&dedup, TEST_DEDUP_DIR, NAME_2, NOW, previous),
+               SN_DEDUP_WATCH);
+  cr_assert_eq(sn_dedup_check(&dedup, TEST_DEDUP_DIR, NAME_3, NOW, previous),
+               SN_DEDUP_WATCH);
+
+  // Same file as NAME_1, but WARN rather than OKAY
+
+  cr_assert_eq(sn_dedup_check(&dedup, TEST_DEDUP_DIR, NAME_4, NOW, previous),
+               SN_DEDUP_WATCH);
+  cr_assert_eq(dedup.count, 3);
+
+  sn_dedup_free(&dedup);
+}
+
+Test(sn_dedup, older_and_retried_files_not_repeats, .init = setup_dir,
+     .fini = teardown_dir) {
+  Dedup dedup;
+  char previous[CNAME_NAME_LENGTH_D];
+  cr_assert_eq(sn_dedup_init(&dedup, false, 0), 0);
+
+  write_result(NAME_1, "host1", "disk", "At 1", "ok\n");
+  write_result(NAME_2, "host1", "disk", "At 2", "ok\n");
+
+  cr_assert_eq(sn_dedup_check(&dedup, TEST_DEDUP_DIR, NAME_2, NOW, previous),
+               SN_DEDUP_WATCH);
+  cr_assert_eq(sn_dedup_check(&dedup, TEST_DEDUP_DIR, NAME_1, NOW, previous),
+               SN_DEDUP_WATCH);
+  cr_assert_eq(sn_dedup_check(&dedup, TEST_DEDUP_DIR, NAME_2, NOW, previous),
+               SN_DEDUP_WATCH);
+
+  cr_assert_eq(sn_dedup_check(&dedup, TEST_DEDUP_DIR, "not_a_name.snff", NOW,
+                              previous),
+               -1);
+
+  sn_dedup_free(&dedup);
+}
+
+Test(sn_dedup, table_grows, .init = setup_dir, .fini = teardown_dir) {
+  Dedup dedup;
+  char previous[CNAME_NAME_LENGTH_D];
+  char checkid[32];
+  cr_assert_eq(sn_dedup_init(&dedup, false, 0), 0);
+
+  for (int i = 0; i < 1000; i++) {
+    snprintf(checkid, sizeof(checkid), "check%d", i);
+    write_result(NAME_1, "host1", checkid, "At 1", "ok\n");
+    cr_assert_eq(sn_dedup_check(&dedup, TEST_DEDUP_DIR, NAME_1, NOW, previous),
+                 SN_DEDUP_WATCH);
+  }
+  cr_assert_eq(dedup.count, 1000);
+
+  // Every check is still found
+
+  write_result(NAME_2, "host1", "check500", "At 2", "ok\n");
+  cr_assert_eq(sn_dedup_check(&dedup, TEST_DEDUP_DIR, NAME_2, NOW, previous),
+               SN_DEDUP_WATCH | SN_DEDUP_REPEAT);
+  cr_assert_str_eq(previous, NAME_1);
+
+  sn_dedup_free(&dedup);
+}
+
+Test(sn_dedup, transitions_only_keeps_unchanged_status_out_of_watch,
+     .init = setup_dir, .fini = teardown_dir) {
+  Dedup dedup;
+  char previous[CNAME_NAME_LENGTH_D];
+  cr_assert_eq(sn_dedup_init(&dedup, true, HOUR), 0);
+
+  write_result(NAME_1, "host1", "disk", "At 1", "ok\n");
+  write_result(NAME_2, "host1", "disk", "At 2", "ok\n");
+  write_result(NAME_3, "host1", "disk", "At 3", "still ok\n");
+  write_result(NAME_4, "host1", "disk", "At 4", "full\n");
+  write_result(NAME_5, "host1", "disk", "At 5", "full\n");
+  write_result(NAME_6, "host1", "disk", "At 6", "ok\n");
+
+  cr_assert_eq(sn_dedup_check(&dedup, TEST_DEDUP_DIR, NAME_1, NOW, previous),
+               SN_DEDUP_WATCH);
+
+  // Same status, same or other body
+
+  cr_assert_eq(sn_dedup_check(&dedup, TEST_DEDUP_DIR, NAME_2, NOW, previous),
+               0);
+  cr_assert_eq(sn_dedup_check(&dedup, TEST_DEDUP_DIR, NAME_3, NOW, previous),
+               0);
+
+  // WARN, then still WARN
+
+  cr_assert_eq(sn_dedup_check(&dedup, TEST_DEDUP_DIR, NAME_4, NOW, previous),
+               SN_DEDUP_WATCH);
+  cr_assert_eq(sn_dedup_check(&dedup, TEST_DEDUP_DIR, NAME_5, NOW, previous),
+               SN_DEDUP_WATCH | SN_DEDUP_REPEAT);
+  cr_assert_str_eq(previous, NAME_4);
+
+  // Back to OKAY is a change
+
+  cr_assert_eq(sn_dedup_check(&dedup, TEST_DEDUP_DIR, NAME_6, NOW, previous),
+               SN_DEDUP_WATCH);
+
+  sn_dedup_free(&dedup);
+}
+
+Test(sn_dedup, heartbeat_shows_unchanged_status, .init = setup_dir,
+     .fini = teardown_dir) {
+  Dedup dedup;
+  char previous[CNAME_NAME_LENGTH_D];
+  cr_assert_eq(sn_dedup_init(&dedup, true, HOUR), 0);
+
+  write_result(NAME_1, "host1", "disk", "At 1", "ok\n");
+  write_result(NAME_2, "host1", "disk", "At 2", "ok\n");
+  write_result(NAME_3, "host1", "disk", "At 3", "ok\n");
+
+  cr_assert_eq(sn_dedup_check(&dedup, TEST_DEDUP_DIR, NAME_1, NOW, previous),
+               SN_DEDUP_WATCH);
+  cr_assert_eq(sn_dedup_check(&dedup, TEST_DEDUP_DIR, NAME_2,
+                              NOW + HOUR - 1, previous),
+               0);
+
+  // Replaces the last result shown, it has the same body
+
+  cr_assert_eq(sn_dedup_check(&dedup, TEST_DEDUP_DIR, NAME_3, NOW + HOUR,
+                              previous),
+               SN_DEDUP_WATCH | SN_DEDUP_REPEAT);
+  cr_assert_str_eq(previous, NAME_1);
+
+  sn_dedup_free(&dedup);
+}
+
+Test(sn_dedup, state_saved_and_loaded, .init = setup_dir,
+     .fini = teardown_dir) {
+  Dedup dedup;
+  char previous[CNAME_NAME_LENGTH_D];
+  cr_assert_eq(sn_dedup_init(&dedup, true, HOUR), 0);
+
+  write_result(NAME_1, "host1", "disk", "At 1", "ok\n");
+  write_result(NAME_2, "host1", "disk", "At 2", "ok\n");
+
+  cr_assert_eq(sn_dedup_check(&dedup, TEST_DEDUP_DIR, NAME_1, NOW, previous),
+               SN_DEDUP_WATCH);
+  cr_assert(dedup.dirty);
+  cr_assert_eq(sn_dedup_save(&dedup, TEST_STATE_FILE), 0);
+  cr_assert_not(dedup.dirty);
+  sn_dedup_free(&dedup);
+
+  // After a restart, the last status and heartbeat time carry on
+
+  cr_assert_eq(sn_dedup_init(&dedup, true, HOUR), 0);
+  cr_assert_eq(sn_dedup_load(&dedup, TEST_STATE_FILE), 0);
+  cr_assert_eq(dedup.count, 1);
+  cr_assert_eq(sn_dedup_check(&dedup, TEST_DEDUP_DIR, NAME_2, NOW + 60,
+                              previous),
+               0);
+
+  // A damaged state file is ignored
+
+  FILE *file = fopen(TEST_STATE_FILE, "a");
+  cr_assert_not_null(file);
+  fputs("x", file);
+  fclose(file);
+
+  cr_assert_eq(sn_dedup_load(&dedup, TEST_STATE_FILE), -2);
+  cr_assert_eq(dedup.count, 0);
+  cr_assert_eq(sn_dedup_load(&dedup, TEST_DEDUP_DIR "/missing"), -1);
+
+  sn_dedup_free(&dedup);
+}
+
+Test(sn_dedup, v2_file_key_matches_v1, .init = setup_dir,
+     .fini = teardown_dir) {
+  write_result(NAME_1, "host1", "disk", "Mar 17, 2025 08:00:01", "ok\n");
+
+  HEADER hdr = {.host = "host1",
+                .ipv4 = "192.0.2.1",
+                .timestamp = "Mar 17, 2025 09:00:01",
+                .checkid = "disk"};
+  char path[256];
+  snprintf(path, sizeof(path), "%s/%s", TEST_DEDUP_DIR, NAME_2);
+  FILE *file = fopen(path, "w");
+  cr_assert_not_null(file);
+  cr_assert_eq(sn_file_write_header_fmt(file, &hdr, SN_FILE_FORMAT_V2), 0);
+  fputs("ok\n", file);
+  fclose(file);
+
+  uint64_t key_1, key_2, body_2, body_3;
+  cr_assert_eq(sn_dedup_hash_file(TEST_DEDUP_DIR "/" NAME_1, 0, &key_1,
+                                  &body_3),
+               0);
+  cr_assert_eq(sn_dedup_hash_file(path, 0, &key_2, &body_2), 0);
+  cr_assert_eq(key_1, key_2);
+
+  // Finishing sets the times and status in the preamble, not the body hash
+
+  cr_assert_eq(sn_file_finish(path, SN_STATUS_OKAY), 0);
+  cr_assert_eq(sn_dedup_hash_file(path, 0, &key_2, &body_3), 0);
+  cr_assert_eq(body_2, body_3);
+}
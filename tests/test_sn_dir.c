@@ -99,3 +99,46 @@ Test(sn_dir_list_files, handles_nonexistent_directory) {
   cr_assert_eq(result, 1);
   cn_multistr_free(&ms);
 }
+
+static int count_name(const char *name, void *arg) {
+  (void)name;
+  (*(int *)arg)++;
+  return 0;
+}
+
+static int stop_at_first(const char *name, void *arg) {
+  (void)name;
+  (*(int *)arg)++;
+  return 1;
+}
+
+Test(sn_dir_each_file, skips_dirs_and_stops_when_asked) {
+  const char *test_dir = "./test_snff_each_dir";
+  mkdir(test_dir, 0700);
+  mkdir("./test_snff_each_dir/sub.snff", 0700);
+
+  char path[64];
+  for (int i = 0; i < 3; i++) {
+    snprintf(path, sizeof(path), "./test_snff_each_dir/file%d.snff", i);
+    FILE *f = fopen(path, "w");
+    fclose(f);
+  }
+
+  int count = 0;
+  cr_assert_eq(sn_dir_each_file(test_dir, count_name, &count), 0);
+  cr_assert_eq(count, 3);
+
+  count = 0;
+  cr_assert_eq(sn_dir_each_file(test_dir, stop_at_first, &count), 2);
+  cr_assert_eq(count, 1);
+
+  cr_assert_eq(sn_dir_each_file("./no_such_dir", count_name, &count), 1);
+
+  // Cleanup
+  for (int i = 0; i < 3; i++) {
+    snprintf(path, sizeof(path), "./test_snff_each_dir/file%d.snff", i);
+    unlink(path);
+  }
+  rmdir("./test_snff_each_dir/sub.snff");
+  rmdir(test_dir);
+}
@@ -28,6 +28,9 @@ SOFTWARE.
 #include "sn_fname.h"
 #include <criterion/criterion.h>
 #include <criterion/logging.h>
+#include <grp.h>
+#include <pthread.h>
+#include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
 #include <unistd.h>
@@ -95,6 +98,36 @@ Test(sn_file, begin_creates_file, .init = setup_test_dir,
   unlink(path);
 }
 
+static void *begin_from_thread(void *arg) {
+  char *path = arg;
+  if (sn_file_begin(path, "/debug/thread") != 0)
+    path[0] = '\0';
+  return NULL;
+}
+
+Test(sn_file, begin_from_threads) {
+  char paths[4][FNAME_PATH_LENGTH_D] = {{0}};
+  pthread_t threads[4];
+
+  for (int i = 0; i < 4; i++)
+    cr_assert_eq(pthread_create(&threads[i], NULL, begin_from_thread,
+                                paths[i]),
+                 0);
+  for (int i = 0; i < 4; i++)
+    pthread_join(threads[i], NULL);
+
+  for (int i = 0; i < 4; i++) {
+    cr_assert_neq(paths[i][0], '\0');
+
+    FILE_DATA *data = malloc(sizeof(*data));
+    cr_assert_not_null(data);
+    cr_assert_eq(sn_file_read(paths[i], data), 0);
+    cr_assert_str_eq(data->header.host, sn_file_host_name());
+    free(data);
+    unlink(paths[i]);
+  }
+}
+
 Test(sn_file, read_and_parse_file, .init = setup_test_dir,
      .fini = teardown_test_dir) {
   // Manually create a valid snff file
@@ -131,3 +164,299 @@ Test(sn_file, delete_file_safely, .init = setup_test_dir) {
   int deleted = stat(deleted_path, &st);
   cr_assert(deleted != 0); // file should be removed
 }
+
+/*
+ * Format v2
+ */
+
+static const HEADER V2_HEADER = {.host = "testhost",
+                                 .ipv4 = "127.0.0.1",
+                                 .timestamp = "2025-04-13T12:00:00Z",
+                                 .checkid = "/disk/usage.sh"};
+
+static void write_result(int format, const char *body) {
+  FILE *f = fopen(TEST_FILE_PATH, "w");
+  cr_assert_not_null(f);
+  cr_assert_eq(sn_file_write_header_fmt(f, &V2_HEADER, format), 0);
+  fputs(body, f);
+  fclose(f);
+}
+
+Test(sn_file, read_v1_and_v2_alike, .init = setup_test_dir,
+     .fini = teardown_test_dir) {
+  static FILE_DATA v1, v2;
+
+  write_result(SN_FILE_FORMAT_V1, "Line 1\nLine 2\n");
+  cr_assert_eq(sn_file_read(TEST_FILE_PATH, &v1), 0);
+
+  write_result(SN_FILE_FORMAT_V2, "Line 1\nLine 2\n");
+  cr_assert_eq(sn_file_read(TEST_FILE_PATH, &v2), 0);
+
+  cr_assert_str_eq(v2.header.host, "testhost");
+  cr_assert_str_eq(v2.header.ipv4, "127.0.0.1");
+  cr_assert_str_eq(v2.header.timestamp, "2025-04-13T12:00:00Z");
+  cr_assert_str_eq(v2.header.checkid, "/disk/usage.sh");
+  cr_assert_eq(v2.body_lines, 3);
+  cr_assert_eq(memcmp(&v1, &v2, sizeof(v1)), 0);
+
+  HEADER hdr;
+  cr_assert_eq(sn_file_read_header(TEST_FILE_PATH, &hdr), 0);
+  cr_assert_str_eq(hdr.checkid, "/disk/usage.sh");
+}
+
+Test(sn_file, read_body_keeps_long_lines, .init = setup_test_dir,
+     .fini = teardown_test_dir) {
+  char line[201];
+  memset(line, 'x', 200);
+  line[200] = '\0';
+
+  char *bodies[2];
+  size_t lengths[2];
+  int formats[] = {SN_FILE_FORMAT_V1, SN_FILE_FORMAT_V2};
+
+  for (size_t i = 0; i < 2; i++) {
+    write_result(formats[i], line);
+    cr_assert_eq(sn_file_read_body(TEST_FILE_PATH, SN_FILE_MAX_RAW_BODY,
+                                   &bodies[i], &lengths[i]),
+                 0);
+    cr_assert_not_null(strstr(bodies[i], line));
+  }
+  cr_assert_eq(lengths[0], lengths[1]);
+  cr_assert_str_eq(bodies[0], bodies[1]);
+
+  // Cut to the bytes asked for
+
+  char *cut;
+  size_t cut_len;
+  cr_assert_eq(sn_file_read_body(TEST_FILE_PATH, 10, &cut, &cut_len), 1);
+  cr_assert_eq(cut_len, 10);
+  cr_assert_eq(strncmp(cut, bodies[1], 10), 0);
+
+  free(cut);
+  free(bodies[0]);
+  free(bodies[1]);
+}
+
+Test(sn_file, read_marks_a_cut_body, .init = setup_test_dir,
+     .fini = teardown_test_dir) {
+  static FILE_DATA data;
+
+  write_result(SN_FILE_FORMAT_V2, "Line 1\nLine 2\n");
+  cr_assert_eq(sn_file_read(TEST_FILE_PATH, &data), 0);
+  cr_assert_not(data.body_truncated);
+
+  // A line past SN_FILE_MAX_BODY_LENGTH, and past the 512 bytes read at a
+  // time, is cut, its rest not taken as a line
+
+  char body[1024];
+  memset(body, 'x', 700);
+  strcpy(body + 700, "\nLine 2\n");
+  write_result(SN_FILE_FORMAT_V2, body);
+  cr_assert_eq(sn_file_read(TEST_FILE_PATH, &data), 0);
+  cr_assert(data.body_truncated);
+  cr_assert_eq(data.body_lines, 3);
+  cr_assert_eq(strncmp(data.body[2], "Line 2 ", 7), 0);
+
+  // More lines than are kept
+
+  char lines[(SN_FILE_MAX_BODY_LINES + 1) * 2 + 1];
+  for (size_t i = 0; i < SN_FILE_MAX_BODY_LINES + 1; i++)
+    memcpy(lines + i * 2, "x\n", 2);
+  lines[sizeof(lines) - 1] = '\0';
+  write_result(SN_FILE_FORMAT_V2, lines);
+  cr_assert_eq(sn_file_read(TEST_FILE_PATH, &data), 0);
+  cr_assert_eq(data.body_lines, SN_FILE_MAX_BODY_LINES);
+  cr_assert(data.body_truncated);
+}
+
+Test(sn_file, finish_v2_sets_preamble, .init = setup_test_dir,
+     .fini = teardown_test_dir) {
+  write_result(SN_FILE_FORMAT_V2, "Line 1\x01\nLine 2");
+  cr_assert_eq(sn_file_finish(TEST_FILE_PATH, SN_STATUS_WARN), 0);
+
+  unsigned char buffer[512];
+  FILE *f = fopen(TEST_FILE_PATH, "r");
+  cr_assert_not_null(f);
+  size_t length = fread(buffer, 1, sizeof(buffer), f);
+  fclose(f);
+
+  PREAMBLE preamble;
+  HEADER hdr;
+  cr_assert_eq(sn_file_parse_preamble(buffer, length, &preamble, &hdr), 0);
+  cr_assert_eq(preamble.line_count, 3);
+  cr_assert_eq(preamble.status, SN_STATUS_WARN);
+  cr_assert_geq(preamble.finished, preamble.begun);
+  cr_assert_gt(preamble.begun, 0);
+  cr_assert_str_eq(hdr.host, "testhost");
+
+  // Only the body is cleaned
+
+  cr_assert_eq(length - preamble.body_offset, strlen("\nLine 1\nLine 2"));
+  cr_assert_eq(memcmp(buffer + preamble.body_offset, "\nLine 1\nLine 2",
+                      length - preamble.body_offset),
+               0);
+}
+
+Test(sn_file, parse_preamble_rejects_bad_v2) {
+  unsigned char buffer[SN_FILE_V2_PREAMBLE_SZ + 8] = {0};
+  PREAMBLE preamble;
+  HEADER hdr;
+
+  // Not v2
+
+  memcpy(buffer, "App:", 4);
+  cr_assert_eq(sn_file_parse_preamble(buffer, sizeof(buffer), &preamble, &hdr),
+               1);
+
+  // Truncated
+
+  memcpy(buffer, SN_FILE_V2_MAGIC, 4);
+  cr_assert_eq(sn_file_parse_preamble(buffer, 8, &preamble, &hdr), -1);
+
+  // Header block runs past the body offset
+
+  buffer[4] = SN_FILE_FORMAT_V2;
+  buffer[6] = 8;
+  buffer[8] = SN_FILE_V2_PREAMBLE_SZ + 8;
+  buffer[SN_FILE_V2_PREAMBLE_SZ] = 200;
+  cr_assert_eq(sn_file_parse_preamble(buffer, sizeof(buffer), &preamble, &hdr),
+               -1);
+}
+
+/*
+ * Publish
+ */
+
+#define TEST_PUBLISH_DIR TEST_TMP_DIR "/published"
+#define TEST_SHM_DIR "/dev/shm/test_sn1ff"
+
+static void setup_publish_dirs(void) {
+  mkdir(TEST_TMP_DIR, 0777);
+  mkdir(TEST_PUBLISH_DIR, 0777);
+  mkdir(TEST_SHM_DIR, 0777);
+
+  FILE *f = fopen(TEST_FILE_PATH, "w");
+  fprintf(f, "App: sn1ff\n\nPublished body\n");
+  fclose(f);
+}
+
+static void teardown_publish_dirs(void) {
+  unlink(TEST_PUBLISH_DIR "/test.snff");
+  unlink(TEST_SHM_DIR "/test.snff");
+  rmdir(TEST_PUBLISH_DIR);
+  rmdir(TEST_SHM_DIR);
+  teardown_test_dir();
+}
+
+Test(sn_file, publish_same_filesystem_hard_links, .init = setup_publish_dirs,
+     .fini = teardown_publish_dirs) {
+  int result = sn_file_publish(TEST_TMP_DIR, TEST_PUBLISH_DIR, "test.snff");
+  cr_assert_eq(result, SN_FILE_PUBLISH_LINK);
+
+  struct stat src, dst;
+  cr_assert_eq(stat(TEST_FILE_PATH, &src), 0);
+  cr_assert_eq(stat(TEST_PUBLISH_DIR "/test.snff", &dst), 0);
+  cr_assert_eq(src.st_ino, dst.st_ino);
+
+  // Publishing again replaces the published file
+
+  result = sn_file_publish(TEST_TMP_DIR, TEST_PUBLISH_DIR, "test.snff");
+  cr_assert_eq(result, SN_FILE_PUBLISH_LINK);
+
+  // The published file survives the source being deleted
+
+  sn_file_delete(TEST_TMP_DIR, "test.snff");
+  cr_assert_eq(stat(TEST_PUBLISH_DIR "/test.snff", &dst), 0);
+  cr_assert_eq(dst.st_nlink, 1);
+}
+
+Test(sn_file, publish_other_filesystem_copies, .init = setup_publish_dirs,
+     .fini = teardown_publish_dirs) {
+  struct stat tmp_dir, shm_dir;
+  cr_assert_eq(stat(TEST_TMP_DIR, &tmp_dir), 0);
+  cr_assert_eq(stat(TEST_SHM_DIR, &shm_dir), 0);
+
+  int result = sn_file_publish(TEST_TMP_DIR, TEST_SHM_DIR, "test.snff");
+  if (tmp_dir.st_dev == shm_dir.st_dev)
+    cr_assert_eq(result, SN_FILE_PUBLISH_LINK);
+  else
+    cr_assert_gt(result, SN_FILE_PUBLISH_LINK);
+
+  FILE *f = fopen(TEST_SHM_DIR "/test.snff", "r");
+  cr_assert_not_null(f);
+  char buffer[64] = {0};
+  size_t n = fread(buffer, 1, sizeof(buffer) - 1, f);
+  fclose(f);
+  cr_assert_eq(n, strlen("App: sn1ff\n\nPublished body\n"));
+  cr_assert_str_eq(buffer, "App: sn1ff\n\nPublished body\n");
+}
+
+Test(sn_file, publish_missing_source_fails, .init = setup_publish_dirs,
+     .fini = teardown_publish_dirs) {
+  int result = sn_file_publish(TEST_TMP_DIR, TEST_PUBLISH_DIR, "none.snff");
+  cr_assert_eq(result, -1);
+}
+
+/*
+ * Move
+ */
+
+static const char *own_group(void) {
+  struct group *grp = getgrgid(getegid());
+  cr_assert_not_null(grp);
+  return grp->gr_name;
+}
+
+Test(sn_file, move_same_filesystem_renames, .init = setup_publish_dirs,
+     .fini = teardown_publish_dirs) {
+  struct stat src, dst;
+  cr_assert_eq(stat(TEST_FILE_PATH, &src), 0);
+
+  int result =
+      sn_file_move(TEST_FILE_PATH, TEST_PUBLISH_DIR "/test.snff", own_group());
+  cr_assert_eq(result, SN_FILE_PUBLISH_RENAME);
+
+  cr_assert_neq(access(TEST_FILE_PATH, F_OK), 0);
+  cr_assert_eq(stat(TEST_PUBLISH_DIR "/test.snff", &dst), 0);
+  cr_assert_eq(src.st_ino, dst.st_ino);
+  cr_assert_eq(dst.st_mode & 0777, 0660);
+}
+
+Test(sn_file, move_other_filesystem_copies, .init = setup_publish_dirs,
+     .fini = teardown_publish_dirs) {
+  struct stat tmp_dir, shm_dir;
+  cr_assert_eq(stat(TEST_TMP_DIR, &tmp_dir), 0);
+  cr_assert_eq(stat(TEST_SHM_DIR, &shm_dir), 0);
+
+  int result =
+      sn_file_move(TEST_FILE_PATH, TEST_SHM_DIR "/test.snff", own_group());
+  if (tmp_dir.st_dev == shm_dir.st_dev)
+    cr_assert_eq(result, SN_FILE_PUBLISH_RENAME);
+  else
+    cr_assert_neq(result, -1);
+
+  // Moved whole, with no temp file left behind
+
+  cr_assert_neq(access(TEST_FILE_PATH, F_OK), 0);
+  cr_assert_neq(access(TEST_SHM_DIR "/.test.snff.tmp", F_OK), 0);
+
+  struct stat dst;
+  cr_assert_eq(stat(TEST_SHM_DIR "/test.snff", &dst), 0);
+  cr_assert_eq(dst.st_mode & 0777, 0660);
+  cr_assert_eq(dst.st_gid, getegid());
+
+  FILE *f = fopen(TEST_SHM_DIR "/test.snff", "r");
+  cr_assert_not_null(f);
+  char buffer[64] = {0};
+  size_t n = fread(buffer, 1, sizeof(buffer) - 1, f);
+  fclose(f);
+  cr_assert_eq(n, strlen("App: sn1ff\n\nPublished body\n"));
+  cr_assert_str_eq(buffer, "App: sn1ff\n\nPublished body\n");
+}
+
+Test(sn_file, move_missing_source_fails, .init = setup_publish_dirs,
+     .fini = teardown_publish_dirs) {
+  int result = sn_file_move(TEST_TMP_DIR "/none.snff",
+                            TEST_PUBLISH_DIR "/none.snff", own_group());
+  cr_assert_eq(result, -1);
+}
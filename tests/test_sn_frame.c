@@ -0,0 +1,93 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "sn_frame.h"
+#include <criterion/criterion.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Output of one command line, to compare
+
+static char *frame(const char *command) {
+  char line[256];
+  char *output = NULL;
+  size_t output_sz = 0;
+
+  FILE *out = open_memstream(&output, &output_sz);
+  cr_assert_not_null(out);
+  strcpy(line, command);
+  cr_assert_eq(sn_frame_line(out, line), 0);
+  fclose(out);
+  return output;
+}
+
+Test(sn_frame, title_is_spaced_and_boxed) {
+  char *output = frame("title DISK");
+  cr_assert_str_eq(output, "                                  .---------.\n"
+                           "                                  |         |\n"
+                           "                                  | D I S K |\n"
+                           "                                  |         |\n"
+                           "                                  '---------'\n"
+                           "\n");
+  free(output);
+}
+
+Test(sn_frame, messages_and_headers) {
+  char *output = frame("message  two spaces");
+  cr_assert_str_eq(output, " two spaces\n");
+  free(output);
+
+  output = frame("header HDR");
+  cr_assert_str_eq(output, "\n\nHDR\n\n");
+  free(output);
+
+  output = frame("first HDR");
+  cr_assert_str_eq(output, "HDR\n\n");
+  free(output);
+}
+
+Test(sn_frame, center_and_trailer) {
+  char *output = frame("center OKAY");
+  cr_assert_eq(strspn(output, " "), 38);
+  cr_assert_str_eq(output + 38, "OKAY\n\n\n");
+  free(output);
+
+  output = frame("trailer");
+  cr_assert_eq(strlen(output), 1 + SN_FRAME_WIDTH + 2);
+  cr_assert_eq(strspn(output + 1, "-"), SN_FRAME_WIDTH);
+  free(output);
+}
+
+Test(sn_frame, control_characters_dropped) {
+  char *output = frame("message a\x1b[31mb\tc\x7f");
+  cr_assert_str_eq(output, "a[31mb\tc\n");
+  free(output);
+}
+
+Test(sn_frame, unknown_command_rejected) {
+  char line[] = "bogus text";
+  cr_assert_eq(sn_frame_line(stdout, line), -1);
+}
@@ -0,0 +1,177 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "sn_history.h"
+#include <criterion/criterion.h>
+#include <dirent.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TEST_HISTORY_DIR "/tmp/test_sn1ff_history"
+
+// Mon Mar 17, 2025 00:00:00 UTC
+#define DAY_1 1742169600
+#define DAY_2 (DAY_1 + SN_HISTORY_DAY_SECS)
+#define HOUR 3600
+
+static void teardown_dir(void) {
+  DIR *d = opendir(TEST_HISTORY_DIR);
+  if (d != NULL) {
+    struct dirent *entry;
+    char path[512];
+    while ((entry = readdir(d)) != NULL) {
+      snprintf(path, sizeof(path), "%s/%s", TEST_HISTORY_DIR, entry->d_name);
+      unlink(path);
+    }
+    closedir(d);
+  }
+  rmdir(TEST_HISTORY_DIR);
+}
+
+typedef struct {
+  int64_t when[16];
+  Status status[16];
+  size_t count;
+} RECORDS;
+
+static int collect(int64_t when, Status status, void *arg) {
+  RECORDS *records = arg;
+  if (records->count < 16) {
+    records->when[records->count] = when;
+    records->status[records->count] = status;
+    records->count++;
+  }
+  return 0;
+}
+
+Test(sn_history, records_only_changes, .fini = teardown_dir) {
+  History history;
+  cr_assert_eq(sn_history_open(&history, TEST_HISTORY_DIR), 0);
+
+  Status statuses[] = {SN_STATUS_OKAY, SN_STATUS_OKAY, SN_STATUS_WARN,
+                       SN_STATUS_WARN, SN_STATUS_OKAY};
+  int expected[] = {1, 0, 1, 0, 1};
+  for (int i = 0; i < 5; i++)
+    cr_assert_eq(sn_history_record(&history, "host1", "disk", statuses[i],
+                                   DAY_1 + i * HOUR),
+                 expected[i]);
+  sn_history_close(&history);
+
+  int64_t series = sn_history_find(TEST_HISTORY_DIR, "host1", "disk");
+  cr_assert_eq(series, 0);
+  cr_assert_eq(sn_history_find(TEST_HISTORY_DIR, "host1", "none"), -1);
+
+  RECORDS records = {0};
+  sn_history_each(TEST_HISTORY_DIR, 0, DAY_1, DAY_2, collect, &records);
+  cr_assert_eq(records.count, 3);
+  cr_assert_eq(records.when[0], DAY_1);
+  cr_assert_eq(records.status[1], SN_STATUS_WARN);
+  cr_assert_eq(records.when[1], DAY_1 + 2 * HOUR);
+  cr_assert_eq(records.when[2], DAY_1 + 4 * HOUR);
+}
+
+Test(sn_history, last_status_kept_across_reopen, .fini = teardown_dir) {
+  History history;
+  cr_assert_eq(sn_history_open(&history, TEST_HISTORY_DIR), 0);
+  cr_assert_eq(sn_history_record(&history, "host1", "disk", SN_STATUS_ALRT,
+                                 DAY_1),
+               1);
+  cr_assert_eq(sn_history_record(&history, "host2", "disk", SN_STATUS_OKAY,
+                                 DAY_1),
+               1);
+  sn_history_close(&history);
+
+  cr_assert_eq(sn_history_open(&history, TEST_HISTORY_DIR), 0);
+  cr_assert_eq(history.series.count, 2);
+  cr_assert_eq(sn_history_record(&history, "host1", "disk", SN_STATUS_ALRT,
+                                 DAY_1 + HOUR),
+               0);
+  cr_assert_eq(sn_history_record(&history, "host2", "disk", SN_STATUS_WARN,
+                                 DAY_1 + HOUR),
+               1);
+  sn_history_close(&history);
+
+  cr_assert_eq(sn_history_find(TEST_HISTORY_DIR, "host2", "disk"), 1);
+
+  MultiString names;
+  cn_multistr_init(&names);
+  cr_assert_eq(sn_history_names(TEST_HISTORY_DIR, &names), 0);
+  cr_assert_eq(names.num_strings, 2);
+  cr_assert_str_eq(cn_multistr_getstr(&names, 1), "host2\tdisk");
+  cn_multistr_free(&names);
+}
+
+Test(sn_history, index_reads_as_log, .fini = teardown_dir) {
+  History history;
+  cr_assert_eq(sn_history_open(&history, TEST_HISTORY_DIR), 0);
+
+  // Two series flapping over two days, the first day is indexed on the
+  // change of day
+
+  for (int i = 0; i < 48; i++) {
+    Status status = i % 2 ? SN_STATUS_WARN : SN_STATUS_OKAY;
+    sn_history_record(&history, "host1", "disk", status, DAY_1 + i * HOUR);
+    if (i % 4 == 0)
+      sn_history_record(&history, "host2", "load",
+                        i % 8 ? SN_STATUS_ALRT : SN_STATUS_OKAY,
+                        DAY_1 + i * HOUR);
+  }
+  sn_history_close(&history);
+
+  struct stat st;
+  cr_assert_eq(stat(TEST_HISTORY_DIR "/20250317.idx", &st), 0);
+  cr_assert_neq(stat(TEST_HISTORY_DIR "/20250318.idx", &st), 0);
+
+  // Partial days, from the index and the log
+
+  RECORDS records = {0};
+  sn_history_each(TEST_HISTORY_DIR, 1, DAY_1 + 4 * HOUR, DAY_2 + 8 * HOUR,
+                  collect, &records);
+  cr_assert_eq(records.count, 8);
+  cr_assert_eq(records.when[0], DAY_1 + 4 * HOUR);
+  cr_assert_eq(records.status[0], SN_STATUS_ALRT);
+  cr_assert_eq(records.when[7], DAY_2 + 8 * HOUR);
+
+  uint32_t counts[2] = {0};
+  sn_history_counts(TEST_HISTORY_DIR, DAY_1, DAY_2 + 23 * HOUR, counts, 2);
+  cr_assert_eq(counts[0], 48);
+  cr_assert_eq(counts[1], 12);
+
+  // Both days indexed, the same counts
+
+  cr_assert_eq(sn_history_index_all(TEST_HISTORY_DIR,
+                                    DAY_2 / SN_HISTORY_DAY_SECS + 1),
+               1);
+  counts[0] = counts[1] = 0;
+  sn_history_counts(TEST_HISTORY_DIR, DAY_1, DAY_2 + 23 * HOUR, counts, 2);
+  cr_assert_eq(counts[0], 48);
+  cr_assert_eq(counts[1], 12);
+
+  counts[0] = counts[1] = 0;
+  sn_history_counts(TEST_HISTORY_DIR, DAY_1 + 12 * HOUR, DAY_2 - 1, counts, 2);
+  cr_assert_eq(counts[0], 12);
+}
@@ -0,0 +1,207 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "sn_index.h"
+#include "sn_shard.h"
+#include <criterion/criterion.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TEST_INDEX_DIR "/tmp/test_sn1ff_index"
+#define TEST_INDEX_FILE "/tmp/test_sn1ff_index.idx"
+
+static const char *NAMES[] = {
+    "3fa85f64-5717-4562-b3fc-2c963f66afa6_OKAY_1742198614.snff",
+    "e2698951-0380-4af3-a6cc-144c82aa31a7_ALRT_1742198615.snff",
+    "not_a_sn1ff_name.snff",
+};
+#define NUM_NAMES (sizeof(NAMES) / sizeof(NAMES[0]))
+
+static void touch(const char *dir, const char *name) {
+  char path[512];
+  snprintf(path, sizeof(path), "%s/%s", dir, name);
+  FILE *file = fopen(path, "w");
+  cr_assert_not_null(file);
+  fclose(file);
+}
+
+// Give a dir an mtime old enough for the index to trust
+static void age_dir(const char *dir, time_t secs) {
+  struct timespec times[2] = {{secs, 0}, {secs, 0}};
+  cr_assert_eq(utimensat(AT_FDCWD, dir, times, 0), 0);
+}
+
+static void setup_dir(void) {
+  mkdir(TEST_INDEX_DIR, 0700);
+  for (size_t i = 0; i < NUM_NAMES; i++)
+    touch(TEST_INDEX_DIR, NAMES[i]);
+  age_dir(TEST_INDEX_DIR, 1000000000);
+}
+
+static void teardown_dir(void) {
+  char path[512];
+  for (size_t i = 0; i < NUM_NAMES; i++) {
+    snprintf(path, sizeof(path), "%s/%s", TEST_INDEX_DIR, NAMES[i]);
+    unlink(path);
+  }
+  snprintf(path, sizeof(path), "%s/%s", TEST_INDEX_DIR,
+           "00000000-0000-0000-0000-000000000000_WARN_1742198616.snff");
+  unlink(path);
+  rmdir(TEST_INDEX_DIR);
+  unlink(TEST_INDEX_FILE);
+}
+
+static int find_entry(const IndexEntry *entry, void *arg) {
+  if (strcmp(entry->name, NAMES[0]) != 0)
+    return 0;
+  *(const IndexEntry **)arg = entry;
+  return 1;
+}
+
+Test(sn_index, refresh_only_rescans_changed_dirs, .init = setup_dir,
+     .fini = teardown_dir) {
+  Index index;
+  cr_assert_eq(sn_index_init(&index, TEST_INDEX_DIR, SN_SHARD_NONE), 0);
+
+  cr_assert_eq(sn_index_refresh(&index), 1);
+  cr_assert_eq(index.count, NUM_NAMES);
+  cr_assert(index.dirty);
+
+  const IndexEntry *entry = NULL;
+  cr_assert_eq(sn_index_each(&index, find_entry, &entry), 2);
+  cr_assert_eq(entry->status, SN_STATUS_OKAY);
+  cr_assert_eq(entry->expiry, 1742198614);
+
+  // Unchanged
+
+  cr_assert_eq(sn_index_refresh(&index), 0);
+
+  // Changed
+
+  touch(TEST_INDEX_DIR,
+        "00000000-0000-0000-0000-000000000000_WARN_1742198616.snff");
+  age_dir(TEST_INDEX_DIR, 1000000001);
+  cr_assert_eq(sn_index_refresh(&index), 1);
+  cr_assert_eq(index.count, NUM_NAMES + 1);
+
+  sn_index_free(&index);
+}
+
+Test(sn_index, recent_mtime_is_rescanned, .init = setup_dir,
+     .fini = teardown_dir) {
+  Index index;
+  cr_assert_eq(sn_index_init(&index, TEST_INDEX_DIR, SN_SHARD_NONE), 0);
+
+  age_dir(TEST_INDEX_DIR, time(NULL));
+  cr_assert_eq(sn_index_refresh(&index), 1);
+  cr_assert_eq(sn_index_refresh(&index), 1);
+
+  sn_index_free(&index);
+}
+
+Test(sn_index, checkpoint_round_trip, .init = setup_dir,
+     .fini = teardown_dir) {
+  Index index;
+  cr_assert_eq(sn_index_init(&index, TEST_INDEX_DIR, SN_SHARD_NONE), 0);
+  cr_assert_eq(sn_index_refresh(&index), 1);
+  cr_assert_eq(sn_index_save(&index, TEST_INDEX_FILE), 0);
+  cr_assert_not(index.dirty);
+  sn_index_free(&index);
+
+  // Warm start, nothing to rescan
+
+  Index loaded;
+  cr_assert_eq(sn_index_init(&loaded, TEST_INDEX_DIR, SN_SHARD_NONE), 0);
+  cr_assert_eq(sn_index_load(&loaded, TEST_INDEX_FILE), 0);
+  cr_assert_eq(loaded.count, NUM_NAMES);
+  cr_assert_eq(sn_index_refresh(&loaded), 0);
+
+  const IndexEntry *entry = NULL;
+  cr_assert_eq(sn_index_each(&loaded, find_entry, &entry), 2);
+  cr_assert_eq(entry->expiry, 1742198614);
+  sn_index_free(&loaded);
+
+  // Checkpoint of another layout
+
+  cr_assert_eq(sn_index_init(&loaded, TEST_INDEX_DIR, SN_SHARD_256), 0);
+  cr_assert_eq(sn_index_load(&loaded, TEST_INDEX_FILE), -2);
+  cr_assert_eq(loaded.count, 0);
+  sn_index_free(&loaded);
+}
+
+Test(sn_index, load_rejects_bad_checkpoint, .init = setup_dir,
+     .fini = teardown_dir) {
+  Index index;
+  cr_assert_eq(sn_index_init(&index, TEST_INDEX_DIR, SN_SHARD_NONE), 0);
+  cr_assert_eq(sn_index_load(&index, "/tmp/no_such_sn1ff_index.idx"), -1);
+
+  cr_assert_eq(sn_index_refresh(&index), 1);
+  cr_assert_eq(sn_index_save(&index, TEST_INDEX_FILE), 0);
+
+  // Truncated
+
+  struct stat st;
+  cr_assert_eq(stat(TEST_INDEX_FILE, &st), 0);
+  cr_assert_eq(truncate(TEST_INDEX_FILE, st.st_size - 1), 0);
+
+  cr_assert_eq(sn_index_load(&index, TEST_INDEX_FILE), -2);
+  cr_assert_eq(index.count, 0);
+  cr_assert_eq(sn_index_refresh(&index), 1);
+
+  sn_index_free(&index);
+}
+
+Test(sn_index, sharded_dir) {
+  cr_assert_eq(mkdir(TEST_INDEX_DIR, 0700), 0);
+  cr_assert_eq(sn_shard_create_dirs(TEST_INDEX_DIR, SN_SHARD_256), 0);
+
+  char path[512];
+  for (size_t i = 0; i < 2; i++) {
+    cr_assert_eq(sn_shard_dir(TEST_INDEX_DIR, NAMES[i], SN_SHARD_256, path,
+                              sizeof(path)),
+                 0);
+    touch(path, NAMES[i]);
+  }
+
+  Index index;
+  cr_assert_eq(sn_index_init(&index, TEST_INDEX_DIR, SN_SHARD_256), 0);
+  cr_assert_eq(sn_index_refresh(&index), 256);
+  cr_assert_eq(index.count, 2);
+  sn_index_free(&index);
+
+  for (size_t i = 0; i < 2; i++) {
+    sn_shard_path(TEST_INDEX_DIR, NAMES[i], SN_SHARD_256, path, sizeof(path));
+    unlink(path);
+  }
+  for (int i = 0; i < SN_SHARD_256; i++) {
+    sn_shard_index_dir(TEST_INDEX_DIR, SN_SHARD_256, i, path, sizeof(path));
+    rmdir(path);
+  }
+  rmdir(TEST_INDEX_DIR);
+}
@@ -0,0 +1,309 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "sn_ingest.h"
+#include <criterion/criterion.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TEST_INGEST_DIR "/tmp/test_sn1ff_ingest"
+#define TEST_UPLOAD_DIR TEST_INGEST_DIR "/upload"
+#define TEST_WATCH_DIR TEST_INGEST_DIR "/watch"
+#define TEST_EXPORT_DIR TEST_INGEST_DIR "/export"
+
+#define TEST_FILES 50
+
+static void write_file(const char *dir, const char *name) {
+  char path[256];
+  snprintf(path, sizeof(path), "%s/%s", dir, name);
+  FILE *file = fopen(path, "w");
+  cr_assert_not_null(file);
+  fprintf(file, "App: sn1ff\n\nbody\n");
+  fclose(file);
+}
+
+static bool file_exists(const char *dir, const char *name) {
+  char path[256];
+  snprintf(path, sizeof(path), "%s/%s", dir, name);
+  return access(path, F_OK) == 0;
+}
+
+static void test_name(size_t i, char *name, size_t size) {
+  snprintf(name, size, "%08zu-0000-0000-0000-000000000000_OKAY_1.snff", i);
+}
+
+static void setup_dirs(void) {
+  mkdir(TEST_INGEST_DIR, 0777);
+  mkdir(TEST_UPLOAD_DIR, 0777);
+  mkdir(TEST_WATCH_DIR, 0777);
+  mkdir(TEST_EXPORT_DIR, 0777);
+}
+
+static void teardown_dirs(void) {
+  const char *dirs[] = {TEST_UPLOAD_DIR, TEST_WATCH_DIR, TEST_EXPORT_DIR};
+  char name[64];
+  char path[256];
+
+  for (size_t d = 0; d < 3; d++) {
+    for (size_t i = 0; i < TEST_FILES; i++) {
+      test_name(i, name, sizeof(name));
+      snprintf(path, sizeof(path), "%s/%s", dirs[d], name);
+      unlink(path);
+    }
+    rmdir(dirs[d]);
+  }
+  rmdir(TEST_INGEST_DIR);
+}
+
+Test(sn_ingest, file_copied_then_deleted, .init = setup_dirs,
+     .fini = teardown_dirs) {
+  char name[64];
+  test_name(0, name, sizeof(name));
+  write_file(TEST_UPLOAD_DIR, name);
+
+  int result =
+      sn_ingest_file(TEST_UPLOAD_DIR, TEST_WATCH_DIR, TEST_EXPORT_DIR, 0, name);
+  cr_assert_eq(result, 0);
+
+  cr_assert(file_exists(TEST_WATCH_DIR, name));
+  cr_assert(file_exists(TEST_EXPORT_DIR, name));
+  cr_assert_not(file_exists(TEST_UPLOAD_DIR, name));
+}
+
+Test(sn_ingest, file_kept_when_copy_fails, .init = setup_dirs,
+     .fini = teardown_dirs) {
+  char name[64];
+  test_name(0, name, sizeof(name));
+  write_file(TEST_UPLOAD_DIR, name);
+
+  int result = sn_ingest_file(TEST_UPLOAD_DIR, TEST_WATCH_DIR,
+                              TEST_INGEST_DIR "/missing", 0, name);
+  cr_assert_eq(result, -2);
+
+  cr_assert(file_exists(TEST_WATCH_DIR, name));
+  cr_assert(file_exists(TEST_UPLOAD_DIR, name));
+}
+
+Test(sn_ingest, start_rejects_invalid_workers) {
+  Ingest ingest;
+  cr_assert_eq(sn_ingest_start(&ingest, TEST_UPLOAD_DIR, NULL, NULL, 0, NULL, 0),
+               -1);
+  cr_assert_eq(sn_ingest_start(&ingest, TEST_UPLOAD_DIR, NULL, NULL, 0, NULL,
+                               SN_INGEST_MAX_WORKERS + 1),
+               -1);
+}
+
+Test(sn_ingest, pool_publishes_all_files, .init = setup_dirs,
+     .fini = teardown_dirs) {
+  char name[64];
+  for (size_t i = 0; i < TEST_FILES; i++) {
+    test_name(i, name, sizeof(name));
+    write_file(TEST_UPLOAD_DIR, name);
+  }
+
+  Ingest ingest;
+  cr_assert_eq(
+      sn_ingest_start(&ingest, TEST_UPLOAD_DIR, TEST_WATCH_DIR, NULL, 0, NULL,
+                      4),
+      0);
+
+  for (size_t i = 0; i < TEST_FILES; i++) {
+    test_name(i, name, sizeof(name));
+    cr_assert_eq(sn_ingest_submit(&ingest, name), 0);
+  }
+  sn_ingest_drain(&ingest);
+
+  cr_assert_eq(atomic_load(&ingest.published), TEST_FILES);
+  cr_assert_eq(atomic_load(&ingest.failed), 0);
+
+  for (size_t i = 0; i < TEST_FILES; i++) {
+    test_name(i, name, sizeof(name));
+    cr_assert(file_exists(TEST_WATCH_DIR, name));
+    cr_assert_not(file_exists(TEST_UPLOAD_DIR, name));
+    cr_assert_not(file_exists(TEST_EXPORT_DIR, name));
+  }
+
+  sn_ingest_stop(&ingest);
+}
+
+Test(sn_ingest, export_only_files_kept_out_of_watch, .init = setup_dirs,
+     .fini = teardown_dirs) {
+  char name[64];
+  for (size_t i = 0; i < TEST_FILES; i++) {
+    test_name(i, name, sizeof(name));
+    write_file(TEST_UPLOAD_DIR, name);
+  }
+
+  Ingest ingest;
+  cr_assert_eq(sn_ingest_start(&ingest, TEST_UPLOAD_DIR, TEST_WATCH_DIR,
+                               TEST_EXPORT_DIR, 0, NULL, 2),
+               0);
+
+  // Even files to "watch" and "export", odd to "export" only
+
+  for (size_t i = 0; i < TEST_FILES; i++) {
+    test_name(i, name, sizeof(name));
+    int result = i % 2 == 0 ? sn_ingest_submit(&ingest, name)
+                            : sn_ingest_submit_export(&ingest, name);
+    cr_assert_eq(result, 0);
+  }
+  sn_ingest_drain(&ingest);
+
+  cr_assert_eq(atomic_load(&ingest.published), TEST_FILES);
+
+  for (size_t i = 0; i < TEST_FILES; i++) {
+    test_name(i, name, sizeof(name));
+    cr_assert_eq(file_exists(TEST_WATCH_DIR, name), i % 2 == 0);
+    cr_assert(file_exists(TEST_EXPORT_DIR, name));
+    cr_assert_not(file_exists(TEST_UPLOAD_DIR, name));
+  }
+
+  sn_ingest_stop(&ingest);
+}
+
+Test(sn_ingest, keeps_names_of_published_files, .init = setup_dirs,
+     .fini = teardown_dirs) {
+  char name[64];
+  for (size_t i = 0; i < TEST_FILES; i++) {
+    test_name(i, name, sizeof(name));
+    write_file(TEST_UPLOAD_DIR, name);
+  }
+
+  // "export" disabled, so the odd files, for "export" only, are dropped
+
+  Ingest ingest;
+  MultiString kept;
+  cn_multistr_init(&kept);
+  cr_assert_eq(sn_ingest_start(&ingest, TEST_UPLOAD_DIR, TEST_WATCH_DIR,
+                               NULL, 0, NULL, 4),
+               0);
+  sn_ingest_keep_published(&ingest, &kept);
+
+  for (size_t i = 0; i < TEST_FILES; i++) {
+    test_name(i, name, sizeof(name));
+    int result = i % 2 == 0 ? sn_ingest_submit(&ingest, name)
+                            : sn_ingest_submit_export(&ingest, name);
+    cr_assert_eq(result, 0);
+  }
+  sn_ingest_drain(&ingest);
+
+  cr_assert_eq(atomic_load(&ingest.published), TEST_FILES);
+  cr_assert_eq(kept.num_strings, TEST_FILES / 2);
+  for (size_t i = 0; i < kept.num_strings; i++)
+    cr_assert(file_exists(TEST_WATCH_DIR, cn_multistr_getstr(&kept, i)));
+
+  sn_ingest_stop(&ingest);
+  cn_multistr_free(&kept);
+}
+
+#define TEST_JOURNAL TEST_INGEST_DIR "/ingest.journal"
+
+static void count_file(const char *name, int state, void *arg) {
+  (void)name;
+  (void)state;
+  (*(int *)arg)++;
+}
+
+Test(sn_ingest, journaled_pool_leaves_no_file_part_way, .init = setup_dirs,
+     .fini = teardown_dirs) {
+  char name[64];
+  for (size_t i = 0; i < TEST_FILES; i++) {
+    test_name(i, name, sizeof(name));
+    write_file(TEST_UPLOAD_DIR, name);
+  }
+
+  Journal journal;
+  cr_assert_eq(sn_journal_open(&journal, TEST_JOURNAL), 0);
+
+  Ingest ingest;
+  cr_assert_eq(sn_ingest_start(&ingest, TEST_UPLOAD_DIR, TEST_WATCH_DIR,
+                               TEST_EXPORT_DIR, 0, &journal, 4),
+               0);
+  for (size_t i = 0; i < TEST_FILES; i++) {
+    test_name(i, name, sizeof(name));
+    cr_assert_eq(sn_ingest_submit(&ingest, name), 0);
+  }
+  sn_ingest_drain(&ingest);
+  sn_ingest_stop(&ingest);
+  sn_journal_close(&journal);
+
+  cr_assert_eq(atomic_load(&ingest.published), TEST_FILES);
+
+  int part_way = 0;
+  cr_assert_eq(sn_journal_replay(TEST_JOURNAL, count_file, &part_way), 0);
+  cr_assert_eq(part_way, 0);
+
+  unlink(TEST_JOURNAL);
+}
+
+Test(sn_ingest, recover_resumes_from_journal_state, .init = setup_dirs,
+     .fini = teardown_dirs) {
+  char staged[64];
+  char watched[64];
+  char exported[64];
+  test_name(0, staged, sizeof(staged));
+  test_name(1, watched, sizeof(watched));
+  test_name(2, exported, sizeof(exported));
+
+  write_file(TEST_UPLOAD_DIR, staged);
+  write_file(TEST_UPLOAD_DIR, watched);
+  write_file(TEST_UPLOAD_DIR, exported);
+
+  // Stopped with one file staged, one in "watch" only, one in both
+
+  Journal journal;
+  cr_assert_eq(sn_journal_open(&journal, TEST_JOURNAL), 0);
+  sn_journal_append(&journal, SN_JOURNAL_STAGED, staged);
+  sn_journal_append(&journal, SN_JOURNAL_STAGED, watched);
+  sn_journal_append(&journal, SN_JOURNAL_STAGED, exported);
+  sn_journal_append(&journal, SN_JOURNAL_WATCH, watched);
+  sn_journal_append(&journal, SN_JOURNAL_WATCH, exported);
+  sn_journal_append(&journal, SN_JOURNAL_EXPORT, exported);
+  sn_journal_close(&journal);
+
+  MultiString resumed;
+  cn_multistr_init(&resumed);
+  cr_assert_eq(sn_ingest_recover(TEST_JOURNAL, TEST_UPLOAD_DIR,
+                                 TEST_WATCH_DIR, TEST_EXPORT_DIR, 0, &resumed),
+               2);
+  cr_assert_eq(resumed.num_strings, 2);
+  cn_multistr_free(&resumed);
+
+  // Staged is left for the next pass
+
+  cr_assert(file_exists(TEST_UPLOAD_DIR, staged));
+
+  // Only the missing "export" is redone, "watch" is not republished
+
+  cr_assert_not(file_exists(TEST_UPLOAD_DIR, watched));
+  cr_assert_not(file_exists(TEST_WATCH_DIR, watched));
+  cr_assert(file_exists(TEST_EXPORT_DIR, watched));
+
+  cr_assert_not(file_exists(TEST_UPLOAD_DIR, exported));
+  cr_assert_not(file_exists(TEST_WATCH_DIR, exported));
+  cr_assert_not(file_exists(TEST_EXPORT_DIR, exported));
+
+  unlink(TEST_JOURNAL);
+}
@@ -0,0 +1,123 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "sn_journal.h"
+#include <criterion/criterion.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TEST_JOURNAL "/tmp/test_sn1ff.journal"
+
+#define NAME_A "3fa85f64-5717-4562-b3fc-2c963f66afa6_OKAY_1742198614.snff"
+#define NAME_B "e2698951-0380-4af3-a6cc-144c82aa31a7_ALRT_1742198615.snff"
+#define NAME_C "00000000-0000-0000-0000-000000000000_WARN_1742198616.snff"
+
+typedef struct {
+  int count;
+  char names[4][SN_JOURNAL_NAME_LENGTH_D];
+  int states[4];
+} REPLAYED;
+
+static void collect(const char *name, int state, void *arg) {
+  REPLAYED *replayed = arg;
+  cr_assert_lt(replayed->count, 4);
+  strcpy(replayed->names[replayed->count], name);
+  replayed->states[replayed->count++] = state;
+}
+
+static int state_of(const REPLAYED *replayed, const char *name) {
+  for (int i = 0; i < replayed->count; i++) {
+    if (strcmp(replayed->names[i], name) == 0)
+      return replayed->states[i];
+  }
+  return 0;
+}
+
+static void fini_journal(void) { unlink(TEST_JOURNAL); }
+
+Test(sn_journal, replay_gives_last_state, .init = fini_journal,
+     .fini = fini_journal) {
+  Journal journal;
+  cr_assert_eq(sn_journal_open(&journal, TEST_JOURNAL), 0);
+
+  uint64_t seq = sn_journal_append(&journal, SN_JOURNAL_STAGED, NAME_A);
+  sn_journal_append(&journal, SN_JOURNAL_STAGED, NAME_B);
+  sn_journal_append(&journal, SN_JOURNAL_STAGED, NAME_C);
+  cr_assert_eq(seq, 1);
+
+  seq = sn_journal_append(&journal, SN_JOURNAL_WATCH, NAME_B);
+  cr_assert_eq(sn_journal_commit(&journal, seq), 0);
+  cr_assert_eq(journal.durable, seq);
+
+  // Already durable, nothing to write
+
+  cr_assert_eq(sn_journal_commit(&journal, 1), 0);
+
+  sn_journal_append(&journal, SN_JOURNAL_WATCH, NAME_C);
+  sn_journal_append(&journal, SN_JOURNAL_EXPORT, NAME_C);
+  sn_journal_append(&journal, SN_JOURNAL_REMOVED, NAME_C);
+  sn_journal_close(&journal);
+
+  REPLAYED replayed = {0};
+  cr_assert_eq(sn_journal_replay(TEST_JOURNAL, collect, &replayed), 2);
+  cr_assert_eq(state_of(&replayed, NAME_A), SN_JOURNAL_STAGED);
+  cr_assert_eq(state_of(&replayed, NAME_B), SN_JOURNAL_WATCH);
+  cr_assert_eq(state_of(&replayed, NAME_C), 0);
+}
+
+Test(sn_journal, torn_record_ends_replay, .init = fini_journal,
+     .fini = fini_journal) {
+  Journal journal;
+  cr_assert_eq(sn_journal_open(&journal, TEST_JOURNAL), 0);
+  sn_journal_append(&journal, SN_JOURNAL_STAGED, NAME_A);
+  sn_journal_append(&journal, SN_JOURNAL_STAGED, NAME_B);
+  sn_journal_close(&journal);
+
+  // Half of the last record written
+
+  cr_assert_eq(truncate(TEST_JOURNAL, sizeof(JournalRecord) * 3 / 2), 0);
+
+  REPLAYED replayed = {0};
+  cr_assert_eq(sn_journal_replay(TEST_JOURNAL, collect, &replayed), 1);
+  cr_assert_str_eq(replayed.names[0], NAME_A);
+}
+
+Test(sn_journal, reset_and_missing_journal, .init = fini_journal,
+     .fini = fini_journal) {
+  REPLAYED replayed = {0};
+  cr_assert_eq(sn_journal_replay(TEST_JOURNAL, collect, &replayed), 0);
+
+  Journal journal;
+  cr_assert_eq(sn_journal_open(&journal, TEST_JOURNAL), 0);
+  sn_journal_commit(&journal,
+                    sn_journal_append(&journal, SN_JOURNAL_STAGED, NAME_A));
+  cr_assert_eq(sn_journal_reset(&journal), 0);
+  sn_journal_close(&journal);
+
+  cr_assert_eq(sn_journal_replay(TEST_JOURNAL, collect, &replayed), 0);
+  cr_assert_eq(replayed.count, 0);
+}
@@ -0,0 +1,180 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "sn_metrics.h"
+#include <criterion/criterion.h>
+#include <string.h>
+
+typedef struct {
+  char names[4][SN_METRICS_NAME_LENGTH_D];
+  double values[4];
+  int count;
+} POINTS;
+
+static int collect(const char *name, double value, void *arg) {
+  POINTS *points = arg;
+  if (points->count < 4) {
+    strcpy(points->names[points->count], name);
+    points->values[points->count] = value;
+    points->count++;
+  }
+  return 0;
+}
+
+static void add_rule(MetricRules *rules, const char *line) {
+  if (rules->count == rules->capacity) {
+    rules->capacity = rules->capacity == 0 ? 4 : rules->capacity * 2;
+    rules->rules = realloc(rules->rules, rules->capacity * sizeof(MetricRule));
+  }
+  cr_assert_eq(sn_metrics_parse_rule(line, &rules->rules[rules->count]), 0);
+  rules->count++;
+}
+
+static void set_body(FILE_DATA *file_data, const char *checkid,
+                     const char *lines[], size_t num_lines) {
+  memset(file_data, 0, sizeof(*file_data));
+  strcpy(file_data->header.checkid, checkid);
+  for (size_t i = 0; i < num_lines; i++) {
+
+    // Padded with spaces, as sn_file_read gives them
+
+    memset(file_data->body[i], ' ', SN_FILE_MAX_BODY_LENGTH);
+    memcpy(file_data->body[i], lines[i], strlen(lines[i]));
+  }
+  file_data->body_lines = num_lines;
+}
+
+Test(sn_metrics, parses_rules) {
+  MetricRule rule;
+
+  cr_assert_eq(sn_metrics_parse_rule("  # comment\n", &rule), 1);
+  cr_assert_eq(sn_metrics_parse_rule("\n", &rule), 1);
+
+  cr_assert_eq(sn_metrics_parse_rule("disk used key Used space\n", &rule), 0);
+  cr_assert_str_eq(rule.checkid, "disk");
+  cr_assert_str_eq(rule.name, "used");
+  cr_assert_eq(rule.kind, SN_METRICS_RULE_KEY);
+  cr_assert_str_eq(rule.key, "Used space");
+
+  cr_assert_eq(sn_metrics_parse_rule("* load regex load ([0-9.]+)", &rule), 0);
+  cr_assert_eq(rule.kind, SN_METRICS_RULE_REGEX);
+  regfree(&rule.regex);
+
+  // No group, bad regex, bad kind, bad name, no pattern
+
+  cr_assert_eq(sn_metrics_parse_rule("disk used regex [0-9]+", &rule), -1);
+  cr_assert_eq(sn_metrics_parse_rule("disk used regex ([0-9]+", &rule), -1);
+  cr_assert_eq(sn_metrics_parse_rule("disk used glob *", &rule), -1);
+  cr_assert_eq(sn_metrics_parse_rule("disk us/ed key Used", &rule), -1);
+  cr_assert_eq(sn_metrics_parse_rule("disk used key  ", &rule), -1);
+}
+
+Test(sn_metrics, parses_values) {
+  double value;
+
+  cr_assert_eq(sn_metrics_parse_value("42%", &value), 0);
+  cr_assert_float_eq(value, 42.0, 1e-9);
+  cr_assert_eq(sn_metrics_parse_value(" 1.5K", &value), 0);
+  cr_assert_float_eq(value, 1536.0, 1e-9);
+  cr_assert_eq(sn_metrics_parse_value("2M", &value), 0);
+  cr_assert_float_eq(value, 2.0 * 1024 * 1024, 1e-9);
+  cr_assert_eq(sn_metrics_parse_value("-3.25 C", &value), 0);
+  cr_assert_float_eq(value, -3.25, 1e-9);
+  cr_assert_eq(sn_metrics_parse_value("n/a", &value), -1);
+  cr_assert_eq(sn_metrics_parse_value("nan", &value), -1);
+}
+
+Test(sn_metrics, extracts_first_match_per_rule) {
+  MetricRules rules = {0};
+  add_rule(&rules, "log/journald/disk_usage journal regex limits "
+                   "\\(([0-9.]+[KMGTP]?)\\)$");
+  add_rule(&rules, "log/journald/disk_usage files key Files");
+  add_rule(&rules, "device/disk/usage root regex ([0-9]+)% /$");
+
+  cr_assert(sn_metrics_applies(&rules, "device/disk/usage"));
+  cr_assert_not(sn_metrics_applies(&rules, "net/ping"));
+
+  const char *lines[] = {"Disk usage ->Archived and active journals<-",
+                         "OK: journal size is within limits (107.5M)",
+                         "Files = 12", "Files: 99"};
+  FILE_DATA *file_data = malloc(sizeof(FILE_DATA));
+  set_body(file_data, "log/journald/disk_usage", lines, 4);
+
+  POINTS points = {0};
+  cr_assert_eq(sn_metrics_extract(&rules, file_data, collect, &points), 2);
+  cr_assert_str_eq(points.names[0], "journal");
+  cr_assert_float_eq(points.values[0], 107.5 * 1024 * 1024, 1e-3);
+  cr_assert_str_eq(points.names[1], "files");
+  cr_assert_float_eq(points.values[1], 12.0, 1e-9);
+
+  // No line matches
+
+  const char *other[] = {"All mount points are under 95% usage."};
+  set_body(file_data, "device/disk/usage", other, 1);
+  points.count = 0;
+  cr_assert_eq(sn_metrics_extract(&rules, file_data, collect, &points), 0);
+
+  free(file_data);
+  sn_metrics_free(&rules);
+}
+
+Test(sn_metrics, disk_rule_matches_when_all_is_well) {
+  MetricRules rules = {0};
+  add_rule(&rules, "device/disk/usage.sh root_used_pct key Root used");
+
+  const char *lines[] = {"All mount points are under 95% usage.",
+                         "Root used: 42%"};
+  FILE_DATA *file_data = malloc(sizeof(FILE_DATA));
+  set_body(file_data, "device/disk/usage.sh", lines, 2);
+
+  POINTS points = {0};
+  cr_assert_eq(sn_metrics_extract(&rules, file_data, collect, &points), 1);
+  cr_assert_str_eq(points.names[0], "root_used_pct");
+  cr_assert_float_eq(points.values[0], 42.0, 1e-9);
+
+  free(file_data);
+  sn_metrics_free(&rules);
+}
+
+Test(sn_metrics, load_skips_invalid_rules) {
+  const char *path = "/tmp/test_sn1ff_metrics.conf";
+  FILE *file = fopen(path, "w");
+  cr_assert_not_null(file);
+  fprintf(file, "# Rules\n"
+                "disk used key Used\n"
+                "disk broken regex (\n"
+                "\n"
+                "* load regex load average: ([0-9.]+)\n");
+  fclose(file);
+
+  MetricRules rules;
+  cr_assert_eq(sn_metrics_load(&rules, path), 2);
+  cr_assert_str_eq(rules.rules[1].name, "load");
+  sn_metrics_free(&rules);
+  unlink(path);
+
+  cr_assert_eq(sn_metrics_load(&rules, path), -1);
+}
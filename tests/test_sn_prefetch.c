@@ -0,0 +1,168 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "sn_prefetch.h"
+#include "sn_shard.h"
+#include <criterion/criterion.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TEST_PREFETCH_DIR "/tmp/test_sn1ff_prefetch"
+#define TEST_FILES 12
+
+// Expiry of the files, Fri Jan 1, 2100
+#define EXPIRES "4102444800"
+
+static void file_name(size_t i, char *name, size_t name_sz) {
+  snprintf(name, name_sz,
+           "%08zx-0000-0000-0000-000000000000_OKAY_" EXPIRES ".snff", i);
+}
+
+static void write_result(size_t i) {
+  char name[128];
+  char path[256];
+  file_name(i, name, sizeof(name));
+  snprintf(path, sizeof(path), "%s/%s", TEST_PREFETCH_DIR, name);
+  FILE *file = fopen(path, "w");
+  cr_assert_not_null(file);
+  fprintf(file,
+          "App: sn1ff\nVer: 1.0\nHost: host%zu\nIPv4: 192.0.2.1\n"
+          "At: Mar 17, 2025 08:00:01\nCheckID: disk\n\n\nline %zu\n",
+          i, i);
+  fclose(file);
+}
+
+static void setup_dir(void) { mkdir(TEST_PREFETCH_DIR, 0777); }
+
+static void teardown_dir(void) {
+  char name[128];
+  char path[256];
+  for (size_t i = 0; i < TEST_FILES; i++) {
+    file_name(i, name, sizeof(name));
+    snprintf(path, sizeof(path), "%s/%s", TEST_PREFETCH_DIR, name);
+    unlink(path);
+  }
+  rmdir(TEST_PREFETCH_DIR);
+}
+
+static void list_files(MultiString *names, size_t count) {
+  char name[128];
+  cn_multistr_init(names);
+  for (size_t i = 0; i < count; i++) {
+    file_name(i, name, sizeof(name));
+    cn_multistr_append(names, name);
+  }
+}
+
+Test(sn_prefetch, takes_files_in_order, .init = setup_dir,
+     .fini = teardown_dir) {
+  MultiString names;
+  for (size_t i = 0; i < TEST_FILES; i++)
+    write_result(i);
+  list_files(&names, TEST_FILES);
+
+  Prefetch prefetch;
+  cr_assert_eq(sn_prefetch_start(&prefetch, TEST_PREFETCH_DIR,
+                                 SN_SHARD_NONE, &names, 3),
+               0);
+
+  const char *name;
+  FILE_DATA *data;
+  char expected[32];
+  for (size_t i = 0; i < TEST_FILES; i++) {
+    cr_assert_eq(sn_prefetch_next(&prefetch, &name, &data), 0);
+    cr_assert_str_eq(name, cn_multistr_getstr(&names, i));
+    snprintf(expected, sizeof(expected), "host%zu", i);
+    cr_assert_str_eq(data->header.host, expected);
+
+    // Never more than "depth" read ahead
+
+    cr_assert_leq(prefetch.read_next - prefetch.take_next, 3);
+  }
+  cr_assert_eq(sn_prefetch_next(&prefetch, &name, &data), 1);
+
+  sn_prefetch_stop(&prefetch);
+  cn_multistr_free(&names);
+}
+
+Test(sn_prefetch, drops_files_missing_or_deleted, .init = setup_dir,
+     .fini = teardown_dir) {
+  MultiString names;
+  for (size_t i = 0; i < 4; i++) {
+    if (i != 1)
+      write_result(i); // 1 is listed, but not there
+  }
+  list_files(&names, 4);
+
+  Prefetch prefetch;
+  cr_assert_eq(sn_prefetch_start(&prefetch, TEST_PREFETCH_DIR,
+                                 SN_SHARD_NONE, &names, 4),
+               0);
+  prefetch.recheck_secs = 0; // Checked again when taken
+
+  const char *name;
+  FILE_DATA *data;
+  cr_assert_eq(sn_prefetch_next(&prefetch, &name, &data), 0);
+  cr_assert_str_eq(data->header.host, "host0");
+
+  // 2 deleted, whether read ahead already or not
+
+  char path[256];
+  snprintf(path, sizeof(path), "%s/%s", TEST_PREFETCH_DIR,
+           cn_multistr_getstr(&names, 2));
+  cr_assert_eq(unlink(path), 0);
+
+  cr_assert_eq(sn_prefetch_next(&prefetch, &name, &data), 0);
+  cr_assert_str_eq(data->header.host, "host3");
+  cr_assert_eq(sn_prefetch_next(&prefetch, &name, &data), 1);
+
+  sn_prefetch_stop(&prefetch);
+  cn_multistr_free(&names);
+}
+
+Test(sn_prefetch, stops_part_way, .init = setup_dir, .fini = teardown_dir) {
+  MultiString names;
+  for (size_t i = 0; i < TEST_FILES; i++)
+    write_result(i);
+  list_files(&names, TEST_FILES);
+
+  Prefetch prefetch;
+  cr_assert_eq(sn_prefetch_start(&prefetch, TEST_PREFETCH_DIR,
+                                 SN_SHARD_NONE, &names, 2),
+               0);
+
+  const char *name;
+  FILE_DATA *data;
+  cr_assert_eq(sn_prefetch_next(&prefetch, &name, &data), 0);
+  sn_prefetch_stop(&prefetch);
+  cr_assert_null(prefetch.slots);
+
+  cr_assert_eq(sn_prefetch_start(&prefetch, TEST_PREFETCH_DIR,
+                                 SN_SHARD_NONE, &names, 0),
+               -1);
+  cn_multistr_free(&names);
+}
@@ -0,0 +1,146 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "sn_run.h"
+#include <criterion/criterion.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define TEST_RUN_DIR "/tmp/test_sn1ff_run"
+
+static void write_check(const char *name, const char *body, mode_t mode) {
+  char path[256];
+  snprintf(path, sizeof(path), "%s/%s", TEST_RUN_DIR, name);
+
+  FILE *file = fopen(path, "w");
+  cr_assert_not_null(file);
+  fprintf(file, "#!/bin/sh\n%s\n", body);
+  fclose(file);
+  chmod(path, mode);
+}
+
+static void setup_dir(void) {
+  mkdir(TEST_RUN_DIR, 0777);
+  mkdir(TEST_RUN_DIR "/disk", 0777);
+}
+
+static void teardown_dir(void) {
+  const char *names[] = {"disk/root.sh", "load.sh", "notes.txt", ".hidden",
+                         "sleep.sh",     "warn.sh", "fail.sh"};
+  char path[256];
+  for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+    snprintf(path, sizeof(path), "%s/%s", TEST_RUN_DIR, names[i]);
+    unlink(path);
+  }
+  rmdir(TEST_RUN_DIR "/disk");
+  rmdir(TEST_RUN_DIR);
+}
+
+Test(sn_run, discovers_executable_checks_in_order, .init = setup_dir,
+     .fini = teardown_dir) {
+  write_check("load.sh", "exit 0", 0755);
+  write_check("disk/root.sh", "exit 0", 0755);
+  write_check("notes.txt", "", 0644);
+  write_check(".hidden", "exit 0", 0755);
+
+  Run run;
+  cr_assert_eq(sn_run_discover(&run, TEST_RUN_DIR), 0);
+  cr_assert_eq(run.count, 2);
+  cr_assert_str_eq(run.checks[0].checkid, "disk/root");
+  cr_assert_str_eq(run.checks[1].checkid, "load");
+  sn_run_free(&run);
+}
+
+Test(sn_run, exit_code_gives_status) {
+  cr_assert_eq(sn_run_status(0), SN_STATUS_OKAY);
+  cr_assert_eq(sn_run_status(1), SN_STATUS_NONE);
+  cr_assert_eq(sn_run_status(2), SN_STATUS_WARN);
+  cr_assert_eq(sn_run_status(3), SN_STATUS_ALRT);
+  cr_assert_eq(sn_run_status(127), SN_STATUS_ALRT);
+}
+
+Test(sn_run, ttl_from_client_ttls) {
+  cr_assert_eq(sn_run_ttl("5,4,3,2", SN_STATUS_ALRT), 5);
+  cr_assert_eq(sn_run_ttl("5,4,3,2", SN_STATUS_WARN), 4);
+  cr_assert_eq(sn_run_ttl("5,4,3,2", SN_STATUS_OKAY), 3);
+  cr_assert_eq(sn_run_ttl("5,4,3,2", SN_STATUS_NONE), 2);
+  cr_assert_eq(sn_run_ttl("5,4", SN_STATUS_OKAY), -1);
+  cr_assert_eq(sn_run_ttl("5,x,3,2", SN_STATUS_WARN), -1);
+}
+
+Test(sn_run, runs_in_parallel_and_kills_on_timeout, .init = setup_dir,
+     .fini = teardown_dir) {
+  write_check("warn.sh",
+              "echo disk filling\n"
+              "echo runner $SN1FF_RUNNER\n"
+              "echo file $SN1FF_RUN_FILE\n"
+              "exit 2",
+              0755);
+  write_check("fail.sh", "exit 9", 0755);
+  write_check("sleep.sh", "sleep 30", 0755);
+  write_check("load.sh", "sleep 1\nexit 0", 0755);
+
+  Run run;
+  cr_assert_eq(sn_run_discover(&run, TEST_RUN_DIR), 0);
+  cr_assert_eq(run.count, 4);
+
+  time_t start = time(NULL);
+  cr_assert_eq(sn_run_checks(&run, 4, 2), 0);
+  cr_assert_lt(time(NULL) - start, 10);
+
+  // In order of path - fail, load, sleep, warn
+
+  cr_assert_eq(run.checks[0].status, SN_STATUS_ALRT);
+  cr_assert_eq(run.checks[1].status, SN_STATUS_OKAY);
+  cr_assert_eq(run.checks[2].status, SN_STATUS_ALRT);
+  cr_assert(run.checks[2].timed_out);
+  cr_assert_eq(run.checks[3].status, SN_STATUS_WARN);
+
+  // Output is captured in the result file, the check told of the runner,
+  // and of the file
+
+  char file_line[FNAME_PATH_LENGTH_D + 8] = {'\0'};
+  snprintf(file_line, sizeof(file_line), "file %s\n",
+           run.checks[3].file_path);
+
+  char line[FNAME_PATH_LENGTH_D + 8] = {'\0'};
+  int found = 0;
+  FILE *file = fopen(run.checks[3].file_path, "r");
+  cr_assert_not_null(file);
+  while (fgets(line, sizeof(line), file) != NULL)
+    if (strcmp(line, "disk filling\n") == 0 ||
+        strcmp(line, "runner 1\n") == 0 || strcmp(line, file_line) == 0)
+      found++;
+  fclose(file);
+  cr_assert_eq(found, 3);
+
+  for (size_t i = 0; i < run.count; i++)
+    unlink(run.checks[i].file_path);
+  sn_run_free(&run);
+}
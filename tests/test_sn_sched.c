@@ -0,0 +1,84 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "sn_sched.h"
+#include <criterion/criterion.h>
+
+#define HOUR 3600
+#define DAY (24 * HOUR)
+
+Test(sn_sched, splay_is_within_period_and_stable) {
+  long splay = sn_sched_splay("host1", "/etc/sn1ff/checks/hourly", HOUR);
+  cr_assert_geq(splay, 0);
+  cr_assert_lt(splay, HOUR);
+  cr_assert_eq(sn_sched_splay("host1", "/etc/sn1ff/checks/hourly", HOUR),
+               splay);
+}
+
+Test(sn_sched, splay_spreads_hosts_over_period) {
+  // 1000 hosts, in 10 buckets of 6 minutes, none should be near empty
+
+  int buckets[10] = {0};
+  char host[32];
+  for (int i = 0; i < 1000; i++) {
+    snprintf(host, sizeof(host), "host%d", i);
+    buckets[sn_sched_splay(host, "/checks", HOUR) / (HOUR / 10)]++;
+  }
+
+  for (int i = 0; i < 10; i++)
+    cr_assert_gt(buckets[i], 50, "bucket %d has %d hosts", i, buckets[i]);
+}
+
+Test(sn_sched, next_is_splay_into_following_period) {
+  time_t midnight = 1742169600; // 2025-03-17 00:00:00 UTC
+
+  cr_assert_eq(sn_sched_next(midnight, HOUR, 600), midnight + 600);
+  cr_assert_eq(sn_sched_next(midnight + 599, HOUR, 600), midnight + 600);
+  cr_assert_eq(sn_sched_next(midnight + 600, HOUR, 600),
+               midnight + HOUR + 600);
+  cr_assert_eq(sn_sched_next(midnight + 601, HOUR, 600),
+               midnight + HOUR + 600);
+  cr_assert_eq(sn_sched_next(midnight + 5, DAY, 0), midnight + DAY);
+}
+
+Test(sn_sched, parses_schedule) {
+  time_t now = 1742169600;
+  Schedule schedule;
+
+  cr_assert_eq(sn_sched_parse("60:/etc/sn1ff/checks/hourly", "host1", now,
+                              &schedule),
+               0);
+  cr_assert_eq(schedule.period, HOUR);
+  cr_assert_str_eq(schedule.dir, "/etc/sn1ff/checks/hourly");
+  cr_assert_gt(schedule.next, now);
+  cr_assert_leq(schedule.next, now + HOUR);
+  cr_assert_eq(schedule.next % HOUR, schedule.splay);
+
+  cr_assert_eq(sn_sched_parse("0:/checks", "host1", now, &schedule), -1);
+  cr_assert_eq(sn_sched_parse("x:/checks", "host1", now, &schedule), -1);
+  cr_assert_eq(sn_sched_parse("60/checks", "host1", now, &schedule), -1);
+  cr_assert_eq(sn_sched_parse("60:checks", "host1", now, &schedule), -2);
+}
@@ -0,0 +1,103 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "sn_series.h"
+#include <criterion/criterion.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TEST_SERIES_DIR "/tmp/test_sn1ff_series"
+
+static void setup_dir(void) { mkdir(TEST_SERIES_DIR, 0777); }
+
+static void teardown_dir(void) {
+  unlink(TEST_SERIES_DIR "/" SN_SERIES_FILE_NAME);
+  rmdir(TEST_SERIES_DIR);
+}
+
+Test(sn_series, name_joins_parts_with_tabs) {
+  char name[64];
+  const char *parts[] = {"web\t1", "disk/root\n", "used"};
+  sn_series_name(parts, 3, name, sizeof(name));
+  cr_assert_str_eq(name, "web 1\tdisk/root \tused");
+
+  sn_series_name(parts, 3, name, 8);
+  cr_assert_str_eq(name, "web 1\td");
+}
+
+Test(sn_series, interns_in_order_across_reopen, .init = setup_dir,
+     .fini = teardown_dir) {
+  SeriesTable table;
+  cr_assert_eq(sn_series_open(&table, TEST_SERIES_DIR), 0);
+  cr_assert_eq(sn_series_intern(&table, "web1\tdisk"), 0);
+  cr_assert_eq(sn_series_intern(&table, "web2\tdisk"), 1);
+  cr_assert_eq(sn_series_intern(&table, "web1\tdisk"), 0);
+  cr_assert_eq(table.count, 2);
+  sn_series_close(&table);
+
+  cr_assert_eq(sn_series_open(&table, TEST_SERIES_DIR), 0);
+  cr_assert_eq(table.count, 2);
+  cr_assert_eq(sn_series_intern(&table, "web2\tdisk"), 1);
+  cr_assert_eq(sn_series_intern(&table, "web3\tdisk"), 2);
+  sn_series_close(&table);
+
+  cr_assert_eq(sn_series_find(TEST_SERIES_DIR, "web3\tdisk"), 2);
+  cr_assert_eq(sn_series_find(TEST_SERIES_DIR, "web4\tdisk"), -1);
+
+  MultiString names;
+  cn_multistr_init(&names);
+  cr_assert_eq(sn_series_names(TEST_SERIES_DIR, &names), 0);
+  cr_assert_eq(names.num_strings, 3);
+  cr_assert_str_eq(cn_multistr_getstr(&names, 1), "web2\tdisk");
+  cn_multistr_free(&names);
+}
+
+Test(sn_series, table_grows_past_initial_capacity, .init = setup_dir,
+     .fini = teardown_dir) {
+  SeriesTable table;
+  char name[32];
+  cr_assert_eq(sn_series_open(&table, TEST_SERIES_DIR), 0);
+
+  for (int i = 0; i < 3000; i++) {
+    snprintf(name, sizeof(name), "host%d\tload", i);
+    cr_assert_eq(sn_series_intern(&table, name), i);
+  }
+  for (int i = 0; i < 3000; i += 101) {
+    snprintf(name, sizeof(name), "host%d\tload", i);
+    cr_assert_eq(sn_series_intern(&table, name), i);
+  }
+  cr_assert_geq(table.capacity, 2 * table.count);
+  sn_series_close(&table);
+}
+
+Test(sn_series, missing_store_has_no_series) {
+  MultiString names;
+  cn_multistr_init(&names);
+  cr_assert_eq(sn_series_find(TEST_SERIES_DIR "/none", "a\tb"), -1);
+  cr_assert_eq(sn_series_names(TEST_SERIES_DIR "/none", &names), -1);
+  cn_multistr_free(&names);
+}
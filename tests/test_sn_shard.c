@@ -0,0 +1,132 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "cn_multistr.h"
+#include "sn_dir.h"
+#include "sn_fname.h"
+#include "sn_shard.h"
+#include <criterion/criterion.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TEST_SHARD_DIR "/tmp/test_sn1ff_shard"
+#define TEST_SHARD_NAME "3FA85F64-5717-4562-b3fc-2c963f66afa6_OKAY_1742198614.snff"
+
+Test(sn_shard, valid_shards) {
+  cr_assert(sn_shard_valid(0));
+  cr_assert(sn_shard_valid(256));
+  cr_assert(sn_shard_valid(4096));
+  cr_assert_not(sn_shard_valid(16));
+  cr_assert_not(sn_shard_valid(-1));
+}
+
+Test(sn_shard, name_from_guid_prefix) {
+  char shard[SN_SHARD_NAME_LENGTH_D];
+
+  cr_assert_eq(sn_shard_name(TEST_SHARD_NAME, 0, shard), 0);
+  cr_assert_str_eq(shard, "");
+
+  cr_assert_eq(sn_shard_name(TEST_SHARD_NAME, 256, shard), 0);
+  cr_assert_str_eq(shard, "3f");
+
+  cr_assert_eq(sn_shard_name(TEST_SHARD_NAME, 4096, shard), 0);
+  cr_assert_str_eq(shard, "3fa");
+
+  // GUID after a prefix
+
+  cr_assert_eq(sn_shard_name(".deleted." TEST_SHARD_NAME, 256, shard), 0);
+  cr_assert_str_eq(shard, "3f");
+}
+
+Test(sn_shard, name_rejects_invalid) {
+  char shard[SN_SHARD_NAME_LENGTH_D];
+  cr_assert_eq(sn_shard_name(TEST_SHARD_NAME, 100, shard), -1);
+  cr_assert_eq(sn_shard_name("short_OKAY_1.snff", 256, shard), -2);
+  cr_assert_eq(sn_shard_name("no-underscore.snff", 256, shard), -2);
+}
+
+Test(sn_shard, path_flat_and_sharded) {
+  char path[256];
+
+  cr_assert_eq(sn_shard_path("/w/", TEST_SHARD_NAME, 0, path, sizeof(path)),
+               0);
+  cr_assert_str_eq(path, "/w/" TEST_SHARD_NAME);
+
+  cr_assert_eq(sn_shard_path("/w/", TEST_SHARD_NAME, 256, path, sizeof(path)),
+               0);
+  cr_assert_str_eq(path, "/w/3f/" TEST_SHARD_NAME);
+
+  cr_assert_eq(sn_shard_path("/w", TEST_SHARD_NAME, 4096, path, sizeof(path)),
+               0);
+  cr_assert_str_eq(path, "/w/3fa/" TEST_SHARD_NAME);
+
+  cr_assert_eq(sn_shard_path("/w", TEST_SHARD_NAME, 256, path, 10), -2);
+}
+
+Test(sn_shard, fname_path_sharded) {
+  FName fname;
+  sn_fname_init(&fname);
+  sn_fname_set_dir(&fname, "/w");
+  sn_cname_set_status(&fname.cname, "OKAY");
+  sn_fname_set_shards(&fname, 256);
+
+  char path[FNAME_PATH_LENGTH_D];
+  sn_fname_get_path(&fname, path);
+
+  char expected[FNAME_PATH_LENGTH_D];
+  snprintf(expected, sizeof(expected), "/w/%.2s/%s_OKAY_%s.snff",
+           fname.cname.guid.str, fname.cname.guid.str, fname.cname.epoch.str);
+  cr_assert_str_eq(path, expected);
+}
+
+Test(sn_shard, create_dirs_and_list_sharded) {
+  mkdir(TEST_SHARD_DIR, 0777);
+  cr_assert_eq(sn_shard_create_dirs(TEST_SHARD_DIR, 256), 0);
+
+  char path[256];
+  cr_assert_eq(sn_shard_path(TEST_SHARD_DIR, TEST_SHARD_NAME, 256, path,
+                             sizeof(path)),
+               0);
+  FILE *file = fopen(path, "w");
+  cr_assert_not_null(file);
+  fclose(file);
+
+  MultiString ms;
+  cn_multistr_init(&ms);
+  cr_assert_eq(sn_dir_list_files_sharded(TEST_SHARD_DIR, 256, &ms), 0);
+  cr_assert_eq(ms.num_strings, 1);
+  cr_assert_str_eq(cn_multistr_getstr(&ms, 0), TEST_SHARD_NAME);
+  cn_multistr_free(&ms);
+
+  // Cleanup
+
+  unlink(path);
+  char shard_dir[256];
+  for (int i = 0; i < 256; i++) {
+    sn_shard_index_dir(TEST_SHARD_DIR, 256, i, shard_dir, sizeof(shard_dir));
+    rmdir(shard_dir);
+  }
+  rmdir(TEST_SHARD_DIR);
+}
@@ -0,0 +1,241 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "sn_sink.h"
+#include <criterion/criterion.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define TEST_SINK_PATH "/tmp/test_sn1ff_sink"
+
+#define TEST_NAME                                                              \
+  "0123abcd-0000-4000-8000-000000000001_WARN_1742198614.snff"
+
+static void teardown_sink(void) { unlink(TEST_SINK_PATH); }
+
+static void make_result(CName *cname, HEADER *hdr, FILE_DATA *file_data) {
+  cr_assert_eq(sn_cname_parse_name(TEST_NAME, cname), CNAME_PARSE_OK);
+
+  memset(hdr, 0, sizeof(*hdr));
+  strcpy(hdr->host, "host1");
+  strcpy(hdr->ipv4, "192.0.2.1");
+  strcpy(hdr->timestamp, "2025-03-17 08:03:34");
+  strcpy(hdr->checkid, "device/disk/usage.sh");
+
+  memset(file_data, 0, sizeof(*file_data));
+  strcpy(file_data->body[0], "Used: 91%");
+  strcpy(file_data->body[1], "Mount \"/var\"\tC:\\");
+  file_data->body_lines = 2;
+}
+
+static size_t read_all(int fd, char *buffer, size_t buffer_sz) {
+  size_t done = 0;
+  ssize_t n;
+  while (done < buffer_sz - 1 &&
+         (n = read(fd, buffer + done, buffer_sz - 1 - done)) > 0)
+    done += (size_t)n;
+  buffer[done] = '\0';
+  return done;
+}
+
+Test(sn_sink, writes_json_records_to_fifo, .fini = teardown_sink) {
+  CName cname;
+  HEADER hdr;
+  FILE_DATA file_data;
+  make_result(&cname, &hdr, &file_data);
+
+  cr_assert_eq(mkfifo(TEST_SINK_PATH, 0600), 0);
+  int reader = open(TEST_SINK_PATH, O_RDONLY | O_NONBLOCK);
+  cr_assert_neq(reader, -1);
+
+  Sink sink;
+  cr_assert_eq(sn_sink_open(&sink, TEST_SINK_PATH, SN_SINK_FIFO, 0, true), 0);
+  cr_assert_eq(sn_sink_add(&sink, TEST_NAME, &cname, &hdr, &file_data,
+                           1742198700),
+               0);
+  cr_assert_eq(sn_sink_add(&sink, TEST_NAME, &cname, &hdr, NULL, 1742198700),
+               0);
+  cr_assert_eq(sn_sink_flush(&sink), 2);
+  cr_assert_eq(sink.length, 0);
+  sn_sink_close(&sink);
+
+  const char *record =
+      "{\"name\":\"" TEST_NAME "\","
+      "\"guid\":\"0123abcd-0000-4000-8000-000000000001\",\"status\":\"WARN\","
+      "\"expires\":1742198614,\"received\":1742198700,\"host\":\"host1\","
+      "\"ipv4\":\"192.0.2.1\",\"at\":\"2025-03-17 08:03:34\","
+      "\"checkid\":\"device/disk/usage.sh\"";
+  char expected[2048];
+  snprintf(expected, sizeof(expected),
+           "%s,\"body\":[\"Used: 91%%\",\"Mount \\\"/var\\\"\\tC:\\\\\"]}\n"
+           "%s}\n",
+           record, record);
+
+  char buffer[2048];
+  read_all(reader, buffer, sizeof(buffer));
+  close(reader);
+  cr_assert_str_eq(buffer, expected);
+}
+
+Test(sn_sink, keeps_records_until_reader, .fini = teardown_sink) {
+  CName cname;
+  HEADER hdr;
+  FILE_DATA file_data;
+  make_result(&cname, &hdr, &file_data);
+  signal(SIGPIPE, SIG_IGN);
+
+  cr_assert_eq(mkfifo(TEST_SINK_PATH, 0600), 0);
+
+  Sink sink;
+  cr_assert_eq(sn_sink_open(&sink, TEST_SINK_PATH, SN_SINK_FIFO, 0, false),
+               0);
+  for (int i = 0; i < 3; i++)
+    cr_assert_eq(sn_sink_add(&sink, TEST_NAME, &cname, &hdr, &file_data,
+                             1742198700),
+                 0);
+
+  // No reader yet, the records wait
+
+  cr_assert_eq(sn_sink_flush(&sink), -1);
+  cr_assert_eq(sink.fd, -1);
+
+  int reader = open(TEST_SINK_PATH, O_RDONLY | O_NONBLOCK);
+  cr_assert_neq(reader, -1);
+  sink.retry_at = 0;
+  cr_assert_eq(sn_sink_flush(&sink), 3);
+  cr_assert_eq(sink.sent, 3);
+
+  char buffer[4096];
+  read_all(reader, buffer, sizeof(buffer));
+  size_t lines = 0;
+  for (char *c = buffer; *c != '\0'; c++)
+    lines += *c == '\n';
+  cr_assert_eq(lines, 3);
+  cr_assert_null(strstr(buffer, "\"body\""));
+
+  // The reader going, closes the FIFO until there is another
+
+  close(reader);
+  cr_assert_eq(sn_sink_add(&sink, TEST_NAME, &cname, &hdr, NULL, 1742198700),
+               0);
+  cr_assert_eq(sn_sink_flush(&sink), 0);
+  cr_assert_eq(sink.fd, -1);
+  cr_assert_gt(sink.length, 0); // Kept for the next reader
+  sn_sink_close(&sink);
+}
+
+Test(sn_sink, drops_records_when_full, .fini = teardown_sink) {
+  CName cname;
+  HEADER hdr;
+  FILE_DATA file_data;
+  make_result(&cname, &hdr, &file_data);
+
+  Sink sink;
+  cr_assert_eq(sn_sink_open(&sink, TEST_SINK_PATH, SN_SINK_FIFO, 0, true), 0);
+
+  size_t added = 0;
+  for (int i = 0; i < 100; i++)
+    added += sn_sink_add(&sink, TEST_NAME, &cname, &hdr, &file_data,
+                         1742198700) == 0;
+
+  cr_assert_lt(added, 100);
+  cr_assert_eq(sink.dropped, 100 - added);
+  cr_assert_leq(sink.length, sink.capacity);
+  sn_sink_close(&sink);
+}
+
+Test(sn_sink, sends_a_datagram_per_record, .fini = teardown_sink) {
+  CName cname;
+  HEADER hdr;
+  FILE_DATA file_data;
+  make_result(&cname, &hdr, &file_data);
+
+  int reader = socket(AF_UNIX, SOCK_DGRAM, 0);
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, TEST_SINK_PATH);
+  cr_assert_eq(bind(reader, (struct sockaddr *)&addr, sizeof(addr)), 0);
+
+  Sink sink;
+  cr_assert_eq(sn_sink_open(&sink, TEST_SINK_PATH, SN_SINK_DGRAM, 0, false),
+               0);
+  cr_assert_eq(sn_sink_add(&sink, TEST_NAME, &cname, &hdr, NULL, 1), 0);
+  cr_assert_eq(sn_sink_add(&sink, TEST_NAME, &cname, &hdr, NULL, 2), 0);
+  cr_assert_eq(sn_sink_flush(&sink), 2);
+  sn_sink_close(&sink);
+
+  char buffer[1024];
+  for (int i = 1; i <= 2; i++) {
+    ssize_t n = recv(reader, buffer, sizeof(buffer) - 1, MSG_DONTWAIT);
+    cr_assert_gt(n, 0);
+    buffer[n] = '\0';
+    cr_assert_eq(buffer[0], '{');
+    cr_assert_eq(buffer[n - 1], '}');
+    char received[32];
+    snprintf(received, sizeof(received), "\"received\":%d,", i);
+    cr_assert_not_null(strstr(buffer, received));
+  }
+  close(reader);
+}
+
+Test(sn_sink, formats_record_for_snapshot) {
+  CName cname;
+  HEADER hdr;
+  FILE_DATA file_data;
+  make_result(&cname, &hdr, &file_data);
+  strcpy(file_data.body[0], "Used: 91%    ");
+  file_data.body_lines = 1;
+
+  char out[1024];
+  int length = sn_sink_format(out, sizeof(out), TEST_NAME, &cname, &hdr,
+                              &file_data, 0);
+  cr_assert_gt(length, 0);
+  cr_assert_eq(out[length - 1], '\n');
+  out[length] = '\0';
+  cr_assert_null(strstr(out, "\"received\""));
+  cr_assert_not_null(strstr(out, ",\"body\":[\"Used: 91%\"]}"));
+
+  // A body sn_file_read cut, is marked
+
+  file_data.body_truncated = true;
+  length = sn_sink_format(out, sizeof(out), TEST_NAME, &cname, &hdr,
+                          &file_data, 0);
+  cr_assert_gt(length, 0);
+  out[length] = '\0';
+  cr_assert_not_null(strstr(out, "\"Used: 91%\"],\"truncated\":true}"));
+
+  // Too small, not written past "out_sz"
+
+  cr_assert_eq(sn_sink_format(out, 64, TEST_NAME, &cname, &hdr, NULL, 0),
+               -1);
+}
@@ -41,3 +41,13 @@ Test(sn_status, invalid_status_values) {
 
   cr_assert_eq(sn_status_isvalid(NULL), -2, "NULL should be invalid");
 }
+
+Test(sn_status, from_chars) {
+  cr_assert_eq(sn_status_from_chars("ALRT"), SN_STATUS_ALRT);
+  cr_assert_eq(sn_status_from_chars("WARN"), SN_STATUS_WARN);
+  cr_assert_eq(sn_status_from_chars("OKAY"), SN_STATUS_OKAY);
+  cr_assert_eq(sn_status_from_chars("NONE_1742198614"), SN_STATUS_NONE);
+  cr_assert_eq(sn_status_from_chars("ALRX"), SN_STATUS_INVALID);
+  cr_assert_eq(sn_status_from_chars("alrt"), SN_STATUS_INVALID);
+  cr_assert_eq(sn_status_from_chars(""), SN_STATUS_INVALID);
+}
@@ -0,0 +1,121 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "sn_suppress.h"
+#include <criterion/criterion.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TEST_SUPPRESS_DIR "/tmp/test_sn1ff_suppress"
+#define TEST_STATE_FILE TEST_SUPPRESS_DIR "/suppress.state"
+#define TEST_RESULT_FILE TEST_SUPPRESS_DIR "/result.txt"
+
+#define NOW 1742198000
+#define TTL_MINS 60
+
+static void write_result(const char *checkid, const char *at,
+                         const char *body) {
+  FILE *file = fopen(TEST_RESULT_FILE, "w");
+  cr_assert_not_null(file);
+  fprintf(file,
+          "App: sn1ff\nVer: 1.0\nHost: host1\nIPv4: 192.0.2.1\nAt: %s\n"
+          "CheckID: %s\n\n\n%s",
+          at, checkid, body);
+  fclose(file);
+}
+
+static int check_and_record(const char *server, Status status, time_t now) {
+  SuppressRecord record;
+  int result = sn_suppress_check(TEST_STATE_FILE, TEST_RESULT_FILE, server,
+                                 status, TTL_MINS, now, &record);
+  if (result == SN_SUPPRESS_SEND)
+    cr_assert_eq(sn_suppress_record(TEST_STATE_FILE, &record), 0);
+  return result;
+}
+
+static void setup_dir(void) { mkdir(TEST_SUPPRESS_DIR, 0777); }
+
+static void teardown_dir(void) {
+  unlink(TEST_STATE_FILE);
+  unlink(TEST_RESULT_FILE);
+  rmdir(TEST_SUPPRESS_DIR);
+}
+
+Test(sn_suppress, unchanged_result_suppressed_for_half_ttl,
+     .init = setup_dir, .fini = teardown_dir) {
+  write_result("disk", "At 1", "ok\n");
+  cr_assert_eq(check_and_record("", SN_STATUS_OKAY, NOW), SN_SUPPRESS_SEND);
+
+  // Only the time it ran differs
+
+  write_result("disk", "At 2", "ok\n");
+  cr_assert_eq(check_and_record("", SN_STATUS_OKAY, NOW + 60),
+               SN_SUPPRESS_SKIP);
+  cr_assert_eq(check_and_record("", SN_STATUS_OKAY, NOW + TTL_MINS * 30),
+               SN_SUPPRESS_SKIP);
+
+  // Less than half the TTL left on the last result sent
+
+  cr_assert_eq(check_and_record("", SN_STATUS_OKAY, NOW + TTL_MINS * 30 + 1),
+               SN_SUPPRESS_SEND);
+  cr_assert_eq(check_and_record("", SN_STATUS_OKAY, NOW + TTL_MINS * 30 + 2),
+               SN_SUPPRESS_SKIP);
+}
+
+Test(sn_suppress, changed_result_sent, .init = setup_dir,
+     .fini = teardown_dir) {
+  write_result("disk", "At 1", "ok\n");
+  cr_assert_eq(check_and_record("", SN_STATUS_OKAY, NOW), SN_SUPPRESS_SEND);
+
+  // Status, body, server, then check changed
+
+  cr_assert_eq(check_and_record("", SN_STATUS_WARN, NOW + 1),
+               SN_SUPPRESS_SEND);
+  write_result("disk", "At 2", "full\n");
+  cr_assert_eq(check_and_record("", SN_STATUS_WARN, NOW + 2),
+               SN_SUPPRESS_SEND);
+  cr_assert_eq(check_and_record("server2", SN_STATUS_WARN, NOW + 3),
+               SN_SUPPRESS_SEND);
+  write_result("load", "At 2", "full\n");
+  cr_assert_eq(check_and_record("", SN_STATUS_WARN, NOW + 4),
+               SN_SUPPRESS_SEND);
+
+  // Each is kept apart
+
+  write_result("disk", "At 3", "full\n");
+  cr_assert_eq(check_and_record("", SN_STATUS_WARN, NOW + 5),
+               SN_SUPPRESS_SKIP);
+  cr_assert_eq(check_and_record("server2", SN_STATUS_WARN, NOW + 5),
+               SN_SUPPRESS_SKIP);
+}
+
+Test(sn_suppress, result_without_checkid_never_suppressed,
+     .init = setup_dir, .fini = teardown_dir) {
+  write_result("N/A", "At 1", "ok\n");
+  cr_assert_eq(check_and_record("", SN_STATUS_OKAY, NOW), -1);
+  cr_assert_eq(check_and_record("", SN_STATUS_OKAY, NOW + 1), -1);
+}
@@ -0,0 +1,276 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "sn_trigram.h"
+#include <criterion/criterion.h>
+#include <dirent.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TEST_TRIGRAM_DIR "/tmp/test_sn1ff_trigram"
+
+// Mon Mar 17, 2025 00:00:00 UTC
+#define DAY_1 1742169600
+
+static void teardown_dir(void) {
+  DIR *d = opendir(TEST_TRIGRAM_DIR);
+  if (d != NULL) {
+    struct dirent *entry;
+    char path[512];
+    while ((entry = readdir(d)) != NULL) {
+      snprintf(path, sizeof(path), "%s/%s", TEST_TRIGRAM_DIR, entry->d_name);
+      unlink(path);
+    }
+    closedir(d);
+  }
+  rmdir(TEST_TRIGRAM_DIR);
+}
+
+static size_t count_segments(void) {
+  size_t count = 0;
+  DIR *d = opendir(TEST_TRIGRAM_DIR);
+  struct dirent *entry;
+  while ((entry = readdir(d)) != NULL) {
+    size_t len = strlen(entry->d_name);
+    if (len > 4 && strcmp(entry->d_name + len - 4, ".tri") == 0)
+      count++;
+  }
+  closedir(d);
+  return count;
+}
+
+static void add_named_doc(TrigramIndex *index, const char *name,
+                          time_t when, const char *line) {
+  char body[1024];
+  HEADER hdr = {0};
+  strcpy(hdr.host, "web1");
+  strcpy(hdr.checkid, "net/ports");
+
+  int len = snprintf(body, sizeof(body), "%s\n", line);
+  cr_assert_eq(sn_trigram_add(index, &hdr, name, when, body, (size_t)len), 0);
+}
+
+static void add_doc(TrigramIndex *index, const char *host,
+                    const char *checkid, time_t when, const char *line) {
+  char body[1024];
+  HEADER hdr = {0};
+  strcpy(hdr.host, host);
+  strcpy(hdr.checkid, checkid);
+
+  // As sn_file_read_body gives it, ending with a newline
+
+  int len = snprintf(body, sizeof(body), "== CHECK ==\n%s\n", line);
+  cr_assert_eq(sn_trigram_add(index, &hdr, "name", when, body, (size_t)len),
+               0);
+}
+
+typedef struct {
+  char hosts[8][32];
+  char lines[8][256];
+  size_t line_nos[8];
+  size_t count;
+} MATCHES;
+
+static int collect(const TrigramMatch *match, void *arg) {
+  MATCHES *matches = arg;
+  if (matches->count < 8) {
+    strcpy(matches->hosts[matches->count], match->host);
+    snprintf(matches->lines[matches->count],
+             sizeof(matches->lines[matches->count]), "%s", match->line);
+    matches->line_nos[matches->count] = match->line_no;
+    matches->count++;
+  }
+  return 0;
+}
+
+static int search(const char *pattern, int flags, const char *host,
+                  MATCHES *matches) {
+  TrigramQuery query = {pattern, flags, host, NULL, 0, (time_t)DAY_1 * 2};
+  memset(matches, 0, sizeof(*matches));
+  return sn_trigram_search(TEST_TRIGRAM_DIR, &query, collect, matches);
+}
+
+Test(sn_trigram, required_trigrams) {
+  uint32_t trigrams[16];
+
+  cr_assert_eq(sn_trigram_required("abcd", SN_TRIGRAM_FIXED, trigrams, 16), 2);
+  cr_assert_eq(trigrams[0], (uint32_t)('a' << 16 | 'b' << 8 | 'c'));
+  cr_assert_eq(sn_trigram_required("ABC", SN_TRIGRAM_FIXED, trigrams, 16), 1);
+  cr_assert_eq(trigrams[0], (uint32_t)('a' << 16 | 'b' << 8 | 'c'));
+  cr_assert_eq(sn_trigram_required("ab", SN_TRIGRAM_FIXED, trigrams, 16), 0);
+
+  cr_assert_eq(sn_trigram_required("foo.*bar", 0, trigrams, 16), 2);
+  cr_assert_eq(sn_trigram_required("foo|bar", 0, trigrams, 16), 0);
+  cr_assert_eq(sn_trigram_required("ab?cde", 0, trigrams, 16), 1);
+  cr_assert_eq(trigrams[0], (uint32_t)('c' << 16 | 'd' << 8 | 'e'));
+  cr_assert_eq(sn_trigram_required("(x|y)port", 0, trigrams, 16), 2);
+  cr_assert_eq(sn_trigram_required("\\.conf", 0, trigrams, 16), 3);
+  cr_assert_eq(sn_trigram_required("[0-9]+ users", 0, trigrams, 16), 4);
+  cr_assert_eq(sn_trigram_required("\\d\\d\\d", 0, trigrams, 16), 0);
+}
+
+Test(sn_trigram, finds_matching_lines, .fini = teardown_dir) {
+  TrigramIndex index;
+  cr_assert_eq(sn_trigram_open(&index, TEST_TRIGRAM_DIR), 0);
+  add_doc(&index, "web1", "net/ports", DAY_1, "LISTEN 0.0.0.0:22 sshd");
+  add_doc(&index, "web2", "net/ports", DAY_1, "LISTEN 0.0.0.0:8080 java");
+  add_doc(&index, "db1", "user/login", DAY_1, "Failed password for Bob");
+  cr_assert_eq(sn_trigram_flush(&index), 3);
+  sn_trigram_close(&index);
+
+  MATCHES matches;
+  cr_assert_eq(search("sshd", SN_TRIGRAM_FIXED, NULL, &matches), 1);
+  cr_assert_str_eq(matches.hosts[0], "web1");
+  cr_assert_str_eq(matches.lines[0], "LISTEN 0.0.0.0:22 sshd");
+  cr_assert_eq(matches.line_nos[0], 2);
+
+  cr_assert_eq(search("LISTEN .*:[0-9]+ ", 0, NULL, &matches), 2);
+  cr_assert_eq(search("for bob$", SN_TRIGRAM_ICASE, NULL, &matches), 1);
+  cr_assert_eq(search("FOR BOB", SN_TRIGRAM_FIXED, NULL, &matches), 0);
+  cr_assert_eq(search("FOR BOB", SN_TRIGRAM_FIXED | SN_TRIGRAM_ICASE, NULL,
+                      &matches),
+               1);
+  cr_assert_eq(search("LISTEN", SN_TRIGRAM_FIXED, "web2", &matches), 1);
+  cr_assert_eq(search("nginx", SN_TRIGRAM_FIXED, NULL, &matches), 0);
+
+  // No trigrams in the pattern, every document is checked
+
+  cr_assert_eq(search("=", SN_TRIGRAM_FIXED, NULL, &matches), 3);
+  cr_assert_eq(search("(", 0, NULL, &matches), -2);
+}
+
+Test(sn_trigram, finds_text_past_the_lines_read, .fini = teardown_dir) {
+  TrigramIndex index;
+  cr_assert_eq(sn_trigram_open(&index, TEST_TRIGRAM_DIR), 0);
+
+  // Wider, and further down, than sn_file_read keeps
+
+  size_t lines = SN_FILE_MAX_BODY_LINES + 10;
+  size_t body_sz = lines * 512;
+  char *body = malloc(body_sz);
+  cr_assert_not_null(body);
+  size_t len = 0;
+  for (size_t i = 0; i < lines; i++)
+    len += (size_t)snprintf(body + len, body_sz - len, "%0400zu %s\n", i,
+                            i == lines - 1 ? "needle" : "hay");
+
+  HEADER hdr = {0};
+  strcpy(hdr.host, "web1");
+  strcpy(hdr.checkid, "log/auth");
+  cr_assert_eq(sn_trigram_add(&index, &hdr, "name", DAY_1, body, len), 0);
+  cr_assert_eq(sn_trigram_flush(&index), 1);
+  sn_trigram_close(&index);
+  free(body);
+
+  MATCHES matches;
+  cr_assert_eq(search("needle", SN_TRIGRAM_FIXED, NULL, &matches), 1);
+  cr_assert_eq(matches.line_nos[0], lines);
+  cr_assert_eq(search("NEEDLE", SN_TRIGRAM_FIXED | SN_TRIGRAM_ICASE, NULL,
+                      &matches),
+               1);
+}
+
+Test(sn_trigram, merges_segments, .fini = teardown_dir) {
+  TrigramIndex index;
+  cr_assert_eq(sn_trigram_open(&index, TEST_TRIGRAM_DIR), 0);
+
+  char line[64];
+  for (int i = 0; i < 4; i++) {
+    snprintf(line, sizeof(line), "port %d open", 1000 + i);
+    add_doc(&index, "web1", "net/ports", DAY_1 + i, line);
+    cr_assert_eq(sn_trigram_flush(&index), 1);
+  }
+
+  // 1 + 1 merged, then 2 + 1 + 1 merged
+
+  cr_assert_eq(count_segments(), 1);
+
+  add_doc(&index, "web1", "net/ports", DAY_1 + 4, "port 1004 open");
+  cr_assert_eq(sn_trigram_flush(&index), 1);
+  cr_assert_eq(count_segments(), 2);
+  sn_trigram_close(&index);
+
+  // Documents added and not yet indexed are searched too
+
+  cr_assert_eq(sn_trigram_open(&index, TEST_TRIGRAM_DIR), 0);
+  cr_assert_eq(index.num_docs, 5);
+  cr_assert_eq(index.indexed, 5);
+  add_doc(&index, "web1", "net/ports", DAY_1 + 5, "port 1005 open");
+  sn_trigram_close(&index);
+
+  MATCHES matches;
+  cr_assert_eq(search("port 100[0-9] open", 0, NULL, &matches), 6);
+  cr_assert_str_eq(matches.lines[5], "port 1005 open");
+  cr_assert_eq(search("1002", SN_TRIGRAM_FIXED, NULL, &matches), 1);
+
+  // Indexed on the next open and flush
+
+  cr_assert_eq(sn_trigram_open(&index, TEST_TRIGRAM_DIR), 0);
+  cr_assert_eq(sn_trigram_flush(&index), 1);
+  sn_trigram_close(&index);
+  cr_assert_eq(search("1005", SN_TRIGRAM_FIXED, NULL, &matches), 1);
+}
+
+Test(sn_trigram, compacts_expired_documents, .fini = teardown_dir) {
+  TrigramIndex index;
+  cr_assert_eq(sn_trigram_open(&index, TEST_TRIGRAM_DIR), 0);
+
+  // Expiring by the epoch of their names, or kept, with no epoch
+
+  const char *expired = "0b4e2ac4-8c1e-4a59-9c3e-6a8f0c8d1e01_OKAY_"
+                        "1742169700.snff";
+  const char *live = "0b4e2ac4-8c1e-4a59-9c3e-6a8f0c8d1e02_OKAY_"
+                     "1742256000.snff";
+  add_named_doc(&index, expired, DAY_1, "port 1000 open");
+  add_named_doc(&index, live, DAY_1, "port 1001 open");
+  add_named_doc(&index, expired, DAY_1, "port 1002 open");
+  add_named_doc(&index, "name", DAY_1, "port 1003 open");
+  cr_assert_eq(sn_trigram_flush(&index), 4);
+
+  // None expired yet
+
+  cr_assert_eq(sn_trigram_compact(&index, DAY_1), 0);
+  cr_assert_eq(index.num_docs, 4);
+
+  cr_assert_eq(sn_trigram_compact(&index, DAY_1 + 200), 2);
+  cr_assert_eq(index.num_docs, 2);
+  cr_assert_eq(index.indexed, 2);
+  cr_assert_eq(access(TEST_TRIGRAM_DIR ".new", F_OK), -1);
+  cr_assert_eq(access(TEST_TRIGRAM_DIR ".old", F_OK), -1);
+
+  // Renumbered from 0, added to as before
+
+  add_named_doc(&index, live, DAY_1, "port 1004 open");
+  cr_assert_eq(sn_trigram_flush(&index), 1);
+  sn_trigram_close(&index);
+
+  MATCHES matches;
+  cr_assert_eq(search("port 100[0-9] open", 0, NULL, &matches), 3);
+  cr_assert_str_eq(matches.lines[0], "port 1001 open");
+  cr_assert_str_eq(matches.lines[1], "port 1003 open");
+  cr_assert_eq(search("1002", SN_TRIGRAM_FIXED, NULL, &matches), 0);
+}
@@ -0,0 +1,175 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "sn_tsdb.h"
+#include <criterion/criterion.h>
+#include <dirent.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#define TEST_TSDB_DIR "/tmp/test_sn1ff_tsdb"
+
+// Mon Mar 17, 2025 00:00:00 UTC
+#define DAY_1 1742169600
+#define MINUTE 60
+#define HOUR 3600
+
+static void teardown_dir(void) {
+  DIR *d = opendir(TEST_TSDB_DIR);
+  if (d != NULL) {
+    struct dirent *entry;
+    char path[512];
+    while ((entry = readdir(d)) != NULL) {
+      snprintf(path, sizeof(path), "%s/%s", TEST_TSDB_DIR, entry->d_name);
+      unlink(path);
+    }
+    closedir(d);
+  }
+  rmdir(TEST_TSDB_DIR);
+}
+
+typedef struct {
+  TsdbBucket buckets[8];
+  size_t count;
+} BUCKETS;
+
+static int collect(const TsdbBucket *bucket, void *arg) {
+  BUCKETS *found = arg;
+  if (found->count < 8)
+    found->buckets[found->count++] = *bucket;
+  return 0;
+}
+
+static BUCKETS query(int resolution, uint32_t series, time_t from,
+                     time_t to) {
+  BUCKETS found = {0};
+  cr_assert_eq(sn_tsdb_query(TEST_TSDB_DIR, resolution, series, from, to,
+                             collect, &found),
+               0);
+  return found;
+}
+
+Test(sn_tsdb, rolls_up_points, .fini = teardown_dir) {
+  Tsdb tsdb;
+  cr_assert_eq(sn_tsdb_open(&tsdb, TEST_TSDB_DIR), 0);
+
+  time_t whens[] = {DAY_1, DAY_1 + 10, DAY_1 + 20, DAY_1 + MINUTE,
+                    DAY_1 + HOUR};
+  double values[] = {10, 30, 20, 5, 7};
+  for (int i = 0; i < 5; i++)
+    cr_assert_eq(sn_tsdb_add(&tsdb, "host1", "disk", "used", values[i],
+                             whens[i]),
+                 0);
+  sn_tsdb_close(&tsdb);
+
+  BUCKETS found = query(SN_TSDB_RES_1M, 0, DAY_1, DAY_1 + HOUR);
+  cr_assert_eq(found.count, 3);
+  cr_assert_eq(found.buckets[0].when, DAY_1);
+  cr_assert_eq(found.buckets[0].count, 3);
+  cr_assert_float_eq(found.buckets[0].min, 10.0, 1e-9);
+  cr_assert_float_eq(found.buckets[0].max, 30.0, 1e-9);
+  cr_assert_float_eq(found.buckets[0].sum, 60.0, 1e-9);
+  cr_assert_eq(found.buckets[1].when, DAY_1 + MINUTE);
+  cr_assert_eq(found.buckets[2].when, DAY_1 + HOUR);
+
+  found = query(SN_TSDB_RES_1H, 0, DAY_1, DAY_1 + HOUR);
+  cr_assert_eq(found.count, 2);
+  cr_assert_eq(found.buckets[0].count, 4);
+  cr_assert_float_eq(found.buckets[0].min, 5.0, 1e-9);
+
+  found = query(SN_TSDB_RES_1D, 0, DAY_1, DAY_1 + HOUR);
+  cr_assert_eq(found.count, 1);
+  cr_assert_eq(found.buckets[0].count, 5);
+  cr_assert_float_eq(found.buckets[0].sum, 72.0, 1e-9);
+
+  // Part of the range only
+
+  found = query(SN_TSDB_RES_1M, 0, DAY_1 + MINUTE, DAY_1 + HOUR - 1);
+  cr_assert_eq(found.count, 1);
+}
+
+Test(sn_tsdb, series_kept_across_reopen, .fini = teardown_dir) {
+  Tsdb tsdb;
+  cr_assert_eq(sn_tsdb_open(&tsdb, TEST_TSDB_DIR), 0);
+  sn_tsdb_add(&tsdb, "host1", "disk", "used", 1, DAY_1);
+  sn_tsdb_add(&tsdb, "host2", "disk", "used", 2, DAY_1);
+  sn_tsdb_close(&tsdb);
+
+  cr_assert_eq(sn_tsdb_open(&tsdb, TEST_TSDB_DIR), 0);
+  cr_assert_eq(tsdb.series.count, 2);
+  sn_tsdb_add(&tsdb, "host2", "disk", "used", 4, DAY_1 + 1);
+  sn_tsdb_add(&tsdb, "host2", "disk", "free", 8, DAY_1 + 1);
+  sn_tsdb_close(&tsdb);
+
+  cr_assert_eq(sn_tsdb_find(TEST_TSDB_DIR, "host2", "disk", "used"), 1);
+  cr_assert_eq(sn_tsdb_find(TEST_TSDB_DIR, "host2", "disk", "free"), 2);
+  cr_assert_eq(sn_tsdb_find(TEST_TSDB_DIR, "host3", "disk", "used"), -1);
+
+  BUCKETS found = query(SN_TSDB_RES_1M, 1, DAY_1, DAY_1);
+  cr_assert_eq(found.count, 1);
+  cr_assert_eq(found.buckets[0].count, 2);
+  cr_assert_float_eq(found.buckets[0].sum, 6.0, 1e-9);
+
+  MultiString names;
+  cn_multistr_init(&names);
+  cr_assert_eq(sn_tsdb_names(TEST_TSDB_DIR, &names), 0);
+  cr_assert_eq(names.num_strings, 3);
+  cr_assert_str_eq(cn_multistr_getstr(&names, 2), "host2\tdisk\tfree");
+  cn_multistr_free(&names);
+}
+
+Test(sn_tsdb, ring_replaces_old_buckets, .fini = teardown_dir) {
+  Tsdb tsdb;
+  cr_assert_eq(sn_tsdb_open(&tsdb, TEST_TSDB_DIR), 0);
+
+  // A day later, the 1 minute bucket goes in the same slot
+
+  time_t later = DAY_1 + 86400;
+  sn_tsdb_add(&tsdb, "host1", "load", "avg", 1, DAY_1);
+  sn_tsdb_add(&tsdb, "host1", "load", "avg", 2, later);
+  sn_tsdb_add(&tsdb, "host1", "load", "avg", 3, DAY_1); // Dropped
+  sn_tsdb_close(&tsdb);
+
+  BUCKETS found = query(SN_TSDB_RES_1M, 0, DAY_1, DAY_1);
+  cr_assert_eq(found.count, 0);
+  found = query(SN_TSDB_RES_1M, 0, later, later);
+  cr_assert_eq(found.count, 1);
+  cr_assert_float_eq(found.buckets[0].sum, 2.0, 1e-9);
+
+  // The 1 hour buckets keep both days
+
+  found = query(SN_TSDB_RES_1H, 0, DAY_1, later);
+  cr_assert_eq(found.count, 2);
+  cr_assert_eq(found.buckets[0].count, 2);
+
+  // No such series, or store
+
+  found = query(SN_TSDB_RES_1H, 9, DAY_1, later);
+  cr_assert_eq(found.count, 0);
+  cr_assert_eq(sn_tsdb_query("/tmp/test_sn1ff_tsdb_none", SN_TSDB_RES_1H, 0,
+                             DAY_1, later, collect, &found),
+               -1);
+}
@@ -0,0 +1,72 @@
+/*
+MIT License
+
+Copyright (c) 2025 Gwyn Davies
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "sn_varint.h"
+#include <criterion/criterion.h>
+
+Test(sn_varint, round_trips_values) {
+  const uint64_t values[] = {0, 1, 127, 128, 300, UINT32_MAX, UINT64_MAX};
+  unsigned char buffer[7 * SN_VARINT_MAX];
+  size_t length = 0;
+
+  for (size_t i = 0; i < 7; i++)
+    length += sn_varint_put(buffer + length, values[i]);
+
+  // 1 + 1 + 1 + 2 + 2 + 5 + 10 bytes
+
+  cr_assert_eq(length, 22);
+
+  const unsigned char *src = buffer;
+  for (size_t i = 0; i < 7; i++) {
+    uint64_t value;
+    cr_assert_eq(sn_varint_get(&src, buffer + length, &value), 0);
+    cr_assert_eq(value, values[i]);
+  }
+  cr_assert_eq(src, buffer + length);
+}
+
+Test(sn_varint, rejects_truncated_and_large) {
+  unsigned char buffer[SN_VARINT_MAX];
+  size_t length = sn_varint_put(buffer, (uint64_t)UINT32_MAX + 1);
+
+  // Cut short, "src" is left where it was
+
+  const unsigned char *src = buffer;
+  uint64_t value;
+  cr_assert_eq(sn_varint_get(&src, buffer + length - 1, &value), -1);
+  cr_assert_eq(src, buffer);
+
+  // Too large for 32 bits
+
+  uint32_t value_32;
+  cr_assert_eq(sn_varint_get_32(&src, buffer + length, &value_32), -1);
+
+  src = buffer;
+  length = sn_varint_put(buffer, UINT32_MAX);
+  cr_assert_eq(length, SN_VARINT_MAX_32);
+  cr_assert_eq(sn_varint_get_32(&src, buffer + length, &value_32), 0);
+  cr_assert_eq(value_32, UINT32_MAX);
+}